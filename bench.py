@@ -0,0 +1,265 @@
+import argparse
+import csv
+import itertools
+import json
+import math
+import os
+import platform
+import re
+import shlex
+import statistics
+import subprocess
+import sys
+import time
+
+# Benchmark sweep over back ends, thread counts, initial buckets, datasets, resize on/off and NUMA placement on/off
+# Every configuration runs warmup + reps times with -s, repetitions are interleaved
+# across configurations so a slow stretch of the machine does not land on one of them
+
+BACKENDS = ["chained_locked", "chained_lock_free", "chained_open", "cuckoo"]
+
+# Sources of every back end, same as the compile commands in the README
+SOURCES = {
+    "chained_locked": ["chained_locked.c", "epoch.c", "item_pool.c"],
+    "chained_lock_free": ["chained_lock_free.c", "epoch.c", "item_pool.c"],
+    "chained_open": ["chained_open.c"],
+    "cuckoo": ["cuckoo.c"],
+}
+DRIVER_SOURCES = ["main.c", "sharded.c", "steal.c", "stats.c", "latency.c", "workload.c", "numa.c", "hugepage.c", "hot.c", "bulk.c", "snapshot.c", "policy.c", "perf.c"]
+
+TIME_PATTERN = re.compile(r"execution time: ([0-9.]+) seconds")
+
+# Hardware counters of -P (perf.h), the median per operation goes next to the time
+PERF_EVENTS = ["cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses", "hitm"]
+PERF_PATTERN = re.compile(r"perf_(\w+): total [0-9]+, per_op ([0-9.]+)")
+
+CSV_FIELDS = [
+    "backend", "dataset", "threads", "buckets", "resize", "variant", "numa", "reps",
+    "median_s", "ci_low_s", "ci_high_s", "mean_s", "stdev_s", "min_s", "max_s",
+    "ops", "median_mops",
+] + [f"{event}_per_op" for event in PERF_EVENTS] + ["ipc"]
+
+class BenchConfig:
+    backend: str
+    dataset: str
+    threads: int
+    buckets: int
+    resize: bool
+    variant: str
+    numa: bool
+    perf: bool
+
+    def __init__(self, backend: str, dataset: str, threads: int, buckets: int, resize: bool, variant: str, numa: bool, perf: bool = False):
+        self.backend = backend
+        self.dataset = dataset
+        self.threads = threads
+        self.buckets = buckets
+        self.resize = resize
+        self.variant = variant
+        self.numa = numa
+        self.perf = perf
+
+    def key(self) -> tuple:
+        return (self.backend, self.dataset, self.threads, self.buckets, self.resize, self.variant, self.numa)
+
+    def command(self, trace: str) -> list[str]:
+        cmd = [f"./{self.backend}.exe", "-f", trace, "-t", str(self.threads), "-b", str(self.buckets), "-s"]
+        if trace.endswith(".bin"):
+            cmd += ["-F", "binary"]
+        if not self.resize:
+            cmd.append("-r")
+        if self.numa:
+            cmd.append("-N")
+        if self.perf:
+            cmd += ["-P", "all"]
+        return cmd + shlex.split(self.variant)
+
+def dataset_path(name: str) -> str:
+    if os.path.exists(name):
+        return name
+    for candidate in (f"datasets/{name}", f"datasets/{name}.txt", f"datasets/{name}.bin"):
+        if os.path.exists(candidate):
+            return candidate
+    raise SystemExit(f"dataset {name} not found")
+
+def count_ops(trace: str) -> int:
+    if trace.endswith(".bin"):
+        return os.path.getsize(trace) // 17
+    with open(trace, "rb") as f:
+        return sum(1 for line in f if line.strip())
+
+def build(backends: list[str], cflags: str):
+    for backend in backends:
+        cmd = ["gcc", "-fopenmp"] + shlex.split(cflags) + DRIVER_SOURCES + SOURCES[backend] + ["-lm", "-o", f"{backend}.exe"]
+        print(" ".join(cmd), file=sys.stderr)
+        subprocess.run(cmd, check=True)
+
+def median_ci(samples: list[float], confidence: float) -> tuple[float, float]:
+    # Distribution free interval for the median from order statistics: the
+    # widest k with P(Binomial(n, 1/2) < k) <= alpha / 2 gives [x_k, x_(n-k+1)]
+    ordered = sorted(samples)
+    n = len(ordered)
+    alpha = 1 - confidence
+
+    k = 0
+    below = 0.0
+    while k < n // 2:
+        below += math.comb(n, k) / 2**n
+        if below > alpha / 2:
+            break
+        k += 1
+
+    # k == 0 means too few samples for this confidence, fall back to the full range
+    low = ordered[k - 1] if k > 0 else ordered[0]
+    high = ordered[n - k] if k > 0 else ordered[-1]
+    return low, high
+
+def run_once(config: BenchConfig, trace: str, env: dict[str, str]) -> tuple[float, dict[str, float]] | None:
+    result = subprocess.run(config.command(trace), capture_output=True, text=True, env=env)
+    match = TIME_PATTERN.search(result.stdout)
+
+    if result.returncode != 0 or not match:
+        print(f"failed: {' '.join(config.command(trace))}\n{result.stdout}{result.stderr}", file=sys.stderr)
+        return None
+    # Events the machine does not allow print "unavailable" and are left out
+    return float(match.group(1)), {event: float(value) for event, value in PERF_PATTERN.findall(result.stdout)}
+
+def summarize(config: BenchConfig, samples: list[float], counters: list[dict[str, float]], ops: int, confidence: float) -> dict:
+    median = statistics.median(samples)
+    low, high = median_ci(samples, confidence)
+
+    per_op = {}
+    for event in PERF_EVENTS:
+        values = [c[event] for c in counters if event in c]
+        per_op[f"{event}_per_op"] = statistics.median(values) if values else ""
+    cycles, instructions = per_op["cycles_per_op"], per_op["instructions_per_op"]
+
+    return {
+        "backend": config.backend,
+        "dataset": config.dataset,
+        "threads": config.threads,
+        "buckets": config.buckets,
+        "resize": int(config.resize),
+        "variant": config.variant,
+        "numa": int(config.numa),
+        "reps": len(samples),
+        "median_s": median,
+        "ci_low_s": low,
+        "ci_high_s": high,
+        "mean_s": statistics.fmean(samples),
+        "stdev_s": statistics.stdev(samples) if len(samples) > 1 else 0.0,
+        "min_s": min(samples),
+        "max_s": max(samples),
+        "ops": ops,
+        "median_mops": ops / median / 1e6 if median > 0 else 0.0,
+        **per_op,
+        "ipc": instructions / cycles if cycles and instructions != "" else "",
+    }
+
+def compare(results: list[dict], baseline_file: str, threshold: float) -> int:
+    with open(baseline_file) as f:
+        # Baselines from before the numa column ran without -N
+        baseline = {tuple(r.get(k, 0) for k in CSV_FIELDS[:7]): r for r in json.load(f)["results"]}
+
+    regressions = 0
+    for r in results:
+        old = baseline.get(tuple(r[k] for k in CSV_FIELDS[:7]))
+        if old is None:
+            continue
+
+        change = r["median_s"] / old["median_s"] - 1
+        # Only a regression if the intervals do not overlap and it is slower by more than threshold
+        if change > threshold and r["ci_low_s"] > old["ci_high_s"]:
+            regressions += 1
+            print(f"REGRESSION {r['backend']} {r['dataset']} t={r['threads']} b={r['buckets']} resize={r['resize']} numa={r['numa']} '{r['variant']}': "
+                  f"{old['median_s']:.6f}s -> {r['median_s']:.6f}s ({change:+.1%})")
+
+    print(f"{regressions} regressions against {baseline_file}")
+    return regressions
+
+def git_revision() -> str:
+    result = subprocess.run(["git", "rev-parse", "--short", "HEAD"], capture_output=True, text=True)
+    return result.stdout.strip() if result.returncode == 0 else "unknown"
+
+if __name__ == "__main__":
+
+    parser = argparse.ArgumentParser(description="sweep the hash table back ends and write CSV/JSON for generate_graphs.py")
+    parser.add_argument("--backends", nargs="+", default=BACKENDS, choices=BACKENDS)
+    parser.add_argument("--threads", nargs="+", type=int, default=[1, 2, 4, 8, 12])
+    parser.add_argument("--buckets", nargs="+", type=int, default=[64], help="initial buckets (-b)")
+    parser.add_argument("--datasets", nargs="+", default=["write_heavy", "read_heavy"], help="names in datasets/ or paths, .bin runs with -F binary")
+    parser.add_argument("--resize", nargs="+", default=["off"], choices=["on", "off"], help="off passes -r")
+    parser.add_argument("--numa", nargs="+", default=["off"], choices=["on", "off"], help="on passes -N (NUMA placement, spread pinning)")
+    parser.add_argument("--variant", action="append", dest="variants", help="extra driver flags, repeat for one configuration each (write --variant=-i, --variant= for none)")
+    parser.add_argument("--reps", type=int, default=7, help="measured runs per configuration")
+    parser.add_argument("--warmup", type=int, default=1, help="discarded runs per configuration before measuring")
+    parser.add_argument("--confidence", type=float, default=0.95, help="confidence of the interval around the median")
+    parser.add_argument("--perf", action="store_true", help="count hardware events with -P all and report them per operation")
+    parser.add_argument("--pin", default="close", choices=["close", "spread", "none"], help="OMP_PROC_BIND with OMP_PLACES=cores")
+    parser.add_argument("--build", metavar="CFLAGS", help="compile the back ends first with these flags (e.g. '-O2')")
+    parser.add_argument("--out", default="results/bench", help="writes OUT.csv and OUT.json")
+    parser.add_argument("--compare", metavar="BASELINE_JSON", help="report configurations slower than a previous run")
+    parser.add_argument("--threshold", type=float, default=0.05, help="slowdown that counts as a regression with --compare")
+    args = parser.parse_args()
+
+    if args.variants is None:
+        args.variants = [""]
+
+    if args.build is not None:
+        build(args.backends, args.build)
+
+    env = dict(os.environ)
+    if args.pin != "none":
+        env["OMP_PROC_BIND"] = args.pin
+        env["OMP_PLACES"] = "cores"
+
+    traces = {name: dataset_path(name) for name in args.datasets}
+    ops = {name: count_ops(path) for name, path in traces.items()}
+
+    configs = [
+        BenchConfig(backend, dataset, threads, buckets, resize == "on", variant, numa == "on", args.perf)
+        for backend, dataset, threads, buckets, resize, variant, numa in itertools.product(
+            args.backends, args.datasets, args.threads, args.buckets, args.resize, args.variants, args.numa)
+    ]
+
+    samples: dict[tuple, list[float]] = {config.key(): [] for config in configs}
+    counters: dict[tuple, list[dict[str, float]]] = {config.key(): [] for config in configs}
+    started = time.time()
+
+    for rep in range(args.warmup + args.reps):
+        print(f"round {rep + 1}/{args.warmup + args.reps} ({'warmup' if rep < args.warmup else 'measured'})", file=sys.stderr)
+        for config in configs:
+            measured = run_once(config, traces[config.dataset], env)
+            if measured is not None and rep >= args.warmup:
+                samples[config.key()].append(measured[0])
+                counters[config.key()].append(measured[1])
+
+    results = [summarize(config, samples[config.key()], counters[config.key()], ops[config.dataset], args.confidence) for config in configs if samples[config.key()]]
+
+    os.makedirs(os.path.dirname(args.out) or ".", exist_ok=True)
+
+    with open(args.out + ".csv", "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=CSV_FIELDS)
+        writer.writeheader()
+        writer.writerows(results)
+
+    with open(args.out + ".json", "w") as f:
+        json.dump({
+            "revision": git_revision(),
+            "host": platform.node(),
+            "cpus": os.cpu_count(),
+            "pin": args.pin,
+            "warmup": args.warmup,
+            "confidence": args.confidence,
+            "started": time.strftime("%Y-%m-%dT%H:%M:%S", time.localtime(started)),
+            "results": results,
+            "samples": [{"config": list(config.key()), "seconds": samples[config.key()], "counters": counters[config.key()]} for config in configs],
+        }, f, indent=2)
+
+    for r in results:
+        print(f"{r['backend']:18} {r['dataset']:14} t={r['threads']:<3} b={r['buckets']:<6} resize={r['resize']} numa={r['numa']} {r['variant']:8} "
+              f"median {r['median_s']:.6f}s [{r['ci_low_s']:.6f}, {r['ci_high_s']:.6f}] {r['median_mops']:.2f} Mops/s"
+              + "".join(f" {event} {r[f'{event}_per_op']:.2f}/op" for event in PERF_EVENTS if r[f"{event}_per_op"] != ""))
+
+    if args.compare and compare(results, args.compare, args.threshold) > 0:
+        raise SystemExit(1)
@@ -0,0 +1,142 @@
+/**
+ * @file bulk.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Radix partitioning of a known key set for bulk_load()
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * One pass counts, one pass scatters. Thread t counts its chunk of the
+ * input into its own row of a num_threads x num_parts histogram. The
+ * offsets run partition by partition and, inside a partition, thread by
+ * thread, so the scatter (over the same chunks) keeps the input order of
+ * every partition without any thread touching another's counters.
+ */
+
+#include "bulk.h"
+#include "hash.h"
+#include "spec.h"
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * @brief partition of a key
+ *
+ * @param parts const BulkPartition* -> specific partitioning
+ * @param key uint64_t -> hash table key
+ * @param hash_function int -> mixer of the table
+ * @param num_buckets size_t -> buckets of the table being built
+ * @return size_t -> partition index
+ */
+static inline size_t key_part(const BulkPartition* parts, uint64_t key, int hash_function, size_t num_buckets) {
+    return (hash_key(key, hash_function) & (num_buckets - 1)) / parts->part_buckets;
+}
+
+/**
+ * @brief Group pairs by the bucket range their key falls into
+ *
+ * @param keys const uint64_t* -> keys to load
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of pairs
+ * @param hash_function int -> mixer of the table (HASH_*)
+ * @param num_buckets size_t -> buckets of the table being built (power of two)
+ * @return BulkPartition* -> free with bulk_partition_free()
+ */
+BulkPartition* bulk_partition(const uint64_t* keys, const uint64_t* values, size_t n, int hash_function, size_t num_buckets) {
+    BulkPartition* parts = malloc(sizeof(BulkPartition));
+    int max_threads = omp_get_max_threads();
+
+    parts->num_parts = round_up_pow2((size_t)max_threads * BULK_PARTS_PER_THREAD);
+    if (parts->num_parts > num_buckets) {
+        parts->num_parts = num_buckets;
+    }
+    parts->part_buckets = num_buckets / parts->num_parts;
+
+    parts->keys = malloc((n ? n : 1) * sizeof(uint64_t));
+    parts->values = malloc((n ? n : 1) * sizeof(uint64_t));
+    parts->starts = malloc((parts->num_parts + 1) * sizeof(size_t));
+
+    size_t num_parts = parts->num_parts;
+    size_t* counts = calloc((size_t)max_threads * num_parts, sizeof(size_t));
+
+    #pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+        int team = omp_get_num_threads();
+        size_t begin = n * thread / team;
+        size_t end = n * (thread + 1) / team;
+        size_t* row = &counts[(size_t)thread * num_parts];
+
+        for (size_t i = begin; i < end; i++) {
+            if (spec_storable(keys[i], values[i])) {
+                row[key_part(parts, keys[i], hash_function, num_buckets)]++;
+            }
+        }
+
+        #pragma omp barrier
+
+        // Every count becomes the offset that thread scatters its next pair of that partition to
+        #pragma omp single
+        {
+            size_t offset = 0;
+            for (size_t p = 0; p < num_parts; p++) {
+                parts->starts[p] = offset;
+                for (int t = 0; t < team; t++) {
+                    size_t count = counts[(size_t)t * num_parts + p];
+                    counts[(size_t)t * num_parts + p] = offset;
+                    offset += count;
+                }
+            }
+            parts->starts[num_parts] = offset;
+        }
+
+        for (size_t i = begin; i < end; i++) {
+            if (spec_storable(keys[i], values[i])) {
+                size_t slot = row[key_part(parts, keys[i], hash_function, num_buckets)]++;
+                parts->keys[slot] = keys[i];
+                parts->values[slot] = values[i];
+            }
+        }
+    }
+
+    free(counts);
+    return parts;
+}
+
+/**
+ * @brief Free a partitioning
+ *
+ * @param parts BulkPartition* -> from bulk_partition()
+ */
+void bulk_partition_free(BulkPartition* parts) {
+    free(parts->keys);
+    free(parts->values);
+    free(parts->starts);
+    free(parts);
+}
+
+/**
+ * @brief Load a table that already holds items through insert()
+ *
+ * @param chained_pointer ChainedHashTable** -> table to fill, replaced by resize_exclusive
+ * @param parts const BulkPartition* -> pairs to insert
+ */
+void bulk_insert(ChainedHashTable** chained_pointer, const BulkPartition* parts) {
+    ChainedHashTable* chained = *chained_pointer;
+
+    #pragma omp parallel
+    {
+        size_t first;
+        size_t end;
+        bulk_thread_parts(parts, omp_get_thread_num(), omp_get_num_threads(), &first, &end);
+
+        for (size_t i = parts->starts[first]; i < parts->starts[end]; i++) {
+            insert(chained, parts->keys[i], parts->values[i]);
+        }
+    }
+
+    while (needs_resize(*chained_pointer)) {
+        resize_exclusive(chained_pointer);
+    }
+}
@@ -0,0 +1,137 @@
+/**
+ * @file bulk.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Radix partitioning of a known key set for bulk_load()
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Loading a table one insert() at a time pays for a lock or a CAS on
+ * every key, and for every resize on the way up. When the whole key set
+ * is known up front the back ends instead size the table once and let
+ * every thread build its own range of buckets with plain writes. That
+ * needs the keys grouped by bucket first, which is what this file does.
+ *
+ * The bucket index of a key (its hash masked to the bucket count) is
+ * split into num_parts equal ranges of buckets. bulk_partition counts
+ * the keys of every range per thread, turns the counts into offsets and
+ * scatters the pairs, all three steps in parallel, so every range ends up
+ * contiguous with its keys still in input order. Thread t of T then owns
+ * the ranges bulk_thread_parts() gives it, no other thread writes to
+ * those buckets.
+ *
+ * Pairs with INVALID_KEY or INVALID_VALUE, or too wide for a narrow
+ * build (see spec.h), are dropped, insert() ignores them too.
+ */
+
+#ifndef BULK_H
+#define BULK_H
+
+#include "chained.h"
+
+#include <stdlib.h>
+
+// Global Constants
+#define BULK_PARTS_PER_THREAD 8  // partitions per thread, evens out ranges of uneven size
+
+/**
+ * @struct BulkPartition
+ * @brief pairs grouped by bucket range
+ *
+ * @param keys uint64_t* -> keys, partition after partition
+ * @param values uint64_t* -> value of every key
+ * @param starts size_t* -> first pair of every partition, starts[num_parts] is the pair count
+ * @param num_parts size_t -> number of partitions (power of two)
+ * @param part_buckets size_t -> buckets in every partition
+ */
+typedef struct {
+    uint64_t* keys; /** @brief keys, partition after partition */
+    uint64_t* values; /** @brief value of every key */
+    size_t* starts; /** @brief first pair of every partition, starts[num_parts] is the pair count */
+    size_t num_parts; /** @brief number of partitions (power of two) */
+    size_t part_buckets; /** @brief buckets in every partition */
+} BulkPartition;
+
+/**
+ * @brief Group pairs by the bucket range their key falls into
+ *
+ * Opens its own parallel region, call it from outside one.
+ *
+ * @param keys const uint64_t* -> keys to load
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of pairs
+ * @param hash_function int -> mixer of the table (HASH_*)
+ * @param num_buckets size_t -> buckets of the table being built (power of two)
+ * @return BulkPartition* -> free with bulk_partition_free()
+ */
+BulkPartition* bulk_partition(const uint64_t* keys, const uint64_t* values, size_t n, int hash_function, size_t num_buckets);
+
+/**
+ * @brief Free a partitioning
+ *
+ * @param parts BulkPartition* -> from bulk_partition()
+ */
+void bulk_partition_free(BulkPartition* parts);
+
+/**
+ * @brief partitions a thread builds
+ *
+ * Contiguous, so a thread's buckets are one range as well.
+ *
+ * @param parts const BulkPartition* -> specific partitioning
+ * @param thread int -> omp_get_thread_num()
+ * @param num_threads int -> omp_get_num_threads()
+ * @param first size_t* -> first partition of the thread
+ * @param end size_t* -> one past the last partition of the thread
+ */
+static inline void bulk_thread_parts(const BulkPartition* parts, int thread, int num_threads, size_t* first, size_t* end) {
+    *first = parts->num_parts * thread / num_threads;
+    *end = parts->num_parts * (thread + 1) / num_threads;
+}
+
+/**
+ * @struct BulkDeferred
+ * @brief pairs one thread could not place inside its own buckets
+ *
+ * The open addressing back ends defer a key whose slots reach into the
+ * next thread's buckets, and insert() it once every thread is done.
+ *
+ * @param pairs size_t* -> indexes into the BulkPartition, in order
+ * @param count size_t -> number of deferred pairs
+ * @param capacity size_t -> room in pairs
+ */
+typedef struct {
+    size_t* pairs; /** @brief indexes into the BulkPartition, in order */
+    size_t count; /** @brief number of deferred pairs */
+    size_t capacity; /** @brief room in pairs */
+} BulkDeferred;
+
+/**
+ * @brief Remember one pair for later
+ *
+ * @param deferred BulkDeferred* -> calling thread's list (zeroed to start)
+ * @param pair size_t -> index into the BulkPartition
+ */
+static inline void bulk_defer(BulkDeferred* deferred, size_t pair) {
+    if (deferred->count == deferred->capacity) {
+        deferred->capacity = deferred->capacity ? 2 * deferred->capacity : 64;
+        deferred->pairs = realloc(deferred->pairs, deferred->capacity * sizeof(size_t));
+    }
+    deferred->pairs[deferred->count++] = pair;
+}
+
+/**
+ * @brief Load a table that already holds items through insert()
+ *
+ * The fallback of bulk_load(). Every thread inserts the pairs of its own
+ * partitions in order, so a repeated key still keeps its last value, then
+ * the table gets whatever resizes the inserts asked for. The partitioning
+ * may be for any bucket count, it only has to keep equal keys together.
+ *
+ * Opens its own parallel region, call it from outside one.
+ *
+ * @param chained_pointer ChainedHashTable** -> table to fill, replaced by resize_exclusive
+ * @param parts const BulkPartition* -> pairs to insert
+ */
+void bulk_insert(ChainedHashTable** chained_pointer, const BulkPartition* parts);
+
+#endif // BULK_H
@@ -17,11 +17,57 @@
 #define INVALID_KEY UINT64_MAX
 #define INVALID_VALUE UINT64_MAX
 #define DEFAULT_NUM_THREADS 16
+#define MAX_THREADS 256
 
-// Global config flags
-extern int resize_enabled;
-extern int speed_test;
-extern int resize_needed;
+// Hash mixers for hash_function, see hash.h
+#define HASH_MURMUR 0
+#define HASH_WY 1
+#define HASH_LEGACY 2
+
+#ifndef DEFAULT_HASH
+#define DEFAULT_HASH HASH_MURMUR
+#endif
+
+/**
+ * @struct TableConfig
+ * @brief behaviour of one table, copied in by create_table
+ * 
+ * Every table carries its own copy, so tables with different settings
+ * can live in the same process (one per shard, see sharded.h).
+ * 
+ * @param resize_enabled int -> grow (and shrink) as the policy below says, see policy.h
+ * @param incremental_resize int -> grow by moving a few buckets per operation instead of resize()
+ * @param hash_function int -> HASH_MURMUR, HASH_WY or HASH_LEGACY, see hash.h
+ * @param optimistic_reads int -> lockless lookups in chained_locked.c, the other back ends always read without locks
+ * @param numa int -> interleave bucket arrays and stripes over the nodes, node local item slabs (see numa.h)
+ * @param huge_pages int -> bucket arrays and item slabs on 2 MB pages, see hugepage.h
+ * @param hot_keys int -> HOT_* skew handling of the chained back ends, see hot.h
+ * @param max_load double -> grow once the items per slot pass this (0 to grow on long chains only)
+ * @param min_load double -> shrink once the items per slot fall below this (0 never shrinks)
+ * @param long_chain_ratio double -> grow once inserts that found an overlong chain pass this share of the buckets (0 for the first one)
+ * @param growth_factor int -> buckets multiply by this on a stop-the-world grow (power of two)
+ * @param expected_items size_t -> pre-size hint, create_table makes room for this many items at max_load
+ * @param report_resizes int -> print every resize decision
+ */
+typedef struct {
+    int resize_enabled; /** @brief grow (and shrink) as the policy below says, see policy.h */
+    int incremental_resize; /** @brief grow by moving a few buckets per operation instead of resize() */
+    int hash_function; /** @brief HASH_MURMUR, HASH_WY or HASH_LEGACY, see hash.h */
+    int optimistic_reads; /** @brief lockless lookups in chained_locked.c, the other back ends always read without locks */
+    int numa; /** @brief interleave bucket arrays and stripes over the nodes, node local item slabs (see numa.h) */
+    int huge_pages; /** @brief bucket arrays and item slabs on 2 MB pages, see hugepage.h */
+    int hot_keys; /** @brief HOT_* skew handling of the chained back ends, see hot.h */
+    double max_load; /** @brief grow once the items per slot pass this (0 to grow on long chains only) */
+    double min_load; /** @brief shrink once the items per slot fall below this (0 never shrinks) */
+    double long_chain_ratio; /** @brief grow once inserts that found an overlong chain pass this share of the buckets (0 for the first one) */
+    int growth_factor; /** @brief buckets multiply by this on a stop-the-world grow (power of two) */
+    size_t expected_items; /** @brief pre-size hint, create_table makes room for this many items at max_load */
+    int report_resizes; /** @brief print every resize decision */
+} TableConfig;
+
+// Initializer for a TableConfig with every back end's defaults
+#define TABLE_CONFIG_DEFAULT { .resize_enabled = 1, .incremental_resize = 0, .hash_function = DEFAULT_HASH, .optimistic_reads = 0, .numa = 0, .huge_pages = 0, .hot_keys = 0, \
+    .max_load = 0.9, .min_load = 0.0, .long_chain_ratio = 1.0 / 1024, .growth_factor = 2, .expected_items = 0, .report_resizes = 0 }
 
 /**
  * @struct ChainedHashTable
@@ -31,18 +77,24 @@ extern int resize_needed;
  * @param num_buckets size_t -> number of buckets
  * @param locks omp_lock_t* -> pointer to array of locks
  * @param num_locks size_t -> number of locks
- * @param num_items volatile int -> number of items in the table (metric purposes)
+ * @param stats StatsCounters* -> per-thread counters, see stats.h
  */
 typedef struct ChainedHashTable ChainedHashTable;
 
+// Merged counters of one table, defined in stats.h
+typedef struct TableStats TableStats;
+
 /**
  * @brief Create chained hash table
  * 
+ * Both counts are rounded up to powers of two so indexes can be masked.
+ * 
  * @param num_buckets size_t -> initial number of buckets
  * @param num_locks size_t -> initial number of locks
+ * @param config const TableConfig* -> settings to copy (NULL for TABLE_CONFIG_DEFAULT)
  * @return ChainedHashTable* 
  */
-ChainedHashTable* create_table(size_t num_buckets, size_t num_locks);
+ChainedHashTable* create_table(size_t num_buckets, size_t num_locks, const TableConfig* config);
 
 /**
  * @brief Destroy chained hash table
@@ -69,11 +121,155 @@ uint64_t lookup(ChainedHashTable* chained, uint64_t key);
  */
 void insert(ChainedHashTable* chained, uint64_t key, uint64_t value);
 
+/**
+ * @brief lookup many keys in chained table
+ * 
+ * Same result as calling lookup() on every key in order, but the bucket
+ * (and chain head) of every key is prefetched first so the cache misses
+ * overlap instead of stalling one after the other.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys to look up
+ * @param out uint64_t* -> value per key (INVALID_VALUE if key not found)
+ * @param n size_t -> number of keys
+ */
+void lookup_batch(ChainedHashTable* chained, const uint64_t* keys, uint64_t* out, size_t n);
+
+/**
+ * @brief Insert many items into chained table
+ * 
+ * Same result as calling insert() on every pair in order, with the
+ * buckets prefetched first.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void insert_batch(ChainedHashTable* chained, const uint64_t* keys, const uint64_t* values, size_t n);
+
+/**
+ * @brief Fill a table with a known key set at once
+ *
+ * Same result as calling insert() on every pair in order (a repeated key
+ * keeps its last value). An empty table is replaced by one sized for n
+ * items up front, then the pairs are radix partitioned by bucket (see
+ * bulk.h) and every thread builds its own range of buckets with plain
+ * writes, the items of each thread in one allocation. A table that
+ * already holds items grows to the same size and gets the pairs through
+ * insert().
+ *
+ * Opens its own parallel regions, call it from outside one. No other
+ * thread may touch the table meanwhile.
+ *
+ * @param chained_pointer ChainedHashTable** -> table to fill, replaced
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void bulk_load(ChainedHashTable** chained_pointer, const uint64_t* keys, const uint64_t* values, size_t n);
+
+/**
+ * @brief Write the table's items to a flat image file
+ *
+ * The image (see snapshot.h) is the settings, the bucket and item counts
+ * and the packed keys and values. Not thread safe, call
+ * it while no other thread works on the table.
+ *
+ * @param chained ChainedHashTable* -> table to save
+ * @param path const char* -> image file, replaced once it is complete
+ * @return int -> 1 on success, 0 if the file could not be written
+ */
+int save_table(ChainedHashTable* chained, const char* path);
+
+/**
+ * @brief Build a table from an image written by save_table()
+ *
+ * The image is mapped and its pairs go to bulk_load() straight from the
+ * mapping, with the settings and at least the bucket count of the saved
+ * table. Images are not tied to a back end. Opens its own parallel
+ * regions, call it from outside one.
+ *
+ * @param path const char* -> image file
+ * @return ChainedHashTable* -> NULL if the file is missing or not an image
+ */
+ChainedHashTable* load_table(const char* path);
+
+/**
+ * @brief Remove item from chained table
+ * 
+ * Named remove_key because stdio.h already declares remove().
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> removed value (INVALID_VALUE if key not found)
+ */
+uint64_t remove_key(ChainedHashTable* chained, uint64_t key);
+
+/**
+ * @brief check whether the table asked for resize()
+ * 
+ * Set by an insert or remove once the resize policy (policy.h) asks for
+ * a new size, cleared by resize(). Never set with incremental_resize in
+ * the chained back ends.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @return int -> the POLICY_* reason if the table wants to resize, 0 otherwise
+ */
+int needs_resize(ChainedHashTable* chained);
+
 /**
  * @brief Resize chained table
  * 
+ * Stop-the-world resize, every thread in the parallel region must call it.
+ * Grows by growth_factor, or halves the table if it asked to shrink.
+ * Not used when incremental_resize is set, in that mode the table grows
+ * itself and moves a few buckets on every lookup/insert instead.
+ * 
  * @param chained_pointer chained table to resize
  */
 void resize(ChainedHashTable** chained_pointer);
 
+/**
+ * @brief Resize chained table from a single thread
+ * 
+ * Same result as resize(), but done entirely by the caller with no team
+ * barriers, so one shard can grow while the other threads keep working
+ * on other shards. No other thread may touch this table meanwhile.
+ * 
+ * @param chained_pointer chained table to resize
+ */
+void resize_exclusive(ChainedHashTable** chained_pointer);
+
+/**
+ * @brief Merge the table's per-thread counters
+ * 
+ * Exact once no thread is working on the table, close enough while they
+ * are.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param out TableStats* -> snapshot to fill (see stats.h)
+ */
+void get_table_stats(ChainedHashTable* chained, TableStats* out);
+
+/**
+ * @brief Print how evenly the hash spreads the keys
+ * 
+ * Chain length histogram for the chained back ends, probe distance
+ * histogram for open addressing, followed by get_table_stats(). Not
+ * thread safe, call it after the parallel region.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ */
+void print_table_stats(ChainedHashTable* chained);
+
+/**
+ * @brief HOT_* remedies of TableConfig.hot_keys this back end implements
+ * 
+ * The others are accepted and ignored, see hot_restrict().
+ * 
+ * @return int -> HOT_* bits (see hot.h)
+ */
+int hot_keys_supported(void);
+
 #endif // CHAINED_H
\ No newline at end of file
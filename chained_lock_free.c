@@ -7,6 +7,17 @@
  */
 
 #include "chained.h"
+#include "epoch.h"
+#include "stats.h"
+#include "numa.h"
+#include "hugepage.h"
+#include "item_pool.h"
+#include "hash.h"
+#include "bulk.h"
+#include "snapshot.h"
+#include "spec.h"
+#include "policy.h"
+#include "hot.h"
 
 #include <omp.h>
 #include <stdlib.h>
@@ -17,14 +28,32 @@
 #include <time.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <sched.h>
 
 // Local constants
-#define MAX_CHAIN_SIZE 8   // depth of each bucket in the table
+#ifndef MAX_CHAIN_SIZE
+#define MAX_CHAIN_SIZE 8   // chains this long count as overlong for the resize policy
+#endif
 #define MAX_TASK_POOL 256
+#define MIGRATE_BATCH 4    // old buckets moved by each operation during an incremental resize
+#define BATCH_GROUP 32     // keys prefetched together by lookup_batch/insert_batch
+#define STATS_MAX_CHAIN (2 * MAX_CHAIN_SIZE) // last chain length bin in print_table_stats
+
+// __builtin_prefetch wants a constant read/write hint
+#define PREFETCH(addr, for_write) ((for_write) ? __builtin_prefetch((addr), 1) : __builtin_prefetch((addr), 0))
+
+// Low bits of chain pointers (Items are at least 8 byte aligned)
+#define FROZEN_TAG 1       // incremental resize is copying this chain, pointer may not change anymore
+#define MIGRATED_TAG 2     // bucket head only: chain has been copied into the next bucket array
+#define DELETED_MARK 4     // next pointer only: item is logically deleted (Harris)
+#define TAG_MASK 7
+
+// Returned by find_unlinking when the bucket is frozen, never dereferenced
+#define FROZEN_BUCKET ((Item*)FROZEN_TAG)
+
+// Head of a next array bucket until the copy of its old bucket is installed
+#define PENDING_BUCKET ((Item*)FROZEN_TAG)
 
-int resize_enabled = 1;
-int speed_test = 0;
-int resize_needed = 0;
 
 /**
  * @struct Item
@@ -32,15 +61,53 @@ int resize_needed = 0;
  * 
  * Essentially represents a "Node" now for the bucket linked list.
  * 
- * @param key uint64_t -> hash table key
- * @param value uint64_t -> item value
+ * Key and value are as wide as spec.h says, a set has no value.
+ * 
+ * @param key spec_key_t -> hash table key
+ * @param value spec_value_t -> item value
  */
 typedef struct Item {
-    uint64_t key; /** @brief hash table key */
-    uint64_t value; /** @brief item value */
+    spec_key_t key; /** @brief hash table key */
+#if TABLE_VALUE_BITS
+    spec_value_t value; /** @brief item value */
+#endif
     struct Item* next; /** @brief next item in bucket linked list */
 } Item;
 
+/**
+ * @brief value of an item that another thread may be updating
+ * 
+ * @param item const Item* -> item in a chain
+ * @return uint64_t -> its value (SET_VALUE in a set)
+ */
+static inline uint64_t read_value(const Item* item) {
+#if TABLE_VALUE_BITS
+    spec_value_t value;
+    #pragma omp atomic read seq_cst
+    value = item->value;
+    return value;
+#else
+    (void)item;
+    return SET_VALUE;
+#endif
+}
+
+/**
+ * @brief update the value of an item other threads may be looking at
+ * 
+ * @param item Item* -> item in a chain
+ * @param value uint64_t -> new value (ignored in a set)
+ */
+static inline void write_value(Item* item, uint64_t value) {
+#if TABLE_VALUE_BITS
+    #pragma omp atomic write seq_cst
+    item->value = (spec_value_t)value;
+#else
+    (void)item;
+    (void)value;
+#endif
+}
+
 /**
  * @struct Bucket
  * @brief Bucket at specific hash index
@@ -53,52 +120,212 @@ typedef struct {
     Item* head; /** @brief head pointer for linked list */
 } Bucket;
 
+/**
+ * @struct BucketArray
+ * @brief Bucket array together with its size
+ * 
+ * Readers load one pointer and get a matching bucket count, which is
+ * what lets an incremental resize swap arrays without a barrier.
+ * 
+ * @param num_buckets size_t -> number of buckets
+ * @param next BucketArray* -> array this one is being drained into
+ * @param migrate_cursor volatile size_t -> next bucket handed out to a helping thread
+ * @param migrated_buckets volatile size_t -> number of buckets already moved
+ * @param huge_pages int -> came from huge_alloc(), free with huge_free()
+ * @param buckets Bucket[] -> the buckets
+ */
+typedef struct BucketArray {
+    size_t num_buckets; /** @brief number of buckets */
+    struct BucketArray* next; /** @brief array this one is being drained into */
+    volatile size_t migrate_cursor; /** @brief next bucket handed out to a helping thread */
+    volatile size_t migrated_buckets; /** @brief number of buckets already moved */
+    int huge_pages; /** @brief came from huge_alloc(), free with huge_free() */
+    Bucket buckets[]; /** @brief the buckets */
+} BucketArray;
+
 /**
  * @struct ChainedHashTable
  * @brief chained hash table
  * 
- * @param buckets Bucket* -> pointer to array of buckets
- * @param num_buckets size_t -> number of buckets
- * @param locks omp_lock_t* -> pointer to array of locks
- * @param num_locks size_t -> number of locks
- * @param num_items volatile int -> number of items in the table (metric purposes)
+ * @param array BucketArray* -> current bucket array, new items go here
+ * @param old_array BucketArray* -> array being drained by an incremental resize
+ * @param epoch EpochDomain* -> reclamation for drained arrays
+ * @param pool ItemPool* -> allocator for every Item in the table
+ * @param resizing volatile int -> set while an incremental resize is in flight
+ * @param config TableConfig -> settings this table was created with
+ * @param resize_needed volatile int -> POLICY_* reason once the policy asks for resize(), cleared by resize()
+ * @param long_chains volatile uint64_t -> inserts that found an overlong chain since the last resize
+ * @param stats StatsCounters* -> per-thread counters, handed to the next table on resize
+ * @param resize_started double -> omp_get_wtime() when the running incremental resize began
+ * @param hot_id uint64_t -> id of the table in the hot key caches, see hot.h
+ * @param versions volatile uint64_t* -> HOT_VERSIONS version words for the hot key caches (NULL without HOT_CACHE)
  */
 struct ChainedHashTable{
-    Bucket* buckets; /** @brief pointer to array of buckets */
-    size_t num_buckets; /** @brief number of buckets */
+    BucketArray* array; /** @brief current bucket array, new items go here */
+    BucketArray* old_array; /** @brief array being drained by an incremental resize (NULL when idle) */
+    EpochDomain* epoch; /** @brief reclamation for drained arrays, readers may still hold them */
+    ItemPool* pool; /** @brief allocator for every Item in the table, handed to the next table on resize */
+    volatile int resizing; /** @brief set while an incremental resize is in flight */
+
+    TableConfig config; /** @brief settings this table was created with */
+    volatile int resize_needed; /** @brief POLICY_* reason once the policy asks for resize(), cleared by resize() */
+    volatile uint64_t long_chains; /** @brief inserts that found an overlong chain since the last resize */
+
+    StatsCounters* stats; /** @brief per-thread counters, handed to the next table on resize */
+    double resize_started; /** @brief omp_get_wtime() when the running incremental resize began */
 
-    volatile int num_items; /** @brief number of items in the table (metric purposes) */
+    uint64_t hot_id; /** @brief id of the table in the hot key caches, see hot.h */
+    volatile uint64_t* versions; /** @brief HOT_VERSIONS version words for the hot key caches (NULL without HOT_CACHE) */
 };
 
 /**
  * @brief hash function
  * 
- * Now the only hash funtion.
+ * Now the only hash funtion. Mixer comes from hash.h.
  * 
+ * @param chained ChainedHashTable* -> table whose mixer to use
  * @param key uint64_t -> hash table key
- * @param num_buckets size_t -> number of hash table buckets
+ * @param num_buckets size_t -> number of hash table buckets (power of two)
  * @return size_t -> hash1 index
  */
-size_t hash1(uint64_t key, size_t num_buckets) {
-    key = (key * 37) + 13;
-    return key % num_buckets;
+size_t hash1(ChainedHashTable* chained, uint64_t key, size_t num_buckets) {
+    return hash_key(key, chained->config.hash_function) & (num_buckets - 1);
+}
+
+/**
+ * @brief strip tags from a chain pointer
+ * 
+ * @param ptr Item* -> possibly tagged head or next pointer
+ * @return Item* -> item it points to
+ */
+static inline Item* untag(Item* ptr) {
+    return (Item*)((uintptr_t)ptr & ~(uintptr_t)TAG_MASK);
+}
+
+/**
+ * @brief check tags on a chain pointer
+ * 
+ * @param ptr Item* -> possibly tagged head or next pointer
+ * @param tag uintptr_t -> any of FROZEN_TAG, MIGRATED_TAG, DELETED_MARK
+ * @return int -> 1 if any of the tags are set
+ */
+static inline int has_tag(Item* ptr, uintptr_t tag) {
+    return ((uintptr_t)ptr & tag) != 0;
+}
+
+/**
+ * @brief add tags to a chain pointer
+ * 
+ * @param ptr Item* -> head or next pointer
+ * @param tag uintptr_t -> tags to add
+ * @return Item* -> tagged pointer
+ */
+static inline Item* with_tag(Item* ptr, uintptr_t tag) {
+    return (Item*)((uintptr_t)ptr | tag);
+}
+
+/**
+ * @brief Create empty bucket array
+ * 
+ * @param num_buckets size_t -> number of buckets
+ * @param pending int -> start every bucket as PENDING_BUCKET (next array of an incremental resize)
+ * @param config const TableConfig* -> numa and huge_pages
+ * @return BucketArray*
+ */
+static BucketArray* create_bucket_array(size_t num_buckets, int pending, const TableConfig* config) {
+    size_t bytes = sizeof(BucketArray) + num_buckets * sizeof(Bucket);
+    BucketArray* array;
+
+    if (config->huge_pages) {
+        array = huge_alloc(bytes, config->numa ? HUGE_PLACE_INTERLEAVE : HUGE_PLACE_ANY);
+    } else {
+        array = calloc(1, bytes);
+
+        // Before anything touches it, calloc leaves fresh pages alone
+        if (config->numa) {
+            numa_interleave(array, bytes);
+        }
+    }
+
+    array->num_buckets = num_buckets;
+    array->huge_pages = config->huge_pages;
+
+    for (size_t i = 0; pending && i < num_buckets; i++) {
+        array->buckets[i].head = PENDING_BUCKET;
+    }
+    return array;
+}
+
+/**
+ * @brief Free a bucket array (not its items)
+ * 
+ * @param array BucketArray* -> array to free (NULL is ignored)
+ */
+static void free_bucket_array(BucketArray* array) {
+    if (array != NULL && array->huge_pages) {
+        huge_free(array);
+    } else {
+        free(array);
+    }
+}
+
+/**
+ * @brief epoch_retire callback for a drained bucket array
+ * 
+ * Buckets that were moved by an incremental resize still point at their
+ * original chain (the next array holds copies), so those items go back
+ * to the pool together with the array.
+ * 
+ * @param array void* -> BucketArray* to free
+ */
+static void free_drained_array(void* array) {
+    BucketArray* drained = (BucketArray*)array;
+
+    for (size_t i = 0; i < drained->num_buckets; i++) {
+        Item* curr = untag(drained->buckets[i].head);
+        while (curr != NULL) {
+            Item* temp = curr;
+            curr = untag(curr->next);
+            pool_free(temp);
+        }
+    }
+    free_bucket_array(drained);
 }
 
 /**
  * @brief Create chained hash table
  * 
+ * num_buckets is rounded up to a power of two so indexes can be masked.
+ * 
  * @param num_buckets size_t -> initial number of buckets
  * @param num_locks size_t -> initial number of locks
+ * @param config const TableConfig* -> settings to copy (NULL for TABLE_CONFIG_DEFAULT)
  * @return ChainedHashTable* 
  */
-ChainedHashTable* create_table(size_t num_buckets, size_t num_locks) {
+ChainedHashTable* create_table(size_t num_buckets, size_t num_locks, const TableConfig* config) {
     ChainedHashTable* chained = malloc(sizeof(ChainedHashTable));
+    TableConfig default_config = TABLE_CONFIG_DEFAULT;
 
-    chained->num_buckets = num_buckets;
+    chained->config = config ? *config : default_config;
+    spec_config(&chained->config);
+    policy_config(&chained->config);
+    chained->resize_needed = 0;
+    chained->long_chains = 0;
 
-    chained->num_items = 0; // Metric purposes
+    chained->array = create_bucket_array(policy_initial_buckets(&chained->config, num_buckets, 1), 0, &chained->config);
+    chained->old_array = NULL;
+    chained->epoch = epoch_create();
+    chained->pool = pool_create(sizeof(Item), chained->config.numa, chained->config.huge_pages);
+    chained->resizing = 0;
 
-    chained->buckets = calloc(num_buckets, sizeof(Bucket));
+    chained->stats = stats_create();
+    chained->resize_started = 0.0;
+
+    chained->hot_id = hot_table_id();
+    chained->versions = NULL;
+    if (chained->config.hot_keys & HOT_CACHE) {
+        chained->versions = calloc(HOT_VERSIONS, sizeof(uint64_t));
+    }
 
     return chained;
 }
@@ -110,218 +337,1271 @@ ChainedHashTable* create_table(size_t num_buckets, size_t num_locks) {
  */
 void destroy_table(ChainedHashTable* chained) {
 
-    // Iterate over all buckets and free each linked list node
-    for (size_t i = 0; i < chained->num_buckets; i++) {
-        Item* curr = chained->buckets[i].head;
-        while (curr != NULL) {
-            Item* temp = curr;
-            curr = curr->next;
-            free(temp);
-        }
+    // Frees drained arrays that were still waiting on readers, needs the pool
+    epoch_destroy(chained->epoch);
+
+    // Every linked list node lives in the pool, release them all at once
+    if (chained->pool != NULL) {
+        pool_destroy(chained->pool);
     }
-    
-    free(chained->buckets);
+
+    // An incremental resize may still be in flight
+    free_bucket_array(chained->old_array);
+    free_bucket_array(chained->array);
+
+    stats_destroy(chained->stats);
+    free((void*)chained->versions);
     free(chained);
 }
 
 /**
- * @brief lookup key in chained table
+ * @brief Start an incremental resize
  * 
- * @param chained ChainedHashTable -> specific chained table
- * @param key uint64_t -> key value (must not be INVALID_KEY)
- * @return uint64_t -> value at key (INVALID_VALUE if key not found)
+ * old_array is published before the new array so that a reader that sees
+ * the new array always finds the array it has to drain first. The
+ * decision is recorded here, an incremental resize always doubles.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param reason int -> POLICY_* reason for the resize
  */
-uint64_t lookup(ChainedHashTable* chained, uint64_t key) {
+static void start_incremental_resize(ChainedHashTable* chained, int reason) {
+    int was_resizing = 1;
 
-    if (key == INVALID_KEY) {
-        //printf("key must not equal INVALID_KEY value (uint64 max)");
-        return INVALID_VALUE;
+    #pragma omp atomic compare capture
+    {
+        was_resizing = chained->resizing;
+        if (chained->resizing == 0) {
+            chained->resizing = 1;
+        }
     }
 
-    size_t bucket = hash1(key, chained->num_buckets);
+    if (was_resizing) {
+        return; // someone else is already growing the table
+    }
 
-    uint64_t value = INVALID_VALUE;
+    BucketArray* curr = chained->array;
+    BucketArray* next = create_bucket_array(curr->num_buckets * 2, 1, &chained->config); // Double size every resize
 
-    Item* curr = chained->buckets[bucket].head;
+    curr->next = next;
+    chained->resize_started = stats_resize_begin();
 
-    while (curr != NULL) {
-        if (curr->key == key) {
-            #pragma omp atomic read
-            value = curr->value;
-            return value;
-        }
-        curr = curr->next;
-    }
+    policy_record(&chained->config, chained->stats, reason, curr->num_buckets, next->num_buckets, 1, chained->long_chains);
 
-    return value;
+    #pragma omp atomic write
+    chained->long_chains = 0;
+
+    #pragma omp atomic write seq_cst
+    chained->old_array = curr;
+
+    #pragma omp atomic write seq_cst
+    chained->array = next;
 }
 
 /**
- * @brief Insert item into chained table
+ * @brief act on a resize the policy asked for
  * 
- * @param chained ChainedHashTable* -> specific chained table
- * @param key uint64_t -> key value (must not be INVALID_KEY)
- * @param value uint64_t -> value value (must not be INVALID_VALUE)
+ * Starts an incremental resize right away, or leaves the reason for the
+ * driver's next needs_resize() (the first reason wins).
+ * 
+ * @param chained ChainedHashTable* -> table that wants a new size
+ * @param reason int -> POLICY_* reason, POLICY_KEEP does nothing
  */
-void insert(ChainedHashTable* chained, uint64_t key, uint64_t value) {
-    if (key == INVALID_KEY) {
-        //printf("key must not equal INVALID_KEY value (uint64 max)");
+static void request_resize(ChainedHashTable* chained, int reason) {
+    if (reason == POLICY_KEEP) {
         return;
-    } else if (value == INVALID_VALUE) {
-        //printf("value must not equal INVALID_VALUE value (uint64 max)");
+    }
+
+    if (chained->config.incremental_resize) {
+        start_incremental_resize(chained, reason);
         return;
     }
 
-    size_t bucket = hash1(key, chained->num_buckets);
+    int temp_resize = 0;
 
-    Item* add_item = malloc(sizeof(Item));
-    add_item->key = key;
-    add_item->value = value;
-    add_item->next = NULL;
-    
-    int added_node = 0;
-    int depth = 0;
+    #pragma omp atomic read
+    temp_resize = chained->resize_needed;
 
-    // Check if key already exists in the linked list
+    if (!temp_resize) {
+        #pragma omp atomic write
+        chained->resize_needed = reason;
+    }
+}
 
-    while (1) {
-        depth = 0;
+/**
+ * @brief buckets of the array new items go to
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @return size_t -> number of buckets
+ */
+static inline size_t current_num_buckets(ChainedHashTable* chained) {
+    BucketArray* array;
 
-        Item* expected = chained->buckets[bucket].head;
+    #pragma omp atomic read seq_cst
+    array = chained->array;
 
-        Item* curr = expected;
-        int succeeded = 0;
+    return array->num_buckets;
+}
 
-        while (curr != NULL) {
-            if (curr->key == key) {
-                #pragma omp atomic write
-                curr->value = value;
-                succeeded = 1;
-                break;
-            }
-            depth++;
-            curr = curr->next;
-        }
+/**
+ * @brief Finish an incremental resize once every old bucket has moved
+ * 
+ * The drained array can not be freed yet because a reader may still be
+ * walking one of its (frozen) chains, so it is retired to the epoch domain.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param old BucketArray* -> fully drained array
+ */
+static void finish_incremental_resize(ChainedHashTable* chained, BucketArray* old) {
+    #pragma omp atomic write seq_cst
+    chained->old_array = NULL;
 
-        if (succeeded) {
-            free(add_item);
-            break;
-        }
+    epoch_retire(chained->epoch, old, free_drained_array);
 
-        add_item->next = expected;
+    stats_resize(chained->stats, chained->resize_started);
 
-        Item* old_head = NULL;
+    #pragma omp atomic write seq_cst
+    chained->resizing = 0;
+}
 
-        #pragma omp atomic compare capture
+/**
+ * @brief Freeze the next pointer of an item
+ * 
+ * After this no delete can mark the item and no unlink can go through it.
+ * 
+ * @param item Item* -> item in a frozen chain
+ * @return Item* -> frozen next pointer (check DELETED_MARK on it)
+ */
+static Item* freeze_next(Item* item) {
+    while (1) {
+        Item* next;
+
+        #pragma omp atomic read seq_cst
+        next = item->next;
+
+        if (has_tag(next, FROZEN_TAG)) {
+            return next;
+        }
+
+        Item* old_next = NULL;
+
+        #pragma omp atomic compare capture seq_cst
         {
-            old_head = chained->buckets[bucket].head;
-            if (chained->buckets[bucket].head == expected) {
-                chained->buckets[bucket].head = add_item;
+            old_next = item->next;
+            if (item->next == next) {
+                item->next = with_tag(next, FROZEN_TAG);
             }
         }
 
-        if (old_head == expected) {
-            added_node = 1;
-            break;
+        if (old_next == next) {
+            return with_tag(next, FROZEN_TAG);
         }
     }
+}
 
-    if (added_node) {
-        int current_items;
+/**
+ * @brief Install a copied chain in a bucket of the next array
+ * 
+ * Only the first copy lands, every later one finds the bucket no longer
+ * PENDING_BUCKET (it never goes back) and is freed.
+ * 
+ * @param bucket Bucket* -> bucket of the next array
+ * @param copy Item* -> private copy of the items that belong there
+ */
+static void install_copy(Bucket* bucket, Item* copy) {
+    Item* old_head = NULL;
 
-        if (!speed_test) {
-            #pragma omp atomic capture
-            current_items = ++chained->num_items;
+    #pragma omp atomic compare capture seq_cst
+    {
+        old_head = bucket->head;
+        if (bucket->head == PENDING_BUCKET) {
+            bucket->head = copy;
         }
+    }
 
-        if (resize_enabled && depth >= MAX_CHAIN_SIZE) {
-            int temp_resize = 0;
-
-            #pragma omp atomic read
-            temp_resize = resize_needed;
-
-            if (!temp_resize) {
-                #pragma omp atomic write
-                resize_needed = 1;
-            }
+    if (old_head != PENDING_BUCKET) {
+        while (copy != NULL) {
+            Item* temp = copy;
+            copy = copy->next;
+            pool_free(temp);
         }
     }
 }
 
 /**
- * @brief Thread safe insert to be used during resize
+ * @brief Move one bucket of an array being drained into its next array
  * 
- * @param chained ChainedHashTable** -> pointer to chained tabl
- * @param key uint64_t -> key value
- * @param value uint64_t -> value value
+ * The bucket is frozen by tagging its head with a compare and set, which
+ * makes every later insert into it fail and go to the next array instead.
+ * Each next pointer is frozen before its item is read, so a delete
+ * either marked the item before (and it is skipped) or retries in the
+ * next array. Once frozen the chain never changes again.
+ * 
+ * Nobody waits for the thread that froze it. Every thread that needs the
+ * bucket moved copies the frozen chain itself, into the two next buckets
+ * it splits into (old_bucket and old_bucket + old size, nothing else
+ * lands there), and installs the copies with a compare and set. All
+ * copies hold the same keys, so it does not matter whose copy wins
+ * which half. Only the compare and set that tags the head MIGRATED_TAG,
+ * after both halves are in, counts the bucket as done. The next buckets
+ * are not used before that tag is seen, and a copy that comes late finds
+ * them no longer PENDING_BUCKET.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param old BucketArray* -> array being drained
+ * @param old_bucket size_t -> bucket index in old
  */
-void resize_insert(ChainedHashTable* chained, uint64_t key, uint64_t value) {
-    size_t bucket = hash1(key, chained->num_buckets);
-
-    Item* add_item = malloc(sizeof(Item));
-    add_item->key = key;
-    add_item->value = value;
-    add_item->next = NULL;
+static void migrate_bucket(ChainedHashTable* chained, BucketArray* old, size_t old_bucket) {
+    Bucket* source = &old->buckets[old_bucket];
+    BucketArray* next = old->next;
+    Item* head;
 
     while (1) {
-        Item* expected = chained->buckets[bucket].head;
-        add_item->next = expected;
+        #pragma omp atomic read seq_cst
+        head = source->head;
+
+        if (has_tag(head, MIGRATED_TAG)) {
+            return;
+        }
+
+        if (has_tag(head, FROZEN_TAG)) {
+            break; // someone else froze it, help copying
+        }
 
         Item* old_head = NULL;
 
-        #pragma omp atomic compare capture
+        #pragma omp atomic compare capture seq_cst
         {
-            old_head = chained->buckets[bucket].head;
-            if (chained->buckets[bucket].head == expected) {
-                chained->buckets[bucket].head = add_item;
+            old_head = source->head;
+            if (source->head == head) {
+                source->head = with_tag(head, FROZEN_TAG);
             }
         }
 
-        if (old_head == expected) {
+        if (old_head == head) {
+            head = with_tag(head, FROZEN_TAG);
             break;
         }
     }
+
+    Item* low = NULL;
+    Item* high = NULL;
+    Item* curr = untag(head);
+
+    while (curr != NULL) {
+        Item* curr_next = freeze_next(curr);
+
+        if (!has_tag(curr_next, DELETED_MARK)) {
+            Item* copy = pool_alloc(chained->pool);
+            copy->key = curr->key;
+            SET_ITEM_VALUE(copy, read_value(curr));
+
+            if (hash1(chained, curr->key, next->num_buckets) == old_bucket) {
+                copy->next = low;
+                low = copy;
+            } else {
+                copy->next = high;
+                high = copy;
+            }
+        }
+
+        curr = untag(curr_next);
+    }
+
+    install_copy(&next->buckets[old_bucket], low);
+    install_copy(&next->buckets[old_bucket + old->num_buckets], high);
+
+    Item* old_head = NULL;
+
+    #pragma omp atomic compare capture seq_cst
+    {
+        old_head = source->head;
+        if (source->head == head) {
+            source->head = with_tag(head, MIGRATED_TAG);
+        }
+    }
+
+    if (old_head != head) {
+        return; // another helper finished it first
+    }
+
+    size_t done;
+
+    #pragma omp atomic capture
+    done = ++old->migrated_buckets;
+
+    if (done == old->num_buckets) {
+        finish_incremental_resize(chained, old);
+    }
 }
 
 /**
- * @brief Resize chained table
+ * @brief Move the old bucket holding key, if a resize is draining one
  * 
- * @param chained_pointer chained table to resize
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param array BucketArray* -> array the caller is about to use
+ * @param key uint64_t -> key about to be accessed
  */
-void resize(ChainedHashTable** chained_pointer) {
+static void migrate_key_bucket(ChainedHashTable* chained, BucketArray* array, uint64_t key) {
+    BucketArray* old;
 
-    static ChainedHashTable* next_chained = NULL;
-    ChainedHashTable* curr_chained = *chained_pointer;
-
-    #pragma omp barrier
+    #pragma omp atomic read seq_cst
+    old = chained->old_array;
 
-    #pragma omp single
-    {
-        size_t next_num_buckets = curr_chained->num_buckets * 2; // Double size every resize
-        next_chained = create_table(next_num_buckets, 1);
-        next_chained->num_items = curr_chained->num_items;
+    if (old != NULL && old != array) {
+        migrate_bucket(chained, old, hash1(chained, key, old->num_buckets));
     }
+}
 
-    #pragma omp barrier
+/**
+ * @brief Move a few more old buckets on behalf of an incremental resize
+ * 
+ * Called after every lookup/insert so the migration progresses even for
+ * buckets nobody touches. The cursor keeps going round the array, so a
+ * bucket whose helper stalled is picked up again on the next lap.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ */
+static void help_incremental_resize(ChainedHashTable* chained) {
+    BucketArray* old;
 
-    #pragma omp for
-    for (size_t i = 0; i < curr_chained->num_buckets; i++) {
-        Item* curr = curr_chained->buckets[i].head;
-        while (curr != NULL) {
-            resize_insert(next_chained, curr->key, curr->value);
-            curr = curr->next;
-        }
+    #pragma omp atomic read seq_cst
+    old = chained->old_array;
+
+    if (old == NULL) {
+        return;
     }
 
-    #pragma omp single 
-    {
-        *chained_pointer = next_chained;
-        destroy_table(curr_chained);
-        next_chained = NULL;
+    for (int i = 0; i < MIGRATE_BATCH; i++) {
+        size_t old_bucket;
 
-        #pragma omp atomic write
-        resize_needed = 0;
+        #pragma omp atomic capture
+        old_bucket = old->migrate_cursor++;
+
+        migrate_bucket(chained, old, old_bucket & (old->num_buckets - 1));
     }
+}
 
-    #pragma omp barrier
-}
\ No newline at end of file
+/**
+ * @brief version word of a key for the hot key caches
+ * 
+ * Picked from the hash alone, so a key keeps its word through an
+ * incremental resize.
+ * 
+ * @param chained ChainedHashTable* -> table with HOT_CACHE on
+ * @param hash uint64_t -> full hash of the key
+ * @return volatile uint64_t* -> word bumped around every write of the key
+ */
+static inline volatile uint64_t* version_word(ChainedHashTable* chained, uint64_t hash) {
+    return &chained->versions[(hash >> 20) & (HOT_VERSIONS - 1)];
+}
+
+/**
+ * @brief lookup key in chained table
+ * 
+ * With HOT_CACHE a value found while the key's version word held still
+ * and showed no writer is offered to the thread's hot key cache.
+ * 
+ * @param chained ChainedHashTable -> specific chained table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> value at key (INVALID_VALUE if key not found)
+ */
+uint64_t lookup(ChainedHashTable* chained, uint64_t key) {
+
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return INVALID_VALUE;
+    }
+
+    uint64_t value = INVALID_VALUE;
+    volatile uint64_t* version = NULL;
+    uint64_t hash = 0;
+    uint64_t seen = 0;
+
+    if (chained->versions != NULL) {
+        hash = hash_key(key, chained->config.hash_function);
+
+        if (hot_get(chained->hot_id, key, hash, &value)) {
+            stats_hot_hit(chained->stats);
+
+            if (chained->config.incremental_resize) {
+                epoch_enter(chained->epoch);
+                help_incremental_resize(chained);
+                epoch_exit(chained->epoch);
+            }
+            return value;
+        }
+
+        version = version_word(chained, hash);
+
+        #pragma omp atomic read seq_cst
+        seen = *version;
+    }
+
+    epoch_enter(chained->epoch);
+
+    while (1) {
+        BucketArray* array;
+
+        #pragma omp atomic read seq_cst
+        array = chained->array;
+
+        Bucket* bucket = &array->buckets[hash1(chained, key, array->num_buckets)];
+
+        if (chained->config.incremental_resize) {
+            BucketArray* old;
+
+            #pragma omp atomic read seq_cst
+            old = chained->old_array;
+
+            // Until the old bucket is moved the key still lives there
+            if (old != NULL && old != array) {
+                Bucket* old_bucket = &old->buckets[hash1(chained, key, old->num_buckets)];
+                Item* old_head;
+
+                #pragma omp atomic read seq_cst
+                old_head = old_bucket->head;
+
+                if (!has_tag(old_head, MIGRATED_TAG)) {
+                    bucket = old_bucket;
+                }
+            }
+        }
+
+        Item* head;
+
+        #pragma omp atomic read seq_cst
+        head = bucket->head;
+
+        if (has_tag(head, MIGRATED_TAG)) {
+            continue; // array was drained while we were looking, reload
+        }
+
+        Item* curr = untag(head);
+        size_t depth = 0;
+
+        while (curr != NULL) {
+            Item* next;
+
+            #pragma omp atomic read
+            next = curr->next;
+
+            // Marked items are already deleted
+            if (curr->key == key && !has_tag(next, DELETED_MARK)) {
+                value = read_value(curr);
+                break;
+            }
+            depth++;
+            curr = untag(next);
+        }
+
+        stats_depth(chained->stats, depth);
+        break;
+    }
+
+    if (version != NULL && value != INVALID_VALUE && hot_quiet(seen)) {
+        uint64_t seen_after;
+
+        #pragma omp atomic read seq_cst
+        seen_after = *version;
+
+        if (seen_after == seen) {
+            hot_put(chained->hot_id, key, hash, value, version, seen);
+        }
+    }
+
+    if (chained->config.incremental_resize) {
+        help_incremental_resize(chained);
+    }
+
+    epoch_exit(chained->epoch);
+
+    return value;
+}
+
+/**
+ * @brief Insert item into chained table
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @param value uint64_t -> value value (must not be INVALID_VALUE)
+ */
+void insert(ChainedHashTable* chained, uint64_t key, uint64_t value) {
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return;
+    } else if (value == INVALID_VALUE) {
+        //printf("value must not equal INVALID_VALUE value (uint64 max)");
+        return;
+    } else if (!spec_storable(key, value)) {
+        // Does not fit a narrow build, see spec.h
+        return;
+    }
+
+    Item* add_item = NULL; // only allocated once the key is known to be missing
+    int added_node = 0;
+    int depth = 0;
+    uint64_t attempts = 0;
+    volatile uint64_t* version = NULL;
+
+    if (chained->versions != NULL) {
+        version = version_word(chained, hash_key(key, chained->config.hash_function));
+    }
+
+    epoch_enter(chained->epoch);
+
+    // Check if key already exists in the linked list
+
+    while (1) {
+        depth = 0;
+        attempts++;
+
+        BucketArray* array;
+
+        #pragma omp atomic read seq_cst
+        array = chained->array;
+
+        if (chained->config.incremental_resize) {
+            migrate_key_bucket(chained, array, key);
+        }
+
+        Bucket* bucket = &array->buckets[hash1(chained, key, array->num_buckets)];
+
+        Item* expected;
+
+        #pragma omp atomic read seq_cst
+        expected = bucket->head;
+
+        if (has_tag(expected, TAG_MASK)) {
+            continue; // bucket is being moved by an incremental resize, reload
+        }
+
+        Item* curr = expected;
+        int succeeded = 0;
+        int lost_update = 0;
+
+        while (curr != NULL) {
+            Item* next;
+
+            #pragma omp atomic read
+            next = curr->next;
+
+            if (curr->key == key && !has_tag(next, DELETED_MARK)) {
+                if (version != NULL) {
+                    hot_write_begin(version);
+                }
+
+                write_value(curr, value);
+
+                #pragma omp atomic read seq_cst
+                next = curr->next;
+
+                /* A delete marked the item or a resize froze it before
+                our write landed, either way the write may be lost. */
+                lost_update = has_tag(next, DELETED_MARK | FROZEN_TAG);
+                succeeded = 1;
+
+                if (version != NULL) {
+                    hot_write_end(version);
+                }
+                break;
+            }
+            depth++;
+            curr = untag(next);
+        }
+
+        if (lost_update) {
+            continue;
+        }
+
+        if (succeeded) {
+            pool_free(add_item); // an earlier attempt may have allocated it
+            break;
+        }
+
+        if (add_item == NULL) {
+            add_item = pool_alloc(chained->pool);
+            add_item->key = key;
+            SET_ITEM_VALUE(add_item, value);
+        }
+
+        add_item->next = expected;
+
+        Item* old_head = NULL;
+
+        #pragma omp atomic compare capture
+        {
+            old_head = bucket->head;
+            if (bucket->head == expected) {
+                bucket->head = add_item;
+            }
+        }
+
+        if (old_head == expected) {
+            added_node = 1;
+            break;
+        }
+    }
+
+    stats_depth(chained->stats, depth);
+    stats_cas_retries(chained->stats, attempts - 1);
+
+    if (added_node) {
+        stats_items(chained->stats, 1);
+
+        if (spec_resize_enabled(&chained->config)) {
+            request_resize(chained, policy_after_add(&chained->config, chained->stats, current_num_buckets(chained), 1, &chained->long_chains, depth >= MAX_CHAIN_SIZE));
+        }
+    }
+
+    if (chained->config.incremental_resize) {
+        help_incremental_resize(chained);
+    }
+
+    epoch_exit(chained->epoch);
+}
+
+/**
+ * @brief Find key in a bucket, unlinking deleted items on the way
+ * 
+ * Harris/Michael style search. Marked items are snipped out with a
+ * compare and set on the previous pointer and retired to the epoch
+ * domain. Any failed compare and set restarts from the bucket head.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param bucket Bucket* -> bucket to search
+ * @param key uint64_t -> key to find
+ * @param prev_out Item*** -> pointer that points at the found item
+ * @param next_out Item** -> next pointer of the found item
+ * @return Item* -> found item, NULL if not found, FROZEN_BUCKET if the bucket is being moved
+ */
+static Item* find_unlinking(ChainedHashTable* chained, Bucket* bucket, uint64_t key, Item*** prev_out, Item** next_out) {
+    while (1) {
+        Item** prev = &bucket->head;
+        Item* curr;
+        int restart = 0;
+
+        #pragma omp atomic read seq_cst
+        curr = *prev;
+
+        if (has_tag(curr, TAG_MASK)) {
+            return FROZEN_BUCKET;
+        }
+
+        while (curr != NULL) {
+            Item* next;
+
+            #pragma omp atomic read seq_cst
+            next = curr->next;
+
+            if (has_tag(next, FROZEN_TAG)) {
+                return FROZEN_BUCKET;
+            }
+
+            if (has_tag(next, DELETED_MARK)) {
+                Item* unmarked = untag(next);
+                Item* seen = NULL;
+
+                #pragma omp atomic compare capture seq_cst
+                {
+                    seen = *prev;
+                    if (*prev == curr) {
+                        *prev = unmarked;
+                    }
+                }
+
+                if (seen != curr) {
+                    restart = 1;
+                    break;
+                }
+
+                epoch_retire(chained->epoch, curr, pool_free);
+                curr = unmarked;
+                continue;
+            }
+
+            if (curr->key == key) {
+                *prev_out = prev;
+                *next_out = next;
+                return curr;
+            }
+
+            prev = &curr->next;
+            curr = next;
+        }
+
+        if (!restart) {
+            return NULL;
+        }
+    }
+}
+
+/**
+ * @brief Remove key from chained table
+ * 
+ * The item is first logically deleted by marking its next pointer, after
+ * which lookups and inserts ignore it, and then unlinked.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> removed value (INVALID_VALUE if key not found)
+ */
+uint64_t remove_key(ChainedHashTable* chained, uint64_t key) {
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return INVALID_VALUE;
+    }
+
+    uint64_t value = INVALID_VALUE;
+    uint64_t attempts = 0;
+    volatile uint64_t* version = NULL;
+
+    if (chained->versions != NULL) {
+        version = version_word(chained, hash_key(key, chained->config.hash_function));
+    }
+
+    epoch_enter(chained->epoch);
+
+    while (1) {
+        BucketArray* array;
+
+        attempts++;
+
+        #pragma omp atomic read seq_cst
+        array = chained->array;
+
+        if (chained->config.incremental_resize) {
+            migrate_key_bucket(chained, array, key);
+        }
+
+        Bucket* bucket = &array->buckets[hash1(chained, key, array->num_buckets)];
+
+        Item** prev;
+        Item* next;
+        Item* curr = find_unlinking(chained, bucket, key, &prev, &next);
+
+        if (curr == FROZEN_BUCKET) {
+            continue; // bucket is being moved by an incremental resize, reload
+        }
+
+        if (curr == NULL) {
+            break;
+        }
+
+        Item* seen = NULL;
+
+        if (version != NULL) {
+            hot_write_begin(version);
+        }
+
+        #pragma omp atomic compare capture seq_cst
+        {
+            seen = curr->next;
+            if (curr->next == next) {
+                curr->next = with_tag(next, DELETED_MARK);
+            }
+        }
+
+        if (version != NULL) {
+            hot_write_end(version);
+        }
+
+        if (seen != next) {
+            continue; // lost a race against another delete or a freeze
+        }
+
+        value = read_value(curr);
+
+        // Physical unlink, if it fails the next search will snip it
+        #pragma omp atomic compare capture seq_cst
+        {
+            seen = *prev;
+            if (*prev == curr) {
+                *prev = next;
+            }
+        }
+
+        if (seen == curr) {
+            epoch_retire(chained->epoch, curr, pool_free);
+        } else {
+            find_unlinking(chained, bucket, key, &prev, &next);
+        }
+
+        stats_items(chained->stats, -1);
+
+        if (spec_resize_enabled(&chained->config)) {
+            request_resize(chained, policy_after_remove(&chained->config, chained->stats, current_num_buckets(chained), 1));
+        }
+
+        break;
+    }
+
+    stats_cas_retries(chained->stats, attempts - 1);
+
+    if (chained->config.incremental_resize) {
+        help_incremental_resize(chained);
+    }
+
+    epoch_exit(chained->epoch);
+
+    return value;
+}
+
+/**
+ * @brief prefetch what a group of operations is about to touch
+ * 
+ * First pass prefetches every bucket, second pass loads the chain heads
+ * (those lines are arriving by now) and prefetches the first item of
+ * each chain. The epoch critical section keeps the array and items alive.
+ * Buckets still waiting in old_array are not prefetched.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys of the group
+ * @param n size_t -> number of keys (at most BATCH_GROUP)
+ * @param for_write int -> 1 if the keys are about to be inserted
+ */
+static void prefetch_keys(ChainedHashTable* chained, const uint64_t* keys, size_t n, int for_write) {
+    Bucket* buckets[BATCH_GROUP];
+
+    epoch_enter(chained->epoch);
+
+    BucketArray* array;
+
+    #pragma omp atomic read seq_cst
+    array = chained->array;
+
+    for (size_t i = 0; i < n; i++) {
+        buckets[i] = &array->buckets[hash1(chained, keys[i], array->num_buckets)];
+        PREFETCH(buckets[i], for_write);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        Item* head;
+
+        #pragma omp atomic read
+        head = buckets[i]->head;
+
+        if (untag(head) != NULL) {
+            PREFETCH(untag(head), for_write);
+        }
+    }
+
+    epoch_exit(chained->epoch);
+}
+
+/**
+ * @brief lookup many keys in chained table
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys to look up
+ * @param out uint64_t* -> value per key (INVALID_VALUE if key not found)
+ * @param n size_t -> number of keys
+ */
+void lookup_batch(ChainedHashTable* chained, const uint64_t* keys, uint64_t* out, size_t n) {
+    for (size_t start = 0; start < n; start += BATCH_GROUP) {
+        size_t count = (n - start < BATCH_GROUP) ? n - start : BATCH_GROUP;
+
+        prefetch_keys(chained, keys + start, count, 0);
+
+        for (size_t i = start; i < start + count; i++) {
+            out[i] = lookup(chained, keys[i]);
+        }
+    }
+}
+
+/**
+ * @brief Insert many items into chained table
+ * 
+ * With HOT_COMBINE an insert a later one of the same key overwrites is
+ * skipped, see hot.h. Hot items are not moved to the front here
+ * (HOT_MOVE_TO_FRONT), a Harris list can only relink an item by
+ * deleting it, which readers would see as a miss.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void insert_batch(ChainedHashTable* chained, const uint64_t* keys, const uint64_t* values, size_t n) {
+    unsigned char superseded[HOT_COMBINE_WINDOW];
+    int combine = (chained->config.hot_keys & HOT_COMBINE) != 0;
+
+    for (size_t window = 0; window < n; window += HOT_COMBINE_WINDOW) {
+        size_t window_end = (n - window < HOT_COMBINE_WINDOW) ? n : window + HOT_COMBINE_WINDOW;
+
+        if (combine) {
+            stats_hot_combined(chained->stats, hot_combine(keys + window, values + window, window_end - window, superseded));
+        }
+
+        for (size_t start = window; start < window_end; start += BATCH_GROUP) {
+            size_t count = (window_end - start < BATCH_GROUP) ? window_end - start : BATCH_GROUP;
+
+            prefetch_keys(chained, keys + start, count, 1);
+
+            for (size_t i = start; i < start + count; i++) {
+                if (!combine || !superseded[i - window]) {
+                    insert(chained, keys[i], values[i]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Thread safe insert to be used during resize
+ * 
+ * The item is relinked from the old table, not copied.
+ * 
+ * @param chained ChainedHashTable* -> table being filled
+ * @param item Item* -> item taken out of the old table
+ */
+void resize_insert(ChainedHashTable* chained, Item* item) {
+    Bucket* bucket = &chained->array->buckets[hash1(chained, item->key, chained->array->num_buckets)];
+
+    while (1) {
+        Item* expected = bucket->head;
+        item->next = expected;
+
+        Item* old_head = NULL;
+
+        #pragma omp atomic compare capture
+        {
+            old_head = bucket->head;
+            if (bucket->head == expected) {
+                bucket->head = item;
+            }
+        }
+
+        if (old_head == expected) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief check whether the table asked for resize()
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @return int -> POLICY_* reason if the table wants a new size, 0 otherwise
+ */
+int needs_resize(ChainedHashTable* chained) {
+    int temp_resize;
+
+    #pragma omp atomic read
+    temp_resize = chained->resize_needed;
+
+    return temp_resize;
+}
+
+/**
+ * @brief Create the table a resize moves into
+ * 
+ * The nodes move over as they are, so their pool does too. So do the
+ * counters.
+ * 
+ * @param curr_chained ChainedHashTable* -> table being resized
+ * @param next_num_buckets size_t -> buckets of the new table (power of two)
+ * @return ChainedHashTable* -> empty table with next_num_buckets buckets
+ */
+static ChainedHashTable* create_next_table(ChainedHashTable* curr_chained, size_t next_num_buckets) {
+    ChainedHashTable* next_chained = create_table(next_num_buckets, 1, &curr_chained->config);
+
+    pool_destroy(next_chained->pool);
+    next_chained->pool = curr_chained->pool;
+    curr_chained->pool = NULL;
+
+    stats_destroy(next_chained->stats);
+    next_chained->stats = curr_chained->stats;
+    curr_chained->stats = NULL;
+
+    return next_chained;
+}
+
+/**
+ * @brief Relink every live item of one old bucket into the next table
+ * 
+ * Nobody is reading during a stop-the-world resize, deleted items can go
+ * right away.
+ * 
+ * @param next_chained ChainedHashTable* -> table being filled
+ * @param bucket Bucket* -> bucket of the table being resized
+ */
+static void move_bucket(ChainedHashTable* next_chained, Bucket* bucket) {
+    Item* curr = bucket->head;
+    while (curr != NULL) {
+        Item* next = curr->next;
+
+        if (has_tag(next, DELETED_MARK)) {
+            pool_free(curr);
+        } else {
+            resize_insert(next_chained, curr);
+        }
+        curr = untag(next);
+    }
+}
+
+/**
+ * @brief Resize chained table
+ * 
+ * @param chained_pointer chained table to resize
+ */
+void resize(ChainedHashTable** chained_pointer) {
+
+    static ChainedHashTable* next_chained = NULL;
+    static double resize_start = 0.0;
+    ChainedHashTable* curr_chained = *chained_pointer;
+
+    #pragma omp barrier
+
+    #pragma omp single
+    {
+        resize_start = stats_resize_begin();
+        next_chained = create_next_table(curr_chained, policy_next_buckets(&curr_chained->config, curr_chained->resize_needed, curr_chained->array->num_buckets));
+    }
+
+    #pragma omp barrier
+
+    #pragma omp for
+    for (size_t i = 0; i < curr_chained->array->num_buckets; i++) {
+        move_bucket(next_chained, &curr_chained->array->buckets[i]);
+    }
+
+    #pragma omp single 
+    {
+        policy_record(&next_chained->config, next_chained->stats, curr_chained->resize_needed, curr_chained->array->num_buckets, next_chained->array->num_buckets, 1, curr_chained->long_chains);
+        *chained_pointer = next_chained;
+        destroy_table(curr_chained);
+        stats_resize(next_chained->stats, resize_start);
+        next_chained = NULL;
+    }
+
+    #pragma omp barrier
+}
+
+/**
+ * @brief Resize chained table from a single thread
+ * 
+ * @param chained_pointer chained table to resize
+ */
+void resize_exclusive(ChainedHashTable** chained_pointer) {
+    double resize_start = stats_resize_begin();
+    ChainedHashTable* curr_chained = *chained_pointer;
+    ChainedHashTable* next_chained = create_next_table(curr_chained, policy_next_buckets(&curr_chained->config, curr_chained->resize_needed, curr_chained->array->num_buckets));
+
+    for (size_t i = 0; i < curr_chained->array->num_buckets; i++) {
+        move_bucket(next_chained, &curr_chained->array->buckets[i]);
+    }
+
+    policy_record(&next_chained->config, next_chained->stats, curr_chained->resize_needed, curr_chained->array->num_buckets, next_chained->array->num_buckets, 1, curr_chained->long_chains);
+    *chained_pointer = next_chained;
+    destroy_table(curr_chained);
+    stats_resize(next_chained->stats, resize_start);
+}
+
+/**
+ * @brief Fill a table with a known key set at once
+ * 
+ * The new table is not published until every thread is done, so the
+ * chains are built with plain writes instead of compare and sets, newest
+ * item at the head as insert() would leave them. Not counted as a
+ * resize. With resize_enabled off the table keeps its bucket count, and
+ * a load into a table that an incremental resize is still draining goes
+ * through insert().
+ * 
+ * @param chained_pointer ChainedHashTable** -> table to fill, replaced
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void bulk_load(ChainedHashTable** chained_pointer, const uint64_t* keys, const uint64_t* values, size_t n) {
+    ChainedHashTable* curr_chained = *chained_pointer;
+    TableStats snapshot;
+    get_table_stats(curr_chained, &snapshot);
+
+    // One item per bucket on average
+    size_t num_buckets = curr_chained->array->num_buckets;
+    if (spec_resize_enabled(&curr_chained->config)) {
+        num_buckets = round_up_pow2(n > num_buckets ? n : num_buckets);
+    }
+
+    if (snapshot.items != 0 || curr_chained->old_array != NULL) {
+        while (curr_chained->old_array == NULL && curr_chained->array->num_buckets < num_buckets) {
+            resize_exclusive(chained_pointer);
+            curr_chained = *chained_pointer;
+        }
+
+        BulkPartition* parts = bulk_partition(keys, values, n, curr_chained->config.hash_function, curr_chained->array->num_buckets);
+        bulk_insert(chained_pointer, parts);
+        bulk_partition_free(parts);
+        return;
+    }
+
+    BulkPartition* parts = bulk_partition(keys, values, n, curr_chained->config.hash_function, num_buckets);
+    ChainedHashTable* next_chained = create_next_table(curr_chained, num_buckets);
+    Bucket* buckets = next_chained->array->buckets;
+
+    #pragma omp parallel
+    {
+        size_t first;
+        size_t end;
+        bulk_thread_parts(parts, omp_get_thread_num(), omp_get_num_threads(), &first, &end);
+
+        size_t begin_pair = parts->starts[first];
+        size_t end_pair = parts->starts[end];
+        int added = 0;
+
+        pool_reserve(next_chained->pool, end_pair - begin_pair);
+
+        for (size_t i = begin_pair; i < end_pair; i++) {
+            uint64_t key = parts->keys[i];
+            Bucket* bucket = &buckets[hash1(next_chained, key, num_buckets)];
+
+            Item* curr = bucket->head;
+            while (curr != NULL && curr->key != key) {
+                curr = curr->next;
+            }
+
+            if (curr != NULL) {
+                SET_ITEM_VALUE(curr, parts->values[i]);
+                continue;
+            }
+
+            Item* add_item = pool_alloc(next_chained->pool);
+            add_item->key = key;
+            SET_ITEM_VALUE(add_item, parts->values[i]);
+            add_item->next = bucket->head;
+            bucket->head = add_item;
+            added++;
+        }
+
+        stats_items(next_chained->stats, added);
+    }
+
+    *chained_pointer = next_chained;
+    destroy_table(curr_chained);
+    bulk_partition_free(parts);
+}
+
+/**
+ * @brief Write the table's items to a flat image file
+ * 
+ * Marked items are already deleted and are left out. While an
+ * incremental resize is in flight a bucket of the next array only
+ * counts once its old bucket is marked migrated, until then the items
+ * are in the old array.
+ * 
+ * @param chained ChainedHashTable* -> table to save
+ * @param path const char* -> image file, replaced once it is complete
+ * @return int -> 1 on success, 0 if the file could not be written
+ */
+int save_table(ChainedHashTable* chained, const char* path) {
+    BucketArray* array = chained->array;
+    BucketArray* old = chained->old_array != array ? chained->old_array : NULL;
+    SnapshotWriter* writer = snapshot_begin(&chained->config, array->num_buckets);
+
+    for (size_t i = 0; i < array->num_buckets; i++) {
+        if (old != NULL && !has_tag(old->buckets[i & (old->num_buckets - 1)].head, MIGRATED_TAG)) {
+            continue;
+        }
+        for (Item* curr = untag(array->buckets[i].head); curr != NULL; curr = untag(curr->next)) {
+            if (!has_tag(curr->next, DELETED_MARK)) {
+                snapshot_add(writer, curr->key, ITEM_VALUE(curr));
+            }
+        }
+    }
+
+    for (size_t i = 0; old != NULL && i < old->num_buckets; i++) {
+        if (has_tag(old->buckets[i].head, MIGRATED_TAG)) {
+            continue;
+        }
+        for (Item* curr = untag(old->buckets[i].head); curr != NULL; curr = untag(curr->next)) {
+            if (!has_tag(curr->next, DELETED_MARK)) {
+                snapshot_add(writer, curr->key, ITEM_VALUE(curr));
+            }
+        }
+    }
+
+    return snapshot_finish(writer, path);
+}
+
+/**
+ * @brief Merge the table's per-thread counters
+ * 
+ * There are no locks, the lock fields stay zero.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param out TableStats* -> snapshot to fill
+ */
+void get_table_stats(ChainedHashTable* chained, TableStats* out) {
+    stats_merge(chained->stats, out);
+}
+
+/**
+ * @brief count the live items of one chain
+ * 
+ * @param head Item* -> possibly tagged head pointer
+ * @return size_t -> number of items that are not marked deleted
+ */
+static size_t chain_length(Item* head) {
+    size_t length = 0;
+    for (Item* curr = untag(head); curr != NULL; curr = untag(curr->next)) {
+        if (!has_tag(curr->next, DELETED_MARK)) {
+            length++;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief HOT_* remedies of TableConfig.hot_keys this back end implements
+ * 
+ * No HOT_MOVE_TO_FRONT, a Harris list can only relink an item by
+ * deleting it.
+ * 
+ * @return int -> HOT_* bits (see hot.h)
+ */
+int hot_keys_supported(void) {
+    return HOT_CACHE | HOT_COMBINE;
+}
+
+/**
+ * @brief Print how evenly the hash spreads the keys
+ * 
+ * Chains still waiting in old_array during an incremental resize are
+ * counted as well.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ */
+void print_table_stats(ChainedHashTable* chained) {
+    size_t counts[STATS_MAX_CHAIN + 1] = {0};
+    size_t max_length = 0;
+    size_t total_items = 0;
+    size_t total_chains = 0;
+
+    BucketArray* arrays[2] = { chained->array, chained->old_array };
+
+    for (int a = 0; a < 2; a++) {
+        BucketArray* array = arrays[a];
+
+        for (size_t i = 0; array != NULL && i < array->num_buckets; i++) {
+            if (has_tag(array->buckets[i].head, MIGRATED_TAG)) {
+                continue;
+            }
+
+            size_t length = chain_length(array->buckets[i].head);
+
+            counts[length < STATS_MAX_CHAIN ? length : STATS_MAX_CHAIN]++;
+            max_length = length > max_length ? length : max_length;
+            total_items += length;
+            total_chains++;
+        }
+    }
+
+    printf("num_buckets: %zu\n", chained->array->num_buckets);
+    print_length_histogram("chain_lengths", counts, STATS_MAX_CHAIN + 1);
+    printf("max_chain_length: %zu\n", max_length);
+    printf("mean_chain_length: %f\n", total_chains ? (double)total_items / total_chains : 0.0);
+
+    TableStats snapshot;
+    get_table_stats(chained, &snapshot);
+    stats_print(&snapshot);
+}
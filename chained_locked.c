@@ -23,6 +23,18 @@
  */
 
 #include "chained.h"
+#include "item_pool.h"
+#include "hash.h"
+#include "epoch.h"
+#include "stats.h"
+#include "numa.h"
+#include "hugepage.h"
+#include "hot.h"
+#include "park_lock.h"
+#include "bulk.h"
+#include "snapshot.h"
+#include "spec.h"
+#include "policy.h"
 
 #include <omp.h>
 #include <stdlib.h>
@@ -35,12 +47,26 @@
 #include <getopt.h>
 
 // Local constants
-#define MAX_CHAIN_SIZE 8   // depth of each bucket in the table
+#ifndef MAX_CHAIN_SIZE
+#define MAX_CHAIN_SIZE 8   // chains this long count as overlong for the resize policy
+#endif
 #define MAX_TASK_POOL 256
+#define MIGRATE_BATCH 4    // old buckets moved by each operation during an incremental resize
+#define BATCH_GROUP 32     // keys prefetched together by lookup_batch/insert_batch
+#define STATS_MAX_CHAIN (2 * MAX_CHAIN_SIZE) // last chain length bin in print_table_stats
+#define OPTIMISTIC_RETRIES 8 // lockless lookup attempts before falling back to the stripe lock
+#define SEQ_RECHECK_STEPS 64 // chain steps between sequence checks in a lockless lookup
+#define STRIPE_GROW_CONTENDED 32 // waits on one stripe before its contention counts
+#define STRIPE_GROW_RATIO 16 // stripes double once 1 in this many acquisitions of one stripe waited
+
+// What the resizing flag is claimed for
+#define RESIZING_NONE 0
+#define RESIZING_BUCKETS 1   // incremental resize in flight
+#define RESIZING_STRIPES 2   // grow_stripes() swapping the stripe array
+
+// __builtin_prefetch wants a constant read/write hint
+#define PREFETCH(addr, for_write) ((for_write) ? __builtin_prefetch((addr), 1) : __builtin_prefetch((addr), 0))
 
-int resize_enabled = 1;
-int speed_test = 0;
-int resize_needed = 0;
 
 /**
  * @struct Item
@@ -48,15 +74,53 @@ int resize_needed = 0;
  * 
  * Essentially represents a "Node" now for the bucket linked list.
  * 
- * @param key uint64_t -> hash table key
- * @param value uint64_t -> item value
+ * Key and value are as wide as spec.h says, a set has no value.
+ * 
+ * @param key spec_key_t -> hash table key
+ * @param value spec_value_t -> item value
  */
 typedef struct Item {
-    uint64_t key; /** @brief hash table key */
-    uint64_t value; /** @brief item value */
+    spec_key_t key; /** @brief hash table key */
+#if TABLE_VALUE_BITS
+    spec_value_t value; /** @brief item value */
+#endif
     struct Item* next; /** @brief next item in bucket linked list */
 } Item;
 
+/**
+ * @brief value of an item that a lockless reader may see change
+ * 
+ * @param item const Item* -> item in a chain
+ * @return uint64_t -> its value (SET_VALUE in a set)
+ */
+static inline uint64_t read_value(const Item* item) {
+#if TABLE_VALUE_BITS
+    spec_value_t value;
+    #pragma omp atomic read acquire
+    value = item->value;
+    return value;
+#else
+    (void)item;
+    return SET_VALUE;
+#endif
+}
+
+/**
+ * @brief update the value of an item lockless readers may be looking at
+ * 
+ * @param item Item* -> item in a chain
+ * @param value uint64_t -> new value (ignored in a set)
+ */
+static inline void write_value(Item* item, uint64_t value) {
+#if TABLE_VALUE_BITS
+    #pragma omp atomic write
+    item->value = (spec_value_t)value;
+#else
+    (void)item;
+    (void)value;
+#endif
+}
+
 /**
  * @struct Bucket
  * @brief Bucket at specific hash index
@@ -69,43 +133,105 @@ typedef struct {
     Item* head; /** @brief head pointer for linked list */
 } Bucket;
 
+/* Marks an old bucket whose chain has already been moved during an
+incremental resize. Never dereferenced. */
+static Item migrated_marker;
+#define MIGRATED_BUCKET (&migrated_marker)
+
+/* With optimistic_reads the stripe is also a seqlock: seq is odd while a
+writer holds the lock, so a lockless reader that saw the same even value
+before and after its walk knows no writer touched the stripe meanwhile.
+acquired, contended and wait_time are only written by the thread holding
+the lock. */
 typedef struct {
-    omp_lock_t lock;
-    char padding[64 - sizeof(omp_lock_t)];
+    volatile uint64_t seq;
+    uint64_t acquired;
+    uint64_t contended;
+    double wait_time;
+    ParkLock lock;
+    char padding[64 - 3 * sizeof(uint64_t) - sizeof(double) - sizeof(ParkLock)];
 } PaddedLock;
 
+/**
+ * @struct StripeArray
+ * @brief the stripe locks and their count, swapped as one pointer
+ * 
+ * The stripes grow on their own when they are contended (grow_stripes),
+ * so a thread must see the count and the array together. A replaced
+ * array is kept on the retired list until the table is destroyed: late
+ * waiters may still be queued on its locks, and its counters still
+ * count.
+ * 
+ * @param num_locks size_t -> number of locks (power of two, at most num_buckets)
+ * @param retired StripeArray* -> the array this one replaced
+ * @param locks PaddedLock[] -> the locks
+ */
+typedef struct StripeArray {
+    size_t num_locks; /** @brief number of locks (power of two, at most num_buckets) */
+    struct StripeArray* retired; /** @brief the array this one replaced */
+    char padding[64 - sizeof(size_t) - sizeof(struct StripeArray*)];
+
+    PaddedLock locks[]; /** @brief the locks */
+} StripeArray;
+
 /**
  * @struct ChainedHashTable
  * @brief chained hash table
  * 
  * @param buckets Bucket* -> pointer to array of buckets
  * @param num_buckets size_t -> number of buckets
- * @param locks omp_lock_t* -> pointer to array of locks
- * @param num_locks size_t -> number of locks
- * @param num_items volatile int -> number of items in the table (metric purposes)
+ * @param stripes StripeArray* -> current stripe locks
+ * @param grow_stripes volatile int -> a stripe crossed the contention threshold
+ * @param stripe_grows size_t -> times the stripes doubled on their own
+ * @param old_buckets Bucket* -> array being drained by an incremental resize
+ * @param old_num_buckets size_t -> number of buckets in old_buckets
+ * @param pool ItemPool* -> allocator for every Item in the table
+ * @param epoch EpochDomain* -> reclamation for lockless readers (optimistic_reads)
+ * @param config TableConfig -> settings this table was created with
+ * @param resize_needed volatile int -> POLICY_* reason once the policy asks for resize(), cleared by resize()
+ * @param long_chains volatile uint64_t -> inserts that found an overlong chain since the last resize
+ * @param stats StatsCounters* -> per-thread counters, handed to the next table on resize
+ * @param resize_started double -> omp_get_wtime() when the running incremental resize began
+ * @param hot_id uint64_t -> id of the table in the hot key caches, see hot.h
  */
 struct ChainedHashTable{
     Bucket* buckets; /** @brief pointer to array of buckets */
     size_t num_buckets; /** @brief number of buckets */
 
-    PaddedLock* locks; /** @brief pointer to array of locks */
-    size_t num_locks; /** @brief number of locks */
+    StripeArray* volatile stripes; /** @brief current stripe locks, only replaced while holding all of them */
+    volatile int grow_stripes; /** @brief a stripe crossed the contention threshold */
+    size_t stripe_grows; /** @brief times the stripes doubled on their own */
+
+    Bucket* old_buckets; /** @brief array being drained by an incremental resize (NULL when idle) */
+    size_t old_num_buckets; /** @brief number of buckets in old_buckets */
+    volatile size_t migrate_cursor; /** @brief next old bucket handed out to a helping thread */
+    volatile size_t migrated_buckets; /** @brief number of old buckets already moved */
+    volatile int resizing; /** @brief RESIZING_BUCKETS or RESIZING_STRIPES while one of them is in flight */
+
+    ItemPool* pool; /** @brief allocator for every Item in the table, handed to the next table on resize */
+    EpochDomain* epoch; /** @brief lockless readers may still hold removed items and drained arrays */
 
-    volatile int num_items; /** @brief number of items in the table (metric purposes) */
+    TableConfig config; /** @brief settings this table was created with */
+    volatile int resize_needed; /** @brief POLICY_* reason once the policy asks for resize(), cleared by resize() */
+    volatile uint64_t long_chains; /** @brief inserts that found an overlong chain since the last resize */
+
+    StatsCounters* stats; /** @brief per-thread counters, handed to the next table on resize */
+    double resize_started; /** @brief omp_get_wtime() when the running incremental resize began */
+    uint64_t hot_id; /** @brief id of the table in the hot key caches, see hot.h */
 };
 
 /**
  * @brief hash function
  * 
- * Now the only hash funtion.
+ * Now the only hash funtion. Mixer comes from hash.h.
  * 
+ * @param chained ChainedHashTable* -> table whose mixer to use
  * @param key uint64_t -> hash table key
- * @param num_buckets size_t -> number of hash table buckets
+ * @param num_buckets size_t -> number of hash table buckets (power of two)
  * @return size_t -> hash1 index
  */
-size_t hash1(uint64_t key, size_t num_buckets) {
-    key = (key * 37) + 13;
-    return key % num_buckets;
+size_t hash1(ChainedHashTable* chained, uint64_t key, size_t num_buckets) {
+    return hash_key(key, chained->config.hash_function) & (num_buckets - 1);
 }
 
 /**
@@ -115,37 +241,123 @@ size_t hash1(uint64_t key, size_t num_buckets) {
  * This is the same as chained, a number of buckets have shared locks
  * for memory saving purposes.
  * 
- * @param chained ChainedHashTable* -> specific chained table
- * @param bucket_index size_t -> bucket index in table
+ * Because num_locks divides num_buckets, the full hash of a key gives the
+ * same stripe as any of its bucket indexes.
+ * 
+ * @param stripes StripeArray* -> stripe locks of the table
+ * @param bucket_index size_t -> bucket index in table (or hash)
  * @return size_t -> lock index
  */
-size_t get_lock_idx(ChainedHashTable* chained, size_t bucket_index) {
-    return bucket_index % chained->num_locks;
+size_t get_lock_idx(StripeArray* stripes, size_t bucket_index) {
+    return bucket_index & (stripes->num_locks - 1);
+}
+
+/**
+ * @brief Create a stripe array of free locks
+ * 
+ * @param num_locks size_t -> number of locks (power of two)
+ * @param numa int -> interleave the locks over the nodes
+ * @return StripeArray*
+ */
+static StripeArray* create_stripes(size_t num_locks, int numa) {
+    size_t bytes = sizeof(StripeArray) + num_locks * sizeof(PaddedLock);
+    StripeArray* stripes = aligned_alloc(64, bytes);
+
+    // Before anything touches them, aligned_alloc leaves fresh pages alone
+    if (numa) {
+        numa_interleave(stripes, bytes);
+    }
+
+    stripes->num_locks = num_locks;
+    stripes->retired = NULL;
+
+    for (size_t i = 0; i < num_locks; i++) {
+        stripes->locks[i].seq = 0;
+        stripes->locks[i].acquired = 0;
+        stripes->locks[i].contended = 0;
+        stripes->locks[i].wait_time = 0.0;
+        park_lock_init(&stripes->locks[i].lock);
+    }
+
+    return stripes;
+}
+
+/**
+ * @brief allocate a zeroed bucket array, placed as the config says
+ * 
+ * @param config const TableConfig* -> numa and huge_pages
+ * @param num_buckets size_t -> buckets in the array
+ * @return Bucket* 
+ */
+static Bucket* alloc_buckets(const TableConfig* config, size_t num_buckets) {
+    if (config->huge_pages) {
+        return huge_alloc(num_buckets * sizeof(Bucket), config->numa ? HUGE_PLACE_INTERLEAVE : HUGE_PLACE_ANY);
+    }
+
+    Bucket* buckets = calloc(num_buckets, sizeof(Bucket));
+
+    // Before anything touches them, calloc leaves fresh pages alone
+    if (config->numa) {
+        numa_interleave(buckets, num_buckets * sizeof(Bucket));
+    }
+
+    return buckets;
 }
 
 /**
  * @brief Create chained hash table
  * 
+ * Both counts are rounded up to powers of two so indexes can be masked.
+ * 
  * @param num_buckets size_t -> initial number of buckets
  * @param num_locks size_t -> initial number of locks
+ * @param config const TableConfig* -> settings to copy (NULL for TABLE_CONFIG_DEFAULT)
  * @return ChainedHashTable* 
  */
-ChainedHashTable* create_table(size_t num_buckets, size_t num_locks) {
+ChainedHashTable* create_table(size_t num_buckets, size_t num_locks, const TableConfig* config) {
     ChainedHashTable* chained = malloc(sizeof(ChainedHashTable));
+    TableConfig default_config = TABLE_CONFIG_DEFAULT;
 
-    chained->num_buckets = num_buckets;
-    chained->num_locks = num_locks;
+    chained->config = config ? *config : default_config;
+    spec_config(&chained->config);
+    policy_config(&chained->config);
+    chained->resize_needed = 0;
+    chained->long_chains = 0;
 
-    chained->num_items = 0; // Metric purposes
+    // Cached values are checked against the stripe sequence, which only lockless readers keep
+    if (chained->config.hot_keys & HOT_CACHE) {
+        chained->config.optimistic_reads = 1;
+    }
+    chained->hot_id = hot_table_id();
 
-    chained->buckets = calloc(num_buckets, sizeof(Bucket));
-    chained->locks = malloc(num_locks * sizeof(PaddedLock));
+    num_buckets = policy_initial_buckets(&chained->config, num_buckets, 1);
+    num_locks = round_up_pow2(num_locks);
 
-    // omp_init_lock must be used to initialize every lock
-    for (size_t i = 0; i < num_locks; i++) {
-        omp_init_lock(&chained->locks[i].lock);
+    // More stripes than buckets buys nothing, and this keeps locks dividing buckets
+    if (num_locks > num_buckets) {
+        num_locks = num_buckets;
     }
 
+    chained->num_buckets = num_buckets;
+
+    chained->stats = stats_create();
+    chained->resize_started = 0.0;
+
+    chained->old_buckets = NULL;
+    chained->old_num_buckets = 0;
+    chained->migrate_cursor = 0;
+    chained->migrated_buckets = 0;
+    chained->resizing = 0;
+
+    chained->pool = pool_create(sizeof(Item), chained->config.numa, chained->config.huge_pages);
+    chained->epoch = epoch_create();
+
+    chained->buckets = alloc_buckets(&chained->config, num_buckets);
+
+    chained->stripes = create_stripes(num_locks, chained->config.numa);
+    chained->grow_stripes = 0;
+    chained->stripe_grows = 0;
+
     return chained;
 }
 
@@ -156,217 +368,1401 @@ ChainedHashTable* create_table(size_t num_buckets, size_t num_locks) {
  */
 void destroy_table(ChainedHashTable* chained) {
 
-    // Iterate over all buckets and free each linked list node
-    for (size_t i = 0; i < chained->num_buckets; i++) {
-        Item* curr = chained->buckets[i].head;
-        while (curr != NULL) {
-            Item* temp = curr;
-            curr = curr->next;
-            free(temp);
-        }
+    // Frees whatever lockless readers could still have been holding, needs the pool
+    epoch_destroy(chained->epoch);
+
+    // Every linked list node lives in the pool, release them all at once
+    if (chained->pool != NULL) {
+        pool_destroy(chained->pool);
+    }
+
+    // An incremental resize may still be in flight
+    if (chained->config.huge_pages) {
+        huge_free(chained->old_buckets);
+        huge_free(chained->buckets);
+    } else {
+        free(chained->old_buckets);
+        free(chained->buckets);
     }
 
-    // use omp_destroy_lock to remove each lock
-    for (size_t i =0; i < chained->num_locks; i++) {
-        omp_destroy_lock(&chained->locks[i].lock);
+    stats_destroy(chained->stats);
+
+    // Stripe arrays that grew away were never freed, late waiters could be on them
+    StripeArray* stripes = chained->stripes;
+    while (stripes != NULL) {
+        StripeArray* temp = stripes;
+        stripes = stripes->retired;
+        free(temp);
     }
 
-    free(chained->locks);
-    free(chained->buckets);
     free(chained);
 }
 
 /**
- * @brief lookup key in chained table
+ * @brief take one stripe's lock and count the acquisition
  * 
- * @param chained ChainedHashTable -> specific chained table
- * @param key uint64_t -> key value (must not be INVALID_KEY)
- * @return uint64_t -> value at key (INVALID_VALUE if key not found)
+ * The clock is only read when the lock is already taken, an uncontended
+ * acquire is the one compare and set of park_trylock().
+ * 
+ * @param stripe PaddedLock* -> stripe to lock
+ * @return int -> 1 if the caller had to wait
  */
-uint64_t lookup(ChainedHashTable* chained, uint64_t key) {
+static inline int stripe_acquire(PaddedLock* stripe) {
+    int waited = 0;
 
-    if (key == INVALID_KEY) {
-        //printf("key must not equal INVALID_KEY value (uint64 max)");
-        return INVALID_VALUE;
+    if (!park_trylock(&stripe->lock)) {
+        double wait_start = omp_get_wtime();
+        park_lock_slow(&stripe->lock);
+        stripe->contended++;
+        stripe->wait_time += omp_get_wtime() - wait_start;
+        waited = 1;
     }
 
-    size_t bucket = hash1(key, chained->num_buckets);
-    size_t lock_idx = get_lock_idx(chained, bucket);
+    stripe->acquired++;
+    return waited;
+}
 
-    uint64_t value = INVALID_VALUE;
+/**
+ * @brief ask for more stripes if this one is contended
+ * 
+ * Caller holds stripe and just waited for it. The stripes can not grow
+ * from here, grow_stripes() needs all of them, so the operation does it
+ * once it has unlocked (after_op).
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param stripes StripeArray* -> current stripes
+ * @param stripe PaddedLock* -> stripe the caller holds
+ */
+static inline void check_contention(ChainedHashTable* chained, StripeArray* stripes, PaddedLock* stripe) {
+    if (stripe->contended < STRIPE_GROW_CONTENDED || stripe->contended * STRIPE_GROW_RATIO < stripe->acquired) {
+        return;
+    }
 
-    omp_set_lock(&chained->locks[lock_idx].lock);
+    size_t num_buckets;
 
-    Item* curr = chained->buckets[bucket].head;
+    #pragma omp atomic read
+    num_buckets = chained->num_buckets;
 
-    while (curr != NULL) {
-        if (curr->key == key) {
-            value = curr->value;
-            break;
-        }
-        curr = curr->next;
+    if (stripes->num_locks < num_buckets && !chained->grow_stripes) {
+        #pragma omp atomic write
+        chained->grow_stripes = 1;
     }
+}
+
+/**
+ * @brief acquire the stripe lock of a key
+ * 
+ * With optimistic_reads the stripe sequence goes odd for as long as the
+ * lock is held. The stripe array may have been replaced while the caller
+ * waited, in which case the lock it got no longer protects anything and
+ * it tries again on the new array. That check is enough because a
+ * replacement holds every stripe of the old array.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param hash size_t -> hash (or bucket index) of the key
+ * @return PaddedLock* -> stripe to hand to stripe_unlock
+ */
+static inline PaddedLock* stripe_lock(ChainedHashTable* chained, size_t hash) {
+    while (1) {
+        StripeArray* stripes;
 
-    omp_unset_lock(&chained->locks[lock_idx].lock);
+        #pragma omp atomic read acquire
+        stripes = chained->stripes;
 
-    return value;
+        PaddedLock* stripe = &stripes->locks[get_lock_idx(stripes, hash)];
+        int waited = stripe_acquire(stripe);
+
+        StripeArray* current;
+
+        #pragma omp atomic read acquire
+        current = chained->stripes;
+
+        if (__builtin_expect(current != stripes, 0)) {
+            // Leave seq alone, a retired array stays odd for lockless readers
+            park_unlock(&stripe->lock);
+            continue;
+        }
+
+        if (waited) {
+            check_contention(chained, stripes, stripe);
+        }
+
+        if (chained->config.optimistic_reads) {
+            // Full barrier, nothing written below may become visible before the odd value
+            #pragma omp atomic update seq_cst
+            stripe->seq++;
+        }
+
+        return stripe;
+    }
 }
 
 /**
- * @brief Insert item into chained table
+ * @brief release one stripe lock
  * 
  * @param chained ChainedHashTable* -> specific chained table
- * @param key uint64_t -> key value (must not be INVALID_KEY)
- * @param value uint64_t -> value value (must not be INVALID_VALUE)
+ * @param stripe PaddedLock* -> stripe from stripe_lock
  */
-void insert(ChainedHashTable* chained, uint64_t key, uint64_t value) {
-    if (key == INVALID_KEY) {
-        //printf("key must not equal INVALID_KEY value (uint64 max)");
-        return;
-    } else if (value == INVALID_VALUE) {
-        //printf("value must not equal INVALID_VALUE value (uint64 max)");
-        return;
+static inline void stripe_unlock(ChainedHashTable* chained, PaddedLock* stripe) {
+    if (chained->config.optimistic_reads) {
+        #pragma omp atomic write release
+        stripe->seq = stripe->seq + 1;
     }
 
-    size_t bucket = hash1(key, chained->num_buckets);
-    size_t lock_idx = get_lock_idx(chained, bucket);
-
-    int succeeded = 0;
-    int added_node = 0;
+    park_unlock(&stripe->lock);
+}
 
-    omp_set_lock(&chained->locks[lock_idx].lock);
+/**
+ * @brief acquire every stripe lock in index order
+ * 
+ * Only used to publish or retire a bucket array during an incremental
+ * resize, or to replace the stripes. Those are claimed through the
+ * resizing flag one at a time, so the array can not change underneath.
+ * Normal operations never hold more than one stripe, so taking them in
+ * order can not deadlock.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @return StripeArray* -> stripes now held
+ */
+static StripeArray* lock_all_stripes(ChainedHashTable* chained) {
+    StripeArray* stripes = chained->stripes;
 
-    // Check if key already exists in the linked list
-    Item* curr = chained->buckets[bucket].head;
-    int depth = 0;
+    for (size_t i = 0; i < stripes->num_locks; i++) {
+        stripe_acquire(&stripes->locks[i]);
 
-    while (curr != NULL) {
-        if (curr->key == key) {
-            curr->value = value;
-            succeeded = 1;
-            break;
+        if (chained->config.optimistic_reads) {
+            #pragma omp atomic update seq_cst
+            stripes->locks[i].seq++;
         }
-        depth++;
-        curr = curr->next;
     }
+    return stripes;
+}
 
-    if (succeeded) {
-        omp_unset_lock(&chained->locks[lock_idx].lock);
-        return;
+/**
+ * @brief release every stripe lock
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param stripes StripeArray* -> stripes from lock_all_stripes
+ */
+static void unlock_all_stripes(ChainedHashTable* chained, StripeArray* stripes) {
+    for (size_t i = 0; i < stripes->num_locks; i++) {
+        stripe_unlock(chained, &stripes->locks[i]);
     }
+}
 
-    /* The add section conforms to previous work done on 
-    creating a concurrent queue. A compare and set should
-    work here for the lock-free version, which is much
-    simpler than the previous two bucket situation of the
-    cuckoo hash table. */
+/**
+ * @brief Double the stripes without touching the buckets
+ * 
+ * Called outside any lock once a stripe crossed the contention threshold.
+ * Claims the resizing flag, so it never runs during an incremental resize
+ * (whose stripe count must stay fixed) and two threads never grow at
+ * once. The old array is held whole while the new one is published, and
+ * its locks are then released without ending the odd sequence values:
+ * a lockless reader still looking at the old array retries and picks up
+ * the new one.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ */
+static void grow_stripes(ChainedHashTable* chained) {
+    int was_resizing = 1;
 
-    // Add new item
-    Item* add_item = malloc(sizeof(Item));
-    add_item->key = key;
-    add_item->value = value;
-    add_item->next = chained->buckets[bucket].head;
-    chained->buckets[bucket].head = add_item;
+    #pragma omp atomic compare capture
+    {
+        was_resizing = chained->resizing;
+        if (chained->resizing == RESIZING_NONE) {
+            chained->resizing = RESIZING_STRIPES;
+        }
+    }
 
-    added_node = 1;
+    if (was_resizing != RESIZING_NONE) {
+        return; // asked again by the next contended acquire
+    }
 
-    omp_unset_lock(&chained->locks[lock_idx].lock);
+    StripeArray* curr = chained->stripes;
 
-    /* Currently debating two design decisions regarding resizing.
-    Fixed-size: no need for traking current items, no need for running
-    resize function. Obvious performance gains but loses modularity.
-    
-    Dynamic-size: need some metric to determine when to resize, need
-    to periodically resize. High contention on total item counter will
-    slow down the parallelism 
-    
-    I think I will analyze both. I need to find a better way to track
-    resizing that doesn't rely on a single counter. */
+    // More stripes than buckets buys nothing, and this keeps locks dividing buckets
+    if (curr->num_locks < chained->num_buckets) {
+        StripeArray* next = create_stripes(curr->num_locks * 2, chained->config.numa);
+        next->retired = lock_all_stripes(chained);
 
-    if (added_node) {
-        int current_items;
+        #pragma omp atomic write release
+        chained->stripes = next;
+
+        chained->stripe_grows++;
 
-        if (!speed_test) {
-            #pragma omp atomic capture
-            current_items = ++chained->num_items;
+        for (size_t i = 0; i < curr->num_locks; i++) {
+            park_unlock(&curr->locks[i].lock);
         }
+    }
 
-        if (resize_enabled && depth >= MAX_CHAIN_SIZE) {
-            int temp_resize = 0;
+    #pragma omp atomic write
+    chained->grow_stripes = 0;
 
-            #pragma omp atomic read
-            temp_resize = resize_needed;
+    #pragma omp atomic write
+    chained->resizing = RESIZING_NONE;
+}
 
-            if (!temp_resize) {
-                #pragma omp atomic write
-                resize_needed = 1;
-            }
+/**
+ * @brief Start an incremental resize
+ * 
+ * The new bucket array is swapped in while holding every stripe, so any
+ * thread holding a single stripe sees a consistent old/new pair. No items
+ * are moved here, that is left to migrate_bucket().
+ * 
+ * The stripe count stays fixed during incremental resizing (grow_stripes
+ * waits for the resizing flag). Because the number of locks divides the
+ * number of buckets, an old bucket and both of the buckets it splits
+ * into share the same stripe.
+ * 
+ * The decision is recorded here, an incremental resize always doubles.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param reason int -> POLICY_* reason for the resize
+ */
+static void start_incremental_resize(ChainedHashTable* chained, int reason) {
+    int was_resizing = 1;
+
+    #pragma omp atomic compare capture
+    {
+        was_resizing = chained->resizing;
+        if (chained->resizing == RESIZING_NONE) {
+            chained->resizing = RESIZING_BUCKETS;
         }
     }
+
+    if (was_resizing != RESIZING_NONE) {
+        return; // someone else is already growing the table (a chain that stays long asks again)
+    }
+
+    size_t next_num_buckets = chained->num_buckets * 2; // Double size every resize
+    Bucket* next_buckets = alloc_buckets(&chained->config, next_num_buckets);
+
+    StripeArray* stripes = lock_all_stripes(chained);
+
+    chained->resize_started = stats_resize_begin();
+    chained->old_buckets = chained->buckets;
+    chained->old_num_buckets = chained->num_buckets;
+    chained->migrate_cursor = 0;
+    chained->migrated_buckets = 0;
+
+    chained->buckets = next_buckets;
+
+    #pragma omp atomic write
+    chained->num_buckets = next_num_buckets;
+
+    policy_record(&chained->config, chained->stats, reason, chained->old_num_buckets, next_num_buckets, 1, chained->long_chains);
+
+    #pragma omp atomic write
+    chained->long_chains = 0;
+
+    unlock_all_stripes(chained, stripes);
 }
 
 /**
- * @brief Thread safe insert to be used during resize
+ * @brief act on a resize the policy asked for
  * 
- * @param chained ChainedHashTable** -> pointer to chained tabl
- * @param key uint64_t -> key value
- * @param value uint64_t -> value value
+ * Starts an incremental resize right away, or leaves the reason for the
+ * driver's next needs_resize() (the first reason wins).
+ * 
+ * @param chained ChainedHashTable* -> table that wants a new size
+ * @param reason int -> POLICY_* reason, POLICY_KEEP does nothing
  */
-void resize_insert(ChainedHashTable* chained, uint64_t key, uint64_t value) {
-    size_t bucket = hash1(key, chained->num_buckets);
-    size_t lock_idx = get_lock_idx(chained, bucket);
+static void request_resize(ChainedHashTable* chained, int reason) {
+    if (reason == POLICY_KEEP) {
+        return;
+    }
 
-    omp_set_lock(&chained->locks[lock_idx].lock);
+    if (chained->config.incremental_resize) {
+        start_incremental_resize(chained, reason);
+        return;
+    }
 
-    Item* add_item = malloc(sizeof(Item));
-    add_item->key = key;
-    add_item->value = value;
-    add_item->next = chained->buckets[bucket].head;
-    chained->buckets[bucket].head = add_item;
+    int temp_resize = 0;
 
-    omp_unset_lock(&chained->locks[lock_idx].lock);
+    #pragma omp atomic read
+    temp_resize = chained->resize_needed;
+
+    if (!temp_resize) {
+        #pragma omp atomic write
+        chained->resize_needed = reason;
+    }
 }
 
 /**
- * @brief Resize chained table
+ * @brief Finish an incremental resize once every old bucket has moved
  * 
- * @param chained_pointer chained table to resize
+ * Taking every stripe guarantees no locked operation is still looking at
+ * old_buckets. Lockless readers might be, so with optimistic_reads the
+ * array goes to the epoch domain instead.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
  */
-void resize(ChainedHashTable** chained_pointer) {
-
-    static ChainedHashTable* next_chained = NULL;
-    ChainedHashTable* curr_chained = *chained_pointer;
+static void finish_incremental_resize(ChainedHashTable* chained) {
+    StripeArray* stripes = lock_all_stripes(chained);
 
-    #pragma omp barrier
+    void (*free_buckets)(void*) = chained->config.huge_pages ? huge_free : free;
 
-    #pragma omp single
-    {
-        size_t next_num_buckets = curr_chained->num_buckets * 2; // Double size every resize
-        size_t next_num_locks = curr_chained->num_locks * 2;
-        next_chained = create_table(next_num_buckets, next_num_locks);
-        next_chained->num_items = curr_chained->num_items;
+    if (chained->config.optimistic_reads) {
+        epoch_retire(chained->epoch, chained->old_buckets, free_buckets);
+    } else {
+        free_buckets(chained->old_buckets);
     }
+    chained->old_buckets = NULL;
+    chained->old_num_buckets = 0;
 
-    #pragma omp barrier
+    stats_resize(chained->stats, chained->resize_started);
 
-    #pragma omp for
-    for (size_t i = 0; i < curr_chained->num_buckets; i++) {
-        Item* curr = curr_chained->buckets[i].head;
-        while (curr != NULL) {
-            resize_insert(next_chained, curr->key, curr->value);
-            curr = curr->next;
-        }
+    unlock_all_stripes(chained, stripes);
+
+    #pragma omp atomic write
+    chained->resizing = RESIZING_NONE;
+}
+
+/**
+ * @brief Move one old bucket into the new bucket array
+ * 
+ * Caller must hold the stripe lock of old_bucket. Nodes are relinked
+ * rather than copied since every reader of this chain holds the same lock.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param old_bucket size_t -> index into old_buckets
+ * @return int -> 1 if this was the last old bucket (caller must finish the resize)
+ */
+static int migrate_bucket(ChainedHashTable* chained, size_t old_bucket) {
+    Item* curr = chained->old_buckets[old_bucket].head;
+
+    if (curr == MIGRATED_BUCKET) {
+        return 0;
     }
 
-    #pragma omp single 
-    {
-        *chained_pointer = next_chained;
-        destroy_table(curr_chained);
-        next_chained = NULL;
+    while (curr != NULL) {
+        Item* next = curr->next;
+        size_t bucket = hash1(chained, curr->key, chained->num_buckets);
+
+        // Atomic so a lockless reader never sees a torn pointer
+        #pragma omp atomic write
+        curr->next = chained->buckets[bucket].head;
 
         #pragma omp atomic write
-        resize_needed = 0;
+        chained->buckets[bucket].head = curr;
+
+        curr = next;
     }
 
-    #pragma omp barrier
-}
\ No newline at end of file
+    #pragma omp atomic write
+    chained->old_buckets[old_bucket].head = MIGRATED_BUCKET;
+
+    size_t done;
+
+    #pragma omp atomic capture
+    done = ++chained->migrated_buckets;
+
+    return done == chained->old_num_buckets;
+}
+
+/**
+ * @brief Make sure the old bucket holding key has been moved
+ * 
+ * Caller must hold the stripe lock of key.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param key uint64_t -> key about to be accessed
+ * @return int -> 1 if the caller must finish the resize after unlocking
+ */
+static int migrate_key_bucket(ChainedHashTable* chained, uint64_t key) {
+    if (chained->old_buckets == NULL) {
+        return 0;
+    }
+    return migrate_bucket(chained, hash1(chained, key, chained->old_num_buckets));
+}
+
+/**
+ * @brief Move a few more old buckets on behalf of an incremental resize
+ * 
+ * Called after every lookup/insert (outside any lock) so the migration
+ * progresses even for buckets nobody touches.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ */
+static void help_incremental_resize(ChainedHashTable* chained) {
+    int resizing;
+
+    #pragma omp atomic read
+    resizing = chained->resizing;
+
+    if (resizing != RESIZING_BUCKETS) {
+        return;
+    }
+
+    for (int i = 0; i < MIGRATE_BATCH; i++) {
+        size_t old_bucket;
+
+        #pragma omp atomic capture
+        old_bucket = chained->migrate_cursor++;
+
+        // Same stripe as the old bucket because num_locks divides old_num_buckets
+        int finished = 0;
+        int exhausted = 0;
+
+        PaddedLock* stripe = stripe_lock(chained, old_bucket);
+
+        if (chained->old_buckets == NULL || old_bucket >= chained->old_num_buckets) {
+            exhausted = 1;
+        } else {
+            finished = migrate_bucket(chained, old_bucket);
+        }
+
+        stripe_unlock(chained, stripe);
+
+        if (finished) {
+            finish_incremental_resize(chained);
+        }
+
+        if (finished || exhausted) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Resize bookkeeping done after every locked operation
+ * 
+ * Helps a running incremental resize, and grows the stripes if a stripe
+ * asked for it. Both need the caller to hold no stripe.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param finish_resize int -> operation moved the last old bucket
+ */
+static inline void after_op(ChainedHashTable* chained, int finish_resize) {
+    if (chained->config.incremental_resize) {
+        if (finish_resize) {
+            finish_incremental_resize(chained);
+        } else {
+            help_incremental_resize(chained);
+        }
+    }
+
+    int grow;
+
+    #pragma omp atomic read
+    grow = chained->grow_stripes;
+
+    if (__builtin_expect(grow, 0)) {
+        grow_stripes(chained);
+    }
+}
+
+/**
+ * @brief move an item to the head of its chain (HOT_MOVE_TO_FRONT)
+ * 
+ * Caller holds the stripe, so lockless readers see it odd and retry. The
+ * chain has no cycle at any step, a reader standing on the item only
+ * walks the chain again from the head.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param bucket Bucket* -> bucket of the chain
+ * @param prev Item* -> item right before curr
+ * @param curr Item* -> item to move
+ */
+static void move_to_front(ChainedHashTable* chained, Bucket* bucket, Item* prev, Item* curr) {
+    #pragma omp atomic write
+    prev->next = curr->next;
+
+    #pragma omp atomic write
+    curr->next = bucket->head;
+
+    #pragma omp atomic write release
+    bucket->head = curr;
+
+    stats_hot_move(chained->stats);
+}
+
+/**
+ * @brief move a hot item a lockless lookup found deep in its chain to the front
+ * 
+ * Takes the stripe like a writer, the item may have moved (or gone) since.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param key uint64_t -> key of the item
+ */
+static void promote(ChainedHashTable* chained, uint64_t key) {
+    size_t bucket = hash1(chained, key, chained->num_buckets);
+    int finish_resize = 0;
+
+    PaddedLock* stripe = stripe_lock(chained, bucket);
+
+    if (chained->config.incremental_resize) {
+        finish_resize = migrate_key_bucket(chained, key);
+        bucket = hash1(chained, key, chained->num_buckets);
+    }
+
+    Item* prev = NULL;
+    Item* curr = chained->buckets[bucket].head;
+    size_t depth = 0;
+
+    while (curr != NULL && curr->key != key) {
+        prev = curr;
+        curr = curr->next;
+        depth++;
+    }
+
+    if (curr != NULL && depth >= HOT_MOVE_DEPTH) {
+        move_to_front(chained, &chained->buckets[bucket], prev, curr);
+    }
+
+    stripe_unlock(chained, stripe);
+
+    after_op(chained, finish_resize);
+}
+
+/**
+ * @brief lookup key without taking its stripe (optimistic_reads)
+ * 
+ * Seqlock read. The table layout (bucket arrays and their sizes) only
+ * changes while every stripe is held, so it is checked against the
+ * stripe sequence before any bucket is touched. The chain walk is checked
+ * again at the end. Removed items and drained arrays are retired to the
+ * epoch domain, so whatever a torn walk dereferences is still valid
+ * memory. Caller must be inside an epoch critical section.
+ * 
+ * The stripe is found from the hash alone: num_locks divides num_buckets,
+ * so it is the same for the old and the new bucket of key. It is looked
+ * up again on every attempt, a stripe array that grew away stays odd.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param key uint64_t -> key value
+ * @param hash uint64_t -> full hash of key
+ * @param value_out uint64_t* -> value at key (INVALID_VALUE if key not found)
+ * @param stripe_out PaddedLock** -> stripe the read was checked against
+ * @param seq_out uint64_t* -> its sequence during the read
+ * @param depth_out size_t* -> chain items walked before the key
+ * @return int -> 1 if the read was consistent, 0 if writers kept getting in the way
+ */
+static int optimistic_lookup(ChainedHashTable* chained, uint64_t key, uint64_t hash, uint64_t* value_out, PaddedLock** stripe_out, uint64_t* seq_out, size_t* depth_out) {
+    for (int attempt = 0; attempt < OPTIMISTIC_RETRIES; attempt++) {
+        StripeArray* stripes;
+
+        #pragma omp atomic read seq_cst
+        stripes = chained->stripes;
+
+        PaddedLock* stripe = &stripes->locks[get_lock_idx(stripes, hash)];
+        uint64_t seq_start;
+
+        #pragma omp atomic read seq_cst
+        seq_start = stripe->seq;
+
+        if (seq_start & 1) {
+            continue; // writer inside
+        }
+
+        size_t num_buckets;
+        Bucket* buckets;
+        size_t old_num_buckets;
+        Bucket* old_buckets;
+
+        #pragma omp atomic read seq_cst
+        num_buckets = chained->num_buckets;
+
+        #pragma omp atomic read seq_cst
+        buckets = chained->buckets;
+
+        #pragma omp atomic read seq_cst
+        old_num_buckets = chained->old_num_buckets;
+
+        #pragma omp atomic read seq_cst
+        old_buckets = chained->old_buckets;
+
+        uint64_t seq_now;
+
+        #pragma omp atomic read seq_cst
+        seq_now = stripe->seq;
+
+        if (seq_now != seq_start) {
+            continue; // layout may be torn, do not touch it
+        }
+
+        Item* curr = NULL;
+        int use_new = 1;
+
+        // Until the old bucket is moved the key still lives there
+        if (old_buckets != NULL) {
+            #pragma omp atomic read acquire
+            curr = old_buckets[hash & (old_num_buckets - 1)].head;
+
+            use_new = (curr == MIGRATED_BUCKET);
+        }
+
+        if (use_new) {
+            #pragma omp atomic read acquire
+            curr = buckets[hash & (num_buckets - 1)].head;
+        }
+
+        uint64_t value = INVALID_VALUE;
+        int steps = 0;
+        int torn = 0;
+
+        while (curr != NULL) {
+            if (curr->key == key) {
+                value = read_value(curr);
+                break;
+            }
+
+            // A walk racing a migration could wander, bail out early
+            if (++steps % SEQ_RECHECK_STEPS == 0) {
+                #pragma omp atomic read seq_cst
+                seq_now = stripe->seq;
+
+                if (seq_now != seq_start) {
+                    torn = 1;
+                    break;
+                }
+            }
+
+            #pragma omp atomic read acquire
+            curr = curr->next;
+        }
+
+        #pragma omp atomic read seq_cst
+        seq_now = stripe->seq;
+
+        if (!torn && seq_now == seq_start) {
+            stats_depth(chained->stats, steps);
+            *value_out = value;
+            *stripe_out = stripe;
+            *seq_out = seq_start;
+            *depth_out = steps;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief lookup key in chained table
+ * 
+ * With optimistic_reads the stripe is only taken when lockless attempts
+ * keep colliding with writers. With HOT_CACHE a value read that way is
+ * offered to the thread's hot key cache, good until the stripe sequence
+ * moves.
+ * 
+ * @param chained ChainedHashTable -> specific chained table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> value at key (INVALID_VALUE if key not found)
+ */
+uint64_t lookup(ChainedHashTable* chained, uint64_t key) {
+
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return INVALID_VALUE;
+    }
+
+    int hot_keys = chained->config.hot_keys;
+
+    if (chained->config.optimistic_reads) {
+        uint64_t hash = hash_key(key, chained->config.hash_function);
+        uint64_t optimistic_value;
+
+        if ((hot_keys & HOT_CACHE) && hot_get(chained->hot_id, key, hash, &optimistic_value)) {
+            stats_hot_hit(chained->stats);
+            if (chained->config.incremental_resize) {
+                help_incremental_resize(chained);
+            }
+            return optimistic_value;
+        }
+
+        PaddedLock* stripe;
+        uint64_t seq;
+        size_t depth;
+
+        epoch_enter(chained->epoch);
+        int consistent = optimistic_lookup(chained, key, hash, &optimistic_value, &stripe, &seq, &depth);
+        epoch_exit(chained->epoch);
+
+        if (consistent) {
+            if ((hot_keys & HOT_CACHE) && optimistic_value != INVALID_VALUE) {
+                hot_put(chained->hot_id, key, hash, optimistic_value, &stripe->seq, seq);
+            }
+
+            if ((hot_keys & HOT_MOVE_TO_FRONT) && optimistic_value != INVALID_VALUE && depth >= HOT_MOVE_DEPTH && hot_sample()) {
+                promote(chained, key);
+            } else if (chained->config.incremental_resize) {
+                help_incremental_resize(chained);
+            }
+            return optimistic_value;
+        }
+    }
+
+    size_t bucket = hash1(chained, key, chained->num_buckets);
+
+    uint64_t value = INVALID_VALUE;
+    int finish_resize = 0;
+
+    PaddedLock* stripe = stripe_lock(chained, bucket);
+
+    if (chained->config.incremental_resize) {
+        // The table may have doubled before we got the stripe
+        finish_resize = migrate_key_bucket(chained, key);
+        bucket = hash1(chained, key, chained->num_buckets);
+    }
+
+    Item* prev = NULL;
+    Item* curr = chained->buckets[bucket].head;
+    size_t depth = 0;
+
+    while (curr != NULL) {
+        if (curr->key == key) {
+            value = ITEM_VALUE(curr);
+
+            if ((hot_keys & HOT_MOVE_TO_FRONT) && depth >= HOT_MOVE_DEPTH && hot_sample()) {
+                move_to_front(chained, &chained->buckets[bucket], prev, curr);
+            }
+            break;
+        }
+        depth++;
+        prev = curr;
+        curr = curr->next;
+    }
+
+    stripe_unlock(chained, stripe);
+
+    stats_depth(chained->stats, depth);
+
+    after_op(chained, finish_resize);
+
+    return value;
+}
+
+/**
+ * @brief Insert item into chained table
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @param value uint64_t -> value value (must not be INVALID_VALUE)
+ */
+void insert(ChainedHashTable* chained, uint64_t key, uint64_t value) {
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return;
+    } else if (value == INVALID_VALUE) {
+        //printf("value must not equal INVALID_VALUE value (uint64 max)");
+        return;
+    } else if (!spec_storable(key, value)) {
+        // Does not fit a narrow build, see spec.h
+        return;
+    }
+
+    size_t bucket = hash1(chained, key, chained->num_buckets);
+
+    int succeeded = 0;
+    int added_node = 0;
+    int finish_resize = 0;
+
+    PaddedLock* stripe = stripe_lock(chained, bucket);
+
+    if (chained->config.incremental_resize) {
+        // The table may have doubled before we got the stripe
+        finish_resize = migrate_key_bucket(chained, key);
+        bucket = hash1(chained, key, chained->num_buckets);
+    }
+
+    // Check if key already exists in the linked list
+    Item* prev = NULL;
+    Item* curr = chained->buckets[bucket].head;
+    int depth = 0;
+
+    while (curr != NULL) {
+        if (curr->key == key) {
+            write_value(curr, value);
+            succeeded = 1;
+
+            if ((chained->config.hot_keys & HOT_MOVE_TO_FRONT) && depth >= HOT_MOVE_DEPTH && hot_sample()) {
+                move_to_front(chained, &chained->buckets[bucket], prev, curr);
+            }
+            break;
+        }
+        depth++;
+        prev = curr;
+        curr = curr->next;
+    }
+
+    if (succeeded) {
+        stripe_unlock(chained, stripe);
+        stats_depth(chained->stats, depth);
+        after_op(chained, finish_resize);
+        return;
+    }
+
+    /* The add section conforms to previous work done on 
+    creating a concurrent queue. A compare and set should
+    work here for the lock-free version, which is much
+    simpler than the previous two bucket situation of the
+    cuckoo hash table. */
+
+    // Add new item
+    Item* add_item = pool_alloc(chained->pool);
+    add_item->key = key;
+    SET_ITEM_VALUE(add_item, value);
+    add_item->next = chained->buckets[bucket].head;
+
+    // Release, a lockless reader that sees the new head also sees the item
+    #pragma omp atomic write release
+    chained->buckets[bucket].head = add_item;
+
+    added_node = 1;
+
+    stripe_unlock(chained, stripe);
+
+    /* Currently debating two design decisions regarding resizing.
+    Fixed-size: no need for traking current items, no need for running
+    resize function. Obvious performance gains but loses modularity.
+    
+    Dynamic-size: need some metric to determine when to resize, need
+    to periodically resize. High contention on total item counter will
+    slow down the parallelism 
+    
+    I think I will analyze both. I need to find a better way to track
+    resizing that doesn't rely on a single counter. */
+
+    if (added_node) {
+        stats_depth(chained->stats, depth);
+        stats_items(chained->stats, 1);
+
+        if (spec_resize_enabled(&chained->config)) {
+            request_resize(chained, policy_after_add(&chained->config, chained->stats, chained->num_buckets, 1, &chained->long_chains, depth >= MAX_CHAIN_SIZE));
+        }
+    }
+
+    after_op(chained, finish_resize);
+}
+
+/**
+ * @brief Remove key from chained table
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> removed value (INVALID_VALUE if key not found)
+ */
+uint64_t remove_key(ChainedHashTable* chained, uint64_t key) {
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return INVALID_VALUE;
+    }
+
+    size_t bucket = hash1(chained, key, chained->num_buckets);
+
+    uint64_t value = INVALID_VALUE;
+    int finish_resize = 0;
+
+    PaddedLock* stripe = stripe_lock(chained, bucket);
+
+    if (chained->config.incremental_resize) {
+        // The table may have doubled before we got the stripe
+        finish_resize = migrate_key_bucket(chained, key);
+        bucket = hash1(chained, key, chained->num_buckets);
+    }
+
+    // Unlink through the pointer that points at the item
+    Item** prev = &chained->buckets[bucket].head;
+    Item* curr = *prev;
+
+    while (curr != NULL) {
+        if (curr->key == key) {
+            #pragma omp atomic write
+            *prev = curr->next;
+
+            value = ITEM_VALUE(curr);
+
+            // Lockless readers may still be standing on it
+            if (chained->config.optimistic_reads) {
+                epoch_retire(chained->epoch, curr, pool_free);
+            } else {
+                pool_free(curr);
+            }
+            break;
+        }
+        prev = &curr->next;
+        curr = curr->next;
+    }
+
+    stripe_unlock(chained, stripe);
+
+    if (value != INVALID_VALUE) {
+        stats_items(chained->stats, -1);
+
+        if (spec_resize_enabled(&chained->config)) {
+            request_resize(chained, policy_after_remove(&chained->config, chained->stats, chained->num_buckets, 1));
+        }
+    }
+
+    after_op(chained, finish_resize);
+
+    return value;
+}
+
+/**
+ * @brief prefetch what a group of operations is about to touch
+ * 
+ * First pass computes every bucket and prefetches the bucket and its
+ * stripe. Second pass loads the chain heads (those lines are arriving by
+ * now) and prefetches the first item of each chain. The heads are read
+ * without the stripe, which is only safe while bucket arrays can not be
+ * freed under us: no incremental resize, or optimistic_reads where drained
+ * arrays go through the epoch domain.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys of the group
+ * @param n size_t -> number of keys (at most BATCH_GROUP)
+ * @param for_write int -> 1 if the keys are about to be inserted
+ */
+static void prefetch_keys(ChainedHashTable* chained, const uint64_t* keys, size_t n, int for_write) {
+    Bucket* buckets;
+    size_t num_buckets;
+    StripeArray* stripes;
+    size_t bucket_idx[BATCH_GROUP];
+
+    // Before the array is read, an incremental resize may retire it right after
+    if (chained->config.optimistic_reads) {
+        epoch_enter(chained->epoch);
+    }
+
+    #pragma omp atomic read
+    num_buckets = chained->num_buckets;
+
+    #pragma omp atomic read
+    buckets = chained->buckets;
+
+    #pragma omp atomic read
+    stripes = chained->stripes;
+
+    for (size_t i = 0; i < n; i++) {
+        bucket_idx[i] = hash1(chained, keys[i], num_buckets);
+        PREFETCH(&buckets[bucket_idx[i]], for_write);
+        __builtin_prefetch(&stripes->locks[get_lock_idx(stripes, bucket_idx[i])], 1);
+    }
+
+    if (chained->config.incremental_resize && !chained->config.optimistic_reads) {
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        Item* head;
+
+        #pragma omp atomic read
+        head = buckets[bucket_idx[i]].head;
+
+        if (head != NULL && head != MIGRATED_BUCKET) {
+            PREFETCH(head, for_write);
+        }
+    }
+
+    if (chained->config.optimistic_reads) {
+        epoch_exit(chained->epoch);
+    }
+}
+
+/**
+ * @brief lookup many keys in chained table
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys to look up
+ * @param out uint64_t* -> value per key (INVALID_VALUE if key not found)
+ * @param n size_t -> number of keys
+ */
+void lookup_batch(ChainedHashTable* chained, const uint64_t* keys, uint64_t* out, size_t n) {
+    for (size_t start = 0; start < n; start += BATCH_GROUP) {
+        size_t count = (n - start < BATCH_GROUP) ? n - start : BATCH_GROUP;
+
+        prefetch_keys(chained, keys + start, count, 0);
+
+        for (size_t i = start; i < start + count; i++) {
+            out[i] = lookup(chained, keys[i]);
+        }
+    }
+}
+
+/**
+ * @brief Insert many items into chained table
+ * 
+ * With HOT_COMBINE an insert a later one of the same key overwrites is
+ * skipped, see hot.h.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void insert_batch(ChainedHashTable* chained, const uint64_t* keys, const uint64_t* values, size_t n) {
+    unsigned char superseded[HOT_COMBINE_WINDOW];
+    int combine = (chained->config.hot_keys & HOT_COMBINE) != 0;
+
+    for (size_t window = 0; window < n; window += HOT_COMBINE_WINDOW) {
+        size_t window_end = (n - window < HOT_COMBINE_WINDOW) ? n : window + HOT_COMBINE_WINDOW;
+
+        if (combine) {
+            stats_hot_combined(chained->stats, hot_combine(keys + window, values + window, window_end - window, superseded));
+        }
+
+        for (size_t start = window; start < window_end; start += BATCH_GROUP) {
+            size_t count = (window_end - start < BATCH_GROUP) ? window_end - start : BATCH_GROUP;
+
+            prefetch_keys(chained, keys + start, count, 1);
+
+            for (size_t i = start; i < start + count; i++) {
+                if (!combine || !superseded[i - window]) {
+                    insert(chained, keys[i], values[i]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Thread safe insert to be used during resize
+ * 
+ * The item is relinked from the old table, not copied.
+ * 
+ * @param chained ChainedHashTable* -> table being filled
+ * @param item Item* -> item taken out of the old table
+ */
+void resize_insert(ChainedHashTable* chained, Item* item) {
+    size_t bucket = hash1(chained, item->key, chained->num_buckets);
+
+    PaddedLock* stripe = stripe_lock(chained, bucket);
+
+    item->next = chained->buckets[bucket].head;
+    chained->buckets[bucket].head = item;
+
+    stripe_unlock(chained, stripe);
+}
+
+/**
+ * @brief check whether the table asked for resize()
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @return int -> POLICY_* reason if the table wants a new size, 0 otherwise
+ */
+int needs_resize(ChainedHashTable* chained) {
+    int temp_resize;
+
+    #pragma omp atomic read
+    temp_resize = chained->resize_needed;
+
+    return temp_resize;
+}
+
+/**
+ * @brief Create the table a resize moves into
+ * 
+ * The nodes move over as they are, so their pool does too. So do the
+ * counters, with the lock wait of the old stripes (and those they grew
+ * from) folded in. The stripe count changes by the same factor as the
+ * buckets, from wherever contention took it.
+ * 
+ * @param curr_chained ChainedHashTable* -> table being resized
+ * @param next_num_buckets size_t -> buckets of the new table (power of two)
+ * @return ChainedHashTable* -> empty table with next_num_buckets buckets
+ */
+static ChainedHashTable* create_next_table(ChainedHashTable* curr_chained, size_t next_num_buckets) {
+    size_t next_num_locks = curr_chained->stripes->num_locks * next_num_buckets / curr_chained->num_buckets;
+    ChainedHashTable* next_chained = create_table(next_num_buckets, next_num_locks, &curr_chained->config);
+
+    pool_destroy(next_chained->pool);
+    next_chained->pool = curr_chained->pool;
+    curr_chained->pool = NULL;
+
+    for (StripeArray* stripes = curr_chained->stripes; stripes != NULL; stripes = stripes->retired) {
+        for (size_t i = 0; i < stripes->num_locks; i++) {
+            curr_chained->stats->lock_contended += stripes->locks[i].contended;
+            curr_chained->stats->lock_wait += stripes->locks[i].wait_time;
+        }
+    }
+
+    stats_destroy(next_chained->stats);
+    next_chained->stats = curr_chained->stats;
+    curr_chained->stats = NULL;
+
+    next_chained->stripe_grows = curr_chained->stripe_grows;
+
+    return next_chained;
+}
+
+/**
+ * @brief Relink every item of one old bucket into the next table
+ * 
+ * @param next_chained ChainedHashTable* -> table being filled
+ * @param bucket Bucket* -> bucket of the table being resized
+ */
+static void move_bucket(ChainedHashTable* next_chained, Bucket* bucket) {
+    Item* curr = bucket->head;
+    while (curr != NULL) {
+        Item* next = curr->next;
+        resize_insert(next_chained, curr);
+        curr = next;
+    }
+}
+
+/**
+ * @brief Resize chained table
+ * 
+ * @param chained_pointer chained table to resize
+ */
+void resize(ChainedHashTable** chained_pointer) {
+
+    static ChainedHashTable* next_chained = NULL;
+    static double resize_start = 0.0;
+    ChainedHashTable* curr_chained = *chained_pointer;
+
+    #pragma omp barrier
+
+    #pragma omp single
+    {
+        resize_start = stats_resize_begin();
+        next_chained = create_next_table(curr_chained, policy_next_buckets(&curr_chained->config, curr_chained->resize_needed, curr_chained->num_buckets));
+    }
+
+    #pragma omp barrier
+
+    #pragma omp for
+    for (size_t i = 0; i < curr_chained->num_buckets; i++) {
+        move_bucket(next_chained, &curr_chained->buckets[i]);
+    }
+
+    #pragma omp single 
+    {
+        policy_record(&next_chained->config, next_chained->stats, curr_chained->resize_needed, curr_chained->num_buckets, next_chained->num_buckets, 1, curr_chained->long_chains);
+        *chained_pointer = next_chained;
+        destroy_table(curr_chained);
+        stats_resize(next_chained->stats, resize_start);
+        next_chained = NULL;
+    }
+
+    #pragma omp barrier
+}
+
+/**
+ * @brief Resize chained table from a single thread
+ * 
+ * @param chained_pointer chained table to resize
+ */
+void resize_exclusive(ChainedHashTable** chained_pointer) {
+    double resize_start = stats_resize_begin();
+    ChainedHashTable* curr_chained = *chained_pointer;
+    ChainedHashTable* next_chained = create_next_table(curr_chained, policy_next_buckets(&curr_chained->config, curr_chained->resize_needed, curr_chained->num_buckets));
+
+    for (size_t i = 0; i < curr_chained->num_buckets; i++) {
+        move_bucket(next_chained, &curr_chained->buckets[i]);
+    }
+
+    policy_record(&next_chained->config, next_chained->stats, curr_chained->resize_needed, curr_chained->num_buckets, next_chained->num_buckets, 1, curr_chained->long_chains);
+    *chained_pointer = next_chained;
+    destroy_table(curr_chained);
+    stats_resize(next_chained->stats, resize_start);
+}
+
+/**
+ * @brief Fill a table with a known key set at once
+ * 
+ * The new table is not published until every thread is done, so the
+ * chains are built with plain writes and no stripe locks, newest item at
+ * the head as insert() would leave them. Not counted as a resize. With
+ * resize_enabled off the table keeps its bucket count, and a load into a
+ * table that an incremental resize is still draining goes through
+ * insert() (resize_exclusive does not know about old_buckets).
+ * 
+ * @param chained_pointer ChainedHashTable** -> table to fill, replaced
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void bulk_load(ChainedHashTable** chained_pointer, const uint64_t* keys, const uint64_t* values, size_t n) {
+    ChainedHashTable* curr_chained = *chained_pointer;
+    TableStats snapshot;
+    get_table_stats(curr_chained, &snapshot);
+
+    // One item per bucket on average
+    size_t num_buckets = curr_chained->num_buckets;
+    if (spec_resize_enabled(&curr_chained->config)) {
+        num_buckets = round_up_pow2(n > num_buckets ? n : num_buckets);
+    }
+
+    if (snapshot.items != 0 || curr_chained->old_buckets != NULL) {
+        while (curr_chained->old_buckets == NULL && curr_chained->num_buckets < num_buckets) {
+            resize_exclusive(chained_pointer);
+            curr_chained = *chained_pointer;
+        }
+
+        BulkPartition* parts = bulk_partition(keys, values, n, curr_chained->config.hash_function, curr_chained->num_buckets);
+        bulk_insert(chained_pointer, parts);
+        bulk_partition_free(parts);
+        return;
+    }
+
+    BulkPartition* parts = bulk_partition(keys, values, n, curr_chained->config.hash_function, num_buckets);
+    ChainedHashTable* next_chained = create_next_table(curr_chained, num_buckets);
+
+    #pragma omp parallel
+    {
+        size_t first;
+        size_t end;
+        bulk_thread_parts(parts, omp_get_thread_num(), omp_get_num_threads(), &first, &end);
+
+        size_t begin_pair = parts->starts[first];
+        size_t end_pair = parts->starts[end];
+        int added = 0;
+
+        pool_reserve(next_chained->pool, end_pair - begin_pair);
+
+        for (size_t i = begin_pair; i < end_pair; i++) {
+            uint64_t key = parts->keys[i];
+            Bucket* bucket = &next_chained->buckets[hash1(next_chained, key, num_buckets)];
+
+            Item* curr = bucket->head;
+            while (curr != NULL && curr->key != key) {
+                curr = curr->next;
+            }
+
+            if (curr != NULL) {
+                SET_ITEM_VALUE(curr, parts->values[i]);
+                continue;
+            }
+
+            Item* add_item = pool_alloc(next_chained->pool);
+            add_item->key = key;
+            SET_ITEM_VALUE(add_item, parts->values[i]);
+            add_item->next = bucket->head;
+            bucket->head = add_item;
+            added++;
+        }
+
+        stats_items(next_chained->stats, added);
+    }
+
+    *chained_pointer = next_chained;
+    destroy_table(curr_chained);
+    bulk_partition_free(parts);
+}
+
+/**
+ * @brief Write the table's items to a flat image file
+ * 
+ * While an incremental resize is in flight the items of a bucket not
+ * moved yet are still in old_buckets, which is saved as well.
+ * 
+ * @param chained ChainedHashTable* -> table to save
+ * @param path const char* -> image file, replaced once it is complete
+ * @return int -> 1 on success, 0 if the file could not be written
+ */
+int save_table(ChainedHashTable* chained, const char* path) {
+    SnapshotWriter* writer = snapshot_begin(&chained->config, chained->num_buckets);
+
+    for (size_t i = 0; i < chained->num_buckets; i++) {
+        for (Item* curr = chained->buckets[i].head; curr != NULL; curr = curr->next) {
+            snapshot_add(writer, curr->key, ITEM_VALUE(curr));
+        }
+    }
+
+    for (size_t i = 0; chained->old_buckets != NULL && i < chained->old_num_buckets; i++) {
+        Item* head = chained->old_buckets[i].head;
+
+        for (Item* curr = head == MIGRATED_BUCKET ? NULL : head; curr != NULL; curr = curr->next) {
+            snapshot_add(writer, curr->key, ITEM_VALUE(curr));
+        }
+    }
+
+    return snapshot_finish(writer, path);
+}
+
+/**
+ * @brief Merge the table's per-thread counters
+ * 
+ * Adds the wait of the current stripes, and of the arrays they grew
+ * from, to what earlier tables left in the counters. hottest_stripe is
+ * only looked for in the current stripes.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param out TableStats* -> snapshot to fill
+ */
+void get_table_stats(ChainedHashTable* chained, TableStats* out) {
+    stats_merge(chained->stats, out);
+
+    for (StripeArray* stripes = chained->stripes; stripes != NULL; stripes = stripes->retired) {
+        for (size_t i = 0; i < stripes->num_locks; i++) {
+            PaddedLock* stripe = &stripes->locks[i];
+
+            out->lock_contended += stripe->contended;
+            out->lock_wait += stripe->wait_time;
+
+            if (stripes == chained->stripes && stripe->wait_time > out->hottest_wait) {
+                out->hottest_wait = stripe->wait_time;
+                out->hottest_stripe = i;
+            }
+        }
+    }
+}
+
+/**
+ * @brief count the length of one chain
+ * 
+ * @param head Item* -> first item of the chain
+ * @return size_t -> number of items
+ */
+static size_t chain_length(Item* head) {
+    size_t length = 0;
+    for (Item* curr = head; curr != NULL; curr = curr->next) {
+        length++;
+    }
+    return length;
+}
+
+/**
+ * @brief HOT_* remedies of TableConfig.hot_keys this back end implements
+ * 
+ * @return int -> HOT_* bits (see hot.h)
+ */
+int hot_keys_supported(void) {
+    return HOT_ALL;
+}
+
+/**
+ * @brief Print how evenly the hash spreads the keys
+ * 
+ * Chains still waiting in old_buckets during an incremental resize are
+ * counted as well.
+ * 
+ * @param chained ChainedHashTable* -> specific chained table
+ */
+void print_table_stats(ChainedHashTable* chained) {
+    size_t counts[STATS_MAX_CHAIN + 1] = {0};
+    size_t max_length = 0;
+    size_t total_items = 0;
+    size_t total_chains = 0;
+
+    for (int old = 0; old < 2; old++) {
+        Bucket* buckets = old ? chained->old_buckets : chained->buckets;
+        size_t num_buckets = old ? chained->old_num_buckets : chained->num_buckets;
+
+        for (size_t i = 0; buckets != NULL && i < num_buckets; i++) {
+            if (buckets[i].head == MIGRATED_BUCKET) {
+                continue;
+            }
+
+            size_t length = chain_length(buckets[i].head);
+
+            counts[length < STATS_MAX_CHAIN ? length : STATS_MAX_CHAIN]++;
+            max_length = length > max_length ? length : max_length;
+            total_items += length;
+            total_chains++;
+        }
+    }
+
+    printf("num_buckets: %zu\n", chained->num_buckets);
+    printf("num_locks: %zu (grown %zu times under contention)\n", chained->stripes->num_locks, chained->stripe_grows);
+    print_length_histogram("chain_lengths", counts, STATS_MAX_CHAIN + 1);
+    printf("max_chain_length: %zu\n", max_length);
+    printf("mean_chain_length: %f\n", total_chains ? (double)total_items / total_chains : 0.0);
+
+    TableStats snapshot;
+    get_table_stats(chained, &snapshot);
+    stats_print(&snapshot);
+}
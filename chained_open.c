@@ -0,0 +1,1158 @@
+/**
+ * @file chained_open.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Open addressing implementation with cache line buckets
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Both chained back ends follow a linked list per bucket, so every probe
+ * is a chain of dependent cache misses. Here each bucket is one 64 byte
+ * cache line holding BUCKET_SLOTS keys and values inline. A key lives in
+ * the first free slot at or after its home bucket (linear probing over
+ * whole buckets), so a lookup is usually one cache miss and the next line
+ * is prefetch friendly.
+ *
+ * Every slot also has a one byte fingerprint in a separate control array
+ * (the same idea as SwissTable). The fingerprints of a whole probe window
+ * are contiguous, so one SIMD compare tells which slots can hold the key
+ * and a miss usually reads a single full key (the first free slot) or
+ * none at all. The first window of the control array is mirrored past its
+ * end so a window that wraps around is still one unaligned load.
+ *
+ * Lookups never lock or write. Slots are claimed with a compare and set
+ * on the key and a claimed key never changes again until the next resize,
+ * which is what makes two concurrent inserts of the same key agree on a
+ * slot. A delete only clears the value (a tombstone), a later insert of
+ * the same key brings the slot back.
+ *
+ * A key only probes MAX_PROBE_BUCKETS buckets. If all of them are taken
+ * by other keys it goes to an overflow chain hung off its home bucket,
+ * protected by striped locks like chained_locked.c. That keeps inserts
+ * working while the driver finishes the tasks in flight before it gets
+ * to resize. Filled windows never free up again, so a key is never in
+ * both its window and an overflow chain.
+ *
+ * Only the stop-the-world resize() is implemented. With incremental_resize
+ * set the table still asks for resize() through needs_resize(), which the
+ * driver honours in both modes.
+ */
+
+#include "chained.h"
+#include "hash.h"
+#include "stats.h"
+#include "numa.h"
+#include "hugepage.h"
+#include "bulk.h"
+#include "snapshot.h"
+#include "spec.h"
+#include "policy.h"
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Slots are 64 bit with INVALID_KEY for a free one, see spec.h
+#if TABLE_KEY_BITS != 64 || TABLE_VALUE_BITS != 64
+#error "chained_open.c stores 64 bit keys and values, build it without TABLE_KEY_BITS / TABLE_VALUE_BITS"
+#endif
+
+// Local constants
+#define BUCKET_SLOTS 4        // key/value pairs in one cache line
+#define MAX_PROBE_BUCKETS 8   // buckets probed before falling back to the overflow chain
+#define RESIZE_PROBE_BUCKETS 4 // probing this far from home counts as overlong for the resize policy
+#define WINDOW_SLOTS (MAX_PROBE_BUCKETS * BUCKET_SLOTS) // fingerprints compared at once, at most 32
+#define BATCH_GROUP 32  // keys prefetched together by lookup_batch/insert_batch
+
+// __builtin_prefetch wants a constant read/write hint
+#define PREFETCH(addr, for_write) ((for_write) ? __builtin_prefetch((addr), 1) : __builtin_prefetch((addr), 0))
+
+// Fingerprint of a slot that has no key yet (or whose claim is still being published)
+#define EMPTY_TAG 0
+
+
+/**
+ * @struct Bucket
+ * @brief Bucket at specific hash index, exactly one cache line
+ *
+ * Keys are grouped so a probe compares them without touching values.
+ * An unclaimed key is INVALID_KEY, a value of INVALID_VALUE means the
+ * slot is deleted or its value is not written yet.
+ *
+ * @param keys uint64_t[] -> slot keys
+ * @param values uint64_t[] -> slot values
+ */
+typedef struct {
+    uint64_t keys[BUCKET_SLOTS]; /** @brief slot keys (INVALID_KEY when unclaimed) */
+    uint64_t values[BUCKET_SLOTS]; /** @brief slot values (INVALID_VALUE when deleted) */
+} __attribute__((aligned(64))) Bucket;
+
+/* contended and wait_time are only written by the thread holding the lock. */
+typedef struct {
+    omp_lock_t lock;
+    uint64_t contended;
+    double wait_time;
+    char padding[64 - sizeof(uint64_t) - sizeof(double) - sizeof(omp_lock_t)];
+} PaddedLock;
+
+/**
+ * @struct OverflowItem
+ * @brief Item whose probe window was full
+ *
+ * @param key uint64_t -> hash table key
+ * @param value uint64_t -> item value
+ * @param next OverflowItem* -> next item in the overflow list
+ */
+typedef struct OverflowItem {
+    uint64_t key; /** @brief hash table key */
+    uint64_t value; /** @brief item value */
+    struct OverflowItem* next; /** @brief next item in the overflow list */
+} OverflowItem;
+
+/**
+ * @struct ChainedHashTable
+ * @brief open addressing hash table
+ *
+ * The name is kept so the back end plugs into chained.h unchanged.
+ *
+ * @param buckets Bucket* -> pointer to array of buckets
+ * @param num_buckets size_t -> number of buckets
+ * @param tags uint8_t* -> fingerprint per slot, first window mirrored at the end
+ * @param overflow OverflowItem** -> per bucket chain of items whose probe window was full
+ * @param locks PaddedLock* -> stripe locks for the overflow chains
+ * @param num_locks size_t -> number of locks
+ * @param config TableConfig -> settings this table was created with
+ * @param resize_needed volatile int -> POLICY_* reason once the policy asks for resize(), cleared by resize()
+ * @param long_chains volatile uint64_t -> inserts that probed too far (or overflowed) since the last resize
+ * @param stats StatsCounters* -> per-thread counters, handed to the next table on resize
+ */
+struct ChainedHashTable{
+    Bucket* buckets; /** @brief pointer to array of buckets */
+    size_t num_buckets; /** @brief number of buckets */
+
+    uint8_t* tags; /** @brief fingerprint per slot (EMPTY_TAG until published), first window mirrored at the end */
+    OverflowItem** overflow; /** @brief per bucket chain of items whose probe window was full (stripe locked) */
+
+    PaddedLock* locks; /** @brief stripe locks for the overflow chains, buckets never lock */
+    size_t num_locks; /** @brief number of locks */
+
+    TableConfig config; /** @brief settings this table was created with */
+    volatile int resize_needed; /** @brief POLICY_* reason once the policy asks for resize(), cleared by resize() */
+    volatile uint64_t long_chains; /** @brief inserts that probed too far (or overflowed) since the last resize */
+
+    StatsCounters* stats; /** @brief per-thread counters, handed to the next table on resize */
+};
+
+/**
+ * @brief hash function
+ *
+ * Same home bucket function as the chained back ends, mixer comes from hash.h.
+ *
+ * @param chained ChainedHashTable* -> table whose mixer to use
+ * @param key uint64_t -> hash table key
+ * @param num_buckets size_t -> number of hash table buckets (power of two)
+ * @return size_t -> hash1 index
+ */
+size_t hash1(ChainedHashTable* chained, uint64_t key, size_t num_buckets) {
+    return hash_key(key, chained->config.hash_function) & (num_buckets - 1);
+}
+
+/**
+ * @brief get lock index for the overflow chain of a bucket
+ * 
+ * @param chained ChainedHashTable* -> specific table
+ * @param bucket_index size_t -> home bucket index in table
+ * @return size_t -> lock index
+ */
+size_t get_lock_idx(ChainedHashTable* chained, size_t bucket_index) {
+    return bucket_index & (chained->num_locks - 1);
+}
+
+/**
+ * @brief one byte fingerprint of a key
+ *
+ * Taken from a different mix than hash1 so keys sharing a home bucket
+ * still mostly differ. Never EMPTY_TAG.
+ *
+ * @param key uint64_t -> hash table key
+ * @return uint8_t -> fingerprint
+ */
+static inline uint8_t fingerprint(uint64_t key) {
+    uint8_t tag = (uint8_t)((key * 0x9E3779B97F4A7C15ULL) >> 56);
+    return tag == EMPTY_TAG ? 1 : tag;
+}
+
+/**
+ * @brief number of buckets in a probe window
+ *
+ * @param chained ChainedHashTable* -> specific table
+ * @return size_t -> MAX_PROBE_BUCKETS, or fewer for tiny tables
+ */
+static inline size_t probe_buckets(ChainedHashTable* chained) {
+    return chained->num_buckets < MAX_PROBE_BUCKETS ? chained->num_buckets : MAX_PROBE_BUCKETS;
+}
+
+/**
+ * @brief compare a window of fingerprints against tag
+ *
+ * Bit i is set when slot i of the window may hold the key: its
+ * fingerprint equals tag, or it is still EMPTY_TAG (unclaimed, or claimed
+ * but not published yet, either way the key has to be checked).
+ *
+ * The vector load is not atomic as a whole, but every byte is read
+ * atomically and fingerprints only ever change from EMPTY_TAG to their
+ * final value, so a stale byte only makes us check one more key.
+ *
+ * @param tags const uint8_t* -> first fingerprint of the window (WINDOW_SLOTS readable bytes)
+ * @param tag uint8_t -> fingerprint of the key
+ * @return uint32_t -> candidate slot mask
+ */
+static inline uint32_t match_window(const uint8_t* tags, uint8_t tag) {
+#if defined(__AVX2__) && WINDOW_SLOTS == 32
+    __m256i group = _mm256_loadu_si256((const __m256i*)tags);
+    __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(group, _mm256_set1_epi8((char)tag)),
+                                   _mm256_cmpeq_epi8(group, _mm256_setzero_si256()));
+    return (uint32_t)_mm256_movemask_epi8(hits);
+#elif defined(__SSE2__) && WINDOW_SLOTS == 32
+    __m128i want = _mm_set1_epi8((char)tag);
+    __m128i empty = _mm_setzero_si128();
+    __m128i low = _mm_loadu_si128((const __m128i*)tags);
+    __m128i high = _mm_loadu_si128((const __m128i*)(tags + 16));
+    uint32_t low_hits = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(low, want), _mm_cmpeq_epi8(low, empty)));
+    uint32_t high_hits = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(high, want), _mm_cmpeq_epi8(high, empty)));
+    return low_hits | (high_hits << 16);
+#else
+    uint32_t hits = 0;
+    for (int i = 0; i < WINDOW_SLOTS; i++) {
+        uint8_t slot_tag;
+
+        #pragma omp atomic read
+        slot_tag = tags[i];
+
+        if (slot_tag == tag || slot_tag == EMPTY_TAG) {
+            hits |= (uint32_t)1 << i;
+        }
+    }
+    return hits;
+#endif
+}
+
+/**
+ * @brief candidate slots of the probe window of key
+ *
+ * @param chained ChainedHashTable* -> specific table
+ * @param home size_t -> home bucket of key
+ * @param tag uint8_t -> fingerprint of key
+ * @return uint32_t -> candidate slot mask, bit i is slot i counted from the home bucket
+ */
+static inline uint32_t window_candidates(ChainedHashTable* chained, size_t home, uint8_t tag) {
+    size_t window_slots = probe_buckets(chained) * BUCKET_SLOTS;
+    uint32_t in_window = window_slots >= 32 ? UINT32_MAX : ((uint32_t)1 << window_slots) - 1;
+    return match_window(&chained->tags[home * BUCKET_SLOTS], tag) & in_window;
+}
+
+/**
+ * @brief publish the fingerprint of a freshly claimed slot
+ *
+ * @param chained ChainedHashTable* -> specific table
+ * @param slot size_t -> slot index (bucket * BUCKET_SLOTS + slot in bucket)
+ * @param tag uint8_t -> fingerprint of the key now in slot
+ */
+static inline void set_tag(ChainedHashTable* chained, size_t slot, uint8_t tag) {
+    #pragma omp atomic write
+    chained->tags[slot] = tag;
+
+    // Keep the mirror in sync for windows that wrap around
+    if (slot < WINDOW_SLOTS) {
+        #pragma omp atomic write
+        chained->tags[chained->num_buckets * BUCKET_SLOTS + slot] = tag;
+    }
+}
+
+/**
+ * @brief find the slot holding key in its probe window
+ *
+ * @param chained ChainedHashTable* -> specific table
+ * @param key uint64_t -> key to find
+ * @param slot_out uint64_t** -> value of the slot holding key
+ * @param distance_out size_t* -> buckets probed past home (MAX_PROBE_BUCKETS if the window was full)
+ * @return int -> 1 found, 0 not in the table, -1 window full (check overflow)
+ */
+static int find_slot(ChainedHashTable* chained, uint64_t key, uint64_t** slot_out, size_t* distance_out) {
+    size_t home = hash1(chained, key, chained->num_buckets);
+    uint32_t candidates = window_candidates(chained, home, fingerprint(key));
+
+    // Slots are visited in probe order, only the candidates need a key compare
+    while (candidates != 0) {
+        int i = __builtin_ctz(candidates);
+        candidates &= candidates - 1;
+
+        Bucket* bucket = &chained->buckets[(home + i / BUCKET_SLOTS) & (chained->num_buckets - 1)];
+        int s = i % BUCKET_SLOTS;
+        uint64_t slot_key;
+
+        #pragma omp atomic read seq_cst
+        slot_key = bucket->keys[s];
+
+        if (slot_key == INVALID_KEY) {
+            *distance_out = i / BUCKET_SLOTS;
+            return 0; // an insert of key would have claimed this slot
+        }
+
+        if (slot_key == key) {
+            *slot_out = &bucket->values[s];
+            *distance_out = i / BUCKET_SLOTS;
+            return 1;
+        }
+    }
+
+    *distance_out = MAX_PROBE_BUCKETS;
+    return -1;
+}
+
+/**
+ * @brief find or claim the slot for key in its probe window
+ *
+ * @param chained ChainedHashTable* -> specific table
+ * @param key uint64_t -> key to place
+ * @param slot_out uint64_t** -> value of the slot now holding key
+ * @param distance_out size_t* -> buckets away from home the slot is
+ * @return int -> 1 if a slot was found or claimed, 0 if the window is full
+ */
+static int claim_slot(ChainedHashTable* chained, uint64_t key, uint64_t** slot_out, size_t* distance_out) {
+    size_t home = hash1(chained, key, chained->num_buckets);
+    uint8_t tag = fingerprint(key);
+    uint32_t candidates = window_candidates(chained, home, tag);
+
+    while (candidates != 0) {
+        int i = __builtin_ctz(candidates);
+        candidates &= candidates - 1;
+
+        size_t bucket_idx = (home + i / BUCKET_SLOTS) & (chained->num_buckets - 1);
+        Bucket* bucket = &chained->buckets[bucket_idx];
+        int s = i % BUCKET_SLOTS;
+        uint64_t slot_key;
+
+        #pragma omp atomic read seq_cst
+        slot_key = bucket->keys[s];
+
+        if (slot_key == INVALID_KEY) {
+            #pragma omp atomic compare capture seq_cst
+            {
+                slot_key = bucket->keys[s];
+                if (bucket->keys[s] == INVALID_KEY) {
+                    bucket->keys[s] = key;
+                }
+            }
+
+            if (slot_key == INVALID_KEY) {
+                set_tag(chained, bucket_idx * BUCKET_SLOTS + s, tag);
+                slot_key = key; // we own it now
+            }
+        }
+
+        // Either ours, or someone claimed it first (possibly for the same key)
+        if (slot_key == key) {
+            *slot_out = &bucket->values[s];
+            *distance_out = i / BUCKET_SLOTS;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief allocate a 64 byte aligned array, placed as the config says
+ *
+ * The contents are undefined, the caller fills it in.
+ *
+ * @param config const TableConfig* -> numa and huge_pages
+ * @param bytes size_t -> size of the array (multiple of 64)
+ * @return void*
+ */
+static void* alloc_array(const TableConfig* config, size_t bytes) {
+    if (config->huge_pages) {
+        return huge_alloc(bytes, config->numa ? HUGE_PLACE_INTERLEAVE : HUGE_PLACE_ANY);
+    }
+
+    void* array = aligned_alloc(64, bytes);
+
+    if (config->numa) {
+        numa_interleave(array, bytes);
+    }
+
+    return array;
+}
+
+/**
+ * @brief free an array from alloc_array
+ *
+ * @param config const TableConfig* -> huge_pages
+ * @param array void* -> array to free
+ */
+static void free_array(const TableConfig* config, void* array) {
+    if (config->huge_pages) {
+        huge_free(array);
+    } else {
+        free(array);
+    }
+}
+
+/**
+ * @brief Create chained hash table
+ *
+ * Both counts are rounded up to powers of two so indexes can be masked.
+ *
+ * @param num_buckets size_t -> initial number of buckets
+ * @param num_locks size_t -> initial number of locks (overflow chains only)
+ * @param config const TableConfig* -> settings to copy (NULL for TABLE_CONFIG_DEFAULT)
+ * @return ChainedHashTable*
+ */
+ChainedHashTable* create_table(size_t num_buckets, size_t num_locks, const TableConfig* config) {
+    ChainedHashTable* chained = malloc(sizeof(ChainedHashTable));
+    TableConfig default_config = TABLE_CONFIG_DEFAULT;
+
+    chained->config = config ? *config : default_config;
+    spec_config(&chained->config);
+    policy_config(&chained->config);
+    chained->resize_needed = 0;
+    chained->long_chains = 0;
+
+    num_buckets = policy_initial_buckets(&chained->config, num_buckets, BUCKET_SLOTS);
+    num_locks = round_up_pow2(num_locks);
+
+    chained->num_buckets = num_buckets;
+    chained->num_locks = num_locks;
+
+    chained->buckets = alloc_array(&chained->config, num_buckets * sizeof(Bucket));
+
+    // Every key INVALID_KEY, every value INVALID_VALUE
+    memset(chained->buckets, 0xFF, num_buckets * sizeof(Bucket));
+
+    // One window past the end for the mirror, rounded up for aligned_alloc
+    size_t tag_bytes = (num_buckets * BUCKET_SLOTS + WINDOW_SLOTS + 63) & ~(size_t)63;
+    chained->tags = alloc_array(&chained->config, tag_bytes);
+
+    memset(chained->tags, EMPTY_TAG, tag_bytes);
+
+    chained->overflow = calloc(num_buckets, sizeof(OverflowItem*));
+
+    chained->locks = malloc(num_locks * sizeof(PaddedLock));
+
+    if (chained->config.numa) {
+        numa_interleave(chained->overflow, num_buckets * sizeof(OverflowItem*));
+        numa_interleave(chained->locks, num_locks * sizeof(PaddedLock));
+    }
+
+    // omp_init_lock must be used to initialize every lock
+    for (size_t i = 0; i < num_locks; i++) {
+        chained->locks[i].contended = 0;
+        chained->locks[i].wait_time = 0.0;
+        omp_init_lock(&chained->locks[i].lock);
+    }
+
+    chained->stats = stats_create();
+
+    return chained;
+}
+
+/**
+ * @brief Destroy chained hash table
+ *
+ * @param chained ChainedHashTable* -> table to destroy
+ */
+void destroy_table(ChainedHashTable* chained) {
+
+    for (size_t i = 0; i < chained->num_buckets; i++) {
+        OverflowItem* curr = chained->overflow[i];
+        while (curr != NULL) {
+            OverflowItem* temp = curr;
+            curr = curr->next;
+            free(temp);
+        }
+    }
+
+    // use omp_destroy_lock to remove each lock
+    for (size_t i = 0; i < chained->num_locks; i++) {
+        omp_destroy_lock(&chained->locks[i].lock);
+    }
+
+    free(chained->locks);
+    free(chained->overflow);
+    free_array(&chained->config, chained->tags);
+    free_array(&chained->config, chained->buckets);
+    stats_destroy(chained->stats);
+    free(chained);
+}
+
+/**
+ * @brief acquire one overflow stripe lock
+ *
+ * The clock is only read when the lock is already taken.
+ *
+ * @param chained ChainedHashTable* -> specific table
+ * @param lock_idx size_t -> stripe to lock
+ */
+static inline void stripe_lock(ChainedHashTable* chained, size_t lock_idx) {
+    PaddedLock* stripe = &chained->locks[lock_idx];
+
+    if (!omp_test_lock(&stripe->lock)) {
+        double wait_start = omp_get_wtime();
+        omp_set_lock(&stripe->lock);
+        stripe->contended++;
+        stripe->wait_time += omp_get_wtime() - wait_start;
+    }
+}
+
+/**
+ * @brief release one overflow stripe lock
+ *
+ * @param chained ChainedHashTable* -> specific table
+ * @param lock_idx size_t -> stripe to unlock
+ */
+static inline void stripe_unlock(ChainedHashTable* chained, size_t lock_idx) {
+    omp_unset_lock(&chained->locks[lock_idx].lock);
+}
+
+/**
+ * @brief ask the driver for a stop-the-world resize
+ *
+ * The first reason wins until resize() clears it.
+ *
+ * @param chained ChainedHashTable* -> table that wants a new size
+ * @param reason int -> POLICY_* reason, POLICY_KEEP does nothing
+ */
+static void request_resize(ChainedHashTable* chained, int reason) {
+    if (reason == POLICY_KEEP) {
+        return;
+    }
+
+    int temp_resize = 0;
+
+    #pragma omp atomic read
+    temp_resize = chained->resize_needed;
+
+    if (!temp_resize) {
+        #pragma omp atomic write
+        chained->resize_needed = reason;
+    }
+}
+
+/**
+ * @brief lookup key in chained table
+ *
+ * @param chained ChainedHashTable -> specific chained table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> value at key (INVALID_VALUE if key not found)
+ */
+uint64_t lookup(ChainedHashTable* chained, uint64_t key) {
+
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return INVALID_VALUE;
+    }
+
+    uint64_t* slot;
+    uint64_t value = INVALID_VALUE;
+    size_t distance;
+    int found = find_slot(chained, key, &slot, &distance);
+
+    stats_depth(chained->stats, distance);
+
+    if (found == 1) {
+        #pragma omp atomic read seq_cst
+        value = *slot;
+    } else if (found == -1) {
+        size_t home = hash1(chained, key, chained->num_buckets);
+        size_t lock_idx = get_lock_idx(chained, home);
+
+        stripe_lock(chained, lock_idx);
+
+        for (OverflowItem* curr = chained->overflow[home]; curr != NULL; curr = curr->next) {
+            if (curr->key == key) {
+                value = curr->value;
+                break;
+            }
+        }
+
+        stripe_unlock(chained, lock_idx);
+    }
+
+    return value;
+}
+
+/**
+ * @brief Insert item into chained table
+ *
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @param value uint64_t -> value value (must not be INVALID_VALUE)
+ */
+void insert(ChainedHashTable* chained, uint64_t key, uint64_t value) {
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return;
+    } else if (value == INVALID_VALUE) {
+        //printf("value must not equal INVALID_VALUE value (uint64 max)");
+        return;
+    }
+
+    uint64_t* slot;
+    size_t distance;
+    int added_item = 0;
+    int overlong = 0;
+
+    if (claim_slot(chained, key, &slot, &distance)) {
+        uint64_t old_value;
+
+        #pragma omp atomic capture seq_cst
+        {
+            old_value = *slot;
+            *slot = value;
+        }
+
+        // Fresh claim or a tombstone brought back
+        added_item = (old_value == INVALID_VALUE);
+        stats_depth(chained->stats, distance);
+        overlong = distance >= RESIZE_PROBE_BUCKETS;
+    } else {
+        size_t home = hash1(chained, key, chained->num_buckets);
+        size_t lock_idx = get_lock_idx(chained, home);
+
+        stripe_lock(chained, lock_idx);
+
+        OverflowItem* curr = chained->overflow[home];
+        while (curr != NULL && curr->key != key) {
+            curr = curr->next;
+        }
+
+        if (curr != NULL) {
+            curr->value = value;
+        } else {
+            OverflowItem* add_item = malloc(sizeof(OverflowItem));
+            add_item->key = key;
+            add_item->value = value;
+            add_item->next = chained->overflow[home];
+            chained->overflow[home] = add_item;
+            added_item = 1;
+        }
+
+        stripe_unlock(chained, lock_idx);
+
+        stats_depth(chained->stats, MAX_PROBE_BUCKETS);
+        overlong = 1;
+    }
+
+    if (added_item) {
+        stats_items(chained->stats, 1);
+
+        if (spec_resize_enabled(&chained->config)) {
+            request_resize(chained, policy_after_add(&chained->config, chained->stats, chained->num_buckets, BUCKET_SLOTS, &chained->long_chains, overlong));
+        }
+    }
+}
+
+/**
+ * @brief Remove key from chained table
+ *
+ * Leaves a tombstone, the key keeps its slot until the next resize.
+ *
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> removed value (INVALID_VALUE if key not found)
+ */
+uint64_t remove_key(ChainedHashTable* chained, uint64_t key) {
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return INVALID_VALUE;
+    }
+
+    uint64_t* slot;
+    uint64_t value = INVALID_VALUE;
+    size_t distance;
+    int found = find_slot(chained, key, &slot, &distance);
+
+    if (found == 1) {
+        #pragma omp atomic capture seq_cst
+        {
+            value = *slot;
+            *slot = INVALID_VALUE;
+        }
+    } else if (found == -1) {
+        size_t home = hash1(chained, key, chained->num_buckets);
+        size_t lock_idx = get_lock_idx(chained, home);
+
+        stripe_lock(chained, lock_idx);
+
+        OverflowItem** prev = &chained->overflow[home];
+        OverflowItem* curr = *prev;
+
+        while (curr != NULL) {
+            if (curr->key == key) {
+                *prev = curr->next;
+                value = curr->value;
+                free(curr);
+                break;
+            }
+            prev = &curr->next;
+            curr = curr->next;
+        }
+
+        stripe_unlock(chained, lock_idx);
+    }
+
+    if (value != INVALID_VALUE) {
+        stats_items(chained->stats, -1);
+
+        if (spec_resize_enabled(&chained->config)) {
+            request_resize(chained, policy_after_remove(&chained->config, chained->stats, chained->num_buckets, BUCKET_SLOTS));
+        }
+    }
+
+    return value;
+}
+
+/**
+ * @brief prefetch what a group of operations is about to touch
+ *
+ * Keys and values are inline, so the fingerprint window and the home
+ * bucket line are everything a probe needs (the window usually ends
+ * there, the next bucket is left to the hardware prefetcher).
+ *
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys of the group
+ * @param n size_t -> number of keys (at most BATCH_GROUP)
+ * @param for_write int -> 1 if the keys are about to be inserted
+ */
+static void prefetch_keys(ChainedHashTable* chained, const uint64_t* keys, size_t n, int for_write) {
+    for (size_t i = 0; i < n; i++) {
+        size_t home = hash1(chained, keys[i], chained->num_buckets);
+        __builtin_prefetch(&chained->tags[home * BUCKET_SLOTS], 0);
+        PREFETCH(&chained->buckets[home], for_write);
+    }
+}
+
+/**
+ * @brief lookup many keys in chained table
+ *
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys to look up
+ * @param out uint64_t* -> value per key (INVALID_VALUE if key not found)
+ * @param n size_t -> number of keys
+ */
+void lookup_batch(ChainedHashTable* chained, const uint64_t* keys, uint64_t* out, size_t n) {
+    for (size_t start = 0; start < n; start += BATCH_GROUP) {
+        size_t count = (n - start < BATCH_GROUP) ? n - start : BATCH_GROUP;
+
+        prefetch_keys(chained, keys + start, count, 0);
+
+        for (size_t i = start; i < start + count; i++) {
+            out[i] = lookup(chained, keys[i]);
+        }
+    }
+}
+
+/**
+ * @brief Insert many items into chained table
+ *
+ * @param chained ChainedHashTable* -> specific chained table
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void insert_batch(ChainedHashTable* chained, const uint64_t* keys, const uint64_t* values, size_t n) {
+    for (size_t start = 0; start < n; start += BATCH_GROUP) {
+        size_t count = (n - start < BATCH_GROUP) ? n - start : BATCH_GROUP;
+
+        prefetch_keys(chained, keys + start, count, 1);
+
+        for (size_t i = start; i < start + count; i++) {
+            insert(chained, keys[i], values[i]);
+        }
+    }
+}
+
+/**
+ * @brief Thread safe insert to be used during resize
+ *
+ * Keys coming out of the old table are unique, so a live key never
+ * meets itself here. Does not ask for another resize.
+ *
+ * @param chained ChainedHashTable* -> table being filled
+ * @param key uint64_t -> key value
+ * @param value uint64_t -> value value
+ */
+void resize_insert(ChainedHashTable* chained, uint64_t key, uint64_t value) {
+    uint64_t* slot;
+    size_t distance;
+
+    if (claim_slot(chained, key, &slot, &distance)) {
+        #pragma omp atomic write seq_cst
+        *slot = value;
+        return;
+    }
+
+    size_t home = hash1(chained, key, chained->num_buckets);
+    size_t lock_idx = get_lock_idx(chained, home);
+
+    OverflowItem* add_item = malloc(sizeof(OverflowItem));
+    add_item->key = key;
+    add_item->value = value;
+
+    stripe_lock(chained, lock_idx);
+    add_item->next = chained->overflow[home];
+    chained->overflow[home] = add_item;
+    stripe_unlock(chained, lock_idx);
+}
+
+/**
+ * @brief check whether the table asked for resize()
+ *
+ * @param chained ChainedHashTable* -> specific chained table
+ * @return int -> POLICY_* reason if the table wants a new size, 0 otherwise
+ */
+int needs_resize(ChainedHashTable* chained) {
+    int temp_resize;
+
+    #pragma omp atomic read
+    temp_resize = chained->resize_needed;
+
+    return temp_resize;
+}
+
+/**
+ * @brief Create the table a resize moves into
+ *
+ * The counters move over, with the lock wait of the old stripes folded in.
+ *
+ * @param curr_chained ChainedHashTable* -> table being resized
+ * @param next_num_buckets size_t -> buckets of the new table (power of two)
+ * @return ChainedHashTable* -> empty table with next_num_buckets buckets, locks scaled by the same factor
+ */
+static ChainedHashTable* create_next_table(ChainedHashTable* curr_chained, size_t next_num_buckets) {
+    size_t next_num_locks = curr_chained->num_locks * next_num_buckets / curr_chained->num_buckets;
+    ChainedHashTable* next_chained = create_table(next_num_buckets, next_num_locks, &curr_chained->config);
+
+    for (size_t i = 0; i < curr_chained->num_locks; i++) {
+        curr_chained->stats->lock_contended += curr_chained->locks[i].contended;
+        curr_chained->stats->lock_wait += curr_chained->locks[i].wait_time;
+    }
+
+    stats_destroy(next_chained->stats);
+    next_chained->stats = curr_chained->stats;
+    curr_chained->stats = NULL;
+
+    return next_chained;
+}
+
+/**
+ * @brief Copy the live slots and overflow chain of one old bucket
+ *
+ * @param next_chained ChainedHashTable* -> table being filled
+ * @param curr_chained ChainedHashTable* -> table being resized
+ * @param i size_t -> bucket index in curr_chained
+ */
+static void move_bucket(ChainedHashTable* next_chained, ChainedHashTable* curr_chained, size_t i) {
+    Bucket* bucket = &curr_chained->buckets[i];
+    for (int s = 0; s < BUCKET_SLOTS; s++) {
+        if (bucket->keys[s] != INVALID_KEY && bucket->values[s] != INVALID_VALUE) {
+            resize_insert(next_chained, bucket->keys[s], bucket->values[s]);
+        }
+    }
+    for (OverflowItem* curr = curr_chained->overflow[i]; curr != NULL; curr = curr->next) {
+        resize_insert(next_chained, curr->key, curr->value);
+    }
+}
+
+/**
+ * @brief Resize chained table
+ *
+ * Tombstones are dropped and overflow items move back into buckets.
+ *
+ * @param chained_pointer chained table to resize
+ */
+void resize(ChainedHashTable** chained_pointer) {
+
+    static ChainedHashTable* next_chained = NULL;
+    static double resize_start = 0.0;
+    ChainedHashTable* curr_chained = *chained_pointer;
+
+    #pragma omp barrier
+
+    #pragma omp single
+    {
+        resize_start = stats_resize_begin();
+        next_chained = create_next_table(curr_chained, policy_next_buckets(&curr_chained->config, curr_chained->resize_needed, curr_chained->num_buckets));
+    }
+
+    #pragma omp barrier
+
+    #pragma omp for
+    for (size_t i = 0; i < curr_chained->num_buckets; i++) {
+        move_bucket(next_chained, curr_chained, i);
+    }
+
+    #pragma omp single
+    {
+        policy_record(&next_chained->config, next_chained->stats, curr_chained->resize_needed, curr_chained->num_buckets, next_chained->num_buckets, BUCKET_SLOTS, curr_chained->long_chains);
+        *chained_pointer = next_chained;
+        destroy_table(curr_chained);
+        stats_resize(next_chained->stats, resize_start);
+        next_chained = NULL;
+    }
+
+    #pragma omp barrier
+}
+
+/**
+ * @brief Resize chained table from a single thread
+ *
+ * @param chained_pointer chained table to resize
+ */
+void resize_exclusive(ChainedHashTable** chained_pointer) {
+    double resize_start = stats_resize_begin();
+    ChainedHashTable* curr_chained = *chained_pointer;
+    ChainedHashTable* next_chained = create_next_table(curr_chained, policy_next_buckets(&curr_chained->config, curr_chained->resize_needed, curr_chained->num_buckets));
+
+    for (size_t i = 0; i < curr_chained->num_buckets; i++) {
+        move_bucket(next_chained, curr_chained, i);
+    }
+
+    policy_record(&next_chained->config, next_chained->stats, curr_chained->resize_needed, curr_chained->num_buckets, next_chained->num_buckets, BUCKET_SLOTS, curr_chained->long_chains);
+    *chained_pointer = next_chained;
+    destroy_table(curr_chained);
+    stats_resize(next_chained->stats, resize_start);
+}
+
+/**
+ * @brief put key into its probe window, short of range_end, without atomics
+ *
+ * Same slot as claim_slot() would pick, as long as the window does not
+ * leave the range. Only for a table nobody else can see yet, in which
+ * the calling thread alone writes the range.
+ *
+ * @param chained ChainedHashTable* -> table being built
+ * @param key uint64_t -> key value
+ * @param value uint64_t -> value value
+ * @param range_end size_t -> one past the last bucket of the calling thread
+ * @return int -> 1 new key, 0 updated, -1 the window is full up to range_end (nothing written)
+ */
+static int bulk_place(ChainedHashTable* chained, uint64_t key, uint64_t value, size_t range_end) {
+    size_t home = hash1(chained, key, chained->num_buckets);
+    size_t window_slots = probe_buckets(chained) * BUCKET_SLOTS;
+
+    for (size_t i = 0; i < window_slots && home + i / BUCKET_SLOTS < range_end; i++) {
+        Bucket* bucket = &chained->buckets[home + i / BUCKET_SLOTS];
+        int s = i % BUCKET_SLOTS;
+
+        if (bucket->keys[s] == key) {
+            bucket->values[s] = value;
+            return 0;
+        }
+        if (bucket->keys[s] == INVALID_KEY) {
+            bucket->keys[s] = key;
+            bucket->values[s] = value;
+            set_tag(chained, home * BUCKET_SLOTS + i, fingerprint(key));
+            return 1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Fill a table with a known key set at once
+ *
+ * Every thread fills the probe windows of its own buckets with plain
+ * writes. A key whose window runs full before the end of the thread's
+ * buckets is deferred, and the deferred keys go through insert() once
+ * every thread is done (a repeated key is deferred every time, so its
+ * order holds). Buckets are sized for half full slots. Not counted as a
+ * resize, with resize_enabled off the table keeps its bucket count.
+ *
+ * @param chained_pointer ChainedHashTable** -> table to fill, replaced
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void bulk_load(ChainedHashTable** chained_pointer, const uint64_t* keys, const uint64_t* values, size_t n) {
+    ChainedHashTable* curr_chained = *chained_pointer;
+    TableStats snapshot;
+    get_table_stats(curr_chained, &snapshot);
+
+    size_t num_buckets = curr_chained->num_buckets;
+    if (spec_resize_enabled(&curr_chained->config)) {
+        size_t wanted = (n + BUCKET_SLOTS / 2 - 1) / (BUCKET_SLOTS / 2);
+        num_buckets = round_up_pow2(wanted > num_buckets ? wanted : num_buckets);
+    }
+
+    if (snapshot.items != 0) {
+        while (curr_chained->num_buckets < num_buckets) {
+            resize_exclusive(chained_pointer);
+            curr_chained = *chained_pointer;
+        }
+
+        BulkPartition* parts = bulk_partition(keys, values, n, curr_chained->config.hash_function, curr_chained->num_buckets);
+        bulk_insert(chained_pointer, parts);
+        bulk_partition_free(parts);
+        return;
+    }
+
+    BulkPartition* parts = bulk_partition(keys, values, n, curr_chained->config.hash_function, num_buckets);
+    ChainedHashTable* next_chained = create_next_table(curr_chained, num_buckets);
+
+    #pragma omp parallel
+    {
+        size_t first;
+        size_t end;
+        bulk_thread_parts(parts, omp_get_thread_num(), omp_get_num_threads(), &first, &end);
+
+        size_t range_end = end * parts->part_buckets;
+        BulkDeferred deferred = {0};
+        int added = 0;
+
+        for (size_t i = parts->starts[first]; i < parts->starts[end]; i++) {
+            int placed = bulk_place(next_chained, parts->keys[i], parts->values[i], range_end);
+
+            if (placed < 0) {
+                bulk_defer(&deferred, i);
+            } else {
+                added += placed;
+            }
+        }
+
+        stats_items(next_chained->stats, added);
+
+        #pragma omp barrier
+
+        for (size_t i = 0; i < deferred.count; i++) {
+            insert(next_chained, parts->keys[deferred.pairs[i]], parts->values[deferred.pairs[i]]);
+        }
+        free(deferred.pairs);
+    }
+
+    *chained_pointer = next_chained;
+    destroy_table(curr_chained);
+    bulk_partition_free(parts);
+
+    while (needs_resize(*chained_pointer)) {
+        resize_exclusive(chained_pointer);
+    }
+}
+
+/**
+ * @brief Write the table's items to a flat image file
+ *
+ * Tombstones are left out, overflow items are saved like any other.
+ *
+ * @param chained ChainedHashTable* -> table to save
+ * @param path const char* -> image file, replaced once it is complete
+ * @return int -> 1 on success, 0 if the file could not be written
+ */
+int save_table(ChainedHashTable* chained, const char* path) {
+    SnapshotWriter* writer = snapshot_begin(&chained->config, chained->num_buckets);
+
+    for (size_t i = 0; i < chained->num_buckets; i++) {
+        Bucket* bucket = &chained->buckets[i];
+
+        for (int s = 0; s < BUCKET_SLOTS; s++) {
+            if (bucket->keys[s] != INVALID_KEY && bucket->values[s] != INVALID_VALUE) {
+                snapshot_add(writer, bucket->keys[s], bucket->values[s]);
+            }
+        }
+        for (OverflowItem* curr = chained->overflow[i]; curr != NULL; curr = curr->next) {
+            snapshot_add(writer, curr->key, curr->value);
+        }
+    }
+
+    return snapshot_finish(writer, path);
+}
+
+/**
+ * @brief Merge the table's per-thread counters
+ *
+ * Adds the wait of the current overflow stripes to what earlier tables
+ * left in the counters. Depths are probe distances in buckets, the last
+ * bin counts operations that had to search an overflow chain.
+ *
+ * @param chained ChainedHashTable* -> specific table
+ * @param out TableStats* -> snapshot to fill
+ */
+void get_table_stats(ChainedHashTable* chained, TableStats* out) {
+    stats_merge(chained->stats, out);
+
+    for (size_t i = 0; i < chained->num_locks; i++) {
+        PaddedLock* stripe = &chained->locks[i];
+
+        out->lock_contended += stripe->contended;
+        out->lock_wait += stripe->wait_time;
+
+        if (stripe->wait_time > out->hottest_wait) {
+            out->hottest_wait = stripe->wait_time;
+            out->hottest_stripe = i;
+        }
+    }
+}
+
+/**
+ * @brief HOT_* remedies of TableConfig.hot_keys this back end implements
+ *
+ * Open addressing has no chains to move along and no hot key cache.
+ *
+ * @return int -> HOT_* bits (see hot.h)
+ */
+int hot_keys_supported(void) {
+    return 0;
+}
+
+/**
+ * @brief Print how evenly the hash spreads the keys
+ *
+ * Histogram of how many buckets past its home each live key sits, the
+ * last bin counts keys that only fit in an overflow chain.
+ *
+ * @param chained ChainedHashTable* -> specific chained table
+ */
+void print_table_stats(ChainedHashTable* chained) {
+    size_t counts[MAX_PROBE_BUCKETS + 1] = {0};
+    size_t live_slots = 0;
+    size_t tombstones = 0;
+
+    for (size_t i = 0; i < chained->num_buckets; i++) {
+        Bucket* bucket = &chained->buckets[i];
+
+        for (int s = 0; s < BUCKET_SLOTS; s++) {
+            if (bucket->keys[s] == INVALID_KEY) {
+                continue;
+            }
+            if (bucket->values[s] == INVALID_VALUE) {
+                tombstones++;
+                continue;
+            }
+
+            size_t home = hash1(chained, bucket->keys[s], chained->num_buckets);
+            counts[(i - home) & (chained->num_buckets - 1)]++;
+            live_slots++;
+        }
+
+        for (OverflowItem* curr = chained->overflow[i]; curr != NULL; curr = curr->next) {
+            counts[MAX_PROBE_BUCKETS]++;
+        }
+    }
+
+    printf("num_buckets: %zu\n", chained->num_buckets);
+    print_length_histogram("probe_distances", counts, MAX_PROBE_BUCKETS + 1);
+    printf("load_factor: %f\n", (double)(live_slots + tombstones) / (chained->num_buckets * BUCKET_SLOTS));
+    printf("tombstones: %zu\n", tombstones);
+
+    TableStats snapshot;
+    get_table_stats(chained, &snapshot);
+    stats_print(&snapshot);
+}
@@ -0,0 +1,810 @@
+/**
+ * @file client.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Load generator for server.c
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Every thread opens one connection (or claims one shared memory channel
+ * with -M) and generates the same operations as the driver's -g mode
+ * (workload.h). Operations of one kind are collected until -k of them
+ * make a request, and up to -d requests are in flight at once. A
+ * request's latency is from the moment it was queued to the moment its
+ * whole response arrived, so it includes the queueing behind the other
+ * requests in flight, the network stack (or the rings) and the server.
+ *
+ * Lookups and removes are checked against the value the generator
+ * expects, as in the driver, misses are counted apart.
+ */
+
+#include "chained.h"
+#include "protocol.h"
+#include "workload.h"
+#include "latency.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+// Local constants
+#define CLIENT_DEPTH 16                               // requests in flight per thread
+#define CLIENT_KEYS 32                                // keys per request
+#define CLIENT_POLL_MS 100                            // longest wait for the server
+#define CLIENT_WORKLOAD "typical_with_misses,time=10"
+
+/**
+ * @struct ClientConnection
+ * @brief one thread's way to the server
+ *
+ * Requests are staged in out and leave from there, through send() or
+ * into the request ring once it has room.
+ *
+ * @param fd int -> socket (-1 with shared memory)
+ * @param channel ShmChannel* -> claimed channel (NULL with TCP)
+ * @param out char* -> staged requests
+ * @param out_start size_t -> first byte not yet sent
+ * @param out_end size_t -> bytes staged
+ * @param out_capacity size_t -> size of out
+ * @param in char* -> received responses (TCP only)
+ * @param in_start size_t -> first byte not yet taken
+ * @param in_end size_t -> bytes received
+ * @param in_capacity size_t -> size of in
+ */
+typedef struct {
+    int fd; /** @brief socket (-1 with shared memory) */
+    ShmChannel* channel; /** @brief claimed channel (NULL with TCP) */
+    char* out; /** @brief staged requests */
+    size_t out_start; /** @brief first byte not yet sent */
+    size_t out_end; /** @brief bytes staged */
+    size_t out_capacity; /** @brief size of out */
+    char* in; /** @brief received responses (TCP only) */
+    size_t in_start; /** @brief first byte not yet taken */
+    size_t in_end; /** @brief bytes received */
+    size_t in_capacity; /** @brief size of in */
+} ClientConnection;
+
+/**
+ * @struct PendingRequest
+ * @brief request in flight
+ *
+ * @param request ServerRequest -> header that was sent
+ * @param start uint64_t -> ticks when it was queued
+ * @param keys uint64_t* -> its keys
+ * @param values uint64_t* -> values sent (inserts) or expected (lookups and removes)
+ */
+typedef struct {
+    ServerRequest request; /** @brief header that was sent */
+    uint64_t start; /** @brief ticks when it was queued */
+    uint64_t* keys; /** @brief its keys */
+    uint64_t* values; /** @brief values sent (inserts) or expected (lookups and removes) */
+} PendingRequest;
+
+/**
+ * @struct ClientCounts
+ * @brief what one thread got back
+ *
+ * @param requests uint64_t[] -> requests per SERVER_OP_* kind
+ * @param keys uint64_t[] -> keys per SERVER_OP_* kind
+ * @param hits uint64_t -> lookups and removes that found their key
+ * @param misses uint64_t -> lookups and removes that did not
+ * @param failed_match uint64_t -> hits with a value other than the expected one
+ */
+typedef struct {
+    uint64_t requests[SERVER_OP_REMOVE + 1]; /** @brief requests per SERVER_OP_* kind */
+    uint64_t keys[SERVER_OP_REMOVE + 1]; /** @brief keys per SERVER_OP_* kind */
+    uint64_t hits; /** @brief lookups and removes that found their key */
+    uint64_t misses; /** @brief lookups and removes that did not */
+    uint64_t failed_match; /** @brief hits with a value other than the expected one */
+} __attribute__((aligned(64))) ClientCounts;
+
+/**
+ * @struct ClientRun
+ * @brief what every thread shares
+ *
+ * @param host const char* -> server host
+ * @param port const char* -> server port
+ * @param region ShmRegion* -> mapped channels (NULL with TCP)
+ * @param depth int -> requests in flight per thread
+ * @param keys_per_request int -> keys per request
+ * @param workload Workload -> operation generator
+ * @param counts ClientCounts* -> one per thread
+ * @param latency LatencyRecorder* -> one per thread
+ * @param failed volatile int -> threads that lost their connection
+ * @param start double -> when the measured run started
+ * @param start_ticks uint64_t -> latency_ticks() at the same time
+ */
+typedef struct {
+    const char* host; /** @brief server host */
+    const char* port; /** @brief server port */
+    ShmRegion* region; /** @brief mapped channels (NULL with TCP) */
+    int depth; /** @brief requests in flight per thread */
+    int keys_per_request; /** @brief keys per request */
+    Workload workload; /** @brief operation generator */
+    ClientCounts* counts; /** @brief one per thread */
+    LatencyRecorder* latency; /** @brief one per thread */
+    volatile int failed; /** @brief threads that lost their connection */
+    double start; /** @brief when the measured run started */
+    uint64_t start_ticks; /** @brief latency_ticks() at the same time */
+} ClientRun;
+
+/**
+ * @brief request kind of a generated operation
+ *
+ * @param hash_op char -> 'I', 'L' or 'D'
+ * @return uint32_t -> SERVER_OP_*
+ */
+static inline uint32_t op_of(char hash_op) {
+    return hash_op == 'L' ? SERVER_OP_LOOKUP : hash_op == 'I' ? SERVER_OP_INSERT : SERVER_OP_REMOVE;
+}
+
+/**
+ * @brief Open a TCP connection to the server
+ *
+ * @param run ClientRun* -> shared state
+ * @param connection ClientConnection* -> fd set
+ * @return int -> 0 on failure
+ */
+static int connect_tcp(ClientRun* run, ClientConnection* connection) {
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* addresses;
+
+    if (getaddrinfo(run->host, run->port, &hints, &addresses) != 0) {
+        return 0;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* address = addresses; address != NULL; address = address->ai_next) {
+        fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+
+    if (fd < 0) {
+        return 0;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    connection->fd = fd;
+    return 1;
+}
+
+/**
+ * @brief Claim a free shared memory channel
+ *
+ * Starts looking at the thread's own index, so threads rarely race for
+ * the same one.
+ *
+ * @param run ClientRun* -> shared state
+ * @param thread int -> thread number
+ * @param connection ClientConnection* -> channel set
+ * @return int -> 0 if every channel is taken
+ */
+static int claim_channel(ClientRun* run, int thread, ClientConnection* connection) {
+    uint32_t num_channels = run->region->num_channels;
+
+    for (uint32_t i = 0; i < num_channels; i++) {
+        ShmChannel* channel = &run->region->channels[(thread + i) % num_channels];
+        uint32_t state;
+
+        #pragma omp atomic compare capture seq_cst
+        {
+            state = channel->state;
+            if (channel->state == SHM_CHANNEL_FREE) {
+                channel->state = SHM_CHANNEL_OPEN;
+            }
+        }
+
+        if (state == SHM_CHANNEL_FREE) {
+            connection->channel = channel;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Move staged requests into the request ring
+ *
+ * A request that would wrap goes to the start of the ring behind a
+ * SERVER_OP_PAD header. Stops at the first one that does not fit yet.
+ *
+ * @param connection ClientConnection* -> connection with a channel
+ */
+static void push_channel(ClientConnection* connection) {
+    ShmRing* ring = &connection->channel->requests;
+    char* data = connection->channel->request_data;
+    uint64_t written = ring->written;
+    uint64_t published = written;
+    uint64_t read = ring_read(ring);
+
+    while (connection->out_start < connection->out_end) {
+        const ServerRequest* request = (const ServerRequest*)(connection->out + connection->out_start);
+        size_t bytes = request_bytes(request);
+        size_t offset = written & (SHM_RING_BYTES - 1);
+        size_t pad = SHM_RING_BYTES - offset < bytes ? SHM_RING_BYTES - offset : 0;
+
+        if (written + pad + bytes - read > SHM_RING_BYTES) {
+            break;
+        }
+
+        if (pad > 0) {
+            ServerRequest skip = { .op = SERVER_OP_PAD, .count = 0 };
+            memcpy(data + offset, &skip, sizeof(skip));
+            written += pad;
+        }
+
+        memcpy(data + (written & (SHM_RING_BYTES - 1)), request, bytes);
+        written += bytes;
+        connection->out_start += bytes;
+    }
+
+    if (written != published) {
+        ring_publish(ring, written);
+    }
+}
+
+/**
+ * @brief Send staged requests and receive responses over TCP
+ *
+ * @param connection ClientConnection* -> connection with a socket
+ * @param block int -> wait up to CLIENT_POLL_MS for the socket
+ * @return int -> 0 if the server closed the connection
+ */
+static int pump_socket(ClientConnection* connection, int block) {
+    struct pollfd ready = { .fd = connection->fd, .events = POLLIN };
+
+    if (connection->out_start < connection->out_end) {
+        ready.events |= POLLOUT;
+    }
+
+    if (poll(&ready, 1, block ? CLIENT_POLL_MS : 0) <= 0) {
+        return 1;
+    }
+
+    while (connection->out_start < connection->out_end) {
+        ssize_t sent = send(connection->fd, connection->out + connection->out_start, connection->out_end - connection->out_start, MSG_NOSIGNAL);
+
+        if (sent > 0) {
+            connection->out_start += sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return 0;
+        }
+    }
+
+    if (connection->in_start > 0) {
+        memmove(connection->in, connection->in + connection->in_start, connection->in_end - connection->in_start);
+        connection->in_end -= connection->in_start;
+        connection->in_start = 0;
+    }
+
+    while (connection->in_end < connection->in_capacity) {
+        ssize_t received = recv(connection->fd, connection->in + connection->in_end, connection->in_capacity - connection->in_end, 0);
+
+        if (received > 0) {
+            connection->in_end += received;
+        } else if (received == 0) {
+            return 0;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Move requests towards the server and responses back
+ *
+ * @param connection ClientConnection* -> specific connection
+ * @param block int -> nothing else to do, a socket may wait and a channel yields
+ * @return int -> 0 if the connection is gone
+ */
+static int pump(ClientConnection* connection, int block) {
+    int alive = 1;
+
+    if (connection->channel) {
+        uint32_t state;
+
+        #pragma omp atomic read seq_cst
+        state = connection->channel->state;
+
+        push_channel(connection);
+        alive = state == SHM_CHANNEL_OPEN;
+
+        // Nothing to do but wait for the server, give its thread the core if they share one
+        if (block) {
+            sched_yield();
+        }
+    } else {
+        alive = pump_socket(connection, block);
+    }
+
+    if (connection->out_start == connection->out_end) {
+        connection->out_start = 0;
+        connection->out_end = 0;
+    }
+
+    return alive;
+}
+
+/**
+ * @brief Stage one request
+ *
+ * There is always room, out holds depth of the largest requests and at
+ * most depth are in flight.
+ *
+ * @param connection ClientConnection* -> specific connection
+ * @param pending const PendingRequest* -> header, keys and values
+ */
+static void stage_request(ClientConnection* connection, const PendingRequest* pending) {
+    size_t bytes = request_bytes(&pending->request);
+
+    if (connection->out_end + bytes > connection->out_capacity) {
+        memmove(connection->out, connection->out + connection->out_start, connection->out_end - connection->out_start);
+        connection->out_end -= connection->out_start;
+        connection->out_start = 0;
+    }
+
+    char* cursor = connection->out + connection->out_end;
+    size_t key_bytes = pending->request.count * sizeof(uint64_t);
+
+    memcpy(cursor, &pending->request, sizeof(ServerRequest));
+    memcpy(cursor + sizeof(ServerRequest), pending->keys, key_bytes);
+    if (pending->request.op == SERVER_OP_INSERT) {
+        memcpy(cursor + sizeof(ServerRequest) + key_bytes, pending->values, key_bytes);
+    }
+
+    connection->out_end += bytes;
+}
+
+/**
+ * @brief Take one whole response if it has arrived
+ *
+ * @param connection ClientConnection* -> specific connection
+ * @param bytes size_t -> size of the response
+ * @param out uint64_t* -> response words
+ * @return int -> 0 if it has not arrived yet
+ */
+static int take_response(ClientConnection* connection, size_t bytes, uint64_t* out) {
+    if (connection->channel == NULL) {
+        if (connection->in_end - connection->in_start < bytes) {
+            return 0;
+        }
+        memcpy(out, connection->in + connection->in_start, bytes);
+        connection->in_start += bytes;
+        return 1;
+    }
+
+    ShmRing* ring = &connection->channel->responses;
+    uint64_t read = ring->read;
+
+    if (ring_written(ring) - read < bytes) {
+        return 0;
+    }
+
+    size_t offset = read & (SHM_RING_BYTES - 1);
+    size_t first = SHM_RING_BYTES - offset < bytes ? SHM_RING_BYTES - offset : bytes;
+
+    memcpy(out, connection->channel->response_data + offset, first);
+    memcpy((char*)out + first, connection->channel->response_data, bytes - first);
+    ring_release(ring, read + bytes);
+
+    return 1;
+}
+
+/**
+ * @brief Check a response against what was asked
+ *
+ * @param pending const PendingRequest* -> the request
+ * @param response const uint64_t* -> its response
+ * @param counts ClientCounts* -> counters of the calling thread
+ */
+static void check_response(const PendingRequest* pending, const uint64_t* response, ClientCounts* counts) {
+    uint32_t op = pending->request.op;
+    uint32_t count = pending->request.count;
+
+    counts->requests[op]++;
+    counts->keys[op] += count;
+
+    if (op == SERVER_OP_INSERT) {
+        counts->failed_match += response[0] != count;
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (response[i] == INVALID_VALUE) {
+            counts->misses++;
+        } else {
+            counts->hits++;
+            counts->failed_match += response[i] != pending->values[i];
+        }
+    }
+}
+
+/**
+ * @brief Run one thread: connect, preload its share, then generate until done
+ *
+ * Meets the other threads at two barriers, once the preload is in and
+ * once the clock has started, so it must be called by every thread of
+ * the team.
+ *
+ * @param run ClientRun* -> shared state
+ * @param thread int -> thread number
+ * @param num_threads int -> threads in the team
+ * @param preload_keys const uint64_t* -> every preloaded key (NULL for none)
+ * @param preload_values const uint64_t* -> value per preloaded key
+ */
+static void run_client(ClientRun* run, int thread, int num_threads, const uint64_t* preload_keys, const uint64_t* preload_values) {
+    const WorkloadConfig* config = &run->workload.config;
+    ClientCounts* counts = &run->counts[thread];
+    LatencyRecorder* recorder = &run->latency[thread];
+    size_t k = run->keys_per_request;
+    int depth = run->depth;
+
+    ClientConnection connection = { .fd = -1 };
+    connection.out_capacity = depth * (sizeof(ServerRequest) + 2 * k * sizeof(uint64_t));
+    connection.in_capacity = depth * k * sizeof(uint64_t);
+    connection.out = aligned_alloc(64, connection.out_capacity);
+    connection.in = aligned_alloc(64, connection.in_capacity);
+
+    // One slot per request in flight plus one group per kind being collected
+    PendingRequest* pending = malloc(depth * sizeof(PendingRequest));
+    PendingRequest groups[SERVER_OP_REMOVE + 1];
+    uint64_t* words = malloc((depth + SERVER_OP_REMOVE + 1) * 2 * k * sizeof(uint64_t));
+    uint64_t* response = malloc(k * sizeof(uint64_t));
+
+    for (int i = 0; i < depth; i++) {
+        pending[i].keys = words + 2 * k * i;
+        pending[i].values = pending[i].keys + k;
+    }
+    for (int op = 0; op <= SERVER_OP_REMOVE; op++) {
+        groups[op].request = (ServerRequest){ .op = op, .count = 0 };
+        groups[op].keys = words + 2 * k * (depth + op);
+        groups[op].values = groups[op].keys + k;
+    }
+
+    int alive = run->region ? claim_channel(run, thread, &connection) : connect_tcp(run, &connection);
+
+    if (!alive) {
+        printf("thread %d could not %s\n", thread, run->region ? "claim a channel" : "connect");
+    }
+
+    // Preload, one request at a time
+    if (alive && preload_keys != NULL) {
+        size_t first = config->preload * thread / num_threads;
+        size_t last = config->preload * (thread + 1) / num_threads;
+
+        for (size_t i = first; alive && i < last; i += k) {
+            PendingRequest* request = &pending[0];
+            size_t count = last - i < k ? last - i : k;
+
+            request->request = (ServerRequest){ .op = SERVER_OP_INSERT, .count = count };
+            memcpy(request->keys, preload_keys + i, count * sizeof(uint64_t));
+            memcpy(request->values, preload_values + i, count * sizeof(uint64_t));
+            stage_request(&connection, request);
+
+            while ((alive = pump(&connection, 1)) && !take_response(&connection, response_bytes(&request->request), response)) {
+            }
+        }
+    }
+
+    #pragma omp barrier
+
+    #pragma omp single
+    {
+        run->start = omp_get_wtime();
+        run->start_ticks = latency_ticks();
+    }
+
+    WorkloadThread generator;
+    workload_thread_init(&run->workload, &generator, thread);
+
+    uint64_t quota = 0;
+    if (config->num_ops > 0) {
+        quota = config->num_ops / num_threads + ((uint64_t)thread < config->num_ops % num_threads);
+    }
+
+    uint64_t sent = 0;
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    int generating = alive;
+
+    while (alive) {
+        double elapsed = omp_get_wtime() - run->start;
+
+        if (generating && ((quota > 0 && sent >= quota) || (config->duration > 0.0 && elapsed >= config->duration))) {
+            generating = 0;
+        }
+
+        // Fill the window, a group that reaches k keys becomes a request
+        while (generating && tail - head < (uint64_t)depth && (quota == 0 || sent < quota)) {
+            BatchItem item;
+            double progress = quota > 0 ? (double)sent / quota : elapsed / config->duration;
+
+            workload_generate(&run->workload, &generator, progress, &item, 1);
+
+            PendingRequest* group = &groups[op_of(item.hash_op)];
+            group->keys[group->request.count] = item.key;
+            group->values[group->request.count] = item.value;
+
+            if (++group->request.count < k) {
+                continue;
+            }
+
+            PendingRequest* request = &pending[tail % depth];
+            request->request = group->request;
+            request->start = latency_ticks();
+            memcpy(request->keys, group->keys, k * sizeof(uint64_t));
+            memcpy(request->values, group->values, k * sizeof(uint64_t));
+            stage_request(&connection, request);
+
+            sent += k;
+            tail++;
+            group->request.count = 0;
+        }
+
+        if (!generating && head == tail) {
+            break;
+        }
+
+        alive = pump(&connection, !generating || tail - head == (uint64_t)depth);
+
+        while (head < tail) {
+            PendingRequest* request = &pending[head % depth];
+
+            if (!take_response(&connection, response_bytes(&request->request), response)) {
+                break;
+            }
+
+            uint64_t done = latency_ticks();
+            int kind = request->request.op == SERVER_OP_LOOKUP ? LATENCY_LOOKUP : request->request.op == SERVER_OP_INSERT ? LATENCY_INSERT : LATENCY_DELETE;
+
+            latency_record(&recorder->kinds[kind], done - request->start);
+            check_response(request, response, counts);
+            head++;
+        }
+    }
+
+    if (head != tail || (connection.channel == NULL && connection.fd < 0)) {
+        #pragma omp atomic update
+        run->failed++;
+    }
+
+    #pragma omp barrier
+
+    if (connection.channel) {
+        #pragma omp atomic write seq_cst
+        connection.channel->state = SHM_CHANNEL_CLOSED;
+    }
+    if (connection.fd >= 0) {
+        close(connection.fd);
+    }
+
+    free(response);
+    free(words);
+    free(pending);
+    free(connection.in);
+    free(connection.out);
+}
+
+/**
+ * @brief Map the server's shared memory channels
+ *
+ * @param name const char* -> name the server was started with
+ * @return ShmRegion* -> mapped region, NULL if it is missing or not a channel region
+ */
+static ShmRegion* open_region(const char* name) {
+    int fd = shm_open(name, O_RDWR, 0);
+    struct stat info;
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ShmRegion)) {
+        close(fd);
+        return NULL;
+    }
+
+    ShmRegion* region = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (region == MAP_FAILED) {
+        return NULL;
+    }
+
+    if (memcmp(region->magic, SHM_MAGIC, sizeof(region->magic)) != 0 || region->version != SHM_VERSION
+        || shm_region_bytes(region->num_channels) > (size_t)info.st_size) {
+        munmap(region, info.st_size);
+        return NULL;
+    }
+
+    return region;
+}
+
+int main(int argc, char *argv[]) {
+
+    int num_threads = DEFAULT_NUM_THREADS;
+    const char* host = "127.0.0.1";
+    char port[16];
+    char* shm_name = NULL;
+    int depth = CLIENT_DEPTH;
+    int keys_per_request = CLIENT_KEYS;
+    char* latency_file = NULL;
+    WorkloadConfig workload_config;
+
+    snprintf(port, sizeof(port), "%d", SERVER_PORT);
+    workload_parse(CLIENT_WORKLOAD, &workload_config);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:t:d:k:g:M:L:")) != -1) {
+        switch (opt) {
+            case 'h':
+                host = optarg;
+                break;
+            case 'p':
+                snprintf(port, sizeof(port), "%s", optarg);
+                break;
+            case 't':
+                num_threads = atoi(optarg);
+                if (num_threads < 1) {
+                    printf("number of threads must be > 1, setting to default\n");
+                    num_threads = DEFAULT_NUM_THREADS;
+                }
+                if (num_threads > MAX_THREADS) {
+                    printf("number of threads must be <= %d, setting to max\n", MAX_THREADS);
+                    num_threads = MAX_THREADS;
+                }
+                break;
+            case 'd':
+                depth = atoi(optarg);
+                if (depth < 1) {
+                    printf("requests in flight must be >= 1, setting to default\n");
+                    depth = CLIENT_DEPTH;
+                }
+                break;
+            case 'k':
+                keys_per_request = atoi(optarg);
+                if (keys_per_request < 1 || keys_per_request > SERVER_MAX_KEYS) {
+                    printf("keys per request must be between 1 and %d, setting to default\n", SERVER_MAX_KEYS);
+                    keys_per_request = CLIENT_KEYS;
+                }
+                break;
+            case 'g':
+                if (!workload_parse(optarg, &workload_config)) {
+                    printf("workload must be [preset][,name=value...] with a positive ops or time, see README\n");
+                    exit(1);
+                }
+                break;
+            case 'M':
+                shm_name = optarg;
+                break;
+            case 'L':
+                latency_file = optarg;
+                break;
+            default:
+                printf("format to use: %s [-h host] [-p port] [-t num_threads] [-d requests_in_flight] [-k keys_per_request] [-g workload] [-M shm_name] [-L latency_csv]\n", argv[0]);
+                exit(1);
+        }
+    }
+
+    omp_set_num_threads(num_threads);
+
+    ClientRun run = {
+        .host = host,
+        .port = port,
+        .depth = depth,
+        .keys_per_request = keys_per_request,
+        .counts = aligned_alloc(64, num_threads * sizeof(ClientCounts)),
+        .latency = latency_create(num_threads, 1),
+    };
+    memset(run.counts, 0, num_threads * sizeof(ClientCounts));
+    workload_init(&run.workload, &workload_config, num_threads);
+
+    if (shm_name != NULL) {
+        run.region = open_region(shm_name);
+        if (run.region == NULL) {
+            printf("could not map shared memory %s, is the server running with -M?\n", shm_name);
+            exit(1);
+        }
+    }
+
+    uint64_t* preload_keys = NULL;
+    uint64_t* preload_values = NULL;
+    size_t preload = run.workload.config.preload;
+
+    if (preload > 0) {
+        preload_keys = malloc(preload * sizeof(uint64_t));
+        preload_values = malloc(preload * sizeof(uint64_t));
+        workload_preload(&run.workload, preload_keys, preload_values);
+    }
+
+    double preload_start = omp_get_wtime();
+
+    #pragma omp parallel
+    {
+        run_client(&run, omp_get_thread_num(), omp_get_num_threads(), preload_keys, preload_values);
+    }
+
+    double end = omp_get_wtime();
+    uint64_t end_ticks = latency_ticks();
+
+    if (preload > 0) {
+        printf("preload: %zu keys in %f seconds\n", preload, run.start - preload_start);
+    }
+
+    ClientCounts total = {0};
+    for (int t = 0; t < num_threads; t++) {
+        for (int op = SERVER_OP_LOOKUP; op <= SERVER_OP_REMOVE; op++) {
+            total.requests[op] += run.counts[t].requests[op];
+            total.keys[op] += run.counts[t].keys[op];
+        }
+        total.hits += run.counts[t].hits;
+        total.misses += run.counts[t].misses;
+        total.failed_match += run.counts[t].failed_match;
+    }
+
+    uint64_t requests = total.requests[SERVER_OP_LOOKUP] + total.requests[SERVER_OP_INSERT] + total.requests[SERVER_OP_REMOVE];
+    uint64_t keys = total.keys[SERVER_OP_LOOKUP] + total.keys[SERVER_OP_INSERT] + total.keys[SERVER_OP_REMOVE];
+    double seconds = end - run.start;
+
+    printf("Execution time: %f\n", seconds);
+    printf("requests: %" PRIu64 " (%.0f per second), keys: %" PRIu64 " (%.3f Mops/s)\n", requests, requests / seconds, keys, keys / seconds / 1e6);
+    printf("lookups: %" PRIu64 ", inserts: %" PRIu64 ", removes: %" PRIu64 ", hits: %" PRIu64 ", misses: %" PRIu64 ", failed matches: %" PRIu64 "\n",
+           total.keys[SERVER_OP_LOOKUP], total.keys[SERVER_OP_INSERT], total.keys[SERVER_OP_REMOVE], total.hits, total.misses, total.failed_match);
+
+    if (run.failed > 0) {
+        printf("%d threads lost their connection\n", run.failed);
+    }
+
+    // Request round trips, per request kind
+    FILE* csv = latency_file ? fopen(latency_file, "w") : NULL;
+    if (latency_file && csv == NULL) {
+        printf("could not open %s, printing latencies only\n", latency_file);
+    }
+    double ticks_per_ns = (end_ticks - run.start_ticks) / ((end - run.start) * 1e9);
+    latency_report(run.latency, num_threads, ticks_per_ns, csv);
+    if (csv) {
+        fclose(csv);
+    }
+
+    free(preload_values);
+    free(preload_keys);
+    latency_destroy(run.latency);
+    free(run.counts);
+
+    return run.failed > 0;
+}
@@ -0,0 +1,1423 @@
+/**
+ * @file cuckoo.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Bucketized cuckoo implementation using striped locks
+ * @version 0.2
+ * @date 2026-10-14
+ *
+ * Cuckoo hashing is a method of dealing with hash table collisions.
+ * Each hash key has two possible locations for storage. If the first
+ * location is taken, it checks the second one. If both are taken, an
+ * item already in one of them is moved to its own other location to
+ * make room, which may need another item moved first, and so on.
+ *
+ * Bucketized cuckoo hashing changes the standard 1D array of key/values
+ * into an array of buckets, each of which can hold multiple key/values.
+ * This shortens the chain of moves because now instead of checking
+ * for only two possible locations, we are now checking two possible
+ * buckets (BUCKET_SIZE entries each). A lookup never reads more than
+ * those two buckets.
+ *
+ * The first version kicked a random item, took its place and then went
+ * looking for a home for the kicked item, holding locks the whole way
+ * and parking the item where lookups had to search every thread for it.
+ * Now the path of moves is searched first, breadth first and without any
+ * lock (at most MAX_PATH_LEN moves, so short paths are found first). The
+ * moves are then done from the free end back to the key's bucket, each
+ * one holding only the two buckets it touches and checking the slot
+ * still holds what the search saw. An item is always copied to its new
+ * slot before it leaves the old one, so it is never out of the table. A
+ * stale path is searched again.
+ *
+ * The implementation in this file uses a striped lock to provide mutual
+ * exclusion to the buckets. Rather than having a lock for each specific
+ * bucket, which could take up a lot of memory for really large tables,
+ * we assign one lock for multiple buckets in a striped fashion.
+ * Basically, a bucket's lock is in an array of locks where the index
+ * is bucket_index & (num_locks - 1). Every write holds the stripes of
+ * both buckets it touches, always taken in index order.
+ *
+ * Lookups do not lock, every stripe is also a seqlock like with
+ * optimistic_reads in chained_locked.c: seq is odd while a writer holds
+ * the stripe, and a lookup that saw the same even values on both of its
+ * stripes before and after reading its two buckets is consistent. Only
+ * after OPTIMISTIC_RETRIES torn reads does it take the locks.
+ *
+ * An insert that finds no path at all goes to a small locked stash hung
+ * off its first bucket and asks for a resize, the same way the overflow
+ * chains of chained_open.c keep inserts working until the driver gets to
+ * it. Lookups only look at the stash while it is not empty.
+ *
+ * Only the stop-the-world resize() is implemented. With incremental_resize
+ * set the table still asks for resize() through needs_resize().
+ *
+ * References:
+ * https://doi.org/10.1007/978-3-031-39698-4_19
+ * https://en.wikipedia.org/wiki/Cuckoo_hashing
+ * https://doi.org/10.1145/2592798.2592820 (libcuckoo, breadth first paths)
+ */
+
+#include "chained.h"
+#include "hash.h"
+#include "stats.h"
+#include "numa.h"
+#include "hugepage.h"
+#include "bulk.h"
+#include "snapshot.h"
+#include "spec.h"
+#include "policy.h"
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+// Slots are 64 bit with INVALID_KEY for a free one, see spec.h
+#if TABLE_KEY_BITS != 64 || TABLE_VALUE_BITS != 64
+#error "cuckoo.c stores 64 bit keys and values, build it without TABLE_KEY_BITS / TABLE_VALUE_BITS"
+#endif
+
+// Local constants
+#define BUCKET_SIZE 4         // depth of each bucket in the table, one cache line
+#define MAX_PATH_LEN 5        // most items a cuckoo path moves
+#define MAX_BFS_NODES 512     // buckets a path search may visit
+#define MAX_PATH_RETRIES 8    // stale paths before the key goes to the stash
+#define OPTIMISTIC_RETRIES 8  // lockless lookup attempts before falling back to the stripe locks
+#define BATCH_GROUP 32        // keys prefetched together by lookup_batch/insert_batch
+#define STASH_DEPTH (MAX_PATH_LEN + 1) // op_depths bin of operations that went to the stash
+
+// __builtin_prefetch wants a constant read/write hint
+#define PREFETCH(addr, for_write) ((for_write) ? __builtin_prefetch((addr), 1) : __builtin_prefetch((addr), 0))
+
+// What place_key did with a key
+#define PLACED_UPDATE 0
+#define PLACED_BUCKET 1
+#define PLACED_STASH 2
+
+
+/**
+ * @struct Bucket
+ * @brief Bucket at specific hash index, exactly one cache line
+ *
+ * Keys are grouped so a probe compares them without touching values.
+ * A free slot has INVALID_KEY.
+ *
+ * @param keys uint64_t[] -> slot keys
+ * @param values uint64_t[] -> slot values
+ */
+typedef struct {
+    uint64_t keys[BUCKET_SIZE]; /** @brief slot keys (INVALID_KEY when free) */
+    uint64_t values[BUCKET_SIZE]; /** @brief slot values */
+} __attribute__((aligned(64))) Bucket;
+
+/**
+ * @struct StashItem
+ * @brief Item that found no cuckoo path
+ *
+ * @param key uint64_t -> hash table key
+ * @param value uint64_t -> item value
+ * @param next StashItem* -> next item in the stash
+ */
+typedef struct StashItem {
+    uint64_t key; /** @brief hash table key */
+    uint64_t value; /** @brief item value */
+    struct StashItem* next; /** @brief next item in the stash */
+} StashItem;
+
+/* seq is odd while a writer holds the lock, see lookup(). contended and
+wait_time are only written by the thread holding the lock. */
+typedef struct {
+    volatile uint64_t seq;
+    omp_lock_t lock;
+    uint64_t contended;
+    double wait_time;
+    char padding[64 - 2 * sizeof(uint64_t) - sizeof(double) - sizeof(omp_lock_t)];
+} PaddedLock;
+
+/**
+ * @struct PathNode
+ * @brief one bucket reached by a path search
+ *
+ * @param bucket size_t -> bucket index
+ * @param parent int -> node the key came from (-1 for the two buckets of the new key)
+ * @param slot int -> slot of the parent bucket holding key
+ * @param key uint64_t -> key that would move from the parent into bucket
+ * @param depth int -> moves from the new key's buckets to here
+ */
+typedef struct {
+    size_t bucket; /** @brief bucket index */
+    int parent; /** @brief node the key came from (-1 for the two buckets of the new key) */
+    int slot; /** @brief slot of the parent bucket holding key */
+    uint64_t key; /** @brief key that would move from the parent into bucket */
+    int depth; /** @brief moves from the new key's buckets to here */
+} PathNode;
+
+/**
+ * @struct PathStep
+ * @brief one slot of a cuckoo path
+ *
+ * @param bucket size_t -> bucket index
+ * @param slot int -> slot in bucket
+ * @param key uint64_t -> key the search saw there (INVALID_KEY at the free end)
+ */
+typedef struct {
+    size_t bucket; /** @brief bucket index */
+    int slot; /** @brief slot in bucket */
+    uint64_t key; /** @brief key the search saw there (INVALID_KEY at the free end) */
+} PathStep;
+
+/**
+ * @struct ChainedHashTable
+ * @brief cuckoo hash table
+ *
+ * The name is kept so the back end plugs into chained.h unchanged.
+ *
+ * @param buckets Bucket* -> pointer to array of buckets
+ * @param num_buckets size_t -> number of buckets
+ * @param stash StashItem** -> per first bucket list of items that found no path
+ * @param stashed volatile size_t -> items in all stashes
+ * @param locks PaddedLock* -> pointer to array of locks
+ * @param num_locks size_t -> number of locks
+ * @param config TableConfig -> settings this table was created with
+ * @param resize_needed volatile int -> POLICY_* reason once the policy asks for resize(), cleared by resize()
+ * @param long_chains volatile uint64_t -> inserts that went to the stash since the last resize
+ * @param stats StatsCounters* -> per-thread counters, handed to the next table on resize
+ */
+struct ChainedHashTable{
+    Bucket* buckets; /** @brief pointer to array of buckets */
+    size_t num_buckets; /** @brief number of buckets */
+
+    StashItem** stash; /** @brief per first bucket list of items that found no path (stripe locked) */
+    volatile size_t stashed; /** @brief items in all stashes, lookups skip them while 0 */
+
+    PaddedLock* locks; /** @brief pointer to array of locks */
+    size_t num_locks; /** @brief number of locks */
+
+    TableConfig config; /** @brief settings this table was created with */
+    volatile int resize_needed; /** @brief POLICY_* reason once the policy asks for resize(), cleared by resize() */
+    volatile uint64_t long_chains; /** @brief inserts that went to the stash since the last resize */
+
+    StatsCounters* stats; /** @brief per-thread counters, handed to the next table on resize */
+};
+
+/**
+ * @brief other bucket of a key
+ *
+ * The offset only depends on the top byte of the key's hash, so the
+ * other bucket of the other bucket is the first one again and a path
+ * search can find it from the bucket it is looking at.
+ *
+ * @param bucket size_t -> one bucket of the key
+ * @param hash uint64_t -> hash_key() of the key
+ * @param num_buckets size_t -> number of hash table buckets (power of two)
+ * @return size_t -> the key's other bucket
+ */
+static inline size_t alt_bucket(size_t bucket, uint64_t hash, size_t num_buckets) {
+    if (num_buckets == 1) {
+        return 0;
+    }
+
+    size_t offset = (size_t)(((hash >> 56) + 1) * 0xc6a4a7935bd1e995ULL) & (num_buckets - 1);
+
+    // A zero offset would give one bucket twice, flipping the low bit is still symmetric
+    return offset ? bucket ^ offset : bucket ^ 1;
+}
+
+/**
+ * @brief first hash function
+ *
+ * Mixer comes from hash.h.
+ *
+ * @param chained ChainedHashTable* -> table whose mixer to use
+ * @param key uint64_t -> hash table key
+ * @param num_buckets size_t -> number of hash table buckets (power of two)
+ * @return size_t -> hash1 index
+ */
+size_t hash1(ChainedHashTable* chained, uint64_t key, size_t num_buckets) {
+    return hash_key(key, chained->config.hash_function) & (num_buckets - 1);
+}
+
+/**
+ * @brief second hash function
+ *
+ * @param chained ChainedHashTable* -> table whose mixer to use
+ * @param key uint64_t -> hash table key
+ * @param num_buckets size_t -> number of hash table buckets (power of two)
+ * @return size_t -> hash2 index
+ */
+size_t hash2(ChainedHashTable* chained, uint64_t key, size_t num_buckets) {
+    uint64_t hash = hash_key(key, chained->config.hash_function);
+    return alt_bucket(hash & (num_buckets - 1), hash, num_buckets);
+}
+
+/**
+ * @brief both buckets of a key from one hash
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param key uint64_t -> hash table key
+ * @param first size_t* -> hash1 index
+ * @param second size_t* -> hash2 index
+ */
+static inline void key_buckets(ChainedHashTable* chained, uint64_t key, size_t* first, size_t* second) {
+    uint64_t hash = hash_key(key, chained->config.hash_function);
+
+    *first = hash & (chained->num_buckets - 1);
+    *second = alt_bucket(*first, hash, chained->num_buckets);
+}
+
+/**
+ * @brief get lock index for specific bucket
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param bucket_index size_t -> bucket index in table
+ * @return size_t -> lock index
+ */
+size_t get_lock_idx(ChainedHashTable* chained, size_t bucket_index) {
+    return bucket_index & (chained->num_locks - 1);
+}
+
+/**
+ * @brief allocate a 64 byte aligned array, placed as the config says
+ *
+ * The contents are undefined, the caller fills it in.
+ *
+ * @param config const TableConfig* -> numa and huge_pages
+ * @param bytes size_t -> size of the array (multiple of 64)
+ * @return void*
+ */
+static void* alloc_array(const TableConfig* config, size_t bytes) {
+    if (config->huge_pages) {
+        return huge_alloc(bytes, config->numa ? HUGE_PLACE_INTERLEAVE : HUGE_PLACE_ANY);
+    }
+
+    void* array = aligned_alloc(64, bytes);
+
+    if (config->numa) {
+        numa_interleave(array, bytes);
+    }
+
+    return array;
+}
+
+/**
+ * @brief free an array from alloc_array
+ *
+ * @param config const TableConfig* -> huge_pages
+ * @param array void* -> array to free
+ */
+static void free_array(const TableConfig* config, void* array) {
+    if (config->huge_pages) {
+        huge_free(array);
+    } else {
+        free(array);
+    }
+}
+
+/**
+ * @brief Create cuckoo hash table
+ *
+ * Both counts are rounded up to powers of two so indexes can be masked.
+ *
+ * @param num_buckets size_t -> initial number of buckets
+ * @param num_locks size_t -> initial number of locks
+ * @param config const TableConfig* -> settings to copy (NULL for TABLE_CONFIG_DEFAULT)
+ * @return ChainedHashTable*
+ */
+ChainedHashTable* create_table(size_t num_buckets, size_t num_locks, const TableConfig* config) {
+    ChainedHashTable* chained = malloc(sizeof(ChainedHashTable));
+    TableConfig default_config = TABLE_CONFIG_DEFAULT;
+
+    chained->config = config ? *config : default_config;
+    spec_config(&chained->config);
+    policy_config(&chained->config);
+    chained->resize_needed = 0;
+    chained->long_chains = 0;
+
+    num_buckets = policy_initial_buckets(&chained->config, num_buckets, BUCKET_SIZE);
+    num_locks = round_up_pow2(num_locks);
+
+    // More stripes than buckets buys nothing
+    if (num_locks > num_buckets) {
+        num_locks = num_buckets;
+    }
+
+    chained->num_buckets = num_buckets;
+    chained->num_locks = num_locks;
+
+    chained->buckets = alloc_array(&chained->config, num_buckets * sizeof(Bucket));
+
+    // initializing to signify not currently occupied
+    memset(chained->buckets, 0xFF, num_buckets * sizeof(Bucket));
+
+    chained->stash = calloc(num_buckets, sizeof(StashItem*));
+    chained->stashed = 0;
+
+    chained->locks = malloc(num_locks * sizeof(PaddedLock));
+
+    if (chained->config.numa) {
+        numa_interleave(chained->stash, num_buckets * sizeof(StashItem*));
+        numa_interleave(chained->locks, num_locks * sizeof(PaddedLock));
+    }
+
+    // omp_init_lock must be used to initialize every lock
+    for (size_t i = 0; i < num_locks; i++) {
+        chained->locks[i].seq = 0;
+        chained->locks[i].contended = 0;
+        chained->locks[i].wait_time = 0.0;
+        omp_init_lock(&chained->locks[i].lock);
+    }
+
+    chained->stats = stats_create();
+
+    return chained;
+}
+
+/**
+ * @brief Destroy cuckoo hash table
+ *
+ * @param chained ChainedHashTable* -> table to destroy
+ */
+void destroy_table(ChainedHashTable* chained) {
+
+    for (size_t i = 0; i < chained->num_buckets; i++) {
+        StashItem* curr = chained->stash[i];
+        while (curr != NULL) {
+            StashItem* temp = curr;
+            curr = curr->next;
+            free(temp);
+        }
+    }
+
+    // use omp_destroy_lock to remove each lock
+    for (size_t i = 0; i < chained->num_locks; i++) {
+        omp_destroy_lock(&chained->locks[i].lock);
+    }
+
+    free(chained->locks);
+    free(chained->stash);
+    free_array(&chained->config, chained->buckets);
+    stats_destroy(chained->stats);
+    free(chained);
+}
+
+/**
+ * @brief acquire one stripe lock
+ *
+ * The stripe sequence goes odd for as long as the lock is held. The
+ * clock is only read when the lock is already taken.
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param lock_idx size_t -> stripe to lock
+ */
+static inline void stripe_lock(ChainedHashTable* chained, size_t lock_idx) {
+    PaddedLock* stripe = &chained->locks[lock_idx];
+
+    if (!omp_test_lock(&stripe->lock)) {
+        double wait_start = omp_get_wtime();
+        omp_set_lock(&stripe->lock);
+        stripe->contended++;
+        stripe->wait_time += omp_get_wtime() - wait_start;
+    }
+
+    // Full barrier, nothing written below may become visible before the odd value
+    #pragma omp atomic update seq_cst
+    stripe->seq++;
+}
+
+/**
+ * @brief release one stripe lock
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param lock_idx size_t -> stripe to unlock
+ */
+static inline void stripe_unlock(ChainedHashTable* chained, size_t lock_idx) {
+    PaddedLock* stripe = &chained->locks[lock_idx];
+
+    #pragma omp atomic write release
+    stripe->seq = stripe->seq + 1;
+
+    omp_unset_lock(&stripe->lock);
+}
+
+/**
+ * @brief lock two buckets
+ *
+ * These are the two buckets that are possible for a specific key, or
+ * the two ends of one move of a cuckoo path.
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param first_bucket size_t -> first bucket
+ * @param second_bucket size_t -> second bucket
+ */
+static void lock_two_buckets(ChainedHashTable* chained, size_t first_bucket, size_t second_bucket) {
+    size_t first_lock = get_lock_idx(chained, first_bucket);
+    size_t second_lock = get_lock_idx(chained, second_bucket);
+
+    if (first_lock == second_lock) {
+        // If the locks are the same, just acquire that lock
+        stripe_lock(chained, first_lock);
+    } else if (first_lock < second_lock) {
+        /* It is possible that two threads may want the same two locks.
+        If Thread A wants lock 2 and lock 5, and Thread B wants them too,
+        there is a possibility that Thread A locks lock 2 and Thread B
+        locks lock 5 and then they are stuck. To prevent this, I have just
+        requried that they lock them in order. Someone will lock lock 2
+        first, and then try to lock lock 5 while the other waits for lock 2. */
+
+        stripe_lock(chained, first_lock);
+        stripe_lock(chained, second_lock);
+    } else {
+        stripe_lock(chained, second_lock);
+        stripe_lock(chained, first_lock);
+    }
+}
+
+/**
+ * @brief unlock two buckets
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param first_bucket size_t -> first bucket
+ * @param second_bucket size_t -> second bucket
+ */
+static void unlock_two_buckets(ChainedHashTable* chained, size_t first_bucket, size_t second_bucket) {
+    size_t first_lock = get_lock_idx(chained, first_bucket);
+    size_t second_lock = get_lock_idx(chained, second_bucket);
+
+    stripe_unlock(chained, first_lock);
+
+    if (second_lock != first_lock) {
+        stripe_unlock(chained, second_lock);
+    }
+}
+
+/**
+ * @brief ask the driver for a stop-the-world resize
+ *
+ * The first reason wins until resize() clears it.
+ *
+ * @param chained ChainedHashTable* -> table that wants a new size
+ * @param reason int -> POLICY_* reason, POLICY_KEEP does nothing
+ */
+static void request_resize(ChainedHashTable* chained, int reason) {
+    if (reason == POLICY_KEEP || !spec_resize_enabled(&chained->config)) {
+        return;
+    }
+
+    int temp_resize = 0;
+
+    #pragma omp atomic read
+    temp_resize = chained->resize_needed;
+
+    if (!temp_resize) {
+        #pragma omp atomic write
+        chained->resize_needed = reason;
+    }
+}
+
+/**
+ * @brief slot of a bucket holding key
+ *
+ * @param bucket Bucket* -> bucket to search
+ * @param key uint64_t -> key to find (INVALID_KEY finds a free slot)
+ * @return int -> slot, -1 if none
+ */
+static inline int find_in_bucket(Bucket* bucket, uint64_t key) {
+    for (int s = 0; s < BUCKET_SIZE; s++) {
+        uint64_t slot_key;
+
+        #pragma omp atomic read
+        slot_key = bucket->keys[s];
+
+        if (slot_key == key) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief fill a free slot
+ *
+ * Caller must hold the stripe of bucket. Atomic writes so a lockless
+ * reader never sees a torn word, the stripe sequence tells it the pair
+ * as a whole may be.
+ *
+ * @param bucket Bucket* -> bucket holding the slot
+ * @param s int -> free slot
+ * @param key uint64_t -> key value
+ * @param value uint64_t -> value value
+ */
+static inline void fill_slot(Bucket* bucket, int s, uint64_t key, uint64_t value) {
+    #pragma omp atomic write
+    bucket->values[s] = value;
+
+    #pragma omp atomic write
+    bucket->keys[s] = key;
+}
+
+/**
+ * @brief free a slot
+ *
+ * Caller must hold the stripe of bucket.
+ *
+ * @param bucket Bucket* -> bucket holding the slot
+ * @param s int -> slot to free
+ */
+static inline void clear_slot(Bucket* bucket, int s) {
+    #pragma omp atomic write
+    bucket->keys[s] = INVALID_KEY;
+
+    #pragma omp atomic write
+    bucket->values[s] = INVALID_VALUE;
+}
+
+/**
+ * @brief stash item holding key
+ *
+ * Caller must hold the stripe of first.
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param first size_t -> first bucket of key
+ * @param key uint64_t -> key to find
+ * @return StashItem* -> item, NULL if key is not stashed
+ */
+static StashItem* find_in_stash(ChainedHashTable* chained, size_t first, uint64_t key) {
+    for (StashItem* curr = chained->stash[first]; curr != NULL; curr = curr->next) {
+        if (curr->key == key) {
+            return curr;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief whether any key sits in a stash
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @return int -> 1 if lookups have to check the stash
+ */
+static inline int has_stash(ChainedHashTable* chained) {
+    size_t stashed;
+
+    #pragma omp atomic read
+    stashed = chained->stashed;
+
+    return stashed != 0;
+}
+
+/**
+ * @brief lookup key without taking its stripes
+ *
+ * Seqlock read over both stripes of key. Buckets never move (resize
+ * builds a new table), so whatever a torn read touches is valid memory
+ * and only its result is thrown away.
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param first size_t -> first bucket of key
+ * @param second size_t -> second bucket of key
+ * @param key uint64_t -> key value
+ * @param value_out uint64_t* -> value at key (INVALID_VALUE if key not in either bucket)
+ * @param depth_out size_t* -> 0 if found in the first bucket, 1 otherwise
+ * @return int -> 1 if the read was consistent, 0 if writers kept getting in the way
+ */
+static int optimistic_lookup(ChainedHashTable* chained, size_t first, size_t second, uint64_t key, uint64_t* value_out, size_t* depth_out) {
+    PaddedLock* first_stripe = &chained->locks[get_lock_idx(chained, first)];
+    PaddedLock* second_stripe = &chained->locks[get_lock_idx(chained, second)];
+
+    for (int attempt = 0; attempt < OPTIMISTIC_RETRIES; attempt++) {
+        uint64_t first_start;
+        uint64_t second_start;
+
+        #pragma omp atomic read seq_cst
+        first_start = first_stripe->seq;
+
+        #pragma omp atomic read seq_cst
+        second_start = second_stripe->seq;
+
+        if ((first_start | second_start) & 1) {
+            continue; // writer inside
+        }
+
+        uint64_t value = INVALID_VALUE;
+        size_t depth = 0;
+        Bucket* bucket = &chained->buckets[first];
+        int s = find_in_bucket(bucket, key);
+
+        if (s < 0) {
+            depth = 1;
+            bucket = &chained->buckets[second];
+            s = find_in_bucket(bucket, key);
+        }
+
+        if (s >= 0) {
+            #pragma omp atomic read
+            value = bucket->values[s];
+        }
+
+        uint64_t first_now;
+        uint64_t second_now;
+
+        #pragma omp atomic read seq_cst
+        first_now = first_stripe->seq;
+
+        #pragma omp atomic read seq_cst
+        second_now = second_stripe->seq;
+
+        if (first_now == first_start && second_now == second_start) {
+            *value_out = value;
+            *depth_out = depth;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief value of key, with its stripes held
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param first size_t -> first bucket of key
+ * @param second size_t -> second bucket of key
+ * @param key uint64_t -> key value
+ * @param depth_out size_t* -> 0 first bucket, 1 second bucket or missing, STASH_DEPTH if the stash was searched
+ * @return uint64_t* -> where the value of key lives, NULL if key is not in the table
+ */
+static uint64_t* locked_find(ChainedHashTable* chained, size_t first, size_t second, uint64_t key, size_t* depth_out) {
+    int s = find_in_bucket(&chained->buckets[first], key);
+
+    if (s >= 0) {
+        *depth_out = 0;
+        return &chained->buckets[first].values[s];
+    }
+
+    *depth_out = 1;
+    s = find_in_bucket(&chained->buckets[second], key);
+
+    if (s >= 0) {
+        return &chained->buckets[second].values[s];
+    }
+
+    if (has_stash(chained)) {
+        *depth_out = STASH_DEPTH;
+        StashItem* item = find_in_stash(chained, first, key);
+        return item ? &item->value : NULL;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief lookup key in cuckoo table
+ *
+ * Never more than the two buckets of key (and the stash while it is in
+ * use). Only takes the stripes when lockless attempts keep colliding
+ * with writers.
+ *
+ * @param chained ChainedHashTable -> specific cuckoo table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> value at key (INVALID_VALUE if key not found)
+ */
+uint64_t lookup(ChainedHashTable* chained, uint64_t key) {
+
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return INVALID_VALUE;
+    }
+
+    size_t first;
+    size_t second;
+    key_buckets(chained, key, &first, &second);
+
+    uint64_t value = INVALID_VALUE;
+    size_t depth;
+
+    if (!optimistic_lookup(chained, first, second, key, &value, &depth) || (value == INVALID_VALUE && has_stash(chained))) {
+        lock_two_buckets(chained, first, second);
+
+        uint64_t* slot = locked_find(chained, first, second, key, &depth);
+        value = slot ? *slot : INVALID_VALUE;
+
+        unlock_two_buckets(chained, first, second);
+    }
+
+    stats_depth(chained->stats, depth);
+
+    return value;
+}
+
+/**
+ * @brief search a cuckoo path from the buckets of a key to a free slot
+ *
+ * Breadth first over the buckets, reading keys without any lock, so the
+ * path found has the fewest moves. Each key met is a way into its other
+ * bucket.
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param first size_t -> first bucket of the key to place
+ * @param second size_t -> second bucket of the key to place
+ * @param path PathStep* -> filled in, path[0] in first or second, the last step is the free slot
+ * @return int -> steps in path (moves plus one), -1 if no free slot within MAX_PATH_LEN moves
+ */
+static int search_path(ChainedHashTable* chained, size_t first, size_t second, PathStep* path) {
+    PathNode nodes[MAX_BFS_NODES];
+    int head = 0;
+    int tail = 0;
+
+    nodes[tail++] = (PathNode){ .bucket = first, .parent = -1, .slot = -1, .key = INVALID_KEY, .depth = 0 };
+    nodes[tail++] = (PathNode){ .bucket = second, .parent = -1, .slot = -1, .key = INVALID_KEY, .depth = 0 };
+
+    for (; head < tail; head++) {
+        PathNode* node = &nodes[head];
+        Bucket* bucket = &chained->buckets[node->bucket];
+
+        for (int s = 0; s < BUCKET_SIZE; s++) {
+            uint64_t key;
+
+            #pragma omp atomic read
+            key = bucket->keys[s];
+
+            if (key == INVALID_KEY) {
+                int steps = node->depth + 1;
+                int n = head;
+
+                path[steps - 1] = (PathStep){ .bucket = node->bucket, .slot = s, .key = INVALID_KEY };
+
+                for (int i = steps - 2; i >= 0; i--) {
+                    PathNode* child = &nodes[n];
+                    n = child->parent;
+                    path[i] = (PathStep){ .bucket = nodes[n].bucket, .slot = child->slot, .key = child->key };
+                }
+                return steps;
+            }
+
+            if (node->depth < MAX_PATH_LEN && tail < MAX_BFS_NODES) {
+                uint64_t hash = hash_key(key, chained->config.hash_function);
+
+                nodes[tail++] = (PathNode){
+                    .bucket = alt_bucket(node->bucket, hash, chained->num_buckets),
+                    .parent = head,
+                    .slot = s,
+                    .key = key,
+                    .depth = node->depth + 1,
+                };
+            }
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief do the moves of a cuckoo path, free end first
+ *
+ * Every move holds the stripes of both its buckets, which are the two
+ * buckets of the key being moved, so lookups and inserts of that key
+ * wait for it or see the stripe sequence change. The key is written
+ * to its new slot before it is cleared from the old one.
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param path PathStep* -> path from search_path()
+ * @param steps int -> steps in path
+ * @return int -> 1 if path[0] is free now, 0 if the path went stale (some moves may be done)
+ */
+static int move_path(ChainedHashTable* chained, PathStep* path, int steps) {
+    for (int i = steps - 2; i >= 0; i--) {
+        PathStep* from = &path[i];
+        PathStep* to = &path[i + 1];
+        Bucket* source = &chained->buckets[from->bucket];
+        Bucket* target = &chained->buckets[to->bucket];
+
+        lock_two_buckets(chained, from->bucket, to->bucket);
+
+        if (source->keys[from->slot] != from->key || target->keys[to->slot] != INVALID_KEY) {
+            unlock_two_buckets(chained, from->bucket, to->bucket);
+            return 0;
+        }
+
+        fill_slot(target, to->slot, from->key, source->values[from->slot]);
+        clear_slot(source, from->slot);
+
+        unlock_two_buckets(chained, from->bucket, to->bucket);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief put key into the table, or update it
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param key uint64_t -> key value
+ * @param value uint64_t -> value value
+ * @param depth_out size_t* -> items moved by cuckoo paths, STASH_DEPTH if stashed
+ * @return int -> PLACED_UPDATE, PLACED_BUCKET or PLACED_STASH
+ */
+static int place_key(ChainedHashTable* chained, uint64_t key, uint64_t value, size_t* depth_out) {
+    size_t first;
+    size_t second;
+    key_buckets(chained, key, &first, &second);
+
+    PathStep path[MAX_PATH_LEN + 1];
+    size_t moved = 0;
+    int stale_paths = 0;
+
+    while (1) {
+        int placed = -1;
+        size_t depth;
+
+        lock_two_buckets(chained, first, second);
+
+        uint64_t* slot = locked_find(chained, first, second, key, &depth);
+
+        if (slot != NULL) {
+            #pragma omp atomic write
+            *slot = value;
+            placed = PLACED_UPDATE;
+        } else {
+            for (int b = 0; b < 2 && placed < 0; b++) {
+                Bucket* bucket = &chained->buckets[b ? second : first];
+                int s = find_in_bucket(bucket, INVALID_KEY);
+
+                if (s >= 0) {
+                    fill_slot(bucket, s, key, value);
+                    placed = PLACED_BUCKET;
+                }
+            }
+        }
+
+        // Waiting for a resize that has already been asked for is cheaper than searching
+        if (placed < 0 && (stale_paths >= MAX_PATH_RETRIES || needs_resize(chained))) {
+            StashItem* item = malloc(sizeof(StashItem));
+            item->key = key;
+            item->value = value;
+            item->next = chained->stash[first];
+            chained->stash[first] = item;
+
+            #pragma omp atomic update
+            chained->stashed++;
+
+            placed = PLACED_STASH;
+        }
+
+        unlock_two_buckets(chained, first, second);
+
+        if (placed >= 0) {
+            *depth_out = placed == PLACED_STASH ? STASH_DEPTH : moved;
+            return placed;
+        }
+
+        // Both buckets full, make room and try again
+        int steps = search_path(chained, first, second, path);
+
+        if (steps < 0) {
+            stale_paths = MAX_PATH_RETRIES; // no room anywhere near, stash it
+        } else if (move_path(chained, path, steps)) {
+            moved += steps - 1;
+        } else {
+            stale_paths++;
+        }
+    }
+}
+
+/**
+ * @brief Insert item into cuckoo table
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @param value uint64_t -> value value (must not be INVALID_VALUE)
+ */
+void insert(ChainedHashTable* chained, uint64_t key, uint64_t value) {
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return;
+    } else if (value == INVALID_VALUE) {
+        //printf("value must not equal INVALID_VALUE value (uint64 max)");
+        return;
+    }
+
+    size_t depth;
+    int placed = place_key(chained, key, value, &depth);
+
+    stats_depth(chained->stats, depth);
+
+    if (placed != PLACED_UPDATE) {
+        stats_items(chained->stats, 1);
+        request_resize(chained, policy_after_add(&chained->config, chained->stats, chained->num_buckets, BUCKET_SIZE, &chained->long_chains, placed == PLACED_STASH));
+    }
+}
+
+/**
+ * @brief Remove key from cuckoo table
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> removed value (INVALID_VALUE if key not found)
+ */
+uint64_t remove_key(ChainedHashTable* chained, uint64_t key) {
+    if (key == INVALID_KEY) {
+        //printf("key must not equal INVALID_KEY value (uint64 max)");
+        return INVALID_VALUE;
+    }
+
+    size_t first;
+    size_t second;
+    key_buckets(chained, key, &first, &second);
+
+    uint64_t value = INVALID_VALUE;
+
+    lock_two_buckets(chained, first, second);
+
+    for (int b = 0; b < 2 && value == INVALID_VALUE; b++) {
+        Bucket* bucket = &chained->buckets[b ? second : first];
+        int s = find_in_bucket(bucket, key);
+
+        if (s >= 0) {
+            value = bucket->values[s];
+            clear_slot(bucket, s);
+        }
+    }
+
+    if (value == INVALID_VALUE && has_stash(chained)) {
+        StashItem** prev = &chained->stash[first];
+        StashItem* curr = *prev;
+
+        while (curr != NULL) {
+            if (curr->key == key) {
+                *prev = curr->next;
+                value = curr->value;
+                free(curr);
+
+                #pragma omp atomic update
+                chained->stashed--;
+                break;
+            }
+            prev = &curr->next;
+            curr = curr->next;
+        }
+    }
+
+    unlock_two_buckets(chained, first, second);
+
+    if (value != INVALID_VALUE) {
+        stats_items(chained->stats, -1);
+        request_resize(chained, policy_after_remove(&chained->config, chained->stats, chained->num_buckets, BUCKET_SIZE));
+    }
+
+    return value;
+}
+
+/**
+ * @brief prefetch what a group of operations is about to touch
+ *
+ * Both buckets of every key, plus the stripes for inserts.
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param keys const uint64_t* -> keys of the group
+ * @param n size_t -> number of keys (at most BATCH_GROUP)
+ * @param for_write int -> 1 if the keys are about to be inserted
+ */
+static void prefetch_keys(ChainedHashTable* chained, const uint64_t* keys, size_t n, int for_write) {
+    for (size_t i = 0; i < n; i++) {
+        size_t first;
+        size_t second;
+        key_buckets(chained, keys[i], &first, &second);
+
+        PREFETCH(&chained->buckets[first], for_write);
+        PREFETCH(&chained->buckets[second], for_write);
+        __builtin_prefetch(&chained->locks[get_lock_idx(chained, first)], 1);
+    }
+}
+
+/**
+ * @brief lookup many keys in cuckoo table
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param keys const uint64_t* -> keys to look up
+ * @param out uint64_t* -> value per key (INVALID_VALUE if key not found)
+ * @param n size_t -> number of keys
+ */
+void lookup_batch(ChainedHashTable* chained, const uint64_t* keys, uint64_t* out, size_t n) {
+    for (size_t start = 0; start < n; start += BATCH_GROUP) {
+        size_t count = (n - start < BATCH_GROUP) ? n - start : BATCH_GROUP;
+
+        prefetch_keys(chained, keys + start, count, 0);
+
+        for (size_t i = start; i < start + count; i++) {
+            out[i] = lookup(chained, keys[i]);
+        }
+    }
+}
+
+/**
+ * @brief Insert many items into cuckoo table
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void insert_batch(ChainedHashTable* chained, const uint64_t* keys, const uint64_t* values, size_t n) {
+    for (size_t start = 0; start < n; start += BATCH_GROUP) {
+        size_t count = (n - start < BATCH_GROUP) ? n - start : BATCH_GROUP;
+
+        prefetch_keys(chained, keys + start, count, 1);
+
+        for (size_t i = start; i < start + count; i++) {
+            insert(chained, keys[i], values[i]);
+        }
+    }
+}
+
+/**
+ * @brief check whether the table asked for resize()
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @return int -> POLICY_* reason if the table wants a new size, 0 otherwise
+ */
+int needs_resize(ChainedHashTable* chained) {
+    int temp_resize;
+
+    #pragma omp atomic read
+    temp_resize = chained->resize_needed;
+
+    return temp_resize;
+}
+
+/**
+ * @brief Create the table a resize moves into
+ *
+ * The counters move over, with the lock wait of the old stripes folded in.
+ *
+ * @param curr_chained ChainedHashTable* -> table being resized
+ * @param next_num_buckets size_t -> buckets of the new table (power of two, at least the current count)
+ * @return ChainedHashTable* -> empty table with next_num_buckets buckets, locks grown by the same factor
+ */
+static ChainedHashTable* create_next_table(ChainedHashTable* curr_chained, size_t next_num_buckets) {
+    size_t next_num_locks = curr_chained->num_locks * next_num_buckets / curr_chained->num_buckets;
+    ChainedHashTable* next_chained = create_table(next_num_buckets, next_num_locks, &curr_chained->config);
+
+    for (size_t i = 0; i < curr_chained->num_locks; i++) {
+        curr_chained->stats->lock_contended += curr_chained->locks[i].contended;
+        curr_chained->stats->lock_wait += curr_chained->locks[i].wait_time;
+    }
+
+    stats_destroy(next_chained->stats);
+    next_chained->stats = curr_chained->stats;
+    curr_chained->stats = NULL;
+
+    return next_chained;
+}
+
+/**
+ * @brief Copy the slots and stash of one old bucket
+ *
+ * Thread safe, place_key locks the next table like any insert. A key
+ * that finds no path even there is stashed again and asks for the next
+ * resize.
+ *
+ * @param next_chained ChainedHashTable* -> table being filled
+ * @param curr_chained ChainedHashTable* -> table being resized
+ * @param i size_t -> bucket index in curr_chained
+ */
+static void move_bucket(ChainedHashTable* next_chained, ChainedHashTable* curr_chained, size_t i) {
+    Bucket* bucket = &curr_chained->buckets[i];
+    size_t depth;
+
+    for (int s = 0; s < BUCKET_SIZE; s++) {
+        if (bucket->keys[s] != INVALID_KEY && place_key(next_chained, bucket->keys[s], bucket->values[s], &depth) == PLACED_STASH) {
+            request_resize(next_chained, POLICY_FULL);
+        }
+    }
+    for (StashItem* curr = curr_chained->stash[i]; curr != NULL; curr = curr->next) {
+        if (place_key(next_chained, curr->key, curr->value, &depth) == PLACED_STASH) {
+            request_resize(next_chained, POLICY_FULL);
+        }
+    }
+}
+
+/**
+ * @brief Resize cuckoo table
+ *
+ * Stashed items move back into buckets.
+ *
+ * @param chained_pointer cuckoo table to resize
+ */
+void resize(ChainedHashTable** chained_pointer) {
+
+    static ChainedHashTable* next_chained = NULL;
+    static double resize_start = 0.0;
+    ChainedHashTable* curr_chained = *chained_pointer;
+
+    #pragma omp barrier
+
+    #pragma omp single
+    {
+        resize_start = stats_resize_begin();
+        next_chained = create_next_table(curr_chained, policy_next_buckets(&curr_chained->config, curr_chained->resize_needed, curr_chained->num_buckets));
+    }
+
+    #pragma omp barrier
+
+    #pragma omp for
+    for (size_t i = 0; i < curr_chained->num_buckets; i++) {
+        move_bucket(next_chained, curr_chained, i);
+    }
+
+    #pragma omp single
+    {
+        policy_record(&next_chained->config, next_chained->stats, curr_chained->resize_needed, curr_chained->num_buckets, next_chained->num_buckets, BUCKET_SIZE, curr_chained->long_chains);
+        *chained_pointer = next_chained;
+        destroy_table(curr_chained);
+        stats_resize(next_chained->stats, resize_start);
+        next_chained = NULL;
+    }
+
+    #pragma omp barrier
+}
+
+/**
+ * @brief Resize cuckoo table from a single thread
+ *
+ * @param chained_pointer cuckoo table to resize
+ */
+void resize_exclusive(ChainedHashTable** chained_pointer) {
+    double resize_start = stats_resize_begin();
+    ChainedHashTable* curr_chained = *chained_pointer;
+    ChainedHashTable* next_chained = create_next_table(curr_chained, policy_next_buckets(&curr_chained->config, curr_chained->resize_needed, curr_chained->num_buckets));
+
+    for (size_t i = 0; i < curr_chained->num_buckets; i++) {
+        move_bucket(next_chained, curr_chained, i);
+    }
+
+    policy_record(&next_chained->config, next_chained->stats, curr_chained->resize_needed, curr_chained->num_buckets, next_chained->num_buckets, BUCKET_SIZE, curr_chained->long_chains);
+    *chained_pointer = next_chained;
+    destroy_table(curr_chained);
+    stats_resize(next_chained->stats, resize_start);
+}
+
+/**
+ * @brief put key into one of its buckets in [range_begin, range_end) without locks
+ *
+ * Only for a table nobody else can see yet, in which the calling thread
+ * alone writes the range. The first bucket is always in range, the
+ * partitioning goes by it.
+ *
+ * @param chained ChainedHashTable* -> table being built
+ * @param key uint64_t -> key value
+ * @param value uint64_t -> value value
+ * @param range_begin size_t -> first bucket of the calling thread
+ * @param range_end size_t -> one past the last bucket of the calling thread
+ * @return int -> 1 new key, 0 updated, -1 no free slot in range (nothing written)
+ */
+static int bulk_place(ChainedHashTable* chained, uint64_t key, uint64_t value, size_t range_begin, size_t range_end) {
+    size_t first;
+    size_t second;
+    key_buckets(chained, key, &first, &second);
+
+    int second_in_range = second >= range_begin && second < range_end;
+    Bucket* buckets[2] = { &chained->buckets[first], &chained->buckets[second] };
+
+    for (int target = 0; target < 2; target++) {
+        for (int b = 0; b < 1 + second_in_range; b++) {
+            int s = find_in_bucket(buckets[b], target ? INVALID_KEY : key);
+
+            if (s >= 0) {
+                buckets[b]->keys[s] = key;
+                buckets[b]->values[s] = value;
+                return target;
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Fill a table with a known key set at once
+ *
+ * Every thread fills the buckets of its own range with plain writes, a
+ * key goes into its first bucket or, if that is full and its second
+ * bucket is in range too, the second one. Everything else is deferred
+ * and goes through insert() (and its cuckoo paths) once every thread is
+ * done. A repeated key is deferred every time, so its order holds.
+ * Buckets are sized for half full slots. Not counted as a resize, with
+ * resize_enabled off the table keeps its bucket count.
+ *
+ * @param chained_pointer ChainedHashTable** -> table to fill, replaced
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void bulk_load(ChainedHashTable** chained_pointer, const uint64_t* keys, const uint64_t* values, size_t n) {
+    ChainedHashTable* curr_chained = *chained_pointer;
+    TableStats snapshot;
+    get_table_stats(curr_chained, &snapshot);
+
+    size_t num_buckets = curr_chained->num_buckets;
+    if (spec_resize_enabled(&curr_chained->config)) {
+        size_t wanted = (n + BUCKET_SIZE / 2 - 1) / (BUCKET_SIZE / 2);
+        num_buckets = round_up_pow2(wanted > num_buckets ? wanted : num_buckets);
+    }
+
+    if (snapshot.items != 0) {
+        while (curr_chained->num_buckets < num_buckets) {
+            resize_exclusive(chained_pointer);
+            curr_chained = *chained_pointer;
+        }
+
+        BulkPartition* parts = bulk_partition(keys, values, n, curr_chained->config.hash_function, curr_chained->num_buckets);
+        bulk_insert(chained_pointer, parts);
+        bulk_partition_free(parts);
+        return;
+    }
+
+    BulkPartition* parts = bulk_partition(keys, values, n, curr_chained->config.hash_function, num_buckets);
+    ChainedHashTable* next_chained = create_next_table(curr_chained, num_buckets);
+
+    #pragma omp parallel
+    {
+        size_t first;
+        size_t end;
+        bulk_thread_parts(parts, omp_get_thread_num(), omp_get_num_threads(), &first, &end);
+
+        size_t range_begin = first * parts->part_buckets;
+        size_t range_end = end * parts->part_buckets;
+        BulkDeferred deferred = {0};
+        int added = 0;
+
+        for (size_t i = parts->starts[first]; i < parts->starts[end]; i++) {
+            int placed = bulk_place(next_chained, parts->keys[i], parts->values[i], range_begin, range_end);
+
+            if (placed < 0) {
+                bulk_defer(&deferred, i);
+            } else {
+                added += placed;
+            }
+        }
+
+        stats_items(next_chained->stats, added);
+
+        #pragma omp barrier
+
+        for (size_t i = 0; i < deferred.count; i++) {
+            insert(next_chained, parts->keys[deferred.pairs[i]], parts->values[deferred.pairs[i]]);
+        }
+        free(deferred.pairs);
+    }
+
+    *chained_pointer = next_chained;
+    destroy_table(curr_chained);
+    bulk_partition_free(parts);
+
+    while (needs_resize(*chained_pointer)) {
+        resize_exclusive(chained_pointer);
+    }
+}
+
+/**
+ * @brief Write the table's items to a flat image file
+ *
+ * Stashed items are saved like any other, the image groups every pair
+ * by its first bucket.
+ *
+ * @param chained ChainedHashTable* -> table to save
+ * @param path const char* -> image file, replaced once it is complete
+ * @return int -> 1 on success, 0 if the file could not be written
+ */
+int save_table(ChainedHashTable* chained, const char* path) {
+    SnapshotWriter* writer = snapshot_begin(&chained->config, chained->num_buckets);
+
+    for (size_t i = 0; i < chained->num_buckets; i++) {
+        Bucket* bucket = &chained->buckets[i];
+
+        for (int s = 0; s < BUCKET_SIZE; s++) {
+            if (bucket->keys[s] != INVALID_KEY) {
+                snapshot_add(writer, bucket->keys[s], bucket->values[s]);
+            }
+        }
+        for (StashItem* curr = chained->stash[i]; curr != NULL; curr = curr->next) {
+            snapshot_add(writer, curr->key, curr->value);
+        }
+    }
+
+    return snapshot_finish(writer, path);
+}
+
+/**
+ * @brief Merge the table's per-thread counters
+ *
+ * Adds the wait of the current stripes to what earlier tables left in
+ * the counters. Lookup depths are 0 for the first bucket and 1 for the
+ * second (or a miss), insert depths the items cuckoo paths moved, and
+ * STASH_DEPTH counts operations that had to search or use the stash.
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ * @param out TableStats* -> snapshot to fill
+ */
+void get_table_stats(ChainedHashTable* chained, TableStats* out) {
+    stats_merge(chained->stats, out);
+
+    for (size_t i = 0; i < chained->num_locks; i++) {
+        PaddedLock* stripe = &chained->locks[i];
+
+        out->lock_contended += stripe->contended;
+        out->lock_wait += stripe->wait_time;
+
+        if (stripe->wait_time > out->hottest_wait) {
+            out->hottest_wait = stripe->wait_time;
+            out->hottest_stripe = i;
+        }
+    }
+}
+
+/**
+ * @brief HOT_* remedies of TableConfig.hot_keys this back end implements
+ *
+ * Cuckoo has no chains to move along and no hot key cache.
+ *
+ * @return int -> HOT_* bits (see hot.h)
+ */
+int hot_keys_supported(void) {
+    return 0;
+}
+
+/**
+ * @brief Print how evenly the hash spreads the keys
+ *
+ * How many live keys sit in their first bucket (0), their second (1)
+ * or the stash (2).
+ *
+ * @param chained ChainedHashTable* -> specific cuckoo table
+ */
+void print_table_stats(ChainedHashTable* chained) {
+    size_t counts[3] = {0};
+    size_t live_slots = 0;
+
+    for (size_t i = 0; i < chained->num_buckets; i++) {
+        Bucket* bucket = &chained->buckets[i];
+
+        for (int s = 0; s < BUCKET_SIZE; s++) {
+            if (bucket->keys[s] == INVALID_KEY) {
+                continue;
+            }
+
+            counts[hash1(chained, bucket->keys[s], chained->num_buckets) == i ? 0 : 1]++;
+            live_slots++;
+        }
+
+        for (StashItem* curr = chained->stash[i]; curr != NULL; curr = curr->next) {
+            counts[2]++;
+        }
+    }
+
+    printf("num_buckets: %zu\n", chained->num_buckets);
+    print_length_histogram("key_buckets", counts, 3);
+    printf("load_factor: %f\n", (double)live_slots / (chained->num_buckets * BUCKET_SIZE));
+
+    TableStats snapshot;
+    get_table_stats(chained, &snapshot);
+    stats_print(&snapshot);
+}
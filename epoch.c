@@ -0,0 +1,314 @@
+/**
+ * @file epoch.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Epoch-based memory reclamation
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Classic three epoch scheme. A thread announces the global epoch when it
+ * enters a critical section. The global epoch can only move from e to
+ * e + 1 once every thread that is inside a critical section has announced
+ * e. Memory retired while the global epoch was e is therefore unreachable
+ * by everyone once the global epoch reaches e + 2.
+ *
+ * Each thread keeps one retire list per epoch modulo 3. When a thread
+ * retires into a list whose epoch is stale, that list is at least three
+ * epochs old and can be freed before being reused. No locks are taken
+ * anywhere, a slow reader only delays reclamation.
+ */
+
+#include "epoch.h"
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+// Local constants
+#define EPOCH_LISTS 3
+#define ADVANCE_THRESHOLD 64   // retires/enters between attempts to advance the global epoch
+
+/**
+ * @struct Retired
+ * @brief memory waiting to be freed
+ *
+ * @param ptr void* -> memory to free
+ * @param free_fn void (*)(void*) -> function that frees ptr
+ */
+typedef struct {
+    void* ptr; /** @brief memory to free */
+    void (*free_fn)(void*); /** @brief function that frees ptr */
+} Retired;
+
+/**
+ * @struct RetireList
+ * @brief memory retired by one thread during one epoch
+ *
+ * @param items Retired* -> growable array of retired memory
+ * @param count size_t -> number of items
+ * @param capacity size_t -> allocated items
+ * @param epoch uint64_t -> epoch the items were retired in
+ */
+typedef struct {
+    Retired* items; /** @brief growable array of retired memory */
+    size_t count; /** @brief number of items */
+    size_t capacity; /** @brief allocated items */
+    uint64_t epoch; /** @brief epoch the items were retired in */
+} RetireList;
+
+/**
+ * @struct EpochThread
+ * @brief per-thread epoch state, one cache line apart from other threads
+ *
+ * @param state volatile uint64_t -> announced epoch << 1 | inside critical section
+ * @param nesting int -> critical section depth
+ * @param seen_epoch uint64_t -> global epoch at the last outermost enter
+ * @param pending size_t -> retired items not freed yet
+ * @param since_advance size_t -> retires/enters since the last advance attempt
+ * @param lists RetireList[] -> retire list per epoch modulo 3
+ */
+typedef struct {
+    volatile uint64_t state; /** @brief announced epoch << 1 | inside critical section */
+    int nesting; /** @brief critical section depth */
+    uint64_t seen_epoch; /** @brief global epoch at the last outermost enter */
+    size_t pending; /** @brief retired items not freed yet */
+    size_t since_advance; /** @brief retires/enters since the last advance attempt */
+    RetireList lists[EPOCH_LISTS]; /** @brief retire list per epoch modulo 3 */
+} __attribute__((aligned(64))) EpochThread;
+
+/**
+ * @struct EpochDomain
+ * @brief reclamation domain, one per table
+ *
+ * @param global_epoch volatile uint64_t -> current epoch
+ * @param max_thread volatile int -> highest thread id that ever entered
+ * @param threads EpochThread[] -> per-thread announcement and retire lists
+ */
+struct EpochDomain {
+    volatile uint64_t global_epoch; /** @brief current epoch */
+    volatile int max_thread; /** @brief highest thread id that ever entered */
+    char padding[64 - sizeof(uint64_t) - sizeof(int)];
+
+    EpochThread threads[MAX_THREADS]; /** @brief per-thread announcement and retire lists */
+};
+
+/**
+ * @brief Create reclamation domain
+ *
+ * @return EpochDomain*
+ */
+EpochDomain* epoch_create(void) {
+    EpochDomain* domain = aligned_alloc(64, sizeof(EpochDomain));
+    memset(domain, 0, sizeof(EpochDomain));
+    domain->max_thread = -1;
+    return domain;
+}
+
+/**
+ * @brief Free everything on a retire list
+ *
+ * @param thread EpochThread* -> owner of the list
+ * @param list RetireList* -> list to empty
+ */
+static void free_list(EpochThread* thread, RetireList* list) {
+    for (size_t i = 0; i < list->count; i++) {
+        list->items[i].free_fn(list->items[i].ptr);
+    }
+    thread->pending -= list->count;
+    list->count = 0;
+}
+
+/**
+ * @brief Destroy reclamation domain, freeing everything still retired
+ *
+ * No thread may be inside a critical section of this domain.
+ *
+ * @param domain EpochDomain* -> domain to destroy
+ */
+void epoch_destroy(EpochDomain* domain) {
+    for (int i = 0; i <= domain->max_thread; i++) {
+        for (int j = 0; j < EPOCH_LISTS; j++) {
+            free_list(&domain->threads[i], &domain->threads[i].lists[j]);
+            free(domain->threads[i].lists[j].items);
+        }
+    }
+    free(domain);
+}
+
+/**
+ * @brief get the calling thread's epoch state
+ *
+ * @param domain EpochDomain* -> specific domain
+ * @return EpochThread*
+ */
+static inline EpochThread* get_thread(EpochDomain* domain) {
+    int thread_id = omp_get_thread_num();
+
+    if (thread_id >= MAX_THREADS) {
+        printf("epoch: thread id %d exceeds MAX_THREADS\n", thread_id);
+        exit(1);
+    }
+
+    return &domain->threads[thread_id];
+}
+
+/**
+ * @brief Free retire lists that every reader has moved past
+ *
+ * @param thread EpochThread* -> calling thread's state
+ * @param epoch uint64_t -> current global epoch
+ */
+static void reclaim(EpochThread* thread, uint64_t epoch) {
+    for (int i = 0; i < EPOCH_LISTS; i++) {
+        RetireList* list = &thread->lists[i];
+        if (list->count > 0 && list->epoch + 2 <= epoch) {
+            free_list(thread, list);
+        }
+    }
+}
+
+/**
+ * @brief Move the global epoch forward if every active thread has caught up
+ *
+ * @param domain EpochDomain* -> specific domain
+ */
+static void try_advance(EpochDomain* domain) {
+    uint64_t epoch;
+    int max_thread;
+
+    #pragma omp atomic read seq_cst
+    epoch = domain->global_epoch;
+
+    #pragma omp atomic read
+    max_thread = domain->max_thread;
+
+    for (int i = 0; i <= max_thread; i++) {
+        uint64_t state;
+
+        #pragma omp atomic read seq_cst
+        state = domain->threads[i].state;
+
+        if ((state & 1) && (state >> 1) != epoch) {
+            return; // someone is still reading in an older epoch
+        }
+    }
+
+    #pragma omp atomic compare seq_cst
+    if (domain->global_epoch == epoch) {
+        domain->global_epoch = epoch + 1;
+    }
+}
+
+/**
+ * @brief Enter critical section
+ *
+ * Pointers loaded from the protected structure stay valid until the
+ * matching epoch_exit. Nested calls are allowed.
+ *
+ * @param domain EpochDomain* -> specific domain
+ */
+void epoch_enter(EpochDomain* domain) {
+    int thread_id = omp_get_thread_num();
+    EpochThread* thread = get_thread(domain);
+
+    if (thread->nesting++ > 0) {
+        return;
+    }
+
+    int max_thread;
+
+    #pragma omp atomic read
+    max_thread = domain->max_thread;
+
+    // First time this thread shows up, make try_advance scan it
+    while (thread_id > max_thread) {
+        int seen;
+
+        #pragma omp atomic compare capture
+        {
+            seen = domain->max_thread;
+            if (domain->max_thread == max_thread) {
+                domain->max_thread = thread_id;
+            }
+        }
+
+        max_thread = (seen == max_thread) ? thread_id : seen;
+    }
+
+    // Rare retirers (a drained bucket array) still need the epoch to move on
+    if (thread->pending > 0 && ++thread->since_advance >= ADVANCE_THRESHOLD) {
+        thread->since_advance = 0;
+        try_advance(domain);
+    }
+
+    uint64_t epoch;
+
+    #pragma omp atomic read seq_cst
+    epoch = domain->global_epoch;
+
+    // Announcement must be visible before any protected pointer is loaded
+    #pragma omp atomic write seq_cst
+    thread->state = (epoch << 1) | 1;
+
+    if (epoch != thread->seen_epoch) {
+        thread->seen_epoch = epoch;
+        reclaim(thread, epoch);
+    }
+}
+
+/**
+ * @brief Leave critical section
+ *
+ * @param domain EpochDomain* -> specific domain
+ */
+void epoch_exit(EpochDomain* domain) {
+    EpochThread* thread = get_thread(domain);
+
+    if (--thread->nesting > 0) {
+        return;
+    }
+
+    #pragma omp atomic write release
+    thread->state = 0;
+}
+
+/**
+ * @brief Free memory once no reader can still hold it
+ *
+ * Caller must already have unlinked ptr from the shared structure.
+ *
+ * @param domain EpochDomain* -> specific domain
+ * @param ptr void* -> memory to free
+ * @param free_fn void (*)(void*) -> function that frees ptr
+ */
+void epoch_retire(EpochDomain* domain, void* ptr, void (*free_fn)(void*)) {
+    EpochThread* thread = get_thread(domain);
+    uint64_t epoch;
+
+    #pragma omp atomic read seq_cst
+    epoch = domain->global_epoch;
+
+    RetireList* list = &thread->lists[epoch % EPOCH_LISTS];
+
+    // A stale list is at least three epochs old, nobody can reach it anymore
+    if (list->epoch != epoch) {
+        free_list(thread, list);
+        list->epoch = epoch;
+    }
+
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->items = realloc(list->items, list->capacity * sizeof(Retired));
+    }
+
+    list->items[list->count].ptr = ptr;
+    list->items[list->count].free_fn = free_fn;
+    list->count++;
+    thread->pending++;
+
+    if (++thread->since_advance >= ADVANCE_THRESHOLD) {
+        thread->since_advance = 0;
+        try_advance(domain);
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ * @file epoch.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Epoch-based memory reclamation
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Lock-free readers walk chains without holding anything, so a node that
+ * gets unlinked can not be freed right away. Every operation runs inside
+ * an epoch critical section (epoch_enter/epoch_exit). Unlinked memory is
+ * handed to epoch_retire, which keeps it on a per-thread list until the
+ * global epoch has moved forward twice, at that point every reader that
+ * could have seen it has left its critical section.
+ *
+ * Threads are identified by omp_get_thread_num(), so a domain may only be
+ * used from inside a single OpenMP team (or from the initial thread).
+ */
+
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include "chained.h"
+
+/**
+ * @struct EpochDomain
+ * @brief reclamation domain, one per table
+ *
+ * @param global_epoch volatile uint64_t -> current epoch
+ * @param threads EpochThread[] -> per-thread announcement and retire lists
+ */
+typedef struct EpochDomain EpochDomain;
+
+/**
+ * @brief Create reclamation domain
+ *
+ * @return EpochDomain*
+ */
+EpochDomain* epoch_create(void);
+
+/**
+ * @brief Destroy reclamation domain, freeing everything still retired
+ *
+ * No thread may be inside a critical section of this domain.
+ *
+ * @param domain EpochDomain* -> domain to destroy
+ */
+void epoch_destroy(EpochDomain* domain);
+
+/**
+ * @brief Enter critical section
+ *
+ * Pointers loaded from the protected structure stay valid until the
+ * matching epoch_exit. Nested calls are allowed.
+ *
+ * @param domain EpochDomain* -> specific domain
+ */
+void epoch_enter(EpochDomain* domain);
+
+/**
+ * @brief Leave critical section
+ *
+ * @param domain EpochDomain* -> specific domain
+ */
+void epoch_exit(EpochDomain* domain);
+
+/**
+ * @brief Free memory once no reader can still hold it
+ *
+ * Caller must already have unlinked ptr from the shared structure.
+ *
+ * @param domain EpochDomain* -> specific domain
+ * @param ptr void* -> memory to free
+ * @param free_fn void (*)(void*) -> function that frees ptr
+ */
+void epoch_retire(EpochDomain* domain, void* ptr, void (*free_fn)(void*));
+
+#endif // EPOCH_H
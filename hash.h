@@ -0,0 +1,116 @@
+/**
+ * @file hash.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Hash functions shared by every back end
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Bucket and lock counts are always powers of two (create_table rounds
+ * them up and resize doubles), so an index is the mixed key masked with
+ * n - 1 instead of a 64 bit division. That only works if the low bits of
+ * the mix are good, which is why the mixers below finish with a xor
+ * shift or fold the high half of a 128 bit product back in.
+ *
+ * The mixer is picked per table with TableConfig.hash_function (-H in the
+ * driver), the default at build time with -DDEFAULT_HASH=HASH_...
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include "chained.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief round up to the next power of two
+ *
+ * @param n size_t -> any count (0 becomes 1)
+ * @return size_t -> smallest power of two >= n
+ */
+static inline size_t round_up_pow2(size_t n) {
+    size_t pow2 = 1;
+    while (pow2 < n) {
+        pow2 <<= 1;
+    }
+    return pow2;
+}
+
+/**
+ * @brief original project hash, kept for comparison
+ *
+ * Keys that only differ above the low bits collide once masked.
+ *
+ * @param key uint64_t -> hash table key
+ * @return uint64_t -> hash
+ */
+static inline uint64_t hash_legacy(uint64_t key) {
+    return (key * 37) + 13;
+}
+
+/**
+ * @brief murmur3 64 bit finalizer (fmix64)
+ *
+ * @param key uint64_t -> hash table key
+ * @return uint64_t -> hash
+ */
+static inline uint64_t hash_murmur(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+/**
+ * @brief wyhash style multiply and fold
+ *
+ * One 64x64 -> 128 bit multiply, both halves xored together.
+ *
+ * @param key uint64_t -> hash table key
+ * @return uint64_t -> hash
+ */
+static inline uint64_t hash_wy(uint64_t key) {
+    __uint128_t product = (__uint128_t)(key ^ 0xa0761d6478bd642fULL) * 0xe7037ed1a0b428dbULL;
+    return (uint64_t)(product >> 64) ^ (uint64_t)product;
+}
+
+/**
+ * @brief hash key with the configured mixer
+ *
+ * @param key uint64_t -> hash table key
+ * @param hash_function int -> HASH_MURMUR, HASH_WY or HASH_LEGACY
+ * @return uint64_t -> hash, mask it to get an index
+ */
+static inline uint64_t hash_key(uint64_t key, int hash_function) {
+    switch (hash_function) {
+        case HASH_LEGACY:
+            return hash_legacy(key);
+        case HASH_WY:
+            return hash_wy(key);
+        default:
+            return hash_murmur(key);
+    }
+}
+
+/**
+ * @brief print a length histogram on one line
+ *
+ * The last entry collects everything at or above it.
+ *
+ * @param label const char* -> name printed in front
+ * @param counts const size_t* -> counts[i] is the number of lengths equal to i
+ * @param num_counts int -> number of entries in counts
+ */
+static inline void print_length_histogram(const char* label, const size_t* counts, int num_counts) {
+    printf("%s:", label);
+    for (int i = 0; i < num_counts; i++) {
+        printf(" %d%s=%zu", i, i == num_counts - 1 ? "+" : "", counts[i]);
+    }
+    printf("\n");
+}
+
+#endif // HASH_H
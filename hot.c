@@ -0,0 +1,129 @@
+/**
+ * @file hot.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Skew handling for hot keys in the chained back ends
+ * @version 0.1
+ * @date 2026-10-15
+ */
+
+#include "hot.h"
+#include "spec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Local constants
+#define COMBINE_FILTER 256  // keys remembered by hot_combine, power of two
+
+_Thread_local HotEntry hot_cache[HOT_CACHE_SLOTS];
+_Thread_local unsigned hot_ticks = 0;
+
+// Last id handed out by hot_table_id
+static volatile uint64_t last_table_id = 0;
+
+/**
+ * @brief Parse "all" or "name[,name...]" into TableConfig.hot_keys
+ *
+ * @param spec const char* -> specification
+ * @param hot_keys int* -> HOT_* bits
+ * @return int -> 0 if spec is not valid
+ */
+int hot_parse(const char* spec, int* hot_keys) {
+    int valid = 1;
+
+    *hot_keys = 0;
+
+    if (strcmp(spec, "all") == 0) {
+        *hot_keys = HOT_ALL;
+        return 1;
+    }
+
+    char* copy = strdup(spec);
+    char* save = NULL;
+
+    for (char* token = strtok_r(copy, ",", &save); token != NULL; token = strtok_r(NULL, ",", &save)) {
+        if (strcmp(token, "cache") == 0) {
+            *hot_keys |= HOT_CACHE;
+        } else if (strcmp(token, "front") == 0) {
+            *hot_keys |= HOT_MOVE_TO_FRONT;
+        } else if (strcmp(token, "combine") == 0) {
+            *hot_keys |= HOT_COMBINE;
+        } else {
+            valid = 0;
+        }
+    }
+
+    free(copy);
+    return valid && *hot_keys != 0;
+}
+
+/**
+ * @brief Drop the remedies a back end does not implement, saying so
+ *
+ * @param hot_keys int -> HOT_* bits asked for
+ * @param supported int -> hot_keys_supported() of the back end
+ * @return int -> hot_keys & supported
+ */
+int hot_restrict(int hot_keys, int supported) {
+    static const char* names[] = {"cache", "front", "combine"};
+    int ignored = hot_keys & ~supported;
+
+    if (ignored) {
+        printf("this back end does not implement -K");
+        for (int bit = 0, first = 1; bit < 3; bit++) {
+            if (ignored & (1 << bit)) {
+                printf("%s%s", first ? " " : ",", names[bit]);
+                first = 0;
+            }
+        }
+        printf(", ignoring it\n");
+    }
+
+    return hot_keys & supported;
+}
+
+/**
+ * @brief Id for a new table, never 0 and never handed out twice
+ *
+ * @return uint64_t
+ */
+uint64_t hot_table_id(void) {
+    uint64_t id;
+
+    #pragma omp atomic capture
+    id = ++last_table_id;
+
+    return id;
+}
+
+/**
+ * @brief Mark the inserts of a batch that a later insert of the same key overwrites
+ *
+ * @param keys const uint64_t* -> keys of the batch
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of keys (at most HOT_COMBINE_WINDOW)
+ * @param superseded unsigned char* -> set to 1 for every insert to skip, 0 otherwise
+ * @return size_t -> number of inserts marked
+ */
+size_t hot_combine(const uint64_t* keys, const uint64_t* values, size_t n, unsigned char* superseded) {
+    uint64_t seen[COMBINE_FILTER];
+    size_t combined = 0;
+
+    // INVALID_KEY is never stored, so it marks an empty filter slot
+    memset(seen, 0xFF, sizeof(seen));
+
+    for (size_t i = n; i-- > 0;) {
+        size_t slot = ((keys[i] * 0x9E3779B97F4A7C15ULL) >> 56) & (COMBINE_FILTER - 1);
+
+        superseded[i] = seen[slot] == keys[i];
+        combined += superseded[i];
+
+        // Only an insert that insert() stores can overwrite the ones before it
+        if (spec_storable(keys[i], values[i])) {
+            seen[slot] = keys[i];
+        }
+    }
+
+    return combined;
+}
@@ -0,0 +1,251 @@
+/**
+ * @file hot.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Skew handling for hot keys in the chained back ends
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * Under a Zipfian load a handful of keys take most of the operations.
+ * In chained_locked.c every reader of such a key queues on its stripe,
+ * in chained_lock_free.c every reader walks to the item a writer of the
+ * same key keeps pulling into its own cache. TableConfig.hot_keys turns
+ * on any of three remedies (-K in the driver and the server):
+ *
+ *   cache    every thread keeps the values it read most often in a small
+ *            direct mapped cache (HOT_CACHE_SLOTS), so a repeated lookup
+ *            of a hot key touches nothing shared but one version word.
+ *            An entry records that word and what it held when the value
+ *            was read, and is only good while the word still holds it.
+ *            chained_locked uses the stripe sequence of optimistic_reads
+ *            (the cache turns those on), chained_lock_free a table of
+ *            HOT_VERSIONS words that updates and deletes bump around
+ *            their write. A slot only changes hands once the key in it
+ *            has cooled down, one miss of another key at a time.
+ *   front    a lookup or update that found its item HOT_MOVE_DEPTH or
+ *            more items down the chain moves it to the head, one in every
+ *            HOT_MOVE_SAMPLE times so cold keys rarely pay for it
+ *            (chained_locked only, the lock-free chains can not relink an
+ *            item without deleting it for a moment)
+ *   combine  insert_batch() drops every insert that a later insert of the
+ *            same key in the same batch overwrites, so a hot key is
+ *            written once per batch. The final state is the same, but
+ *            other threads may see the batch's inserts land out of order
+ *
+ * The version words hold a count of writers in flight in their low half
+ * and a generation in the high half. A writer adds one before it writes
+ * and turns that into a generation step after, so a reader that saw no
+ * writer and the same word before and after its lookup read a value no
+ * write overlapped, and a cached value stays current exactly as long as
+ * the word does not move.
+ *
+ * Entries carry the id of their table (hot_table_id()), not its address:
+ * a stop-the-world resize makes a new table, possibly at the old address,
+ * and ids are never reused. The cache is thread local and shared by every
+ * table of the thread, shards included.
+ */
+
+#ifndef HOT_H
+#define HOT_H
+
+#include "chained.h"
+
+// Remedies for TableConfig.hot_keys
+#define HOT_CACHE 1          // per-thread cache of hot values
+#define HOT_MOVE_TO_FRONT 2  // hot items move to the head of their chain
+#define HOT_COMBINE 4        // insert_batch() writes each key once
+#define HOT_ALL (HOT_CACHE | HOT_MOVE_TO_FRONT | HOT_COMBINE)
+
+// Local constants
+#define HOT_CACHE_SLOTS 256         // entries per thread, power of two
+#define HOT_MAX_HEAT 3              // hits an entry can bank against replacement
+#define HOT_VERSIONS 1024           // version words of a chained_lock_free table, power of two
+#define HOT_GENERATION (1ULL << 32) // one generation step of a version word
+#define HOT_MOVE_DEPTH 2            // items above a hot item before it moves to the front
+#define HOT_MOVE_SAMPLE 8           // one in this many deep finds moves, power of two
+#define HOT_COMBINE_WINDOW 4096     // inserts combined together by insert_batch()
+
+/**
+ * @struct HotEntry
+ * @brief one cached value
+ *
+ * @param table uint64_t -> hot_table_id() of its table (0 when empty)
+ * @param key uint64_t -> cached key
+ * @param value uint64_t -> value read under version
+ * @param version const volatile uint64_t* -> word that moves on every write of the key
+ * @param seen uint64_t -> what version held when value was read
+ * @param heat uint64_t -> hits banked against replacement
+ */
+typedef struct {
+    uint64_t table; /** @brief hot_table_id() of its table (0 when empty) */
+    uint64_t key; /** @brief cached key */
+    uint64_t value; /** @brief value read under version */
+    const volatile uint64_t* version; /** @brief word that moves on every write of the key */
+    uint64_t seen; /** @brief what version held when value was read */
+    uint64_t heat; /** @brief hits banked against replacement */
+} HotEntry;
+
+// Cache of the calling thread, see hot.c
+extern _Thread_local HotEntry hot_cache[HOT_CACHE_SLOTS];
+
+// Deep finds of the calling thread, for HOT_MOVE_SAMPLE
+extern _Thread_local unsigned hot_ticks;
+
+/**
+ * @brief Parse "all" or "name[,name...]" into TableConfig.hot_keys
+ *
+ * Names are cache, front and combine.
+ *
+ * @param spec const char* -> specification
+ * @param hot_keys int* -> HOT_* bits
+ * @return int -> 0 if spec is not valid
+ */
+int hot_parse(const char* spec, int* hot_keys);
+
+/**
+ * @brief Drop the remedies a back end does not implement, saying so
+ *
+ * @param hot_keys int -> HOT_* bits asked for
+ * @param supported int -> hot_keys_supported() of the back end
+ * @return int -> hot_keys & supported
+ */
+int hot_restrict(int hot_keys, int supported);
+
+/**
+ * @brief Id for a new table, never 0 and never handed out twice
+ *
+ * @return uint64_t
+ */
+uint64_t hot_table_id(void);
+
+/**
+ * @brief cache slot of a key
+ *
+ * Takes the top bits, the bucket index uses the bottom ones.
+ *
+ * @param hash uint64_t -> full hash of the key
+ * @return HotEntry*
+ */
+static inline HotEntry* hot_slot(uint64_t hash) {
+    return &hot_cache[(hash >> 40) & (HOT_CACHE_SLOTS - 1)];
+}
+
+/**
+ * @brief Look the key up in the calling thread's cache
+ *
+ * A miss on a slot that holds another key cools that key down by one.
+ *
+ * @param table uint64_t -> hot_table_id() of the table
+ * @param key uint64_t -> key
+ * @param hash uint64_t -> full hash of the key
+ * @param value uint64_t* -> cached value on a hit
+ * @return int -> 1 on a hit
+ */
+static inline int hot_get(uint64_t table, uint64_t key, uint64_t hash, uint64_t* value) {
+    HotEntry* entry = hot_slot(hash);
+
+    if (entry->table != table || entry->key != key) {
+        if (entry->heat > 0) {
+            entry->heat--;
+        }
+        return 0;
+    }
+
+    uint64_t current;
+
+    #pragma omp atomic read seq_cst
+    current = *entry->version;
+
+    if (current != entry->seen) {
+        return 0;
+    }
+
+    if (entry->heat < HOT_MAX_HEAT) {
+        entry->heat++;
+    }
+    *value = entry->value;
+    return 1;
+}
+
+/**
+ * @brief Offer a value read under a version to the calling thread's cache
+ *
+ * Refreshes the key's entry, or takes a slot whose key has cooled down.
+ *
+ * @param table uint64_t -> hot_table_id() of the table
+ * @param key uint64_t -> key
+ * @param hash uint64_t -> full hash of the key
+ * @param value uint64_t -> value the lookup found (not INVALID_VALUE)
+ * @param version const volatile uint64_t* -> word that moves on every write of the key
+ * @param seen uint64_t -> what version held before and after the lookup
+ */
+static inline void hot_put(uint64_t table, uint64_t key, uint64_t hash, uint64_t value, const volatile uint64_t* version, uint64_t seen) {
+    HotEntry* entry = hot_slot(hash);
+
+    if (entry->table != table || entry->key != key) {
+        if (entry->heat > 0) {
+            return;
+        }
+        entry->table = table;
+        entry->key = key;
+    }
+
+    entry->value = value;
+    entry->version = version;
+    entry->seen = seen;
+}
+
+/**
+ * @brief check a version word for writers in flight
+ *
+ * @param version uint64_t -> word as read
+ * @return int -> 1 if no writer was between its two bumps
+ */
+static inline int hot_quiet(uint64_t version) {
+    return (version & (HOT_GENERATION - 1)) == 0;
+}
+
+/**
+ * @brief bump a version word before writing one of its keys
+ *
+ * @param version volatile uint64_t* -> word of the key
+ */
+static inline void hot_write_begin(volatile uint64_t* version) {
+    #pragma omp atomic update seq_cst
+    *version += 1;
+}
+
+/**
+ * @brief bump a version word after writing one of its keys
+ *
+ * @param version volatile uint64_t* -> word hot_write_begin() bumped
+ */
+static inline void hot_write_end(volatile uint64_t* version) {
+    #pragma omp atomic update seq_cst
+    *version += HOT_GENERATION - 1;
+}
+
+/**
+ * @brief decide whether this deep find moves its item to the front
+ *
+ * @return int -> 1 once every HOT_MOVE_SAMPLE calls of the thread
+ */
+static inline int hot_sample(void) {
+    return (++hot_ticks & (HOT_MOVE_SAMPLE - 1)) == 0;
+}
+
+/**
+ * @brief Mark the inserts of a batch that a later insert of the same key overwrites
+ *
+ * Walks the batch backwards through a small direct mapped filter of the
+ * keys already seen, so a key that keeps coming back is caught and a
+ * rare repeat may slip through, which only costs the extra write.
+ *
+ * @param keys const uint64_t* -> keys of the batch
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of keys (at most HOT_COMBINE_WINDOW)
+ * @param superseded unsigned char* -> set to 1 for every insert to skip, 0 otherwise
+ * @return size_t -> number of inserts marked
+ */
+size_t hot_combine(const uint64_t* keys, const uint64_t* values, size_t n, unsigned char* superseded);
+
+#endif // HOT_H
@@ -0,0 +1,208 @@
+/**
+ * @file hugepage.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief 2 MB page backed bucket arrays and item slabs
+ * @version 0.1
+ * @date 2026-10-15
+ */
+
+#define _GNU_SOURCE
+#include "hugepage.h"
+#include "numa.h"
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// Local constants
+#define SMALL_PAGE_SIZE 4096
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23  // Linux 5.14, older headers do not have it
+#endif
+
+// Where a region's pages came from
+#define HUGE_KIND_HUGETLB 0
+#define HUGE_KIND_TRANSPARENT 1
+#define HUGE_KIND_REGULAR 2
+#define HUGE_KIND_HEAP 3
+#define HUGE_KINDS 4
+
+/**
+ * @struct HugeRegion
+ * @brief one live mapping
+ *
+ * @param ptr void* -> start of the mapping, what huge_alloc returned
+ * @param bytes size_t -> length of the mapping
+ */
+typedef struct {
+    void* ptr; /** @brief start of the mapping, what huge_alloc returned */
+    size_t bytes; /** @brief length of the mapping */
+} HugeRegion;
+
+// Live mappings, guarded by critical(huge_regions)
+static HugeRegion* regions = NULL;
+static size_t num_regions = 0;
+static size_t regions_capacity = 0;
+
+// Bytes handed out per HUGE_KIND_*
+static volatile uint64_t kind_bytes[HUGE_KINDS] = {0};
+
+/**
+ * @brief round up to a multiple of a power of two
+ *
+ * @param value size_t -> value to round
+ * @param unit size_t -> power of two
+ * @return size_t
+ */
+static inline size_t round_up(size_t value, size_t unit) {
+    return (value + unit - 1) & ~(unit - 1);
+}
+
+/**
+ * @brief place and fault in a fresh mapping
+ *
+ * @param ptr char* -> start of the mapping
+ * @param bytes size_t -> length of the mapping
+ * @param placement int -> HUGE_PLACE_*
+ */
+static void populate(char* ptr, size_t bytes, int placement) {
+    if (placement == HUGE_PLACE_INTERLEAVE) {
+        numa_interleave(ptr, bytes);
+    } else if (placement == HUGE_PLACE_LOCAL) {
+        numa_bind_local(ptr, bytes);
+    }
+
+    if (madvise(ptr, bytes, MADV_POPULATE_WRITE) != 0) {
+        for (size_t offset = 0; offset < bytes; offset += SMALL_PAGE_SIZE) {
+            ((volatile char*)ptr)[offset] = 0;
+        }
+    }
+}
+
+/**
+ * @brief map bytes on 4 KB pages, 2 MB aligned
+ *
+ * Maps one huge page more than needed and cuts off both ends.
+ *
+ * @param bytes size_t -> multiple of HUGE_PAGE_SIZE
+ * @return char* -> mapping, NULL if out of memory
+ */
+static char* map_aligned(size_t bytes) {
+    char* raw = mmap(NULL, bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (raw == MAP_FAILED) {
+        return NULL;
+    }
+
+    char* aligned = (char*)round_up((uintptr_t)raw, HUGE_PAGE_SIZE);
+    size_t head = aligned - raw;
+
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    munmap(aligned + bytes, HUGE_PAGE_SIZE - head);
+
+    return aligned;
+}
+
+/**
+ * @brief Allocate a zeroed, faulted in region on 2 MB pages if possible
+ *
+ * @param bytes size_t -> size of the region
+ * @param placement int -> HUGE_PLACE_ANY, HUGE_PLACE_INTERLEAVE or HUGE_PLACE_LOCAL
+ * @return void* -> 2 MB aligned (64 byte aligned below HUGE_MIN_BYTES), NULL if out of memory
+ */
+void* huge_alloc(size_t bytes, int placement) {
+    if (bytes < HUGE_MIN_BYTES) {
+        size_t rounded = round_up(bytes ? bytes : 1, 64);
+        void* ptr = aligned_alloc(64, rounded);
+
+        if (ptr != NULL) {
+            if (placement == HUGE_PLACE_INTERLEAVE) {
+                numa_interleave(ptr, rounded);
+            } else if (placement == HUGE_PLACE_LOCAL) {
+                numa_bind_local(ptr, rounded);
+            }
+            memset(ptr, 0, rounded);
+
+            #pragma omp atomic
+            kind_bytes[HUGE_KIND_HEAP] += rounded;
+        }
+        return ptr;
+    }
+
+    size_t length = round_up(bytes, HUGE_PAGE_SIZE);
+    int kind = HUGE_KIND_HUGETLB;
+    char* ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    // No reserved pool (or not enough of it left), ask for transparent ones instead
+    if (ptr == MAP_FAILED) {
+        ptr = map_aligned(length);
+        if (ptr == NULL) {
+            return NULL;
+        }
+        kind = madvise(ptr, length, MADV_HUGEPAGE) == 0 ? HUGE_KIND_TRANSPARENT : HUGE_KIND_REGULAR;
+    }
+
+    populate(ptr, length, placement);
+
+    #pragma omp critical(huge_regions)
+    {
+        if (num_regions == regions_capacity) {
+            regions_capacity = regions_capacity ? 2 * regions_capacity : 64;
+            regions = realloc(regions, regions_capacity * sizeof(HugeRegion));
+        }
+        regions[num_regions].ptr = ptr;
+        regions[num_regions].bytes = length;
+        num_regions++;
+    }
+
+    #pragma omp atomic
+    kind_bytes[kind] += length;
+
+    return ptr;
+}
+
+/**
+ * @brief Free a region from huge_alloc()
+ *
+ * @param ptr void* -> region (NULL is ignored)
+ */
+void huge_free(void* ptr) {
+    size_t bytes = 0;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    #pragma omp critical(huge_regions)
+    {
+        for (size_t i = 0; i < num_regions; i++) {
+            if (regions[i].ptr == ptr) {
+                bytes = regions[i].bytes;
+                regions[i] = regions[--num_regions];
+                break;
+            }
+        }
+    }
+
+    if (bytes > 0) {
+        munmap(ptr, bytes);
+    } else {
+        free(ptr);
+    }
+}
+
+/**
+ * @brief Print how many bytes each kind of page backed
+ */
+void huge_report(void) {
+    printf("huge_pages: hugetlb %.1f MB, transparent %.1f MB, regular %.1f MB, heap (small) %.1f MB\n",
+           kind_bytes[HUGE_KIND_HUGETLB] / 1048576.0, kind_bytes[HUGE_KIND_TRANSPARENT] / 1048576.0,
+           kind_bytes[HUGE_KIND_REGULAR] / 1048576.0, kind_bytes[HUGE_KIND_HEAP] / 1048576.0);
+}
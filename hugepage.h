@@ -0,0 +1,73 @@
+/**
+ * @file hugepage.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief 2 MB page backed bucket arrays and item slabs
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * A probe lands on a random bucket and a chain walk on a random item, so
+ * at large.txt scale nearly every one of them is a data TLB miss on 4 KB
+ * pages. With TableConfig.huge_pages the back ends take their bucket
+ * arrays (and chained_open its tag array) and item_pool.h its slabs from
+ * huge_alloc() instead, 2 MB pages that cover 512 times more per TLB
+ * entry.
+ *
+ * huge_alloc() tries, in order:
+ *
+ *   hugetlb      MAP_HUGETLB, the kernel's reserved pool (vm.nr_hugepages)
+ *   transparent  a 2 MB aligned mapping with madvise(MADV_HUGEPAGE), which
+ *                the kernel backs with huge pages when THP is not "never"
+ *   regular      the same mapping on 4 KB pages if madvise is refused
+ *
+ * so it never fails for lack of huge pages. Allocations smaller than
+ * HUGE_MIN_BYTES (a small table's first bucket array) are not worth a
+ * 2 MB page and come from aligned_alloc.
+ *
+ * Every region is zeroed and faulted in before huge_alloc() returns
+ * (MADV_POPULATE_WRITE, or one write per page on older kernels), after
+ * the NUMA placement, so a resize pays for its new array up front in
+ * one go instead of one page fault at a time while it moves the items.
+ *
+ * huge_free() has free()'s signature for epoch_retire(). The mappings are
+ * kept in a small locked list (regions are few and only freed on resize
+ * and destroy), anything not in it goes to free().
+ */
+
+#ifndef HUGEPAGE_H
+#define HUGEPAGE_H
+
+#include <stddef.h>
+
+// Global Constants
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define HUGE_MIN_BYTES (HUGE_PAGE_SIZE / 4)  // smaller allocations stay on the heap
+
+// Placement for huge_alloc
+#define HUGE_PLACE_ANY 0         // first touch (the populating thread)
+#define HUGE_PLACE_INTERLEAVE 1  // numa_interleave()
+#define HUGE_PLACE_LOCAL 2       // numa_bind_local()
+
+/**
+ * @brief Allocate a zeroed, faulted in region on 2 MB pages if possible
+ *
+ * @param bytes size_t -> size of the region
+ * @param placement int -> HUGE_PLACE_ANY, HUGE_PLACE_INTERLEAVE or HUGE_PLACE_LOCAL
+ * @return void* -> 2 MB aligned (64 byte aligned below HUGE_MIN_BYTES), NULL if out of memory
+ */
+void* huge_alloc(size_t bytes, int placement);
+
+/**
+ * @brief Free a region from huge_alloc()
+ *
+ * @param ptr void* -> region (NULL is ignored)
+ */
+void huge_free(void* ptr);
+
+/**
+ * @brief Print how many bytes each kind of page backed
+ *
+ * Counts every huge_alloc() of the process, freed or not.
+ */
+void huge_report(void);
+
+#endif // HUGEPAGE_H
@@ -0,0 +1,368 @@
+/**
+ * @file item_pool.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Per-thread slab allocator for chain nodes
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Slabs are SLAB_SIZE bytes and aligned to SLAB_SIZE, so the slab (and
+ * from its header the pool) an item belongs to is found by masking the
+ * item address. That is what lets pool_free take a single pointer.
+ *
+ * A thread first reuses items from its free list, then bumps through its
+ * current slab, and only calls into the system allocator when the slab is
+ * used up. Slabs are never returned before pool_destroy.
+ *
+ * A reservation is one allocation of several slabs back to back, every
+ * one with its own header so masking still works. They all go onto the
+ * thread's slab list at once with the first one (the start of the
+ * allocation, owner set) pushed first, so pool_destroy reaches it after
+ * the others and frees the whole allocation exactly once.
+ *
+ * In numa mode the slab header also records its node. Lists on the nodes
+ * are only touched by a free away from home and by a thread whose own list
+ * is empty, the common path is the same as without numa.
+ *
+ * In huge_pages mode a thread's refills double from one slab up to a whole
+ * huge page (HUGE_SLABS slabs), and from there on come from huge_alloc()
+ * in multiples of it. A table that stays small, or one shard of many,
+ * does not pin 2 MB per thread, and one that grows gets its items on
+ * huge pages. The slabs of a refill beyond the one asked for become the
+ * thread's reserve.
+ */
+
+#include "item_pool.h"
+#include "numa.h"
+#include "hugepage.h"
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+// Local constants
+#define SLAB_SIZE (64 * 1024)   // bytes per slab, must be a power of two
+#define SLAB_HEADER ((sizeof(Slab) + 7) & ~(size_t)7) // items start on an 8 byte boundary right after the header
+#define HUGE_SLABS (HUGE_PAGE_SIZE / SLAB_SIZE) // slabs per huge page
+
+/**
+ * @struct FreeItem
+ * @brief free list link, stored in the first bytes of a free item
+ *
+ * @param next FreeItem* -> next free item
+ */
+typedef struct FreeItem {
+    struct FreeItem* next; /** @brief next free item */
+} FreeItem;
+
+/**
+ * @struct Slab
+ * @brief header at the start of every slab
+ *
+ * @param pool ItemPool* -> pool the slab belongs to
+ * @param next Slab* -> next slab owned by the same thread
+ * @param node int -> node the slab is bound to (numa mode)
+ * @param owner int -> start of its allocation, the only slab pool_destroy frees
+ */
+typedef struct Slab {
+    ItemPool* pool; /** @brief pool the slab belongs to */
+    struct Slab* next; /** @brief next slab owned by the same thread */
+    int node; /** @brief node the slab is bound to (numa mode) */
+    int owner; /** @brief start of its allocation, the only slab pool_destroy frees */
+} Slab;
+
+/**
+ * @struct PoolThread
+ * @brief per-thread allocation state, one cache line apart from other threads
+ *
+ * @param free_list FreeItem* -> items freed by this thread
+ * @param bump char* -> next unused item in the current slab
+ * @param bump_end char* -> end of the current slab
+ * @param slabs Slab* -> every slab this thread allocated
+ * @param reserve char* -> next unused slab of the last pool_reserve()
+ * @param reserve_end char* -> end of the last pool_reserve()
+ * @param refill size_t -> slabs of the next refill (huge_pages mode)
+ */
+typedef struct {
+    FreeItem* free_list; /** @brief items freed by this thread */
+    char* bump; /** @brief next unused item in the current slab */
+    char* bump_end; /** @brief end of the current slab */
+    Slab* slabs; /** @brief every slab this thread allocated */
+    char* reserve; /** @brief next unused slab of the last pool_reserve() */
+    char* reserve_end; /** @brief end of the last pool_reserve() */
+    size_t refill; /** @brief slabs of the next refill (huge_pages mode) */
+} __attribute__((aligned(64))) PoolThread;
+
+/**
+ * @struct PoolNode
+ * @brief items of one node freed by threads on other nodes
+ *
+ * @param lock omp_lock_t -> protects free_list
+ * @param free_list FreeItem* -> items waiting for a thread of this node
+ */
+typedef struct {
+    omp_lock_t lock; /** @brief protects free_list */
+    FreeItem* volatile free_list; /** @brief items waiting for a thread of this node */
+} __attribute__((aligned(64))) PoolNode;
+
+/**
+ * @struct ItemPool
+ * @brief fixed size item allocator, one per table
+ *
+ * @param item_size size_t -> bytes per item
+ * @param numa int -> node local slabs and per-node free lists
+ * @param huge_pages int -> slabs from huge_alloc() once a thread needs a huge page of them
+ * @param threads PoolThread[] -> per-thread slab and free list
+ * @param nodes PoolNode[] -> items freed away from their node
+ */
+struct ItemPool {
+    size_t item_size; /** @brief bytes per item */
+    int numa; /** @brief node local slabs and per-node free lists */
+    int huge_pages; /** @brief slabs from huge_alloc() once a thread needs a huge page of them */
+    char padding[64 - sizeof(size_t) - 2 * sizeof(int)];
+
+    PoolThread threads[MAX_THREADS]; /** @brief per-thread slab and free list */
+    PoolNode nodes[NUMA_MAX_NODES]; /** @brief items freed away from their node */
+};
+
+/**
+ * @brief Create item pool
+ *
+ * @param item_size size_t -> bytes per item (at least a pointer, multiple of 8)
+ * @param numa int -> node local slabs and per-node free lists
+ * @param huge_pages int -> slabs from huge_alloc() once a thread needs a huge page of them
+ * @return ItemPool*
+ */
+ItemPool* pool_create(size_t item_size, int numa, int huge_pages) {
+    ItemPool* pool = aligned_alloc(64, sizeof(ItemPool));
+    memset(pool, 0, sizeof(ItemPool));
+    pool->item_size = item_size;
+    pool->numa = numa;
+    pool->huge_pages = huge_pages;
+
+    for (int i = 0; i < NUMA_MAX_NODES; i++) {
+        omp_init_lock(&pool->nodes[i].lock);
+    }
+    return pool;
+}
+
+/**
+ * @brief Destroy item pool, releasing every item it ever handed out
+ *
+ * @param pool ItemPool* -> pool to destroy
+ */
+void pool_destroy(ItemPool* pool) {
+    for (int i = 0; i < MAX_THREADS; i++) {
+        Slab* slab = pool->threads[i].slabs;
+        while (slab != NULL) {
+            Slab* temp = slab;
+            slab = slab->next;
+            if (temp->owner) {
+                if (pool->huge_pages) {
+                    huge_free(temp); // free() for the refills that were too small for a huge page
+                } else {
+                    free(temp);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < NUMA_MAX_NODES; i++) {
+        omp_destroy_lock(&pool->nodes[i].lock);
+    }
+    free(pool);
+}
+
+/**
+ * @brief get the calling thread's allocation state
+ *
+ * @param pool ItemPool* -> specific pool
+ * @return PoolThread*
+ */
+static inline PoolThread* get_thread(ItemPool* pool) {
+    int thread_id = omp_get_thread_num();
+
+    if (thread_id >= MAX_THREADS) {
+        printf("item_pool: thread id %d exceeds MAX_THREADS\n", thread_id);
+        exit(1);
+    }
+
+    return &pool->threads[thread_id];
+}
+
+/**
+ * @brief Allocate slabs back to back, put them on the calling thread's list and make them its reserve
+ *
+ * In huge_pages mode the allocation can be larger than asked for, see
+ * the top of the file.
+ *
+ * @param pool ItemPool* -> specific pool
+ * @param thread PoolThread* -> calling thread's state
+ * @param num_slabs size_t -> slabs needed
+ */
+static void alloc_slabs(ItemPool* pool, PoolThread* thread, size_t num_slabs) {
+    char* region;
+
+    if (pool->huge_pages) {
+        if (thread->refill == 0) {
+            thread->refill = 1;
+        }
+        if (num_slabs < thread->refill) {
+            num_slabs = thread->refill;
+        }
+        if (thread->refill < HUGE_SLABS) {
+            thread->refill *= 2;
+        }
+    }
+
+    if (pool->huge_pages && num_slabs >= HUGE_SLABS) {
+        num_slabs = (num_slabs + HUGE_SLABS - 1) / HUGE_SLABS * HUGE_SLABS;
+
+        // Placed and faulted in by huge_alloc
+        region = huge_alloc(num_slabs * SLAB_SIZE, pool->numa ? HUGE_PLACE_LOCAL : HUGE_PLACE_ANY);
+    } else {
+        region = aligned_alloc(SLAB_SIZE, num_slabs * SLAB_SIZE);
+
+        // Before the header writes below is the first touch
+        if (pool->numa && region != NULL) {
+            numa_bind_local(region, num_slabs * SLAB_SIZE);
+        }
+    }
+
+    if (region == NULL) {
+        printf("item_pool: out of memory\n");
+        exit(1);
+    }
+
+    for (size_t i = 0; i < num_slabs; i++) {
+        Slab* slab = (Slab*)(region + i * SLAB_SIZE);
+
+        slab->pool = pool;
+        slab->next = thread->slabs;
+        slab->node = pool->numa ? numa_current_node() : 0;
+        slab->owner = i == 0;
+        thread->slabs = slab;
+    }
+
+    // What is left of an older reserve stays on the slab list, just unused
+    thread->reserve = region;
+    thread->reserve_end = region + num_slabs * SLAB_SIZE;
+}
+
+/**
+ * @brief Give the calling thread a fresh slab to bump through
+ *
+ * @param pool ItemPool* -> specific pool
+ * @param thread PoolThread* -> calling thread's state
+ */
+static void new_slab(ItemPool* pool, PoolThread* thread) {
+    if (thread->reserve >= thread->reserve_end) {
+        alloc_slabs(pool, thread, 1);
+    }
+
+    char* slab = thread->reserve;
+    thread->reserve += SLAB_SIZE;
+
+    thread->bump = slab + SLAB_HEADER;
+    thread->bump_end = slab + SLAB_SIZE;
+}
+
+/**
+ * @brief Make sure the calling thread can allocate count items without another allocation
+ *
+ * Items on the free list are not counted, bulk_load starts from an
+ * empty table.
+ *
+ * @param pool ItemPool* -> specific pool
+ * @param count size_t -> items the thread is about to allocate
+ */
+void pool_reserve(ItemPool* pool, size_t count) {
+    PoolThread* thread = get_thread(pool);
+    size_t per_slab = (SLAB_SIZE - SLAB_HEADER) / pool->item_size;
+    size_t available = thread->bump ? (size_t)(thread->bump_end - thread->bump) / pool->item_size : 0;
+
+    available += (size_t)(thread->reserve_end - thread->reserve) / SLAB_SIZE * per_slab;
+    if (count <= available) {
+        return;
+    }
+
+    available = thread->bump ? (size_t)(thread->bump_end - thread->bump) / pool->item_size : 0;
+
+    alloc_slabs(pool, thread, (count - available + per_slab - 1) / per_slab);
+}
+
+/**
+ * @brief Allocate one item
+ *
+ * Items are 8 byte aligned, the low three bits are free for tags.
+ *
+ * @param pool ItemPool* -> specific pool
+ * @return void* -> uninitialized item
+ */
+void* pool_alloc(ItemPool* pool) {
+    PoolThread* thread = get_thread(pool);
+
+    if (thread->free_list != NULL) {
+        FreeItem* item = thread->free_list;
+        thread->free_list = item->next;
+        return item;
+    }
+
+    // Whatever other nodes gave back to this one, before carving more
+    if (pool->numa) {
+        PoolNode* node = &pool->nodes[numa_current_node()];
+
+        if (node->free_list != NULL) {
+            omp_set_lock(&node->lock);
+            FreeItem* item = node->free_list;
+            node->free_list = NULL;
+            omp_unset_lock(&node->lock);
+
+            if (item != NULL) {
+                thread->free_list = item->next;
+                return item;
+            }
+        }
+    }
+
+    if (thread->bump + pool->item_size > thread->bump_end) {
+        new_slab(pool, thread);
+    }
+
+    void* item = thread->bump;
+    thread->bump += pool->item_size;
+    return item;
+}
+
+/**
+ * @brief Return one item to the pool it came from
+ *
+ * Matches the free() signature so it can be handed to epoch_retire.
+ *
+ * @param item void* -> item from pool_alloc (NULL is ignored)
+ */
+void pool_free(void* item) {
+    if (item == NULL) {
+        return;
+    }
+
+    Slab* slab = (Slab*)((uintptr_t)item & ~(uintptr_t)(SLAB_SIZE - 1));
+    ItemPool* pool = slab->pool;
+    FreeItem* free_item = item;
+
+    // Away from home, back to the node the slab is bound to
+    if (pool->numa && slab->node != numa_current_node()) {
+        PoolNode* node = &pool->nodes[slab->node];
+
+        omp_set_lock(&node->lock);
+        free_item->next = node->free_list;
+        node->free_list = free_item;
+        omp_unset_lock(&node->lock);
+        return;
+    }
+
+    PoolThread* thread = get_thread(pool);
+
+    free_item->next = thread->free_list;
+    thread->free_list = free_item;
+}
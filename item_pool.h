@@ -0,0 +1,97 @@
+/**
+ * @file item_pool.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Per-thread slab allocator for chain nodes
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Every insert used to malloc its node, which at high thread counts
+ * spends more time in the allocator than in the table. A pool hands out
+ * fixed size items carved from large slabs. Each thread allocates from
+ * its own slab and its own free list, so the hot path never touches
+ * shared state. Items are released in bulk when the pool is destroyed.
+ *
+ * An item freed by another thread goes onto the freeing thread's list,
+ * there is no hand back to the thread that allocated it.
+ *
+ * With numa set every slab is bound to the node of the thread that carves
+ * it (see numa.h), and an item freed on another node goes back to a
+ * locked per-node list of its own node instead, where any thread of that
+ * node picks the whole list up once its own list runs dry. Items then
+ * stay on the node that allocates them.
+ *
+ * pool_reserve() lets a thread that knows how many items it is about to
+ * take (bulk_load) get all of their slabs in one allocation up front.
+ *
+ * With huge_pages set a thread's slabs come from huge_alloc() (see
+ * hugepage.h) once it has needed a huge page worth of them.
+ *
+ * Threads are identified by omp_get_thread_num(), same as epoch.h.
+ */
+
+#ifndef ITEM_POOL_H
+#define ITEM_POOL_H
+
+#include "chained.h"
+
+/**
+ * @struct ItemPool
+ * @brief fixed size item allocator, one per table
+ *
+ * @param item_size size_t -> bytes per item
+ * @param numa int -> node local slabs and per-node free lists
+ * @param huge_pages int -> slabs from huge_alloc() once a thread needs a huge page of them
+ * @param threads PoolThread[] -> per-thread slab and free list
+ * @param nodes PoolNode[] -> items freed away from their node
+ */
+typedef struct ItemPool ItemPool;
+
+/**
+ * @brief Create item pool
+ *
+ * @param item_size size_t -> bytes per item (at least a pointer, multiple of 8)
+ * @param numa int -> node local slabs and per-node free lists
+ * @param huge_pages int -> slabs from huge_alloc() once a thread needs a huge page of them
+ * @return ItemPool*
+ */
+ItemPool* pool_create(size_t item_size, int numa, int huge_pages);
+
+/**
+ * @brief Destroy item pool, releasing every item it ever handed out
+ *
+ * @param pool ItemPool* -> pool to destroy
+ */
+void pool_destroy(ItemPool* pool);
+
+/**
+ * @brief Allocate one item
+ *
+ * Items are 8 byte aligned, the low three bits are free for tags.
+ *
+ * @param pool ItemPool* -> specific pool
+ * @return void* -> uninitialized item
+ */
+void* pool_alloc(ItemPool* pool);
+
+/**
+ * @brief Make sure the calling thread can allocate count items without another allocation
+ *
+ * The slabs missing for count items beyond the current one come out of
+ * a single allocation. Calling it again drops whatever is left of the
+ * previous reservation (the memory stays with the pool).
+ *
+ * @param pool ItemPool* -> specific pool
+ * @param count size_t -> items the thread is about to allocate
+ */
+void pool_reserve(ItemPool* pool, size_t count);
+
+/**
+ * @brief Return one item to the pool it came from
+ *
+ * Matches the free() signature so it can be handed to epoch_retire.
+ *
+ * @param item void* -> item from pool_alloc (NULL is ignored)
+ */
+void pool_free(void* item);
+
+#endif // ITEM_POOL_H
@@ -0,0 +1,141 @@
+/**
+ * @file latency.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Per-thread operation latency histograms for the driver
+ * @version 0.1
+ * @date 2026-10-14
+ */
+
+#include "latency.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Local constants
+#define LATENCY_NUM_PERCENTILES 5
+
+static const char* kind_names[LATENCY_KINDS] = { "lookup", "insert", "delete", "resize_overlap", "resize_stall" };
+static const double percentiles[LATENCY_NUM_PERCENTILES] = { 0.50, 0.90, 0.99, 0.999, 0.9999 };
+
+/**
+ * @brief Create one recorder per thread
+ *
+ * @param num_threads int -> number of recorders
+ * @param sample uint64_t -> time one out of this many operations (at least 1)
+ * @return LatencyRecorder*
+ */
+LatencyRecorder* latency_create(int num_threads, uint64_t sample) {
+    LatencyRecorder* recorders = aligned_alloc(64, num_threads * sizeof(LatencyRecorder));
+    memset(recorders, 0, num_threads * sizeof(LatencyRecorder));
+
+    for (int t = 0; t < num_threads; t++) {
+        recorders[t].sample = sample > 0 ? sample : 1;
+        recorders[t].countdown = recorders[t].sample;
+    }
+
+    return recorders;
+}
+
+/**
+ * @brief Destroy recorders
+ *
+ * @param recorders LatencyRecorder* -> recorders to destroy
+ */
+void latency_destroy(LatencyRecorder* recorders) {
+    free(recorders);
+}
+
+/**
+ * @brief largest value that lands in a bin
+ *
+ * @param bin size_t -> bin index
+ * @return uint64_t -> ticks
+ */
+static uint64_t bin_highest(size_t bin) {
+    if (bin < 2 * LATENCY_SUB_BUCKETS) {
+        return bin;
+    }
+
+    int shift = (int)(bin >> LATENCY_SUB_BITS) - 1;
+    uint64_t mantissa = bin - ((size_t)shift << LATENCY_SUB_BITS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/**
+ * @brief value at a percentile
+ *
+ * @param histogram const LatencyHistogram* -> merged histogram (count > 0)
+ * @param percentile double -> between 0 and 1
+ * @return uint64_t -> ticks, never more than the largest value recorded
+ */
+static uint64_t value_at(const LatencyHistogram* histogram, double percentile) {
+    uint64_t rank = (uint64_t)(percentile * histogram->count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BINS; i++) {
+        seen += histogram->bins[i];
+        if (seen >= rank) {
+            uint64_t value = bin_highest(i);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+/**
+ * @brief Merge the recorders and print percentiles
+ *
+ * @param recorders LatencyRecorder* -> recorder per thread
+ * @param num_threads int -> number of recorders
+ * @param ticks_per_ns double -> measured tick rate
+ * @param csv FILE* -> machine-readable output (NULL for none)
+ */
+void latency_report(LatencyRecorder* recorders, int num_threads, double ticks_per_ns, FILE* csv) {
+    LatencyHistogram* merged = malloc(sizeof(LatencyHistogram));
+
+    if (csv) {
+        fprintf(csv, "kind,count,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,p9999_ns,max_ns\n");
+    }
+
+    for (int kind = 0; kind < LATENCY_KINDS; kind++) {
+        memset(merged, 0, sizeof(LatencyHistogram));
+
+        for (int t = 0; t < num_threads; t++) {
+            const LatencyHistogram* histogram = &recorders[t].kinds[kind];
+
+            merged->count += histogram->count;
+            merged->total += histogram->total;
+            if (histogram->max > merged->max) {
+                merged->max = histogram->max;
+            }
+            for (size_t i = 0; i < LATENCY_BINS; i++) {
+                merged->bins[i] += histogram->bins[i];
+            }
+        }
+
+        if (merged->count == 0) {
+            continue;
+        }
+
+        double values[LATENCY_NUM_PERCENTILES];
+        for (int p = 0; p < LATENCY_NUM_PERCENTILES; p++) {
+            values[p] = value_at(merged, percentiles[p]) / ticks_per_ns;
+        }
+        double mean = (double)merged->total / merged->count / ticks_per_ns;
+        double max = merged->max / ticks_per_ns;
+
+        printf("latency_%s: count %" PRIu64 ", mean %.0f ns, p50 %.0f ns, p90 %.0f ns, p99 %.0f ns, p99.9 %.0f ns, p99.99 %.0f ns, max %.0f ns\n",
+               kind_names[kind], merged->count, mean, values[0], values[1], values[2], values[3], values[4], max);
+
+        if (csv) {
+            fprintf(csv, "%s,%" PRIu64 ",%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+                    kind_names[kind], merged->count, mean, values[0], values[1], values[2], values[3], values[4], max);
+        }
+    }
+
+    free(merged);
+}
@@ -0,0 +1,233 @@
+/**
+ * @file latency.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Per-thread operation latency histograms for the driver
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * The execution time of a whole run hides the operations that hurt: the
+ * insert that ends up doing resize_exclusive() for its shard, the lookups
+ * that migrate buckets during an incremental resize, the waits on a hot
+ * stripe. With latency recording on, the driver times single operations
+ * with the time stamp counter (clock_gettime where there is none) and
+ * counts them in log-linear histograms, HDR style: every power of two
+ * range is split into LATENCY_SUB_BUCKETS bins, so any value is off by at
+ * most 1/LATENCY_SUB_BUCKETS and the histogram still has a fixed size.
+ *
+ * Every thread owns one LatencyRecorder and writes it without atomics,
+ * latency_report() merges them after the run. Ticks are turned into
+ * nanoseconds with the tick rate measured over the whole run.
+ *
+ * An operation overlapped a resize if some table in the process was
+ * between stats_resize_begin() and stats_resize() while it ran. Those
+ * operations are counted a second time under LATENCY_RESIZE. The time a
+ * thread spends inside a stop-the-world resize() is not an operation,
+ * it goes to LATENCY_STALL.
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "stats.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+// Local constants
+#define LATENCY_SUB_BITS 5                            // log2 of the bins per power of two
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_SHIFT 40                          // longer values land in the last bin
+#define LATENCY_BINS ((LATENCY_MAX_SHIFT + 2) * LATENCY_SUB_BUCKETS)
+
+// Histograms of a recorder
+#define LATENCY_LOOKUP 0  // lookups
+#define LATENCY_INSERT 1  // inserts
+#define LATENCY_DELETE 2  // deletes
+#define LATENCY_RESIZE 3  // operations of any kind that overlapped a resize
+#define LATENCY_STALL 4   // time one thread spent inside resize()
+#define LATENCY_KINDS 5
+
+/**
+ * @struct LatencyHistogram
+ * @brief log-linear histogram of tick counts
+ *
+ * @param count uint64_t -> values recorded
+ * @param total uint64_t -> sum of all values
+ * @param max uint64_t -> largest value
+ * @param bins uint64_t[] -> values per bin, see latency_bin()
+ */
+typedef struct {
+    uint64_t count; /** @brief values recorded */
+    uint64_t total; /** @brief sum of all values */
+    uint64_t max; /** @brief largest value */
+    uint64_t bins[LATENCY_BINS]; /** @brief values per bin, see latency_bin() */
+} LatencyHistogram;
+
+/**
+ * @struct LatencyRecorder
+ * @brief histograms of one thread
+ *
+ * @param kinds LatencyHistogram[] -> one per LATENCY_* kind
+ * @param sample uint64_t -> time one out of this many operations
+ * @param countdown uint64_t -> operations left until the next timed one
+ */
+typedef struct {
+    LatencyHistogram kinds[LATENCY_KINDS]; /** @brief one per LATENCY_* kind */
+    uint64_t sample; /** @brief time one out of this many operations */
+    uint64_t countdown; /** @brief operations left until the next timed one */
+} __attribute__((aligned(64))) LatencyRecorder;
+
+/**
+ * @struct LatencySample
+ * @brief one operation being timed
+ *
+ * @param start uint64_t -> ticks when it started
+ * @param resizes_started uint64_t -> stats_resizes_started when it started
+ * @param resizing int -> a resize was already running when it started
+ */
+typedef struct {
+    uint64_t start; /** @brief ticks when it started */
+    uint64_t resizes_started; /** @brief stats_resizes_started when it started */
+    int resizing; /** @brief a resize was already running when it started */
+} LatencySample;
+
+/**
+ * @brief read the clock
+ *
+ * @return uint64_t -> ticks (nanoseconds without a time stamp counter)
+ */
+static inline uint64_t latency_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief bin of a value
+ *
+ * Values below 2 * LATENCY_SUB_BUCKETS get a bin each, above that the
+ * low bits are dropped until LATENCY_SUB_BITS + 1 are left.
+ *
+ * @param value uint64_t -> ticks
+ * @return size_t -> bin index
+ */
+static inline size_t latency_bin(uint64_t value) {
+    int shift = value < 2 * LATENCY_SUB_BUCKETS ? 0 : 63 - __builtin_clzll(value) - LATENCY_SUB_BITS;
+
+    if (shift > LATENCY_MAX_SHIFT) {
+        return LATENCY_BINS - 1;
+    }
+    return ((size_t)shift << LATENCY_SUB_BITS) + (size_t)(value >> shift);
+}
+
+/**
+ * @brief add one value to a histogram
+ *
+ * @param histogram LatencyHistogram* -> specific histogram
+ * @param value uint64_t -> ticks
+ */
+static inline void latency_record(LatencyHistogram* histogram, uint64_t value) {
+    histogram->count++;
+    histogram->total += value;
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+    histogram->bins[latency_bin(value)]++;
+}
+
+/**
+ * @brief decide whether to time the next operation
+ *
+ * @param recorder LatencyRecorder* -> recorder of the calling thread
+ * @return int -> 1 if it should be timed
+ */
+static inline int latency_sampled(LatencyRecorder* recorder) {
+    if (--recorder->countdown > 0) {
+        return 0;
+    }
+    recorder->countdown = recorder->sample;
+    return 1;
+}
+
+/**
+ * @brief start timing an operation
+ *
+ * @param sample LatencySample* -> filled in
+ */
+static inline void latency_start(LatencySample* sample) {
+    uint64_t finished;
+    uint64_t started;
+
+    // Finished first, a resize that ends in between then still counts as running
+    #pragma omp atomic read
+    finished = stats_resizes_finished;
+
+    #pragma omp atomic read
+    started = stats_resizes_started;
+
+    sample->resizing = started != finished;
+    sample->resizes_started = started;
+    sample->start = latency_ticks();
+}
+
+/**
+ * @brief stop timing an operation and record it
+ *
+ * @param recorder LatencyRecorder* -> recorder of the calling thread
+ * @param kind int -> LATENCY_LOOKUP, LATENCY_INSERT or LATENCY_DELETE
+ * @param sample const LatencySample* -> what latency_start() filled in
+ */
+static inline void latency_stop(LatencyRecorder* recorder, int kind, const LatencySample* sample) {
+    uint64_t elapsed = latency_ticks() - sample->start;
+    uint64_t started;
+
+    #pragma omp atomic read
+    started = stats_resizes_started;
+
+    latency_record(&recorder->kinds[kind], elapsed);
+
+    if (sample->resizing || started != sample->resizes_started) {
+        latency_record(&recorder->kinds[LATENCY_RESIZE], elapsed);
+    }
+}
+
+/**
+ * @brief Create one recorder per thread
+ *
+ * @param num_threads int -> number of recorders
+ * @param sample uint64_t -> time one out of this many operations (at least 1)
+ * @return LatencyRecorder*
+ */
+LatencyRecorder* latency_create(int num_threads, uint64_t sample);
+
+/**
+ * @brief Destroy recorders
+ *
+ * @param recorders LatencyRecorder* -> recorders to destroy
+ */
+void latency_destroy(LatencyRecorder* recorders);
+
+/**
+ * @brief Merge the recorders and print percentiles
+ *
+ * One line per kind that recorded anything. With csv set, the same
+ * numbers also go there as one row per kind under a header line.
+ *
+ * @param recorders LatencyRecorder* -> recorder per thread
+ * @param num_threads int -> number of recorders
+ * @param ticks_per_ns double -> measured tick rate
+ * @param csv FILE* -> machine-readable output (NULL for none)
+ */
+void latency_report(LatencyRecorder* recorders, int num_threads, double ticks_per_ns, FILE* csv);
+
+#endif // LATENCY_H
@@ -1,4 +1,14 @@
 #include "chained.h"
+#include "sharded.h"
+#include "parse.h"
+#include "steal.h"
+#include "latency.h"
+#include "workload.h"
+#include "numa.h"
+#include "policy.h"
+#include "perf.h"
+#include "hugepage.h"
+#include "hot.h"
 #include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,12 +16,20 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
 
 #define MAX_LINE_LENGTH 256
 #define INIT_NUM_BUCKETS 64
 #define INIT_NUM_LOCKS_RATIO 8
 #define MAX_TASK_POOL 256
 #define FILE_CHUNK_SIZE 32768 
+#define RECORD_CHUNK_SIZE ((FILE_CHUNK_SIZE / RECORD_SIZE) * RECORD_SIZE)
+#define BATCH_SIZE 32
+#define STEAL_REFILL 8  // chunks a thread reads into its own deque at once (less than STEAL_DEQUE_SIZE)
+#define MAX_INTERVALS 4096  // throughput reports kept for the steady-state median
 
 int end_of_file = 0;
 
@@ -22,35 +40,863 @@ typedef struct {
     uint64_t value;
 } FileIterator;
 
-typedef struct {
-    char hash_op;
-    uint64_t key;
-    uint64_t value;
-} BatchItem;
-
 typedef struct {
     uint64_t total_ops;
     uint64_t total_lookups;
     uint64_t successful_lookups;
     uint64_t missed_lookups;
     uint64_t total_inserts;
+    uint64_t total_deletes;
+    uint64_t missed_deletes;
     uint64_t failed_match;
     double start;
     double end;
 
 } MetricObject;
 
-static inline const char* parse_line(const char* cursor, char* op, uint64_t* key, uint64_t* val) {
-    while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n') cursor++;
-    if (*cursor == '\0') return NULL;
-    *op = *cursor;
-    cursor++;
-    char* end_ptr;
-    *key = strtoull(cursor, &end_ptr, 10);
-    cursor = end_ptr;
-    *val = strtoull(cursor, &end_ptr, 10);
-    cursor = end_ptr;
-    return cursor;
+/**
+ * @brief Run one operation on its own, timing it if it is sampled
+ * 
+ * @param chained ChainedHashTable* -> table (NULL when sharded)
+ * @param sharded ShardedTable* -> sharded table (NULL when not sharded)
+ * @param hash_op char -> 'I', 'L' or 'D'
+ * @param key uint64_t -> key
+ * @param value uint64_t -> value to insert
+ * @param recorder LatencyRecorder* -> recorder of the calling thread
+ * @return uint64_t -> lookup or remove result (INVALID_VALUE for inserts)
+ */
+static uint64_t timed_op(ChainedHashTable* chained, ShardedTable* sharded, char hash_op, uint64_t key, uint64_t value, LatencyRecorder* recorder) {
+    int timed = latency_sampled(recorder);
+    uint64_t result = INVALID_VALUE;
+    LatencySample sample;
+
+    if (timed) {
+        latency_start(&sample);
+    }
+
+    if (hash_op == 'L') {
+        result = sharded ? sharded_lookup(sharded, key) : lookup(chained, key);
+    } else if (hash_op == 'I') {
+        if (sharded) {
+            sharded_insert(sharded, key, value);
+        } else {
+            insert(chained, key, value);
+        }
+    } else {
+        result = sharded ? sharded_remove_key(sharded, key) : remove_key(chained, key);
+    }
+
+    if (timed) {
+        latency_stop(recorder, hash_op == 'L' ? LATENCY_LOOKUP : hash_op == 'I' ? LATENCY_INSERT : LATENCY_DELETE, &sample);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Run resize(), counting the time this thread spent in it as a stall
+ * 
+ * @param chained_pointer ChainedHashTable** -> table to resize
+ * @param latency LatencyRecorder* -> recorder per thread (NULL when off)
+ */
+static void timed_resize(ChainedHashTable** chained_pointer, LatencyRecorder* latency) {
+    uint64_t start = latency ? latency_ticks() : 0;
+
+    resize(chained_pointer);
+
+    if (latency) {
+        latency_record(&latency[omp_get_thread_num()].kinds[LATENCY_STALL], latency_ticks() - start);
+    }
+}
+
+/**
+ * @brief Run one batch of parsed (or generated) operations against the table
+ * 
+ * Runs of the same kind go to the batch calls. With latency recording on
+ * they go one at a time instead, a batch call can only be timed as a
+ * whole.
+ * 
+ * @param chained ChainedHashTable* -> table (NULL when sharded)
+ * @param sharded ShardedTable* -> sharded table (NULL when not sharded)
+ * @param speed_test int -> skip checking results and counting them
+ * @param batch const BatchItem* -> operations in trace order
+ * @param batch_count size_t -> number of operations (at most BATCH_SIZE)
+ * @param recorder LatencyRecorder* -> recorder of the calling thread (NULL when off)
+ * @param counts MetricObject* -> counters of the calling thread
+ */
+static void process_batch(ChainedHashTable* chained, ShardedTable* sharded, int speed_test, const BatchItem* batch, size_t batch_count, LatencyRecorder* recorder, MetricObject* counts) {
+    uint64_t batch_keys[BATCH_SIZE];
+    uint64_t batch_values[BATCH_SIZE];
+    uint64_t batch_results[BATCH_SIZE];
+
+    counts->total_ops += batch_count;
+
+    // Consecutive operations of the same kind go to the table as one batch
+    size_t run_start = 0;
+    while (run_start < batch_count) {
+        char hash_op = batch[run_start].hash_op;
+        size_t run_count = 0;
+
+        while (run_start + run_count < batch_count && batch[run_start + run_count].hash_op == hash_op) {
+            batch_keys[run_count] = batch[run_start + run_count].key;
+            batch_values[run_count] = batch[run_start + run_count].value;
+            run_count++;
+        }
+
+        if (hash_op == 'L') {
+            counts->total_lookups += run_count;
+            if (recorder) {
+                for (size_t i = 0; i < run_count; i++) {
+                    batch_results[i] = timed_op(chained, sharded, 'L', batch_keys[i], 0, recorder);
+                }
+            } else if (sharded) {
+                sharded_lookup_batch(sharded, batch_keys, batch_results, run_count);
+            } else {
+                lookup_batch(chained, batch_keys, batch_results, run_count);
+            }
+
+            if (!speed_test) {
+                for (size_t i = 0; i < run_count; i++) {
+                    if (batch_results[i] == INVALID_VALUE) {
+                        counts->missed_lookups++;
+                    } else {
+                        counts->successful_lookups++;
+                        if (batch_results[i] != batch_values[i]) {
+                            counts->failed_match++;
+                        }
+                    }
+                }
+            }
+        } else if (hash_op == 'I') {
+            counts->total_inserts += run_count;
+            if (recorder) {
+                for (size_t i = 0; i < run_count; i++) {
+                    timed_op(chained, sharded, 'I', batch_keys[i], batch_values[i], recorder);
+                }
+            } else if (sharded) {
+                sharded_insert_batch(sharded, batch_keys, batch_values, run_count);
+            } else {
+                insert_batch(chained, batch_keys, batch_values, run_count);
+            }
+        } else if (hash_op == 'D') {
+            counts->total_deletes += run_count;
+            for (size_t i = 0; i < run_count; i++) {
+                uint64_t removed_val;
+                if (recorder) {
+                    removed_val = timed_op(chained, sharded, 'D', batch_keys[i], 0, recorder);
+                } else {
+                    removed_val = sharded ? sharded_remove_key(sharded, batch_keys[i]) : remove_key(chained, batch_keys[i]);
+                }
+
+                if (!speed_test) {
+                    if (removed_val == INVALID_VALUE) {
+                        counts->missed_deletes++;
+                    } else if (removed_val != batch_values[i]) {
+                        counts->failed_match++;
+                    }
+                }
+            }
+        }
+
+        run_start += run_count;
+    }
+}
+
+/**
+ * @brief Add the counters of one thread to the run totals
+ * 
+ * @param run_metrics MetricObject* -> run totals
+ * @param counts const MetricObject* -> counters of the calling thread
+ */
+static void merge_metrics(MetricObject* run_metrics, const MetricObject* counts) {
+    #pragma omp atomic
+    run_metrics->total_ops += counts->total_ops;
+    #pragma omp atomic
+    run_metrics->total_lookups += counts->total_lookups;
+    #pragma omp atomic
+    run_metrics->successful_lookups += counts->successful_lookups;
+    #pragma omp atomic
+    run_metrics->missed_lookups += counts->missed_lookups;
+    #pragma omp atomic
+    run_metrics->total_inserts += counts->total_inserts;
+    #pragma omp atomic
+    run_metrics->total_deletes += counts->total_deletes;
+    #pragma omp atomic
+    run_metrics->missed_deletes += counts->missed_deletes;
+    #pragma omp atomic
+    run_metrics->failed_match += counts->failed_match;
+}
+
+/**
+ * @brief Run every operation in a chunk of the trace against the table
+ * 
+ * Operations are parsed BATCH_SIZE at a time and go through
+ * process_batch(). Counters are merged into run_metrics at the end.
+ * 
+ * @param chained ChainedHashTable* -> table (NULL when sharded)
+ * @param sharded ShardedTable* -> sharded table (NULL when not sharded)
+ * @param speed_test int -> skip checking results and counting them
+ * @param begin const char* -> first byte of the chunk, at the start of a line
+ * @param end const char* -> one past the last byte, right after a newline or at the end of the trace
+ * @param binary int -> chunk holds RECORD_SIZE records instead of text lines
+ * @param latency LatencyRecorder* -> recorder per thread (NULL when off)
+ * @param run_metrics MetricObject* -> run totals
+ */
+static void process_chunk(ChainedHashTable* chained, ShardedTable* sharded, int speed_test, const char* begin, const char* end, int binary, LatencyRecorder* latency, MetricObject* run_metrics) {
+    MetricObject counts = {0};
+    const char* cursor = begin;
+
+    BatchItem batch[BATCH_SIZE];
+    size_t batch_count;
+
+    LatencyRecorder* recorder = latency ? &latency[omp_get_thread_num()] : NULL;
+
+    while ((batch_count = binary ? parse_binary_batch(&cursor, end, batch, BATCH_SIZE) : parse_text_batch(&cursor, begin, end, batch, BATCH_SIZE)) > 0) {
+        process_batch(chained, sharded, speed_test, batch, batch_count, recorder, &counts);
+    }
+
+    if (!speed_test) {
+        merge_metrics(run_metrics, &counts);
+    } else {
+        // The operation count is still needed for the per operation counters of -P
+        #pragma omp atomic
+        run_metrics->total_ops += counts.total_ops;
+    }
+}
+
+/**
+ * @brief Read the next chunk of the trace with fread
+ *
+ * Binary chunks are whole records. Text chunks get cut back to the last
+ * newline and the file position moves back to the start of the cut line.
+ *
+ * @param f FILE* -> trace file
+ * @param binary int -> trace is RECORD_SIZE records instead of text lines
+ * @param chunk Chunk* -> filled in on success, chunk->buffer has to be freed
+ * @return int -> 0 at the end of the file
+ */
+static int read_chunk(FILE* f, int binary, Chunk* chunk) {
+    size_t chunk_size = binary ? RECORD_CHUNK_SIZE : FILE_CHUNK_SIZE;
+
+    char* buffer = malloc(chunk_size + 1);
+    if (!buffer) exit(1);
+
+    size_t bytes_read = fread(buffer, 1, chunk_size, f);
+
+    if (bytes_read == 0) {
+        free(buffer);
+        return 0;
+    }
+    if (!binary && bytes_read == chunk_size) {
+
+        // Find the last newline for a clean break
+        char* last_newline = NULL;
+        for (size_t i = bytes_read; i > 0; i--) {
+            if (buffer[i-1] == '\n') {
+                last_newline = &buffer[i-1];
+                break;
+            }
+        }
+
+        if (last_newline) {
+            size_t valid_bytes = (last_newline - buffer) + 1;
+            fseek(f, -(long)(bytes_read - valid_bytes), SEEK_CUR);
+            bytes_read = valid_bytes;
+        }
+    }
+
+    buffer[bytes_read] = '\0';
+
+    chunk->begin = buffer;
+    chunk->end = buffer + bytes_read;
+    chunk->buffer = buffer;
+    return 1;
+}
+
+/**
+ * @struct MappedTrace
+ * @brief trace file mapped into memory, handed out in chunks
+ *
+ * @param data const char* -> first byte of the mapping
+ * @param size size_t -> file size in bytes
+ * @param cursor volatile size_t -> next unclaimed offset
+ * @param binary int -> trace is RECORD_SIZE records instead of text lines
+ */
+typedef struct {
+    const char* data; /** @brief first byte of the mapping */
+    size_t size; /** @brief file size in bytes */
+    volatile size_t cursor; /** @brief next unclaimed offset */
+    int binary; /** @brief trace is RECORD_SIZE records instead of text lines */
+} MappedTrace;
+
+/**
+ * @brief Map the trace file read only
+ *
+ * The strtoull fallback in parse_field may read one token past the end
+ * of a chunk, which is only safe at the end of the file if the mapping is
+ * followed by zero fill (size not a multiple of the page size) or the
+ * file ends in a newline.
+ * Binary records are never read past the end of a chunk.
+ *
+ * @param path const char* -> trace file
+ * @param binary int -> trace is RECORD_SIZE records instead of text lines
+ * @param trace MappedTrace* -> filled in on success
+ * @return int -> 1 if the trace is mapped
+ */
+static int map_trace(const char* path, int binary, MappedTrace* trace) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+
+    if (data == MAP_FAILED) {
+        return 0;
+    }
+
+    trace->data = data;
+    trace->size = st.st_size;
+    trace->cursor = 0;
+    trace->binary = binary;
+
+    if (!binary && trace->size % sysconf(_SC_PAGESIZE) == 0 && trace->data[trace->size - 1] != '\n') {
+        munmap(data, trace->size);
+        return 0;
+    }
+
+    madvise(data, trace->size, MADV_WILLNEED);
+    return 1;
+}
+
+/**
+ * @brief find the first line that starts at or after offset
+ *
+ * @param trace MappedTrace* -> mapped trace
+ * @param offset size_t -> byte offset into the trace
+ * @return const char* -> start of that line (end of the trace if there is none)
+ */
+static const char* line_start(MappedTrace* trace, size_t offset) {
+    if (offset == 0) {
+        return trace->data;
+    }
+
+    const char* curr = trace->data + offset - 1;
+    const char* last = trace->data + trace->size;
+
+    while (curr < last && *curr != '\n') {
+        curr++;
+    }
+
+    return curr < last ? curr + 1 : last;
+}
+
+/**
+ * @brief Claim the next chunk of a mapped trace
+ *
+ * Threads claim raw FILE_CHUNK_SIZE ranges with one atomic add. A line
+ * belongs to the range its first byte is in, so both ends move forward to
+ * the next line start and no line is skipped or parsed twice. Binary
+ * chunks are a whole number of records and need no adjusting.
+ *
+ * @param trace MappedTrace* -> mapped trace
+ * @param begin const char** -> first line of the chunk
+ * @param end const char** -> one past the last line of the chunk
+ * @return int -> 0 once the whole trace has been claimed
+ */
+static int claim_chunk(MappedTrace* trace, const char** begin, const char** end) {
+    size_t start;
+    size_t chunk_size = trace->binary ? RECORD_CHUNK_SIZE : FILE_CHUNK_SIZE;
+
+    // seq_cst so a failed claim is ordered after the in_flight count of the claim before it (refill_deque)
+    #pragma omp atomic capture seq_cst
+    {
+        start = trace->cursor;
+        trace->cursor += chunk_size;
+    }
+
+    if (start >= trace->size) {
+        return 0;
+    }
+
+    size_t stop = start + chunk_size;
+
+    if (trace->binary) {
+        *begin = trace->data + start;
+        *end = trace->data + (stop < trace->size ? stop : trace->size);
+        return 1;
+    }
+
+    *begin = line_start(trace, start);
+    *end = stop < trace->size ? line_start(trace, stop) : trace->data + trace->size;
+    return 1;
+}
+
+/**
+ * @brief Replay a mapped trace with every thread pulling its own chunks
+ *
+ * There is no producer. Threads only meet when the table asks for a
+ * stop-the-world resize and once at the end of the trace.
+ *
+ * @param trace MappedTrace* -> mapped trace
+ * @param chained_pointer ChainedHashTable** -> table, replaced by resize (NULL when sharded)
+ * @param sharded ShardedTable* -> sharded table (NULL when not sharded)
+ * @param speed_test int -> skip checking results and counting them
+ * @param latency LatencyRecorder* -> recorder per thread (NULL when off)
+ * @param run_metrics MetricObject* -> run totals
+ */
+static void run_mapped(MappedTrace* trace, ChainedHashTable** chained_pointer, ShardedTable* sharded, int speed_test, LatencyRecorder* latency, MetricObject* run_metrics) {
+    #pragma omp parallel
+    {
+        while (1) {
+            const char* begin;
+            const char* end;
+
+            while (!(*chained_pointer != NULL && needs_resize(*chained_pointer)) && claim_chunk(trace, &begin, &end)) {
+                process_chunk(*chained_pointer, sharded, speed_test, begin, end, trace->binary, latency, run_metrics);
+            }
+
+            #pragma omp barrier
+
+            if (*chained_pointer != NULL && needs_resize(*chained_pointer)) {
+                timed_resize(chained_pointer, latency);
+            }
+
+            size_t claimed;
+
+            #pragma omp atomic read
+            claimed = trace->cursor;
+
+            // Read before the barrier, the next round claims again
+            int done = claimed >= trace->size;
+
+            #pragma omp barrier
+
+            if (done) {
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @struct StealRun
+ * @brief shared state of a work-stealing replay
+ *
+ * @param pool StealPool* -> deque per thread
+ * @param file FILE* -> trace read with fread (NULL for a mapped trace)
+ * @param trace MappedTrace* -> mapped trace (NULL when reading with fread)
+ * @param binary int -> trace is RECORD_SIZE records instead of text lines
+ * @param read_lock omp_lock_t -> taken by the thread currently reading with fread
+ * @param exhausted volatile int -> set once the source has no chunks left
+ * @param in_flight volatile long -> chunks taken from the source and not processed yet
+ */
+typedef struct {
+    StealPool* pool; /** @brief deque per thread */
+    FILE* file; /** @brief trace read with fread (NULL for a mapped trace) */
+    MappedTrace* trace; /** @brief mapped trace (NULL when reading with fread) */
+    int binary; /** @brief trace is RECORD_SIZE records instead of text lines */
+    omp_lock_t read_lock; /** @brief taken by the thread currently reading with fread */
+    volatile int exhausted; /** @brief set once the source has no chunks left */
+    volatile long in_flight; /** @brief chunks taken from the source and not processed yet */
+} StealRun;
+
+/**
+ * @brief Move up to STEAL_REFILL chunks from the source into the caller's deque
+ *
+ * Only called with an empty deque, so every push fits. A thread that
+ * finds another one reading with fread goes stealing instead of waiting.
+ * Thieves take the back of a refill, the owner works from the front.
+ *
+ * @param run StealRun* -> shared state
+ * @return int -> number of chunks queued
+ */
+static int refill_deque(StealRun* run) {
+    int exhausted;
+
+    #pragma omp atomic read seq_cst
+    exhausted = run->exhausted;
+
+    if (exhausted || (run->file != NULL && !omp_test_lock(&run->read_lock))) {
+        return 0;
+    }
+
+    Chunk chunks[STEAL_REFILL];
+    int count = 0;
+
+    while (count < STEAL_REFILL) {
+        Chunk* chunk = &chunks[count];
+        chunk->buffer = NULL;
+
+        /* Counted before the attempt: a mapped trace is claimed without
+        read_lock, and a thread whose claim fails right after ours may set
+        exhausted before we get here. Nobody leaves while this chunk is
+        still on its way to a deque. */
+        #pragma omp atomic update seq_cst
+        run->in_flight++;
+
+        int more = run->file != NULL ? read_chunk(run->file, run->binary, chunk) : claim_chunk(run->trace, &chunk->begin, &chunk->end);
+
+        if (!more) {
+            #pragma omp atomic write seq_cst
+            run->exhausted = 1;
+
+            // Set exhausted first, in_flight at zero must not be seen before it
+            #pragma omp atomic update seq_cst
+            run->in_flight--;
+            break;
+        }
+
+        count++;
+    }
+
+    if (run->file != NULL) {
+        omp_unset_lock(&run->read_lock);
+    }
+
+    // The owner pops the newest push first, so push backwards to keep trace order
+    for (int i = count - 1; i >= 0; i--) {
+        steal_push(run->pool, &chunks[i]);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Replay the trace with per-thread deques and stealing
+ *
+ * Idle threads take turns pulling chunks from the source into their own
+ * deque, and steal from the others while someone else is reading. There
+ * is no round and no barrier per round. The resize handshake is resize()
+ * itself: every thread checks needs_resize() between two chunks and then
+ * joins the collective resize, the first barrier inside it waits for the
+ * threads still finishing a chunk.
+ *
+ * A thread only leaves once the source is exhausted and no chunk is in
+ * flight. in_flight drops after the last insert of a chunk, so a thread
+ * that sees it at zero also sees any resize that chunk asked for.
+ *
+ * @param run StealRun* -> shared state
+ * @param chained_pointer ChainedHashTable** -> table, replaced by resize (NULL when sharded)
+ * @param sharded ShardedTable* -> sharded table (NULL when not sharded)
+ * @param speed_test int -> skip checking results and counting them
+ * @param latency LatencyRecorder* -> recorder per thread (NULL when off)
+ * @param run_metrics MetricObject* -> run totals
+ */
+static void run_stealing(StealRun* run, ChainedHashTable** chained_pointer, ShardedTable* sharded, int speed_test, LatencyRecorder* latency, MetricObject* run_metrics) {
+    #pragma omp parallel
+    {
+        while (1) {
+            if (*chained_pointer != NULL && needs_resize(*chained_pointer)) {
+                timed_resize(chained_pointer, latency);
+                continue;
+            }
+
+            Chunk chunk;
+
+            if (steal_pop(run->pool, &chunk) || (refill_deque(run) > 0 && steal_pop(run->pool, &chunk)) || steal_take(run->pool, &chunk)) {
+                process_chunk(*chained_pointer, sharded, speed_test, chunk.begin, chunk.end, run->binary, latency, run_metrics);
+                free(chunk.buffer);
+
+                #pragma omp atomic update seq_cst
+                run->in_flight--;
+
+                continue;
+            }
+
+            int exhausted;
+            long in_flight;
+
+            #pragma omp atomic read seq_cst
+            exhausted = run->exhausted;
+
+            #pragma omp atomic read seq_cst
+            in_flight = run->in_flight;
+
+            if (exhausted && in_flight == 0) {
+                if (*chained_pointer != NULL && needs_resize(*chained_pointer)) {
+                    continue;
+                }
+                break;
+            }
+
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * @struct ThreadProgress
+ * @brief operations one thread has finished, alone on its cache line
+ *
+ * @param ops volatile uint64_t -> operations done so far
+ */
+typedef struct {
+    volatile uint64_t ops; /** @brief operations done so far */
+} __attribute__((aligned(64))) ThreadProgress;
+
+/**
+ * @struct SyntheticRun
+ * @brief shared state of a generated (-g) run
+ *
+ * @param workload Workload -> generator settings
+ * @param progress ThreadProgress* -> per-thread operation counts for the reports
+ * @param stop volatile int -> set by thread 0 once the duration is over
+ * @param finished volatile int -> threads that generated their last operation
+ * @param intervals double* -> Mops/s of every report interval
+ * @param num_intervals int -> number of intervals reported
+ */
+typedef struct {
+    Workload workload; /** @brief generator settings */
+    ThreadProgress* progress; /** @brief per-thread operation counts for the reports */
+    volatile int stop; /** @brief set by thread 0 once the duration is over */
+    volatile int finished; /** @brief threads that generated their last operation */
+    double* intervals; /** @brief Mops/s of every report interval */
+    int num_intervals; /** @brief number of intervals reported */
+} SyntheticRun;
+
+/**
+ * @brief Print the throughput since the last report
+ *
+ * Only called by thread 0.
+ *
+ * @param run SyntheticRun* -> shared state
+ * @param num_threads int -> threads in the team
+ * @param elapsed double -> seconds since the start of the run
+ * @param last_ops uint64_t* -> in: operations at the last report, out: now
+ * @param last_time double* -> in: time of the last report, out: elapsed
+ */
+static void report_interval(SyntheticRun* run, int num_threads, double elapsed, uint64_t* last_ops, double* last_time) {
+    uint64_t ops = 0;
+
+    for (int t = 0; t < num_threads; t++) {
+        uint64_t thread_ops;
+
+        #pragma omp atomic read
+        thread_ops = run->progress[t].ops;
+
+        ops += thread_ops;
+    }
+
+    double mops = (ops - *last_ops) / (elapsed - *last_time) / 1e6;
+    printf("interval %d: %.3f seconds, %" PRIu64 " ops, %.3f Mops/s\n", run->num_intervals + 1, elapsed, ops, mops);
+
+    if (run->num_intervals < MAX_INTERVALS) {
+        run->intervals[run->num_intervals++] = mops;
+    }
+
+    *last_ops = ops;
+    *last_time = elapsed;
+}
+
+/**
+ * @brief Run generated operations until the op count or the duration is reached
+ *
+ * Every thread generates BATCH_SIZE operations at a time and runs them
+ * through process_batch(), so results are checked as for a trace. Thread
+ * 0 also prints the throughput of every report interval.
+ *
+ * Threads that are done keep checking needs_resize() until all of them
+ * are, the same handshake as run_stealing(): finished is raised after a
+ * thread's last insert, so whoever sees every thread finished also sees
+ * any resize those inserts asked for.
+ *
+ * @param run SyntheticRun* -> shared state
+ * @param chained_pointer ChainedHashTable** -> table, replaced by resize (NULL when sharded)
+ * @param sharded ShardedTable* -> sharded table (NULL when not sharded)
+ * @param speed_test int -> skip checking results and counting them
+ * @param latency LatencyRecorder* -> recorder per thread (NULL when off)
+ * @param run_metrics MetricObject* -> run totals
+ */
+static void run_synthetic(SyntheticRun* run, ChainedHashTable** chained_pointer, ShardedTable* sharded, int speed_test, LatencyRecorder* latency, MetricObject* run_metrics) {
+    const WorkloadConfig* config = &run->workload.config;
+    double start = omp_get_wtime();
+
+    #pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+        int num_threads = omp_get_num_threads();
+
+        WorkloadThread generator;
+        workload_thread_init(&run->workload, &generator, thread);
+
+        // Split the op count, the first threads take one more (a thread may get none)
+        int bounded = config->num_ops > 0;
+        uint64_t quota = 0;
+        if (bounded) {
+            quota = config->num_ops / num_threads + ((uint64_t)thread < config->num_ops % num_threads);
+        }
+
+        MetricObject counts = {0};
+        BatchItem batch[BATCH_SIZE];
+        LatencyRecorder* recorder = latency ? &latency[thread] : NULL;
+
+        uint64_t done = 0;
+        uint64_t last_ops = 0;
+        double last_time = 0.0;
+        double next_report = config->interval;
+        int generating = 1;
+
+        while (1) {
+            if (*chained_pointer != NULL && needs_resize(*chained_pointer)) {
+                timed_resize(chained_pointer, latency);
+                continue;
+            }
+
+            if (generating) {
+                int stop;
+
+                #pragma omp atomic read
+                stop = run->stop;
+
+                if (stop || (bounded && done >= quota)) {
+                    generating = 0;
+
+                    #pragma omp atomic update seq_cst
+                    run->finished++;
+
+                    continue;
+                }
+
+                size_t count = BATCH_SIZE;
+                if (bounded && quota - done < count) {
+                    count = quota - done;
+                }
+
+                double progress = bounded ? (double)done / quota : (omp_get_wtime() - start) / config->duration;
+
+                workload_generate(&run->workload, &generator, progress, batch, count);
+                process_batch(*chained_pointer, sharded, speed_test, batch, count, recorder, &counts);
+                done += count;
+
+                #pragma omp atomic write
+                run->progress[thread].ops = done;
+            } else {
+                int finished;
+
+                #pragma omp atomic read seq_cst
+                finished = run->finished;
+
+                if (finished == num_threads) {
+                    if (*chained_pointer != NULL && needs_resize(*chained_pointer)) {
+                        continue;
+                    }
+                    break;
+                }
+
+                sched_yield();
+            }
+
+            if (thread == 0) {
+                double elapsed = omp_get_wtime() - start;
+
+                if (elapsed >= next_report) {
+                    report_interval(run, num_threads, elapsed, &last_ops, &last_time);
+                    next_report = elapsed + config->interval;
+                }
+                if (config->duration > 0.0 && elapsed >= config->duration) {
+                    #pragma omp atomic write
+                    run->stop = 1;
+                }
+            }
+        }
+
+        if (!speed_test) {
+            merge_metrics(run_metrics, &counts);
+        } else {
+            #pragma omp atomic
+            run_metrics->total_ops += counts.total_ops;
+        }
+    }
+}
+
+/**
+ * @brief Print the median interval throughput, leaving out the first interval
+ *
+ * @param run SyntheticRun* -> shared state
+ */
+static void print_steady_state(SyntheticRun* run) {
+    int first = run->num_intervals > 1 ? 1 : 0;
+    int n = run->num_intervals - first;
+
+    if (n <= 0) {
+        printf("steady_state: no full interval, use a longer run or a shorter interval\n");
+        return;
+    }
+
+    double* sorted = malloc(n * sizeof(double));
+    memcpy(sorted, run->intervals + first, n * sizeof(double));
+
+    // Insertion sort, there are few intervals
+    for (int i = 1; i < n; i++) {
+        double value = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > value) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = value;
+    }
+
+    double median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    printf("steady_state: %.3f Mops/s (median of %d intervals, min %.3f, max %.3f)\n", median, n, sorted[0], sorted[n - 1]);
+
+    free(sorted);
+}
+
+/**
+ * @brief Name the table flags a loaded image overrode
+ *
+ * load_table() builds the table with the settings saved in the image, so
+ * -b and every flag that only goes into the TableConfig are not used.
+ *
+ * @param config const TableConfig* -> settings from the command line
+ * @param initial_buckets int -> -b
+ */
+static void print_ignored_flags(const TableConfig* config, int initial_buckets) {
+    TableConfig defaults = TABLE_CONFIG_DEFAULT;
+    char flags[64] = "";
+
+    if (initial_buckets != INIT_NUM_BUCKETS) {
+        strcat(flags, " -b");
+    }
+    if (config->hash_function != defaults.hash_function) {
+        strcat(flags, " -H");
+    }
+    if (config->max_load != defaults.max_load || config->min_load != defaults.min_load
+        || config->long_chain_ratio != defaults.long_chain_ratio || config->growth_factor != defaults.growth_factor
+        || config->expected_items != defaults.expected_items || config->report_resizes != defaults.report_resizes) {
+        strcat(flags, " -R");
+    }
+    if (config->hot_keys != defaults.hot_keys) {
+        strcat(flags, " -K");
+    }
+    if (config->numa != defaults.numa) {
+        strcat(flags, " -N");
+    }
+    if (config->huge_pages != defaults.huge_pages) {
+        strcat(flags, " -G");
+    }
+    if (config->resize_enabled != defaults.resize_enabled) {
+        strcat(flags, " -r");
+    }
+    if (config->incremental_resize != defaults.incremental_resize) {
+        strcat(flags, " -i");
+    }
+    if (config->optimistic_reads != defaults.optimistic_reads) {
+        strcat(flags, " -o");
+    }
+
+    if (flags[0] != '\0') {
+        printf("the image brings its own table settings, ignoring%s\n", flags);
+    }
 }
 
 int main(int argc, char *argv[]) {
@@ -58,13 +904,37 @@ int main(int argc, char *argv[]) {
     int initial_buckets = INIT_NUM_BUCKETS;
     int num_threads = DEFAULT_NUM_THREADS;
     char* data_file = "output.txt";
+    int num_shards = 0;
+    int use_mmap = 0;
+    int binary_trace = 0;
+    int work_stealing = 0;
+    int speed_test = 0;
+    long latency_sample = 0;
+    char* latency_file = NULL;
+    int synthetic = 0;
+    WorkloadConfig workload_config;
+    int pin_policy = -1;
+    char* load_image = NULL;
+    char* save_image = NULL;
+    int count_events = 0;
+    PerfCounters perf = {0};
+    TableConfig config = TABLE_CONFIG_DEFAULT;
 
     int opt;
-    while ((opt = getopt(argc, argv, "f:b:t:rs")) != -1) {
+    while ((opt = getopt(argc, argv, "f:F:b:H:t:S:l:L:g:A:I:O:R:P:K:risomwNG")) != -1) {
         switch (opt) {
             case 'f':
                 data_file = optarg;
                 break;
+            case 'F':
+                if (strcmp(optarg, "text") == 0) {
+                    binary_trace = 0;
+                } else if (strcmp(optarg, "binary") == 0) {
+                    binary_trace = 1;
+                } else {
+                    printf("trace format must be text or binary, keeping text\n");
+                }
+                break;
             case 'b':
                 initial_buckets = atoi(optarg);
                 if (initial_buckets == 0) {
@@ -72,190 +942,383 @@ int main(int argc, char *argv[]) {
                     initial_buckets = INIT_NUM_BUCKETS;
                 }
                 break;
+            case 'H':
+                if (strcmp(optarg, "murmur") == 0) {
+                    config.hash_function = HASH_MURMUR;
+                } else if (strcmp(optarg, "wy") == 0) {
+                    config.hash_function = HASH_WY;
+                } else if (strcmp(optarg, "legacy") == 0) {
+                    config.hash_function = HASH_LEGACY;
+                } else {
+                    printf("hash must be murmur, wy or legacy, keeping default\n");
+                }
+                break;
             case 't':
                 num_threads = atoi(optarg);
                 if (num_threads < 1) {
                     printf("number of threads must be > 1, setting to default\n");
                     num_threads = DEFAULT_NUM_THREADS;
                 }
+                if (num_threads > MAX_THREADS) {
+                    printf("number of threads must be <= %d, setting to max\n", MAX_THREADS);
+                    num_threads = MAX_THREADS;
+                }
+                break;
+            case 'S':
+                num_shards = atoi(optarg);
+                if (num_shards < 1) {
+                    printf("number of shards must be >= 1, not sharding\n");
+                    num_shards = 0;
+                }
+                break;
+            case 'l':
+                latency_sample = atol(optarg);
+                if (latency_sample < 1) {
+                    printf("latency sample rate must be >= 1, timing every operation\n");
+                    latency_sample = 1;
+                }
+                break;
+            case 'L':
+                latency_file = optarg;
+                if (latency_sample == 0) {
+                    latency_sample = 1;
+                }
+                break;
+            case 'g':
+                if (!workload_parse(optarg, &workload_config)) {
+                    printf("workload must be [preset][,name=value...] with a positive ops or time, see README\n");
+                    exit(1);
+                }
+                synthetic = 1;
+                break;
+            case 'A':
+                if (strcmp(optarg, "close") == 0) {
+                    pin_policy = NUMA_PIN_CLOSE;
+                } else if (strcmp(optarg, "spread") == 0) {
+                    pin_policy = NUMA_PIN_SPREAD;
+                } else if (strcmp(optarg, "none") == 0) {
+                    pin_policy = NUMA_PIN_NONE;
+                } else {
+                    printf("affinity must be close, spread or none, not pinning\n");
+                    pin_policy = NUMA_PIN_NONE;
+                }
+                break;
+            case 'I':
+                load_image = optarg;
+                break;
+            case 'O':
+                save_image = optarg;
+                break;
+            case 'R':
+                if (!policy_parse(optarg, &config)) {
+                    printf("resize policy must be name=value[,name=value...] with max_load, min_load, long, grow >= 2, expect, report, see README\n");
+                    exit(1);
+                }
+                break;
+            case 'P':
+                if (!perf_parse(optarg, &perf)) {
+                    printf("counters must be all or name[,name...] with cycles, instructions, llc_misses, dtlb_misses, branch_misses, hitm[=raw_code], see README\n");
+                    exit(1);
+                }
+                count_events = 1;
+                break;
+            case 'K':
+                if (!hot_parse(optarg, &config.hot_keys)) {
+                    printf("hot keys must be all or name[,name...] with cache, front, combine, see README\n");
+                    exit(1);
+                }
+                break;
+            case 'N':
+                config.numa = 1;
+                break;
+            case 'G':
+                config.huge_pages = 1;
                 break;
             case 'r':
-                resize_enabled = 0;
+                config.resize_enabled = 0;
+                break;
+            case 'i':
+                config.incremental_resize = 1;
                 break;
             case 's':
                 speed_test = 1;
                 break;
+            case 'o':
+                config.optimistic_reads = 1;
+                break;
+            case 'm':
+                use_mmap = 1;
+                break;
+            case 'w':
+                work_stealing = 1;
+                break;
             default:
-                printf("format to use: %s [-b initial_buckets] [-t num_threads] [-r disable_resize] [-s speed_test]\n", argv[0]);
+                printf("format to use: %s [-f data_file] [-F text|binary] [-b initial_buckets] [-H murmur|wy|legacy] [-t num_threads] [-S num_shards] [-l latency_sample] [-L latency_csv] [-g workload] [-A close|spread|none] [-I load_image] [-O save_image] [-R resize_policy] [-P perf_counters] [-K hot_keys] [-N numa_placement] [-G huge_pages] [-r disable_resize] [-i incremental_resize] [-s speed_test] [-o optimistic_reads] [-m mmap_input] [-w work_stealing]\n", argv[0]);
                 exit(1);
         }
     }
 
+    config.hot_keys = hot_restrict(config.hot_keys, hot_keys_supported());
+
     omp_set_num_threads(num_threads);
 
-    FILE *f = fopen(data_file, "rb");
+    // -N alone spreads the threads over the nodes, so every node has some to serve
+    if (pin_policy < 0) {
+        pin_policy = config.numa ? NUMA_PIN_SPREAD : NUMA_PIN_NONE;
+    }
+    numa_pin_threads(pin_policy, num_threads);
+
+    // A generated run has no trace at all
+    FILE *f = synthetic ? NULL : fopen(data_file, "rb");
 
-    if (f == NULL) {
+    if (f == NULL && !synthetic) {
         printf("File not found\n");
         exit(1);
     }
 
     FileIterator iter = { .file = f };
 
+    MappedTrace trace = {0};
+
+    if (synthetic) {
+        use_mmap = 0;
+        work_stealing = 0;
+    }
+
+    if (use_mmap && !map_trace(data_file, binary_trace, &trace)) {
+        printf("could not mmap the trace, reading it with fread\n");
+        use_mmap = 0;
+    }
+
     MetricObject run_metrics = {0};
 
-    ChainedHashTable* chained = create_table(initial_buckets, initial_buckets / INIT_NUM_LOCKS_RATIO);
+    int num_locks = initial_buckets / INIT_NUM_LOCKS_RATIO;
+    if (num_locks < 1) {
+        num_locks = 1;
+    }
+
+    // create_table rounds both up to powers of two, so the stripes always divide the buckets
+    // With -S every shard resizes on its own and the driver never stops for resize()
+    ChainedHashTable* chained = NULL;
+    ShardedTable* sharded = NULL;
+
+    if (num_shards > 0) {
+        sharded = create_sharded(num_shards, initial_buckets, num_locks, &config);
+    } else if (load_image != NULL) {
+        // The image brings its own settings and size, -b and the table flags only apply if it can not be read
+        double load_start = omp_get_wtime();
+        chained = load_table(load_image);
+
+        if (chained != NULL) {
+            printf("load_table: %s in %f seconds\n", load_image, omp_get_wtime() - load_start);
+            print_ignored_flags(&config, initial_buckets);
+        } else {
+            printf("could not load %s, starting with an empty table\n", load_image);
+            chained = create_table(initial_buckets, num_locks, &config);
+        }
+    } else {
+        chained = create_table(initial_buckets, num_locks, &config);
+    }
+
+    if (sharded != NULL && (load_image != NULL || save_image != NULL)) {
+        printf("images are for unsharded tables, ignoring -I and -O with -S\n");
+        save_image = NULL;
+    }
+
+    LatencyRecorder* latency = latency_sample > 0 ? latency_create(omp_get_max_threads(), latency_sample) : NULL;
+
+    // Set up before the clock starts, a Zipfian key space needs its zeta sum and preloaded keys their table
+    SyntheticRun synthetic_run = {0};
+
+    if (synthetic) {
+        synthetic_run.progress = aligned_alloc(64, omp_get_max_threads() * sizeof(ThreadProgress));
+        synthetic_run.intervals = malloc(MAX_INTERVALS * sizeof(double));
+        memset(synthetic_run.progress, 0, omp_get_max_threads() * sizeof(ThreadProgress));
+        workload_init(&synthetic_run.workload, &workload_config, omp_get_max_threads());
+
+        size_t preload = synthetic_run.workload.config.preload;
+
+        if (preload > 0) {
+            uint64_t* keys = malloc(preload * sizeof(uint64_t));
+            uint64_t* values = malloc(preload * sizeof(uint64_t));
+            workload_preload(&synthetic_run.workload, keys, values);
+
+            double load_start = omp_get_wtime();
+            if (sharded != NULL) {
+                sharded_bulk_load(sharded, keys, values, preload);
+            } else {
+                bulk_load(&chained, keys, values, preload);
+            }
+            printf("bulk_load: %zu keys in %f seconds\n", preload, omp_get_wtime() - load_start);
+
+            free(values);
+            free(keys);
+        }
+    }
+
+    // Opened in the run's threads just before the clock starts, so setup and preload are not counted
+    if (count_events) {
+        perf_start(&perf, omp_get_max_threads());
+    }
 
+    uint64_t start_ticks = latency_ticks();
     run_metrics.start = omp_get_wtime();
 
-    #pragma omp parallel
-    {
-        while (!end_of_file) {
+    if (synthetic) {
+        run_synthetic(&synthetic_run, &chained, sharded, speed_test, latency, &run_metrics);
+    } else if (work_stealing) {
+        StealRun run = {
+            .pool = steal_create(omp_get_max_threads()),
+            .file = use_mmap ? NULL : f,
+            .trace = use_mmap ? &trace : NULL,
+            .binary = binary_trace,
+        };
+        omp_init_lock(&run.read_lock);
 
-            #pragma omp single
-            {
-                int temp_resize_needed = 0;
-                int count = 0;
-                while (1) {
+        run_stealing(&run, &chained, sharded, speed_test, latency, &run_metrics);
 
-                    char* buffer = malloc(FILE_CHUNK_SIZE + 1);
-                    if (!buffer) exit(1);
+        omp_destroy_lock(&run.read_lock);
+        steal_destroy(run.pool);
+    } else if (use_mmap) {
+        run_mapped(&trace, &chained, sharded, speed_test, latency, &run_metrics);
+    } else {
+        #pragma omp parallel
+        {
+            while (1) {
 
-                    size_t bytes_read = fread(buffer, 1, FILE_CHUNK_SIZE, f);
+                #pragma omp single
+                {
+                    int temp_resize_needed = 0;
+                    int count = 0;
+                    while (1) {
 
-                    if (bytes_read == 0) {
-                        free(buffer);
-                        end_of_file = 1;
-                        break;
-                    }
-                    if (bytes_read == FILE_CHUNK_SIZE) {
-
-                        // Find the last newline for a clean break
-                        char* last_newline = NULL;
-                        for (size_t i = bytes_read; i > 0; i--) {
-                            if (buffer[i-1] == '\n') {
-                                last_newline = &buffer[i-1];
-                                break;
-                            }
-                        }
+                        Chunk chunk;
 
-                        if (last_newline) {
-                            size_t valid_bytes = (last_newline - buffer) + 1;
-                            fseek(f, -(long)(bytes_read - valid_bytes), SEEK_CUR);
-                            bytes_read = valid_bytes;
+                        if (!read_chunk(f, binary_trace, &chunk)) {
+                            end_of_file = 1;
+                            break;
                         }
-                    }
-                    
-                    buffer[bytes_read] = '\0';
-
-                    #pragma omp task firstprivate(buffer, bytes_read) shared(run_metrics, chained)
-                    {
-                        uint64_t temp_ops = 0;
-                        uint64_t temp_lookups = 0;
-                        uint64_t temp_succ_lookups = 0;
-                        uint64_t temp_missed_lookups = 0;
-                        uint64_t temp_inserts = 0;
-                        uint64_t temp_failed_match = 0;
-
-                        const char* cursor = buffer;
-                        const char* end = buffer + bytes_read;
-                        
-                        char hash_op;
-                        uint64_t key;
-                        uint64_t value;
-
-                        while (cursor < end && *cursor != '\0') {
-                            cursor = parse_line(cursor, &hash_op, &key, &value);
-                            if (!cursor) break;
-
-                            temp_ops++;
-
-                            if (hash_op == 'L') {
-                                temp_lookups++;
-                                uint64_t lookup_val = lookup(chained, key);
-
-                                if (!speed_test) {
-                                    if (lookup_val == INVALID_VALUE) {
-                                        temp_missed_lookups++;
-                                    } else {
-                                        temp_succ_lookups++;
-                                        if (lookup_val != value) {
-                                            temp_failed_match++;
-                                        }
-                                    }
-                                }
-                            } else if (hash_op == 'I') {
-                                temp_inserts++;
-                                insert(chained, key, value);
-                            }
+
+                        #pragma omp task firstprivate(chunk) shared(run_metrics, chained, sharded, latency)
+                        {
+                            process_chunk(chained, sharded, speed_test, chunk.begin, chunk.end, binary_trace, latency, &run_metrics);
+                            free(chunk.buffer);
                         }
 
-                        free(buffer);
-
-                        if (!speed_test) {
-                            #pragma omp atomic
-                            run_metrics.total_ops += temp_ops;
-                            #pragma omp atomic
-                            run_metrics.total_lookups += temp_lookups;
-                            #pragma omp atomic
-                            run_metrics.successful_lookups += temp_succ_lookups;
-                            #pragma omp atomic
-                            run_metrics.missed_lookups += temp_missed_lookups;
-                            #pragma omp atomic
-                            run_metrics.total_inserts += temp_inserts;
-                            #pragma omp atomic
-                            run_metrics.failed_match += temp_failed_match;
+                        if (end_of_file) {
+                            break;
                         }
-                    }
 
-                    if (end_of_file) {
-                        break;
-                    }
+                        count++;
 
-                    count++;
+                        if (count >= MAX_TASK_POOL - 1) {
+                            break;
+                        }
 
-                    if (count >= MAX_TASK_POOL - 1) {
-                        break;
-                    }
+                        temp_resize_needed = chained != NULL && needs_resize(chained);
 
-                    #pragma omp atomic read
-                    temp_resize_needed = resize_needed;
+                        if (temp_resize_needed) {
+                            break;
+                        }
+                    }
 
-                    if (temp_resize_needed) {
-                        break;
+                    if (!(count == MAX_TASK_POOL - 1) && !(temp_resize_needed)) {
+                        end_of_file = 1;
                     }
                 }
 
-                if (!(count == MAX_TASK_POOL - 1) && !(temp_resize_needed)) {
-                    end_of_file = 1;
+                #pragma omp taskwait
+
+                #pragma omp barrier
+
+                if (chained != NULL && needs_resize(chained)) {
+                    timed_resize(&chained, latency);
                 }
-            }
 
-            #pragma omp taskwait
+                // Read before the barrier, the next single may set it again
+                int done = end_of_file;
 
-            #pragma omp barrier
+                #pragma omp barrier // VERY MUCH NEEDED
 
-            if (resize_needed) {
-                resize(&chained);
-                resize_needed = 0;
+                if (done) {
+                    break;
+                }
             }
-
-            #pragma omp barrier // VERY MUCH NEEDED
         }
     }
 
     run_metrics.end = omp_get_wtime();
+    uint64_t end_ticks = latency_ticks();
+
+    if (count_events) {
+        perf_stop(&perf);
+    }
 
     printf("execution time: %f seconds\n", run_metrics.end - run_metrics.start);
+
+    if (count_events) {
+        perf_report(&perf, run_metrics.total_ops, !speed_test);
+        perf_destroy(&perf);
+    }
+
+    // Includes the arrays of resizes during the run
+    if (config.huge_pages) {
+        huge_report();
+    }
+
+    if (synthetic) {
+        print_steady_state(&synthetic_run);
+        free(synthetic_run.intervals);
+        free(synthetic_run.progress);
+    }
+
+    if (latency) {
+        FILE* csv = latency_file ? fopen(latency_file, "w") : NULL;
+        if (latency_file && csv == NULL) {
+            printf("could not open %s, printing latencies only\n", latency_file);
+        }
+
+        double ticks_per_ns = (end_ticks - start_ticks) / ((run_metrics.end - run_metrics.start) * 1e9);
+        latency_report(latency, omp_get_max_threads(), ticks_per_ns, csv);
+
+        if (csv) {
+            fclose(csv);
+        }
+        latency_destroy(latency);
+    }
     if (!speed_test) {
         printf("total_ops: %" PRIu64 "\n", run_metrics.total_ops);
         printf("total_lookups: %" PRIu64 "\n", run_metrics.total_lookups);
         printf("successful_lookups: %" PRIu64 "\n", run_metrics.successful_lookups);
         printf("failed_lookups: %" PRIu64 "\n", run_metrics.missed_lookups);
         printf("total_inserts: %" PRIu64 "\n", run_metrics.total_inserts);
+        printf("total_deletes: %" PRIu64 "\n", run_metrics.total_deletes);
+        printf("failed_deletes: %" PRIu64 "\n", run_metrics.missed_deletes);
         printf("failed_matches: %" PRIu64 "\n", run_metrics.failed_match);
+        if (sharded) {
+            print_sharded_stats(sharded);
+        } else {
+            print_table_stats(chained);
+        }
+    }
+
+    if (save_image != NULL) {
+        if (save_table(chained, save_image)) {
+            printf("save_table: %s\n", save_image);
+        } else {
+            printf("could not write %s\n", save_image);
+        }
     }
 
-    destroy_table(chained);
-    fclose(f);
+    if (sharded) {
+        destroy_sharded(sharded);
+    } else {
+        destroy_table(chained);
+    }
+    if (use_mmap) {
+        munmap((void*)trace.data, trace.size);
+    }
+    if (f) {
+        fclose(f);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,257 @@
+/**
+ * @file numa.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief NUMA placement and thread pinning for the tables and the driver
+ * @version 0.1
+ * @date 2026-10-14
+ */
+
+#define _GNU_SOURCE
+#include "numa.h"
+
+#include <omp.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// Local constants, from linux/mempolicy.h
+#define MPOL_PREFERRED 1
+#define MPOL_INTERLEAVE 3
+#define MPOL_MF_MOVE (1 << 1)
+
+// Node of the calling thread, -1 until known
+static _Thread_local int thread_node = -1;
+
+// Topology, read once by load_topology()
+static volatile int topology_loaded = 0;
+static int num_nodes = 1;
+static unsigned long node_mask = 1;         // nodes that exist, one bit each
+static int cpu_nodes[CPU_SETSIZE];          // node of every CPU
+
+/**
+ * @brief mark the CPUs of a sysfs cpulist ("0-3,8-11") as belonging to node
+ *
+ * @param list const char* -> cpulist text
+ * @param node int -> node the CPUs belong to
+ */
+static void parse_cpulist(const char* list, int node) {
+    const char* p = list;
+
+    while (*p != '\0' && *p != '\n') {
+        char* end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+
+        if (end == p) {
+            return;
+        }
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            cpu_nodes[cpu] = node;
+        }
+
+        p = (*end == ',') ? end + 1 : end;
+    }
+}
+
+/**
+ * @brief read the nodes and their CPUs from sysfs
+ */
+static void load_topology(void) {
+    int loaded;
+
+    #pragma omp atomic read
+    loaded = topology_loaded;
+
+    if (loaded) {
+        return;
+    }
+
+    #pragma omp critical(numa_topology)
+    {
+        if (!topology_loaded) {
+            memset(cpu_nodes, 0, sizeof(cpu_nodes));
+            node_mask = 0;
+
+            for (int node = 0; node < NUMA_MAX_NODES; node++) {
+                char path[64];
+                char list[4096];
+                snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+
+                FILE* f = fopen(path, "r");
+                if (f == NULL) {
+                    continue;
+                }
+                if (fgets(list, sizeof(list), f) != NULL) {
+                    parse_cpulist(list, node);
+                }
+                fclose(f);
+
+                node_mask |= 1UL << node;
+                num_nodes = node + 1;
+            }
+
+            if (node_mask == 0) {
+                node_mask = 1;
+                num_nodes = 1;
+            }
+
+            #pragma omp atomic write
+            topology_loaded = 1;
+        }
+    }
+}
+
+/**
+ * @brief number of memory nodes
+ *
+ * @return int -> at least 1
+ */
+int numa_num_nodes(void) {
+    load_topology();
+    return num_nodes;
+}
+
+/**
+ * @brief node of the calling thread
+ *
+ * @return int -> node index
+ */
+int numa_current_node(void) {
+    if (__builtin_expect(thread_node < 0, 0)) {
+        unsigned cpu = 0;
+        unsigned node = 0;
+
+        if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0 || node >= NUMA_MAX_NODES) {
+            node = 0;
+        }
+        thread_node = (int)node;
+    }
+    return thread_node;
+}
+
+/**
+ * @brief apply a memory policy to the whole pages of an allocation
+ *
+ * @param ptr void* -> start of the allocation
+ * @param bytes size_t -> size of the allocation
+ * @param mode int -> MPOL_*
+ * @param mask unsigned long -> nodes for the policy
+ */
+static void set_policy(void* ptr, size_t bytes, int mode, unsigned long mask) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t)ptr + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t)ptr + bytes) & ~(page - 1);
+
+    if (end <= start) {
+        return;
+    }
+
+    // Best effort, a failed mbind leaves first touch placement
+    syscall(SYS_mbind, (void*)start, end - start, mode, &mask, NUMA_MAX_NODES + 1, MPOL_MF_MOVE);
+}
+
+/**
+ * @brief Spread the pages of a fresh allocation over all nodes
+ *
+ * @param ptr void* -> start of the allocation
+ * @param bytes size_t -> size of the allocation
+ */
+void numa_interleave(void* ptr, size_t bytes) {
+    if (numa_num_nodes() < 2) {
+        return;
+    }
+    set_policy(ptr, bytes, MPOL_INTERLEAVE, node_mask);
+}
+
+/**
+ * @brief Put the pages of an allocation on the calling thread's node
+ *
+ * @param ptr void* -> start of the allocation
+ * @param bytes size_t -> size of the allocation
+ */
+void numa_bind_local(void* ptr, size_t bytes) {
+    if (numa_num_nodes() < 2) {
+        return;
+    }
+    // Preferred rather than bind, a full node spills over instead of failing
+    set_policy(ptr, bytes, MPOL_PREFERRED, 1UL << numa_current_node());
+}
+
+/**
+ * @brief Pin every thread of the next parallel region's team
+ *
+ * Close walks the allowed CPUs node by node, spread takes one CPU of
+ * every node in turn. More threads than CPUs wrap around.
+ *
+ * @param policy int -> NUMA_PIN_CLOSE, NUMA_PIN_SPREAD (NUMA_PIN_NONE does nothing)
+ * @param num_threads int -> threads to pin
+ */
+void numa_pin_threads(int policy, int num_threads) {
+    if (policy == NUMA_PIN_NONE) {
+        return;
+    }
+
+    load_topology();
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return;
+    }
+
+    int* order = malloc(CPU_SETSIZE * sizeof(int));
+    int num_cpus = 0;
+
+    if (policy == NUMA_PIN_CLOSE) {
+        for (int node = 0; node < num_nodes; node++) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &allowed) && cpu_nodes[cpu] == node) {
+                    order[num_cpus++] = cpu;
+                }
+            }
+        }
+    } else {
+        // Next unused CPU of every node, one node after the other
+        int next_cpu[NUMA_MAX_NODES] = {0};
+        int added = 1;
+
+        while (added) {
+            added = 0;
+            for (int node = 0; node < num_nodes; node++) {
+                while (next_cpu[node] < CPU_SETSIZE && !(CPU_ISSET(next_cpu[node], &allowed) && cpu_nodes[next_cpu[node]] == node)) {
+                    next_cpu[node]++;
+                }
+                if (next_cpu[node] < CPU_SETSIZE) {
+                    order[num_cpus++] = next_cpu[node]++;
+                    added = 1;
+                }
+            }
+        }
+    }
+
+    if (num_cpus > 0) {
+        #pragma omp parallel num_threads(num_threads)
+        {
+            int cpu = order[omp_get_thread_num() % num_cpus];
+            cpu_set_t set;
+
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+
+            if (sched_setaffinity(0, sizeof(set), &set) == 0) {
+                thread_node = cpu_nodes[cpu];
+            }
+        }
+    }
+
+    free(order);
+}
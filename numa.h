@@ -0,0 +1,90 @@
+/**
+ * @file numa.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief NUMA placement and thread pinning for the tables and the driver
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * create_table() allocates its bucket array from one thread, during a
+ * resize the one in the omp single, so first touch puts the whole table
+ * on that thread's node and every thread on the other socket pays remote
+ * latency on every probe. With TableConfig.numa the back ends interleave
+ * their bucket arrays and stripes page by page over all nodes (mbind
+ * MPOL_INTERLEAVE before the first touch), which works from whichever
+ * thread builds the table. Items are the opposite: a thread mostly touches
+ * what it just inserted, so item_pool.h binds every slab to the node of
+ * the thread that carves it.
+ *
+ * Pinning (-A in the driver) places the threads round robin over the
+ * nodes (spread) or fills one node before the next (close), using the
+ * CPUs the process may run on. A pinned thread knows its node without a
+ * system call.
+ *
+ * Everything goes through plain system calls and sysfs, there is no
+ * libnuma dependency. On a single node machine (or without permission to
+ * call mbind) every call quietly does nothing.
+ */
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <stddef.h>
+
+// Global Constants
+#define NUMA_MAX_NODES 64  // nodes beyond this are treated as node 0
+
+// Thread placement for numa_pin_threads
+#define NUMA_PIN_NONE 0
+#define NUMA_PIN_CLOSE 1
+#define NUMA_PIN_SPREAD 2
+
+/**
+ * @brief number of memory nodes
+ *
+ * Read from sysfs once.
+ *
+ * @return int -> at least 1
+ */
+int numa_num_nodes(void);
+
+/**
+ * @brief node of the calling thread
+ *
+ * Set by numa_pin_threads, otherwise asked from the kernel on the first
+ * call and cached (an unpinned thread may move later).
+ *
+ * @return int -> node index
+ */
+int numa_current_node(void);
+
+/**
+ * @brief Spread the pages of a fresh allocation over all nodes
+ *
+ * Only whole pages inside [ptr, ptr + bytes) are affected, pages already
+ * touched are moved.
+ *
+ * @param ptr void* -> start of the allocation
+ * @param bytes size_t -> size of the allocation
+ */
+void numa_interleave(void* ptr, size_t bytes);
+
+/**
+ * @brief Put the pages of an allocation on the calling thread's node
+ *
+ * @param ptr void* -> start of the allocation
+ * @param bytes size_t -> size of the allocation
+ */
+void numa_bind_local(void* ptr, size_t bytes);
+
+/**
+ * @brief Pin every thread of the next parallel region's team
+ *
+ * Call from outside a parallel region, it opens one of its own with
+ * num_threads threads.
+ *
+ * @param policy int -> NUMA_PIN_CLOSE, NUMA_PIN_SPREAD (NUMA_PIN_NONE does nothing)
+ * @param num_threads int -> threads to pin
+ */
+void numa_pin_threads(int policy, int num_threads);
+
+#endif // NUMA_H
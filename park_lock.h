@@ -0,0 +1,151 @@
+/**
+ * @file park_lock.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Spin-then-park mutex for the stripe locks
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * omp_lock_t is an opaque library call on every acquire and release,
+ * even when nobody else wants the lock, which is the common case for a
+ * stripe. A ParkLock is one int: 0 free, 1 held, 2 held with threads
+ * asleep on it. An uncontended acquire is a single compare and set and
+ * an uncontended release a single exchange, both inlined.
+ *
+ * A thread that finds the lock taken spins for a while first (critical
+ * sections here are a few chain steps, the holder is usually about to
+ * leave), then marks the lock 2 and sleeps in futex() until the holder
+ * wakes it. A release only enters the kernel if it saw a 2. This is the
+ * mutex of Drepper's "Futexes Are Tricky".
+ */
+
+#ifndef PARK_LOCK_H
+#define PARK_LOCK_H
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// Local constants
+#define PARK_SPINS 128  // failed checks of a held lock before the thread goes to sleep
+
+/**
+ * @struct ParkLock
+ * @brief spin-then-park mutex
+ *
+ * @param state volatile int -> 0 free, 1 held, 2 held with sleepers
+ */
+typedef struct {
+    volatile int state; /** @brief 0 free, 1 held, 2 held with sleepers */
+} ParkLock;
+
+/**
+ * @brief tell the core this is a spin loop
+ */
+static inline void park_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * @brief Initialize a free lock
+ *
+ * @param lock ParkLock* -> lock to initialize
+ */
+static inline void park_lock_init(ParkLock* lock) {
+    lock->state = 0;
+}
+
+/**
+ * @brief Take the lock if it is free
+ *
+ * @param lock ParkLock* -> lock to take
+ * @return int -> 1 if the caller now holds the lock
+ */
+static inline int park_trylock(ParkLock* lock) {
+    int old;
+
+    #pragma omp atomic compare capture acquire
+    {
+        old = lock->state;
+        if (lock->state == 0) {
+            lock->state = 1;
+        }
+    }
+
+    return old == 0;
+}
+
+/**
+ * @brief Take a lock that was held a moment ago
+ *
+ * Spins on plain reads, so the line stays shared until the holder lets
+ * go, then sleeps. A thread that went to sleep always takes the lock as
+ * 2: it can not know whether others are still asleep.
+ *
+ * @param lock ParkLock* -> lock to take
+ */
+static inline void park_lock_slow(ParkLock* lock) {
+    int state;
+
+    for (int i = 0; i < PARK_SPINS; i++) {
+        #pragma omp atomic read relaxed
+        state = lock->state;
+
+        if (state == 0 && park_trylock(lock)) {
+            return;
+        }
+        park_cpu_relax();
+    }
+
+    while (1) {
+        int old;
+
+        #pragma omp atomic capture acquire
+        {
+            old = lock->state;
+            lock->state = 2;
+        }
+
+        if (old == 0) {
+            return;
+        }
+
+        // Returns at once if the state is no longer 2
+        syscall(SYS_futex, &lock->state, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+    }
+}
+
+/**
+ * @brief Take the lock
+ *
+ * @param lock ParkLock* -> lock to take
+ */
+static inline void park_lock(ParkLock* lock) {
+    if (!park_trylock(lock)) {
+        park_lock_slow(lock);
+    }
+}
+
+/**
+ * @brief Release the lock, waking one sleeper if there is one
+ *
+ * @param lock ParkLock* -> lock held by the caller
+ */
+static inline void park_unlock(ParkLock* lock) {
+    int old;
+
+    #pragma omp atomic capture release
+    {
+        old = lock->state;
+        lock->state = 0;
+    }
+
+    if (old == 2) {
+        syscall(SYS_futex, &lock->state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+#endif // PARK_LOCK_H
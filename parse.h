@@ -0,0 +1,236 @@
+/**
+ * @file parse.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Trace parsing into BatchItem arrays
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Text lines are "op key value". strtoull walks a field one character at
+ * a time, so on lookup heavy runs parsing cost about as much as the table.
+ * The SIMD path finds the end of a field with one 32 byte compare and
+ * turns up to 16 digits into a number with three multiply-add steps
+ * (digit pairs, groups of four, groups of eight), which SSE2 can do
+ * without any shuffles. 17 to 20 digit fields do the first few digits
+ * scalar and the last 16 in SIMD. A 20 digit field above UINT64_MAX
+ * comes out as UINT64_MAX, as strtoull saturates it, checked on the
+ * first four digits and the last 16 before they are combined.
+ *
+ * The digit conversion loads the 16 bytes ending at the last digit and
+ * masks off what comes before the field. Only the first field or two of
+ * a chunk have less than 16 bytes in front of them, those go through the
+ * scalar loop. Fields closer than 32 bytes to the end of the chunk, or
+ * longer than 20 digits, fall back to strtoull.
+ *
+ * SSE2 compares by default, AVX2 for the scan with -mavx2, -DSCALAR_PARSE
+ * forces strtoull everywhere for comparison. Both give the same value for
+ * every field (the generator never writes more than 2^64 - 2).
+ */
+
+#ifndef PARSE_H
+#define PARSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__AVX2__) || defined(__SSE2__)) && !defined(SCALAR_PARSE)
+#include <immintrin.h>
+#define SIMD_PARSE
+#endif
+
+// Local constants
+#define RECORD_SIZE 17      // binary trace: op byte, little endian key, little endian value
+#define SCAN_BYTES 32       // bytes compared at once to find the end of a field
+#define MAX_SIMD_DIGITS 20  // longer fields go to strtoull
+#define UINT64_MAX_HEAD 1844ULL              // first 4 of the 20 digits of UINT64_MAX
+#define UINT64_MAX_TAIL 6744073709551615ULL  // last 16 of the 20 digits of UINT64_MAX
+
+/**
+ * @struct BatchItem
+ * @brief one parsed trace operation
+ *
+ * @param hash_op char -> 'I', 'L' or 'D'
+ * @param key uint64_t -> key
+ * @param value uint64_t -> value (expected result for 'L' and 'D')
+ */
+typedef struct {
+    char hash_op; /** @brief 'I', 'L' or 'D' */
+    uint64_t key; /** @brief key */
+    uint64_t value; /** @brief value (expected result for 'L' and 'D') */
+} BatchItem;
+
+/**
+ * @brief convert digits one at a time
+ *
+ * @param digits const char* -> first digit
+ * @param len int -> number of digits
+ * @return uint64_t -> value
+ */
+static inline uint64_t digits_scalar(const char* digits, int len) {
+    uint64_t value = 0;
+    for (int i = 0; i < len; i++) {
+        value = value * 10 + (uint64_t)(digits[i] - '0');
+    }
+    return value;
+}
+
+#ifdef SIMD_PARSE
+
+/**
+ * @brief count the digits at the start of a field
+ *
+ * @param digits const char* -> start of the field, SCAN_BYTES readable
+ * @return int -> number of leading digits (SCAN_BYTES if all are digits)
+ */
+static inline int digit_run(const char* digits) {
+    uint32_t non_digit;
+
+#if defined(__AVX2__)
+    __m256i v = _mm256_loadu_si256((const __m256i*)digits);
+    __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('9')), _mm256_cmpgt_epi8(_mm256_set1_epi8('0'), v));
+    non_digit = (uint32_t)_mm256_movemask_epi8(outside);
+#else
+    __m128i low = _mm_loadu_si128((const __m128i*)digits);
+    __m128i high = _mm_loadu_si128((const __m128i*)(digits + 16));
+    __m128i low_outside = _mm_or_si128(_mm_cmpgt_epi8(low, _mm_set1_epi8('9')), _mm_cmplt_epi8(low, _mm_set1_epi8('0')));
+    __m128i high_outside = _mm_or_si128(_mm_cmpgt_epi8(high, _mm_set1_epi8('9')), _mm_cmplt_epi8(high, _mm_set1_epi8('0')));
+    non_digit = (uint32_t)_mm_movemask_epi8(low_outside) | ((uint32_t)_mm_movemask_epi8(high_outside) << 16);
+#endif
+
+    return non_digit ? __builtin_ctz(non_digit) : SCAN_BYTES;
+}
+
+/**
+ * @brief convert up to 16 digits with SSE2 multiply-adds
+ *
+ * @param digits_end const char* -> one past the last digit, 16 bytes before it readable
+ * @param len int -> number of digits (1 to 16)
+ * @return uint64_t -> value
+ */
+static inline uint64_t digits_simd16(const char* digits_end, int len) {
+    // Sliding window over this keeps the last len bytes of a 16 byte load
+    static const uint8_t keep_last[32] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+    };
+
+    __m128i v = _mm_loadu_si128((const __m128i*)(digits_end - 16));
+    __m128i d = _mm_and_si128(_mm_sub_epi8(v, _mm_set1_epi8('0')), _mm_loadu_si128((const __m128i*)(keep_last + len)));
+
+    // Most significant digit first: d[2k] * 10 + d[2k + 1]
+    __m128i pairs = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(d, _mm_set1_epi16(0x00FF)), _mm_set1_epi16(10)), _mm_srli_epi16(d, 8));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set_epi16(1, 100, 1, 100, 1, 100, 1, 100));
+    __m128i octs = _mm_madd_epi16(_mm_packs_epi32(quads, quads), _mm_set_epi16(1, 10000, 1, 10000, 1, 10000, 1, 10000));
+
+    uint64_t high = (uint32_t)_mm_cvtsi128_si32(octs);
+    uint64_t low = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(octs, 4));
+    return high * 100000000ULL + low;
+}
+
+#endif // SIMD_PARSE
+
+/**
+ * @brief parse one decimal field and step past it
+ *
+ * @param cursor const char** -> in: anywhere before the field, out: right after it
+ * @param begin const char* -> start of the chunk (nothing before it may be read)
+ * @param end const char* -> end of the chunk
+ * @return uint64_t -> value
+ */
+static inline uint64_t parse_field(const char** cursor, const char* begin, const char* end) {
+    const char* digits = *cursor;
+
+    while (digits < end && (*digits == ' ' || *digits == '\t')) digits++;
+
+#ifdef SIMD_PARSE
+    if (end - digits >= SCAN_BYTES) {
+        int len = digit_run(digits);
+
+        if (len > 0 && len <= MAX_SIMD_DIGITS) {
+            *cursor = digits + len;
+
+            if ((size_t)(digits - begin) + len < 16) {
+                return digits_scalar(digits, len);
+            }
+            if (len <= 16) {
+                return digits_simd16(digits + len, len);
+            }
+
+            uint64_t head = digits_scalar(digits, len - 16);
+            uint64_t tail = digits_simd16(digits + len, 16);
+
+            // Only 20 digits can pass UINT64_MAX, saturate like strtoull
+            if (len == MAX_SIMD_DIGITS && (head > UINT64_MAX_HEAD || (head == UINT64_MAX_HEAD && tail > UINT64_MAX_TAIL))) {
+                return UINT64_MAX;
+            }
+            return head * 10000000000000000ULL + tail;
+        }
+    }
+#endif
+
+    char* end_ptr;
+    uint64_t value = strtoull(digits, &end_ptr, 10);
+    *cursor = end_ptr;
+    (void)begin;
+    return value;
+}
+
+/**
+ * @brief parse up to max text lines
+ *
+ * @param cursor const char** -> in: next line, out: where the next call continues
+ * @param begin const char* -> start of the chunk
+ * @param end const char* -> end of the chunk (right after a newline or at the end of the trace)
+ * @param batch BatchItem* -> parsed operations
+ * @param max size_t -> capacity of batch
+ * @return size_t -> number of operations parsed (less than max once the chunk is done)
+ */
+static inline size_t parse_text_batch(const char** cursor, const char* begin, const char* end, BatchItem* batch, size_t max) {
+    const char* curr = *cursor;
+    size_t count = 0;
+
+    while (count < max) {
+        while (curr < end && (*curr == ' ' || *curr == '\t' || *curr == '\n')) curr++;
+        if (curr >= end || *curr == '\0') break;
+
+        BatchItem* item = &batch[count++];
+        item->hash_op = *curr++;
+        item->key = parse_field(&curr, begin, end);
+        item->value = parse_field(&curr, begin, end);
+    }
+
+    *cursor = curr;
+    return count;
+}
+
+/**
+ * @brief parse up to max binary records
+ *
+ * @param cursor const char** -> in: next record, out: where the next call continues
+ * @param end const char* -> end of the chunk (a trailing partial record is ignored)
+ * @param batch BatchItem* -> parsed operations
+ * @param max size_t -> capacity of batch
+ * @return size_t -> number of operations parsed (less than max once the chunk is done)
+ */
+static inline size_t parse_binary_batch(const char** cursor, const char* end, BatchItem* batch, size_t max) {
+    const char* curr = *cursor;
+    size_t count = 0;
+
+    while (count < max && end - curr >= RECORD_SIZE) {
+        BatchItem* item = &batch[count++];
+        item->hash_op = curr[0];
+        memcpy(&item->key, curr + 1, sizeof(uint64_t));
+        memcpy(&item->value, curr + 1 + sizeof(uint64_t), sizeof(uint64_t));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        item->key = __builtin_bswap64(item->key);
+        item->value = __builtin_bswap64(item->value);
+#endif
+        curr += RECORD_SIZE;
+    }
+
+    *cursor = curr;
+    return count;
+}
+
+#endif // PARSE_H
@@ -0,0 +1,288 @@
+/**
+ * @file perf.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Hardware performance counters over the driver's measured region
+ * @version 0.1
+ * @date 2026-10-15
+ */
+
+#include "perf.h"
+
+#include <omp.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+static const char* event_names[PERF_EVENTS] = { "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses", "hitm" };
+
+/**
+ * @struct PerfReading
+ * @brief what read() returns for PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+ *
+ * @param value uint64_t -> raw count
+ * @param time_enabled uint64_t -> nanoseconds the event was enabled
+ * @param time_running uint64_t -> nanoseconds it was on a counter
+ */
+typedef struct {
+    uint64_t value; /** @brief raw count */
+    uint64_t time_enabled; /** @brief nanoseconds the event was enabled */
+    uint64_t time_running; /** @brief nanoseconds it was on a counter */
+} PerfReading;
+
+/**
+ * @brief Parse "all" or "name[,name...]" into the events to count
+ *
+ * @param spec const char* -> specification
+ * @param perf PerfCounters* -> enabled and hitm_raw set
+ * @return int -> 0 if spec is not valid
+ */
+int perf_parse(const char* spec, PerfCounters* perf) {
+    int valid = 1;
+
+    memset(perf->enabled, 0, sizeof(perf->enabled));
+    perf->hitm_raw = PERF_HITM_RAW;
+
+    if (strcmp(spec, "all") == 0) {
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            perf->enabled[e] = 1;
+        }
+        return 1;
+    }
+
+    char* copy = strdup(spec);
+    char* save = NULL;
+
+    for (char* token = strtok_r(copy, ",", &save); token != NULL; token = strtok_r(NULL, ",", &save)) {
+        char* value = strchr(token, '=');
+        int found = 0;
+
+        if (value != NULL) {
+            *value++ = '\0';
+        }
+
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            if (strcmp(token, event_names[e]) == 0) {
+                perf->enabled[e] = 1;
+                found = 1;
+            }
+        }
+
+        if (value != NULL) {
+            char* end;
+            perf->hitm_raw = strtoull(value, &end, 0);
+            found = found && strcmp(token, "hitm") == 0 && end != value && *end == '\0';
+        }
+
+        valid = valid && found;
+    }
+
+    free(copy);
+    return valid;
+}
+
+/**
+ * @brief Describe one event to perf_event_open
+ *
+ * @param perf const PerfCounters* -> for the raw hitm code
+ * @param event int -> PERF_* event
+ * @param attr struct perf_event_attr* -> filled in
+ */
+static void event_attr(const PerfCounters* perf, int event, struct perf_event_attr* attr) {
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->disabled = 1;
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (event) {
+        case PERF_CYCLES:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_LLC_MISSES:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PERF_DTLB_MISSES:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PERF_BRANCH_MISSES:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            attr->type = PERF_TYPE_RAW;
+            attr->config = perf->hitm_raw;
+            break;
+    }
+}
+
+/**
+ * @brief Open and start the counters in every thread
+ *
+ * @param perf PerfCounters* -> events parsed by perf_parse
+ * @param num_threads int -> threads of the run
+ */
+void perf_start(PerfCounters* perf, int num_threads) {
+    perf->num_threads = num_threads;
+    perf->threads = aligned_alloc(64, num_threads * sizeof(PerfThread));
+    memset(perf->threads, 0, num_threads * sizeof(PerfThread));
+    memset(perf->open_error, 0, sizeof(perf->open_error));
+    memset(perf->scaled, 0, sizeof(perf->scaled));
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        PerfThread* thread = &perf->threads[omp_get_thread_num()];
+
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            struct perf_event_attr attr;
+
+            thread->fds[e] = -1;
+            if (!perf->enabled[e]) {
+                continue;
+            }
+
+            // pid 0, cpu -1: this thread on whichever CPU it runs
+            event_attr(perf, e, &attr);
+            thread->fds[e] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+            if (thread->fds[e] < 0) {
+                int error = errno;
+
+                #pragma omp critical(perf_open)
+                if (perf->open_error[e] == 0) {
+                    perf->open_error[e] = error;
+                }
+            }
+        }
+
+        // Opened disabled, so every thread's counters start as close together as they can
+        #pragma omp barrier
+
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            if (thread->fds[e] >= 0) {
+                ioctl(thread->fds[e], PERF_EVENT_IOC_RESET, 0);
+                ioctl(thread->fds[e], PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Stop the counters, read and close them
+ *
+ * @param perf PerfCounters* -> counters perf_start opened
+ */
+void perf_stop(PerfCounters* perf) {
+    // Any thread may stop and read another thread's counters, they count their own thread only
+    for (int t = 0; t < perf->num_threads; t++) {
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            if (perf->threads[t].fds[e] >= 0) {
+                ioctl(perf->threads[t].fds[e], PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+    }
+
+    for (int t = 0; t < perf->num_threads; t++) {
+        PerfThread* thread = &perf->threads[t];
+
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            PerfReading reading;
+
+            if (thread->fds[e] < 0) {
+                continue;
+            }
+
+            if (read(thread->fds[e], &reading, sizeof(reading)) == sizeof(reading) && reading.time_running > 0) {
+                if (reading.time_running < reading.time_enabled) {
+                    thread->counts[e] = (uint64_t)((double)reading.value * reading.time_enabled / reading.time_running);
+                    perf->scaled[e]++;
+                } else {
+                    thread->counts[e] = reading.value;
+                }
+            }
+
+            close(thread->fds[e]);
+            thread->fds[e] = -1;
+        }
+    }
+}
+
+/**
+ * @brief Print every event's total and per operation count
+ *
+ * @param perf PerfCounters* -> counters perf_stop read
+ * @param ops uint64_t -> operations of the run
+ * @param per_thread int -> also print every thread's counts
+ */
+void perf_report(PerfCounters* perf, uint64_t ops, int per_thread) {
+    uint64_t totals[PERF_EVENTS] = {0};
+    int counted = 0;
+
+    for (int t = 0; t < perf->num_threads; t++) {
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            totals[e] += perf->threads[t].counts[e];
+        }
+    }
+
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (!perf->enabled[e]) {
+            continue;
+        }
+
+        if (perf->open_error[e] != 0) {
+            printf("perf_%s: unavailable (%s)\n", event_names[e], strerror(perf->open_error[e]));
+            continue;
+        }
+
+        counted++;
+        printf("perf_%s: total %" PRIu64 ", per_op %.4f", event_names[e], totals[e], ops > 0 ? (double)totals[e] / ops : 0.0);
+        if (perf->scaled[e] > 0) {
+            printf(" (multiplexed in %d threads, scaled)", perf->scaled[e]);
+        }
+        printf("\n");
+    }
+
+    int have_ipc = perf->enabled[PERF_CYCLES] && perf->enabled[PERF_INSTRUCTIONS] && perf->open_error[PERF_CYCLES] == 0
+        && perf->open_error[PERF_INSTRUCTIONS] == 0 && totals[PERF_CYCLES] > 0;
+
+    if (have_ipc) {
+        printf("perf_ipc: %.3f\n", (double)totals[PERF_INSTRUCTIONS] / totals[PERF_CYCLES]);
+    }
+
+    if (!per_thread || counted == 0) {
+        return;
+    }
+
+    for (int t = 0; t < perf->num_threads; t++) {
+        printf("perf_thread %d:", t);
+        for (int e = 0; e < PERF_EVENTS; e++) {
+            if (perf->enabled[e] && perf->open_error[e] == 0) {
+                printf(" %s %" PRIu64, event_names[e], perf->threads[t].counts[e]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * @brief Free what perf_start allocated
+ *
+ * @param perf PerfCounters* -> counters to free
+ */
+void perf_destroy(PerfCounters* perf) {
+    free(perf->threads);
+    perf->threads = NULL;
+}
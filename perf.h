@@ -0,0 +1,135 @@
+/**
+ * @file perf.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Hardware performance counters over the driver's measured region
+ * @version 0.1
+ * @date 2026-10-15
+ *
+ * The execution time says which back end won, not why. With -P the
+ * driver opens perf_event_open counters in every worker thread right
+ * before the clock starts and reads them right after it stops, so the
+ * table setup, the bulk load and the report are not counted. The totals
+ * are divided by the operations of the run.
+ *
+ *   cycles         core cycles
+ *   instructions   retired instructions (with cycles, the IPC)
+ *   llc_misses     last level cache misses, the chain walks that went to memory
+ *   dtlb_misses    data TLB load misses, one per random page a probe touched
+ *   branch_misses  mispredicted branches, mostly chain walks of unpredictable length
+ *   hitm           loads that hit a line modified in another core's cache,
+ *                  the cache line transfers of contended stripes, chain heads and counters
+ *
+ * There is no generic event for hitm, it is a raw event code that
+ * depends on the CPU. The default PERF_HITM_RAW is Intel's
+ * MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM (Skylake, XSNP_FWD from Ice Lake on),
+ * give another one with -P hitm=0x... or -DPERF_HITM_RAW. Failed compare
+ * and sets are not a hardware event, stats.h already counts them.
+ *
+ * Every event is opened on its own rather than as a group, so an event
+ * the CPU (or a virtual machine, or perf_event_paranoid) does not allow
+ * is reported as unavailable and the others still count. If the kernel
+ * had to multiplex the counters, the counts are scaled up by the time
+ * each one was enabled over the time it actually ran.
+ */
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+
+// Events, also the order of the report
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_LLC_MISSES 2
+#define PERF_DTLB_MISSES 3
+#define PERF_BRANCH_MISSES 4
+#define PERF_HITM 5
+#define PERF_EVENTS 6
+
+#ifndef PERF_HITM_RAW
+#define PERF_HITM_RAW 0x04d2  // event 0xd2 umask 0x04
+#endif
+
+/**
+ * @struct PerfThread
+ * @brief counters of one thread, alone on its cache line
+ *
+ * @param fds int[] -> one perf_event_open descriptor per event (-1 if not open)
+ * @param counts uint64_t[] -> scaled counts once perf_stop() read them
+ */
+typedef struct {
+    int fds[PERF_EVENTS]; /** @brief one perf_event_open descriptor per event (-1 if not open) */
+    uint64_t counts[PERF_EVENTS]; /** @brief scaled counts once perf_stop() read them */
+} __attribute__((aligned(64))) PerfThread;
+
+/**
+ * @struct PerfCounters
+ * @brief counters of every thread of a run
+ *
+ * @param threads PerfThread* -> one per thread
+ * @param num_threads int -> number of threads
+ * @param enabled int[] -> events asked for
+ * @param hitm_raw uint64_t -> raw event code of hitm
+ * @param open_error int[] -> errno of the first failed open per event (0 if it opened)
+ * @param scaled int[] -> threads whose count was scaled for multiplexing, per event
+ */
+typedef struct {
+    PerfThread* threads; /** @brief one per thread */
+    int num_threads; /** @brief number of threads */
+    int enabled[PERF_EVENTS]; /** @brief events asked for */
+    uint64_t hitm_raw; /** @brief raw event code of hitm */
+    int open_error[PERF_EVENTS]; /** @brief errno of the first failed open per event (0 if it opened) */
+    int scaled[PERF_EVENTS]; /** @brief threads whose count was scaled for multiplexing, per event */
+} PerfCounters;
+
+/**
+ * @brief Parse "all" or "name[,name...]" into the events to count
+ *
+ * Names are cycles, instructions, llc_misses, dtlb_misses, branch_misses
+ * and hitm, hitm=0x... also sets its raw event code.
+ *
+ * @param spec const char* -> specification
+ * @param perf PerfCounters* -> enabled and hitm_raw set
+ * @return int -> 0 if spec is not valid
+ */
+int perf_parse(const char* spec, PerfCounters* perf);
+
+/**
+ * @brief Open and start the counters in every thread
+ *
+ * Call from outside a parallel region, it opens one of its own with
+ * num_threads threads. OpenMP keeps those threads for the regions of the
+ * run, and the counters stay with them.
+ *
+ * @param perf PerfCounters* -> events parsed by perf_parse
+ * @param num_threads int -> threads of the run
+ */
+void perf_start(PerfCounters* perf, int num_threads);
+
+/**
+ * @brief Stop the counters, read and close them
+ *
+ * @param perf PerfCounters* -> counters perf_start opened
+ */
+void perf_stop(PerfCounters* perf);
+
+/**
+ * @brief Print every event's total and per operation count
+ *
+ * One perf_<event> line per event, plus the IPC when both cycles and
+ * instructions counted. With per_thread set, one line per thread too.
+ *
+ * @param perf PerfCounters* -> counters perf_stop read
+ * @param ops uint64_t -> operations of the run
+ * @param per_thread int -> also print every thread's counts
+ */
+void perf_report(PerfCounters* perf, uint64_t ops, int per_thread);
+
+/**
+ * @brief Free what perf_start allocated
+ *
+ * @param perf PerfCounters* -> counters to free
+ */
+void perf_destroy(PerfCounters* perf);
+
+#endif // PERF_H
@@ -0,0 +1,142 @@
+/**
+ * @file policy.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief When a table resizes and to what size
+ * @version 0.1
+ * @date 2026-10-14
+ */
+
+#include "policy.h"
+#include "hash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char* reason_names[] = { "asked", "long_chains", "load", "full", "shrink" };
+
+/**
+ * @brief Parse "name=value,..." into the policy fields of a config
+ *
+ * @param spec const char* -> specification
+ * @param config TableConfig* -> policy fields overwritten
+ * @return int -> 0 if spec is not valid
+ */
+int policy_parse(const char* spec, TableConfig* config) {
+    int valid = 1;
+
+    char* copy = strdup(spec);
+    char* save = NULL;
+
+    for (char* field = strtok_r(copy, ",", &save); field != NULL; field = strtok_r(NULL, ",", &save)) {
+        char* equals = strchr(field, '=');
+        if (equals == NULL) {
+            valid = 0;
+            break;
+        }
+
+        *equals = '\0';
+        const char* name = field;
+        const char* text = equals + 1;
+
+        if (strcmp(name, "max_load") == 0) {
+            config->max_load = atof(text);
+        } else if (strcmp(name, "min_load") == 0) {
+            config->min_load = atof(text);
+        } else if (strcmp(name, "long") == 0) {
+            config->long_chain_ratio = atof(text);
+        } else if (strcmp(name, "grow") == 0) {
+            config->growth_factor = atoi(text);
+        } else if (strcmp(name, "expect") == 0) {
+            config->expected_items = strtoull(text, NULL, 10);
+        } else if (strcmp(name, "report") == 0) {
+            config->report_resizes = atoi(text);
+        } else {
+            valid = 0;
+            break;
+        }
+    }
+
+    free(copy);
+
+    if (config->max_load < 0.0 || config->min_load < 0.0 || config->long_chain_ratio < 0.0 || config->growth_factor < 2) {
+        return 0;
+    }
+
+    // A grow must not land below min_load again (and a shrink above max_load)
+    if (config->min_load > 0.0 && config->max_load > 0.0 && config->min_load * config->growth_factor >= config->max_load) {
+        return 0;
+    }
+
+    return valid;
+}
+
+/**
+ * @brief Make a config's policy fields safe to use
+ *
+ * @param config TableConfig* -> copy made by create_table
+ */
+void policy_config(TableConfig* config) {
+    config->growth_factor = (int)round_up_pow2(config->growth_factor > 2 ? (size_t)config->growth_factor : 2);
+}
+
+/**
+ * @brief Bucket count a new table starts with
+ *
+ * @param config const TableConfig* -> normalized settings
+ * @param num_buckets size_t -> count asked for
+ * @param slots size_t -> slots per bucket
+ * @return size_t -> num_buckets, raised to fit expected_items at max_load (power of two)
+ */
+size_t policy_initial_buckets(const TableConfig* config, size_t num_buckets, size_t slots) {
+    if (config->expected_items > 0) {
+        double load = config->max_load > 0.0 ? config->max_load : 1.0;
+        size_t needed = (size_t)((double)config->expected_items / (load * (double)slots)) + 1;
+
+        if (needed > num_buckets) {
+            num_buckets = needed;
+        }
+    }
+    return round_up_pow2(num_buckets);
+}
+
+/**
+ * @brief Bucket count a stop-the-world resize moves to
+ *
+ * @param config const TableConfig* -> settings of the table
+ * @param reason int -> what needs_resize() returned
+ * @param num_buckets size_t -> current buckets
+ * @return size_t -> half for POLICY_SHRINK, growth_factor times otherwise
+ */
+size_t policy_next_buckets(const TableConfig* config, int reason, size_t num_buckets) {
+    if (reason == POLICY_SHRINK) {
+        return num_buckets > POLICY_MIN_BUCKETS ? num_buckets / 2 : num_buckets;
+    }
+    return num_buckets * config->growth_factor;
+}
+
+/**
+ * @brief Count a finished resize and report it if asked to
+ *
+ * @param config const TableConfig* -> settings of the table
+ * @param stats StatsCounters* -> counters of the resized table
+ * @param reason int -> why it resized
+ * @param old_buckets size_t -> buckets before
+ * @param new_buckets size_t -> buckets after
+ * @param slots size_t -> slots per bucket
+ * @param long_chains uint64_t -> overlong inserts that went into the decision
+ */
+void policy_record(const TableConfig* config, StatsCounters* stats, int reason, size_t old_buckets, size_t new_buckets, size_t slots, uint64_t long_chains) {
+    if (new_buckets < old_buckets) {
+        stats->shrinks++;
+    }
+
+    if (config->report_resizes) {
+        double items = (double)stats_total_items(stats);
+        const char* name = reason > 0 && reason <= POLICY_SHRINK ? reason_names[reason] : reason_names[0];
+
+        printf("resize: %s %zu -> %zu buckets, load %.3f -> %.3f, %" PRIu64 " long chains\n",
+            name, old_buckets, new_buckets, items / (double)(old_buckets * slots), items / (double)(new_buckets * slots), long_chains);
+    }
+}
@@ -0,0 +1,179 @@
+/**
+ * @file policy.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief When a table resizes and to what size
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * One insert that found a chain of MAX_CHAIN_SIZE used to double the
+ * whole table, so a single unlucky bucket (or a weak mixer) could blow
+ * memory up, one full rehash after the other. The policy now weighs
+ * three inputs, all set per table in TableConfig:
+ *
+ *   load        items per slot (a chained bucket is one slot, an open
+ *               addressing or cuckoo bucket has 4) against max_load and
+ *               min_load, summed from the per-thread counters of stats.h
+ *   long chains inserts since the last resize that found an overlong
+ *               chain (a long probe, an overflow chain, the cuckoo stash),
+ *               a resize once they pass long_chain_ratio of the buckets
+ *   size hint   expected_items, create_table starts with room for that
+ *               many at max_load, and never shrinks below it
+ *
+ * Summing the counters costs a read of every thread's line, so a thread
+ * only does it every 1/64 of the table's slots of its own adds or removes,
+ * at most every POLICY_CHECK_STEP. A grow multiplies the buckets by
+ * growth_factor, a shrink halves them and only happens with min_load set.
+ * Long chains do not grow a table that would then sit below min_load, it
+ * would only shrink right back. Incremental resizes always double and never
+ * shrink, their migration splits every old bucket in two.
+ *
+ * Every stop-the-world resize ends in policy_record() (an incremental one
+ * is recorded when it starts), which counts shrinks and with
+ * report_resizes prints the decision: why, the old and new size, the load
+ * and the long chain count, so the ratios can be tuned against the
+ * op_depths histogram.
+ */
+
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "chained.h"
+#include "stats.h"
+
+// Resize reasons, also what needs_resize() returns
+#define POLICY_KEEP 0
+#define POLICY_LONG_CHAINS 1  // enough inserts found an overlong chain
+#define POLICY_LOAD 2         // items per slot passed max_load
+#define POLICY_FULL 3         // a key found no room even in the table being resized into
+#define POLICY_SHRINK 4       // items per slot fell below min_load
+
+// Local constants
+#define POLICY_CHECK_STEP 1024  // a thread sums the item counters at most every this many of its own adds/removes
+#define POLICY_MIN_BUCKETS 64   // smallest table a shrink leaves
+
+/**
+ * @brief Bucket count a new table starts with
+ *
+ * @param config const TableConfig* -> normalized settings
+ * @param num_buckets size_t -> count asked for
+ * @param slots size_t -> slots per bucket
+ * @return size_t -> num_buckets, raised to fit expected_items at max_load (power of two)
+ */
+size_t policy_initial_buckets(const TableConfig* config, size_t num_buckets, size_t slots);
+
+/**
+ * @brief whether the calling thread should look at the load now
+ *
+ * A small table is checked more often, so it cannot run far past
+ * max_load before any thread looks.
+ *
+ * @param stats StatsCounters* -> table counters
+ * @param capacity size_t -> slots of the table (power of two)
+ * @return int -> 1 every capacity / 64 (at most POLICY_CHECK_STEP) of the thread's net adds
+ */
+static inline int policy_check_due(StatsCounters* stats, size_t capacity) {
+    size_t step = capacity / 64 < POLICY_CHECK_STEP ? capacity / 64 : POLICY_CHECK_STEP;
+    return step <= 1 || (stats_thread(stats)->items & (step - 1)) == 0;
+}
+
+/**
+ * @brief Decide after an insert that added a key
+ *
+ * @param config const TableConfig* -> settings of the table
+ * @param stats StatsCounters* -> table counters (the add already counted)
+ * @param num_buckets size_t -> buckets of the table
+ * @param slots size_t -> slots per bucket
+ * @param long_chains volatile uint64_t* -> overlong inserts since the last resize, shared by the table
+ * @param overlong int -> this insert found an overlong chain
+ * @return int -> POLICY_KEEP, POLICY_LONG_CHAINS or POLICY_LOAD
+ */
+static inline int policy_after_add(const TableConfig* config, StatsCounters* stats, size_t num_buckets, size_t slots, volatile uint64_t* long_chains, int overlong) {
+    if (overlong) {
+        uint64_t seen;
+
+        #pragma omp atomic capture
+        seen = ++*long_chains;
+
+        // Not if the grown table would be so empty that it shrinks right back
+        if ((double)seen > config->long_chain_ratio * (double)num_buckets
+            && (config->min_load <= 0.0 || (double)stats_total_items(stats) >= config->min_load * (double)(num_buckets * slots * config->growth_factor))) {
+            return POLICY_LONG_CHAINS;
+        }
+    }
+
+    if (config->max_load > 0.0 && policy_check_due(stats, num_buckets * slots)
+        && (double)stats_total_items(stats) > config->max_load * (double)(num_buckets * slots)) {
+        return POLICY_LOAD;
+    }
+
+    return POLICY_KEEP;
+}
+
+/**
+ * @brief Decide after a remove that took a key out
+ *
+ * @param config const TableConfig* -> settings of the table
+ * @param stats StatsCounters* -> table counters (the remove already counted)
+ * @param num_buckets size_t -> buckets of the table
+ * @param slots size_t -> slots per bucket
+ * @return int -> POLICY_KEEP or POLICY_SHRINK
+ */
+static inline int policy_after_remove(const TableConfig* config, StatsCounters* stats, size_t num_buckets, size_t slots) {
+    if (config->min_load > 0.0 && !config->incremental_resize && num_buckets > POLICY_MIN_BUCKETS
+        && policy_check_due(stats, num_buckets * slots)
+        && (double)stats_total_items(stats) < config->min_load * (double)(num_buckets * slots)
+        && policy_initial_buckets(config, num_buckets / 2, slots) < num_buckets) {
+        return POLICY_SHRINK;
+    }
+
+    return POLICY_KEEP;
+}
+
+/**
+ * @brief Parse "name=value,..." into the policy fields of a config
+ *
+ * Names are max_load, min_load, long (long_chain_ratio), grow
+ * (growth_factor), expect (expected_items) and report (0 or 1).
+ *
+ * @param spec const char* -> specification
+ * @param config TableConfig* -> policy fields overwritten
+ * @return int -> 0 if spec is not valid
+ */
+int policy_parse(const char* spec, TableConfig* config);
+
+/**
+ * @brief Make a config's policy fields safe to use
+ *
+ * growth_factor becomes a power of two of at least 2. Called by every
+ * create_table on its own copy.
+ *
+ * @param config TableConfig* -> copy made by create_table
+ */
+void policy_config(TableConfig* config);
+
+/**
+ * @brief Bucket count a stop-the-world resize moves to
+ *
+ * @param config const TableConfig* -> settings of the table
+ * @param reason int -> what needs_resize() returned
+ * @param num_buckets size_t -> current buckets
+ * @return size_t -> half for POLICY_SHRINK, growth_factor times otherwise
+ */
+size_t policy_next_buckets(const TableConfig* config, int reason, size_t num_buckets);
+
+/**
+ * @brief Count a finished resize and report it if asked to
+ *
+ * Called by the one thread that finishes the resize.
+ *
+ * @param config const TableConfig* -> settings of the table
+ * @param stats StatsCounters* -> counters of the resized table
+ * @param reason int -> why it resized
+ * @param old_buckets size_t -> buckets before
+ * @param new_buckets size_t -> buckets after
+ * @param slots size_t -> slots per bucket
+ * @param long_chains uint64_t -> overlong inserts that went into the decision
+ */
+void policy_record(const TableConfig* config, StatsCounters* stats, int reason, size_t old_buckets, size_t new_buckets, size_t slots, uint64_t long_chains);
+
+#endif // POLICY_H
@@ -0,0 +1,221 @@
+/**
+ * @file protocol.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Wire format and shared memory rings of the table server
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * The driver only measures the table itself. server.c puts a sharded
+ * table behind a pipelined request protocol and client.c drives it, so
+ * the time a request spends in the network stack, the event loop and the
+ * batching is measured too.
+ *
+ * A request is a ServerRequest header and its payload, all of it 64 bit
+ * words in host byte order:
+ *
+ *   SERVER_OP_LOOKUP   count keys
+ *   SERVER_OP_INSERT   count keys, then count values (one insert_batch())
+ *   SERVER_OP_REMOVE   count keys
+ *
+ * with 1 <= count <= SERVER_MAX_KEYS. A client may send any number of
+ * requests before it reads a response. Responses come back in request
+ * order and have no header, the client knows what it asked:
+ *
+ *   SERVER_OP_LOOKUP   count values (INVALID_VALUE for a miss)
+ *   SERVER_OP_INSERT   one word, count
+ *   SERVER_OP_REMOVE   count removed values (INVALID_VALUE for a miss)
+ *
+ * A request the server does not understand closes the connection.
+ *
+ * Co-located clients can skip the sockets: with -M the server creates a
+ * POSIX shared memory object of ShmChannel structs, a single producer
+ * single consumer byte ring per direction. A client claims a free
+ * channel, writes requests into its request ring and reads the values
+ * from its response ring, both sides spin instead of sleeping in the
+ * kernel. A request never wraps around the end of the ring, a client
+ * that would have to fills the rest with a SERVER_OP_PAD header and
+ * writes the request at the start. Values are words, they wrap anywhere.
+ */
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Global Constants
+#define SERVER_PORT 7070          // default TCP port
+#define SERVER_MAX_KEYS 4096      // keys per request
+#define SHM_MAGIC "HTRINGS"       // first 8 bytes of the shared memory object, with the terminating zero
+#define SHM_VERSION 1
+#define SHM_RING_BYTES (1 << 20)  // bytes per ring (power of two)
+
+// Request kinds
+#define SERVER_OP_PAD 0     // shared memory only: skip to the start of the ring
+#define SERVER_OP_LOOKUP 1
+#define SERVER_OP_INSERT 2
+#define SERVER_OP_REMOVE 3
+
+// Channel states, the client moves FREE to OPEN and OPEN to CLOSED, the server CLOSED to FREE
+#define SHM_CHANNEL_FREE 0
+#define SHM_CHANNEL_OPEN 1
+#define SHM_CHANNEL_CLOSED 2
+
+/**
+ * @struct ServerRequest
+ * @brief header of every request
+ *
+ * @param op uint32_t -> SERVER_OP_LOOKUP, SERVER_OP_INSERT or SERVER_OP_REMOVE
+ * @param count uint32_t -> keys in the request
+ */
+typedef struct {
+    uint32_t op; /** @brief SERVER_OP_LOOKUP, SERVER_OP_INSERT or SERVER_OP_REMOVE */
+    uint32_t count; /** @brief keys in the request */
+} ServerRequest;
+
+/**
+ * @struct ShmRing
+ * @brief positions of one byte ring
+ *
+ * Both only grow, a position is taken modulo SHM_RING_BYTES. The producer
+ * writes the bytes first and then written, the consumer reads written
+ * first and then the bytes. Each on its own cache line.
+ *
+ * @param written volatile uint64_t -> bytes the producer has published
+ * @param read volatile uint64_t -> bytes the consumer is done with
+ */
+typedef struct {
+    volatile uint64_t written __attribute__((aligned(64))); /** @brief bytes the producer has published */
+    volatile uint64_t read __attribute__((aligned(64))); /** @brief bytes the consumer is done with */
+} ShmRing;
+
+/**
+ * @struct ShmChannel
+ * @brief one client's pair of rings
+ *
+ * @param state volatile uint32_t -> SHM_CHANNEL_FREE, SHM_CHANNEL_OPEN or SHM_CHANNEL_CLOSED
+ * @param requests ShmRing -> client to server
+ * @param responses ShmRing -> server to client
+ * @param request_data char[] -> bytes of the request ring
+ * @param response_data char[] -> bytes of the response ring
+ */
+typedef struct {
+    volatile uint32_t state __attribute__((aligned(64))); /** @brief SHM_CHANNEL_FREE, SHM_CHANNEL_OPEN or SHM_CHANNEL_CLOSED */
+    ShmRing requests; /** @brief client to server */
+    ShmRing responses; /** @brief server to client */
+    char request_data[SHM_RING_BYTES] __attribute__((aligned(64))); /** @brief bytes of the request ring */
+    char response_data[SHM_RING_BYTES] __attribute__((aligned(64))); /** @brief bytes of the response ring */
+} ShmChannel;
+
+/**
+ * @struct ShmRegion
+ * @brief start of the shared memory object, the channels follow
+ *
+ * @param magic char[8] -> SHM_MAGIC
+ * @param version uint32_t -> SHM_VERSION
+ * @param num_channels uint32_t -> channels in the object
+ * @param channels ShmChannel[] -> one per client
+ */
+typedef struct {
+    char magic[8]; /** @brief SHM_MAGIC */
+    uint32_t version; /** @brief SHM_VERSION */
+    uint32_t num_channels; /** @brief channels in the object */
+    ShmChannel channels[] __attribute__((aligned(64))); /** @brief one per client */
+} ShmRegion;
+
+/**
+ * @brief size of a request with its payload
+ *
+ * @param request const ServerRequest* -> header
+ * @return size_t -> bytes
+ */
+static inline size_t request_bytes(const ServerRequest* request) {
+    size_t words = request->op == SERVER_OP_INSERT ? 2 * (size_t)request->count : request->count;
+    return sizeof(ServerRequest) + words * sizeof(uint64_t);
+}
+
+/**
+ * @brief size of the response to a request
+ *
+ * @param request const ServerRequest* -> header
+ * @return size_t -> bytes
+ */
+static inline size_t response_bytes(const ServerRequest* request) {
+    return (request->op == SERVER_OP_INSERT ? 1 : request->count) * sizeof(uint64_t);
+}
+
+/**
+ * @brief check a request header
+ *
+ * @param request const ServerRequest* -> header
+ * @return int -> 1 if the server serves it
+ */
+static inline int request_valid(const ServerRequest* request) {
+    return request->op >= SERVER_OP_LOOKUP && request->op <= SERVER_OP_REMOVE
+        && request->count >= 1 && request->count <= SERVER_MAX_KEYS;
+}
+
+/**
+ * @brief size of a shared memory object
+ *
+ * @param num_channels size_t -> channels in it
+ * @return size_t -> bytes
+ */
+static inline size_t shm_region_bytes(size_t num_channels) {
+    return sizeof(ShmRegion) + num_channels * sizeof(ShmChannel);
+}
+
+/**
+ * @brief read the producer's position
+ *
+ * @param ring ShmRing* -> specific ring
+ * @return uint64_t -> bytes published, everything before it is visible
+ */
+static inline uint64_t ring_written(ShmRing* ring) {
+    uint64_t written;
+
+    #pragma omp atomic read seq_cst
+    written = ring->written;
+
+    return written;
+}
+
+/**
+ * @brief read the consumer's position
+ *
+ * @param ring ShmRing* -> specific ring
+ * @return uint64_t -> bytes consumed, the producer may overwrite them
+ */
+static inline uint64_t ring_read(ShmRing* ring) {
+    uint64_t read;
+
+    #pragma omp atomic read seq_cst
+    read = ring->read;
+
+    return read;
+}
+
+/**
+ * @brief publish bytes the producer wrote
+ *
+ * @param ring ShmRing* -> specific ring
+ * @param written uint64_t -> new producer position
+ */
+static inline void ring_publish(ShmRing* ring, uint64_t written) {
+    #pragma omp atomic write seq_cst
+    ring->written = written;
+}
+
+/**
+ * @brief hand bytes back to the producer
+ *
+ * @param ring ShmRing* -> specific ring
+ * @param read uint64_t -> new consumer position
+ */
+static inline void ring_release(ShmRing* ring, uint64_t read) {
+    #pragma omp atomic write seq_cst
+    ring->read = read;
+}
+
+#endif // PROTOCOL_H
@@ -1,7 +1,12 @@
+import argparse
 import random
 import math
+import struct
 import numpy as np
 
+# Binary trace record read by main.c -F binary: op byte, little endian key, little endian value
+RECORD_FORMAT = "<cQQ"
+
 class DataConfig:
     name: str
     num_ops: int
@@ -9,6 +14,7 @@ class DataConfig:
     add_ratio: float
     transition_to_updates_ratio: float
     correct_lookup_ratio: float
+    delete_ratio: float
     
     def __init__(
         self, 
@@ -17,7 +23,8 @@ class DataConfig:
         insert_ratio: float, 
         add_ratio: float, 
         transition_to_updates_ratio: float, 
-        correct_lookup_ratio: float):
+        correct_lookup_ratio: float,
+        delete_ratio: float = 0.0):
         
         self.name = name
         self.num_ops = num_ops
@@ -25,12 +32,26 @@ class DataConfig:
         self.add_ratio = add_ratio
         self.transition_to_updates_ratio = transition_to_updates_ratio
         self.correct_lookup_ratio = correct_lookup_ratio
+        self.delete_ratio = delete_ratio
 
 class Item:
     key: np.uint64
     value: np.uint64
+
+def write_op(f, op: str, key, value, binary: bool):
+    if binary:
+        f.write(struct.pack(RECORD_FORMAT, op.encode(), int(key), int(value)))
+    else:
+        f.write(f"{op} {key} {value}\n")
+
+def convert_to_binary(text_file: str, binary_file: str):
+    with open(text_file, 'r') as src, open(binary_file, 'wb') as dst:
+        for line in src:
+            fields = line.split()
+            if len(fields) == 3:
+                write_op(dst, fields[0], fields[1], fields[2], True)
     
-def generate_data(config: DataConfig, output_file: str):
+def generate_data(config: DataConfig, output_file: str, binary: bool = False):
     
     item_history: list[Item] = []
     
@@ -40,9 +61,21 @@ def generate_data(config: DataConfig, output_file: str):
     
     u64_max = 2**64 - 2
     
-    with open(output_file, 'w') as f:
+    with open(output_file, 'wb' if binary else 'w') as f:
         for i in range(config.num_ops):
-            if random.random() < config.insert_ratio:
+            op = random.random()
+            
+            if len(item_history) > 0 and op < config.delete_ratio:
+                # delete (swap with last so removal stays O(1))
+                delete_idx = random.randint(0, len(item_history) - 1)
+                
+                item = item_history[delete_idx]
+                item_history[delete_idx] = item_history[-1]
+                item_history.pop()
+                keys_history.discard(item.key)
+                
+                write_op(f, "D", item.key, item.value, binary)
+            elif op < config.delete_ratio + config.insert_ratio:
                 # insert
                 if len(item_history) > 0 and random.random() < config.add_ratio - (math.pow((i / config.num_ops), 2) * config.transition_to_updates_ratio):
                     update_idx = random.randint(0, len(item_history) - 1)
@@ -50,7 +83,7 @@ def generate_data(config: DataConfig, output_file: str):
                     new_val: np.uint64 = rng.integers(0, 2**64 - 2, dtype=np.uint64) # type: ignore
                     item_history[update_idx].value = new_val
                     
-                    f.write(f"I {item_history[update_idx].key} {new_val}\n")
+                    write_op(f, "I", item_history[update_idx].key, new_val, binary)
                 else:
                     item = Item()
                     
@@ -60,7 +93,7 @@ def generate_data(config: DataConfig, output_file: str):
                     keys_history.add(item.key) # type: ignore
                     item_history.append(item)
                     
-                    f.write(f"I {item.key} {item.value}\n")
+                    write_op(f, "I", item.key, item.value, binary)
             else:
                 if len(item_history) > 0 and random.random() < config.correct_lookup_ratio:
                     lookup_idx = random.randint(0, len(item_history) - 1)
@@ -68,7 +101,7 @@ def generate_data(config: DataConfig, output_file: str):
                     lookup_key = item_history[lookup_idx].key
                     lookup_value = item_history[lookup_idx].value
                     
-                    f.write(f"L {lookup_key} {lookup_value}\n")
+                    write_op(f, "L", lookup_key, lookup_value, binary)
                 else:
                     potential_key: np.uint64
                     
@@ -79,10 +112,19 @@ def generate_data(config: DataConfig, output_file: str):
                             break
                     
                     value = rng.integers(0, u64_max, dtype=np.uint64)
-                    f.write(f"L {potential_key} {value}\n")
+                    write_op(f, "L", potential_key, value, binary)
 
 if __name__ == "__main__":
     
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--binary", action="store_true", help="write .bin traces for main.c -F binary instead of text")
+    parser.add_argument("--convert", nargs=2, metavar=("TEXT_FILE", "BINARY_FILE"), help="convert an existing text trace and exit")
+    args = parser.parse_args()
+    
+    if args.convert:
+        convert_to_binary(args.convert[0], args.convert[1])
+        raise SystemExit(0)
+    
     config_list: list[DataConfig] = [
         DataConfig(
             name="balanced.txt",
@@ -124,6 +166,15 @@ if __name__ == "__main__":
             transition_to_updates_ratio=0.8,
             correct_lookup_ratio=0.9
         ),
+        DataConfig(
+            name="delete_heavy.txt",
+            num_ops=100000,
+            insert_ratio=0.4,
+            add_ratio=0.2,
+            transition_to_updates_ratio=0,
+            correct_lookup_ratio=0.9,
+            delete_ratio=0.3
+        ),
         DataConfig(
             name="large.txt",
             num_ops=1000000,
@@ -135,4 +186,7 @@ if __name__ == "__main__":
     ]
     
     for config in config_list:
-        generate_data(config, "./datasets/"+config.name)
\ No newline at end of file
+        if args.binary:
+            generate_data(config, "./datasets/"+config.name.replace(".txt", ".bin"), binary=True)
+        else:
+            generate_data(config, "./datasets/"+config.name)
\ No newline at end of file
@@ -1,36 +1,104 @@
-gcc -fopenmp main.c chained_locked.c -o chained_locked.exe
-gcc -fopenmp main.c chained_lock_free.c -o chained_lock_free.exe
+gcc -fopenmp main.c sharded.c steal.c stats.c latency.c workload.c numa.c hugepage.c hot.c bulk.c snapshot.c policy.c perf.c chained_locked.c epoch.c item_pool.c -lm -o chained_locked.exe
+gcc -fopenmp main.c sharded.c steal.c stats.c latency.c workload.c numa.c hugepage.c hot.c bulk.c snapshot.c policy.c perf.c chained_lock_free.c epoch.c item_pool.c -lm -o chained_lock_free.exe
+gcc -fopenmp main.c sharded.c steal.c stats.c latency.c workload.c numa.c hugepage.c hot.c bulk.c snapshot.c policy.c perf.c chained_open.c -lm -o chained_open.exe
+gcc -fopenmp main.c sharded.c steal.c stats.c latency.c workload.c numa.c hugepage.c hot.c bulk.c snapshot.c policy.c perf.c cuckoo.c -lm -o cuckoo.exe
+gcc -fopenmp server.c sharded.c stats.c numa.c hugepage.c hot.c bulk.c snapshot.c policy.c chained_locked.c epoch.c item_pool.c -lm -o server_locked.exe
+gcc -fopenmp server.c sharded.c stats.c numa.c hugepage.c hot.c bulk.c snapshot.c policy.c chained_lock_free.c epoch.c item_pool.c -lm -o server_lock_free.exe
+gcc -fopenmp client.c workload.c latency.c stats.c -lm -o client.exe
+
+# Every sweep writes results/<name>.csv and .json, plot them with generate_graphs.py results/<name>.csv
 
 echo "scalability test"
 
-echo "lock-based"
+python3 bench.py --out results/scalability --datasets write_heavy read_heavy --threads 1 2 4 8 12 --buckets 64 --resize off
+
+echo "resize test (stop-the-world vs incremental vs sharded)"
+
+python3 bench.py --out results/resize --datasets write_heavy --threads 1 2 4 8 12 --buckets 64 --resize on --variant= --variant=-i --variant="-S 16"
+
+echo "input test (producer + tasks vs mmap vs work stealing)"
+
+python3 bench.py --out results/input --datasets large --threads 12 --buckets 64 --resize on --variant= --variant=-m --variant=-w --variant="-m -w"
+
+echo "hardware counters (cache, TLB and cache line transfer events per operation next to the time)"
+
+python3 bench.py --out results/counters --backends chained_locked chained_lock_free --datasets write_heavy read_heavy --threads 1 4 12 --buckets 64 --resize off --perf
+
+echo "numa test (first touch on one node vs interleaved tables, node local slabs and spread threads)"
+
+python3 bench.py --out results/numa --datasets write_heavy read_heavy --threads 1 2 4 8 12 --buckets 64 --resize on --numa off on
+
+echo "latency test (stop-the-world vs incremental vs sharded)"
+
+./chained_locked.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -l 1
+./chained_locked.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -l 1 -i
+./chained_locked.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -l 1 -S 16
+./chained_lock_free.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -l 1
+./chained_lock_free.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -l 1 -i
+./chained_lock_free.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -l 1 -S 16
+./chained_open.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -l 1
+./chained_open.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -l 1 -S 16
+./cuckoo.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -l 1
+./cuckoo.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -l 1 -S 16
+
+echo "generated load (10 seconds, Zipfian keys)"
+
+./chained_locked.exe -t 12 -s -b 64 -g typical_with_misses,zipf=0.99,time=10
+./chained_lock_free.exe -t 12 -s -b 64 -g typical_with_misses,zipf=0.99,time=10
+./chained_open.exe -t 12 -s -b 64 -g typical_with_misses,zipf=0.99,time=10
+./cuckoo.exe -t 12 -s -b 64 -g typical_with_misses,zipf=0.99,time=10
+
+echo "hot keys (see hot.h), Zipfian keys with and without the hot key cache, move-to-front and combining"
+
+# chained_open and cuckoo have none of them, their Zipfian numbers are in "generated load" above
+for exe in chained_locked.exe chained_lock_free.exe; do
+    ./$exe -t 12 -s -b 64 -g typical_with_misses,zipf=0.99,time=10
+    ./$exe -t 12 -s -b 64 -K all -g typical_with_misses,zipf=0.99,time=10
+done
+./chained_locked.exe -t 12 -b 64 -K all -g write_heavy,zipf=0.99,time=10
+./chained_lock_free.exe -t 12 -b 64 -K all -g write_heavy,zipf=0.99,time=10
+
+echo "generated load on a bulk loaded table (1M keys)"
+
+./chained_locked.exe -t 12 -s -b 64 -g read_heavy,preload=1048576,time=10
+./chained_lock_free.exe -t 12 -s -b 64 -g read_heavy,preload=1048576,time=10
+./chained_open.exe -t 12 -s -b 64 -g read_heavy,preload=1048576,time=10
+./cuckoo.exe -t 12 -s -b 64 -g read_heavy,preload=1048576,time=10
+
+echo "build time variants (32 bit keys and values, no counters, see spec.h)"
 
-./chained_locked.exe -f datasets/write_heavy.txt -t 1 -s -b 64 -r
-./chained_locked.exe -f datasets/write_heavy.txt -t 2 -s -b 64 -r
-./chained_locked.exe -f datasets/write_heavy.txt -t 4 -s -b 64 -r
-./chained_locked.exe -f datasets/write_heavy.txt -t 8 -s -b 64 -r
-./chained_locked.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -r
+gcc -O2 -fopenmp -DTABLE_KEY_BITS=32 -DTABLE_VALUE_BITS=32 -DTABLE_STATS=0 main.c sharded.c steal.c stats.c latency.c workload.c numa.c hugepage.c hot.c bulk.c snapshot.c policy.c perf.c chained_locked.c epoch.c item_pool.c -lm -o chained_locked_32.exe
+gcc -O2 -fopenmp -DTABLE_KEY_BITS=32 -DTABLE_VALUE_BITS=32 -DTABLE_STATS=0 main.c sharded.c steal.c stats.c latency.c workload.c numa.c hugepage.c hot.c bulk.c snapshot.c policy.c perf.c chained_lock_free.c epoch.c item_pool.c -lm -o chained_lock_free_32.exe
+./chained_locked.exe -t 12 -s -b 64 -g read_heavy,preload=1048576,time=10
+./chained_locked_32.exe -t 12 -s -b 64 -g read_heavy,preload=1048576,time=10
+./chained_lock_free.exe -t 12 -s -b 64 -g read_heavy,preload=1048576,time=10
+./chained_lock_free_32.exe -t 12 -s -b 64 -g read_heavy,preload=1048576,time=10
 
-echo "lock-free"
+echo "resize policy (see policy.h), every decision printed"
 
-./chained_lock_free.exe -f datasets/write_heavy.txt -t 1 -s -b 64 -r
-./chained_lock_free.exe -f datasets/write_heavy.txt -t 2 -s -b 64 -r
-./chained_lock_free.exe -f datasets/write_heavy.txt -t 4 -s -b 64 -r
-./chained_lock_free.exe -f datasets/write_heavy.txt -t 8 -s -b 64 -r
-./chained_lock_free.exe -f datasets/write_heavy.txt -t 12 -s -b 64 -r
+./chained_locked.exe -t 12 -s -b 64 -R report=1 -g write_heavy,time=10
+./chained_locked.exe -t 12 -s -b 64 -R max_load=0.75,grow=4,report=1 -g write_heavy,time=10
+./chained_open.exe -t 12 -s -b 64 -R min_load=0.2,report=1 -g balanced,insert=0,delete=0.9,preload=1048576,time=10
 
-echo "lock-based"
+echo "huge pages (see hugepage.h), with -P dtlb_misses to see the difference"
 
-./chained_locked.exe -f datasets/read_heavy.txt -t 1 -s -b 64 -r
-./chained_locked.exe -f datasets/read_heavy.txt -t 2 -s -b 64 -r
-./chained_locked.exe -f datasets/read_heavy.txt -t 4 -s -b 64 -r
-./chained_locked.exe -f datasets/read_heavy.txt -t 8 -s -b 64 -r
-./chained_locked.exe -f datasets/read_heavy.txt -t 12 -s -b 64 -r
+./chained_locked.exe -t 12 -s -b 64 -P dtlb_misses -g read_heavy,preload=1048576,time=10
+./chained_locked.exe -t 12 -s -b 64 -P dtlb_misses -G -g read_heavy,preload=1048576,time=10
+./chained_lock_free.exe -t 12 -s -b 64 -P dtlb_misses -G -g read_heavy,preload=1048576,time=10
+./chained_open.exe -t 12 -s -b 64 -P dtlb_misses -G -g read_heavy,preload=1048576,time=10
+./cuckoo.exe -t 12 -s -b 64 -P dtlb_misses -G -g read_heavy,preload=1048576,time=10
+./chained_locked.exe -t 12 -s -b 64 -G -i -g write_heavy,time=10
 
-echo "lock-free"
+echo "server (end-to-end request latency over TCP and shared memory, 6 server threads, 6 client threads)"
 
-./chained_lock_free.exe -f datasets/read_heavy.txt -t 1 -s -b 64 -r
-./chained_lock_free.exe -f datasets/read_heavy.txt -t 2 -s -b 64 -r
-./chained_lock_free.exe -f datasets/read_heavy.txt -t 4 -s -b 64 -r
-./chained_lock_free.exe -f datasets/read_heavy.txt -t 8 -s -b 64 -r
-./chained_lock_free.exe -f datasets/read_heavy.txt -t 12 -s -b 64 -r
\ No newline at end of file
+for server in server_locked.exe server_lock_free.exe; do
+    ./$server -t 6 -M /hashtable &
+    server_pid=$!
+    sleep 1
+    ./client.exe -t 6 -g typical_with_misses,zipf=0.99,preload=1048576,time=10
+    ./client.exe -t 6 -d 1 -k 1 -g read_heavy,time=10
+    ./client.exe -t 6 -M /hashtable -g typical_with_misses,zipf=0.99,time=10
+    ./client.exe -t 6 -M /hashtable -d 1 -k 1 -g read_heavy,time=10
+    kill -INT $server_pid
+    wait $server_pid
+done
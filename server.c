@@ -0,0 +1,851 @@
+/**
+ * @file server.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Key-value server over a sharded table
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Every thread runs its own event loop: an epoll instance, its own
+ * SO_REUSEPORT listening socket (the kernel spreads new connections over
+ * the threads) and every -C channel whose index it owns, channel i
+ * belongs to thread i % threads. A connection stays on the thread that
+ * accepted it, so a connection's buffers are never shared.
+ *
+ * The table is always a ShardedTable (sharded.h): a stop-the-world
+ * resize() would need every event loop at a barrier, a shard grows from
+ * the inserting thread instead.
+ *
+ * A request is executed straight from where it arrived: the keys of a
+ * lookup go to sharded_lookup_batch() from the receive buffer (or the
+ * request ring) and the values are written into the send buffer (or the
+ * response ring) that send() reads, no copy in between. All requests a
+ * read() brought in are executed before anything is sent, so a pipelining
+ * client gets one send() for all of them.
+ *
+ * See protocol.h for the wire format.
+ */
+
+#define _GNU_SOURCE
+
+#include "chained.h"
+#include "sharded.h"
+#include "protocol.h"
+#include "numa.h"
+#include "hugepage.h"
+#include "hot.h"
+#include "policy.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+// Local constants
+#define INIT_NUM_BUCKETS 1024
+#define INIT_NUM_LOCKS_RATIO 8
+#define SERVER_SHARDS 64
+#define SERVER_CHANNELS 16
+#define SERVER_BUFFER_BYTES (256 * 1024)  // per direction and connection, holds several of the largest requests
+#define SERVER_MAX_EVENTS 64
+#define SERVER_POLL_MS 100                // how often an idle loop checks for shutdown
+#define SERVER_SHM_POLL_MS 1              // same, while it owns channels that may open
+
+static volatile sig_atomic_t server_stop = 0;
+
+/**
+ * @struct Connection
+ * @brief one TCP client of an event loop
+ *
+ * @param fd int -> socket (non-blocking)
+ * @param in char* -> receive buffer
+ * @param in_start size_t -> first byte not yet executed
+ * @param in_end size_t -> bytes received
+ * @param out char* -> send buffer
+ * @param out_start size_t -> first byte not yet sent
+ * @param out_end size_t -> bytes of responses
+ * @param events uint32_t -> epoll interest currently registered
+ * @param prev struct Connection* -> previous connection of the loop
+ * @param next struct Connection* -> next connection of the loop
+ */
+typedef struct Connection {
+    int fd; /** @brief socket (non-blocking) */
+    char* in; /** @brief receive buffer */
+    size_t in_start; /** @brief first byte not yet executed */
+    size_t in_end; /** @brief bytes received */
+    char* out; /** @brief send buffer */
+    size_t out_start; /** @brief first byte not yet sent */
+    size_t out_end; /** @brief bytes of responses */
+    uint32_t events; /** @brief epoll interest currently registered */
+    struct Connection* prev; /** @brief previous connection of the loop */
+    struct Connection* next; /** @brief next connection of the loop */
+} Connection;
+
+/**
+ * @struct ServerCounts
+ * @brief what one event loop served
+ *
+ * @param requests uint64_t[] -> requests per SERVER_OP_* kind
+ * @param keys uint64_t[] -> keys per SERVER_OP_* kind
+ * @param hits uint64_t -> lookups and removes that found their key
+ * @param connections uint64_t -> connections accepted
+ * @param channels uint64_t -> shared memory channels served
+ */
+typedef struct {
+    uint64_t requests[SERVER_OP_REMOVE + 1]; /** @brief requests per SERVER_OP_* kind */
+    uint64_t keys[SERVER_OP_REMOVE + 1]; /** @brief keys per SERVER_OP_* kind */
+    uint64_t hits; /** @brief lookups and removes that found their key */
+    uint64_t connections; /** @brief connections accepted */
+    uint64_t channels; /** @brief shared memory channels served */
+} __attribute__((aligned(64))) ServerCounts;
+
+/**
+ * @struct Server
+ * @brief what every event loop shares
+ *
+ * @param table ShardedTable* -> the table
+ * @param port int -> TCP port
+ * @param region ShmRegion* -> shared memory channels (NULL without -M)
+ * @param counts ServerCounts* -> one per thread
+ */
+typedef struct {
+    ShardedTable* table; /** @brief the table */
+    int port; /** @brief TCP port */
+    ShmRegion* region; /** @brief shared memory channels (NULL without -M) */
+    ServerCounts* counts; /** @brief one per thread */
+} Server;
+
+/**
+ * @brief Ask every event loop to stop
+ *
+ * @param signal_number int -> unused
+ */
+static void handle_stop(int signal_number) {
+    (void)signal_number;
+    server_stop = 1;
+}
+
+/**
+ * @brief Execute one request
+ *
+ * The keys (and values) are checked before the table sees any of them,
+ * INVALID_KEY and INVALID_VALUE are reserved.
+ *
+ * @param table ShardedTable* -> the table
+ * @param request const ServerRequest* -> header, request_valid()
+ * @param payload const uint64_t* -> keys, for inserts followed by the values
+ * @param out uint64_t* -> response_bytes() of room
+ * @param counts ServerCounts* -> counters of the calling thread
+ * @return int -> 0 if the payload holds a reserved key or value
+ */
+static int execute_request(ShardedTable* table, const ServerRequest* request, const uint64_t* payload, uint64_t* out, ServerCounts* counts) {
+    size_t count = request->count;
+    size_t words = request->op == SERVER_OP_INSERT ? 2 * count : count;
+
+    for (size_t i = 0; i < words; i++) {
+        if (payload[i] == INVALID_KEY) {
+            return 0;
+        }
+    }
+
+    if (request->op == SERVER_OP_LOOKUP) {
+        sharded_lookup_batch(table, payload, out, count);
+    } else if (request->op == SERVER_OP_INSERT) {
+        sharded_insert_batch(table, payload, payload + count, count);
+        out[0] = count;
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = sharded_remove_key(table, payload[i]);
+        }
+    }
+
+    if (request->op != SERVER_OP_INSERT) {
+        for (size_t i = 0; i < count; i++) {
+            counts->hits += out[i] != INVALID_VALUE;
+        }
+    }
+    counts->requests[request->op]++;
+    counts->keys[request->op] += count;
+
+    return 1;
+}
+
+/**
+ * @brief Open this thread's listening socket
+ *
+ * @param port int -> TCP port, shared by every thread through SO_REUSEPORT
+ * @return int -> non-blocking socket, -1 on failure
+ */
+static int open_listener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    int one = 1;
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY) };
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief Close a connection and unlink it from its loop
+ *
+ * @param connection Connection* -> connection to close
+ * @param head Connection** -> first connection of the loop
+ */
+static void close_connection(Connection* connection, Connection** head) {
+    if (connection->prev) {
+        connection->prev->next = connection->next;
+    } else {
+        *head = connection->next;
+    }
+    if (connection->next) {
+        connection->next->prev = connection->prev;
+    }
+
+    close(connection->fd);
+    free(connection->in);
+    free(connection->out);
+    free(connection);
+}
+
+/**
+ * @brief Accept every pending connection of a listener
+ *
+ * @param listener int -> listening socket
+ * @param epoll_fd int -> event loop
+ * @param head Connection** -> first connection of the loop
+ * @param counts ServerCounts* -> counters of the calling thread
+ */
+static void accept_connections(int listener, int epoll_fd, Connection** head, ServerCounts* counts) {
+    while (1) {
+        int fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK);
+        int one = 1;
+
+        if (fd < 0) {
+            return;
+        }
+
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        Connection* connection = calloc(1, sizeof(Connection));
+        connection->fd = fd;
+        connection->in = aligned_alloc(64, SERVER_BUFFER_BYTES);
+        connection->out = aligned_alloc(64, SERVER_BUFFER_BYTES);
+        connection->events = EPOLLIN;
+
+        struct epoll_event event = { .events = connection->events, .data.ptr = connection };
+
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            free(connection->in);
+            free(connection->out);
+            free(connection);
+            continue;
+        }
+
+        connection->next = *head;
+        if (*head) {
+            (*head)->prev = connection;
+        }
+        *head = connection;
+        counts->connections++;
+    }
+}
+
+/**
+ * @brief Execute every complete request in the receive buffer
+ *
+ * Stops at a partial request or once the send buffer has no room for the
+ * next response, the rest waits for the next call.
+ *
+ * @param connection Connection* -> specific connection
+ * @param table ShardedTable* -> the table
+ * @param counts ServerCounts* -> counters of the calling thread
+ * @return int -> 0 if a request was not valid
+ */
+static int execute_buffered(Connection* connection, ShardedTable* table, ServerCounts* counts) {
+    while (connection->in_end - connection->in_start >= sizeof(ServerRequest)) {
+        const ServerRequest* request = (const ServerRequest*)(connection->in + connection->in_start);
+
+        if (!request_valid(request)) {
+            return 0;
+        }
+
+        size_t in_bytes = request_bytes(request);
+        size_t out_bytes = response_bytes(request);
+
+        if (connection->in_end - connection->in_start < in_bytes) {
+            break;
+        }
+
+        if (SERVER_BUFFER_BYTES - connection->out_end < out_bytes) {
+            if (connection->out_start == 0) {
+                break;
+            }
+            memmove(connection->out, connection->out + connection->out_start, connection->out_end - connection->out_start);
+            connection->out_end -= connection->out_start;
+            connection->out_start = 0;
+            continue;
+        }
+
+        // Requests and responses are whole words, so both stay 8 byte aligned
+        if (!execute_request(table, request, (const uint64_t*)(request + 1), (uint64_t*)(connection->out + connection->out_end), counts)) {
+            return 0;
+        }
+
+        connection->in_start += in_bytes;
+        connection->out_end += out_bytes;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Serve one ready connection
+ *
+ * Reads whatever arrived, executes it and sends what it can, until the
+ * socket has nothing more to give or take. A send buffer that does not
+ * drain stops the reading, so a client that never reads can not make
+ * the server queue without bound.
+ *
+ * @param connection Connection* -> specific connection
+ * @param epoll_fd int -> event loop
+ * @param table ShardedTable* -> the table
+ * @param counts ServerCounts* -> counters of the calling thread
+ * @return int -> 0 if the connection should be closed
+ */
+static int serve_connection(Connection* connection, int epoll_fd, ShardedTable* table, ServerCounts* counts) {
+    int progress = 1;
+
+    while (progress) {
+        progress = 0;
+
+        // The partial request at the end moves to the front, a complete one never has to
+        if (connection->in_start > 0) {
+            memmove(connection->in, connection->in + connection->in_start, connection->in_end - connection->in_start);
+            connection->in_end -= connection->in_start;
+            connection->in_start = 0;
+        }
+
+        while (connection->in_end < SERVER_BUFFER_BYTES) {
+            ssize_t received = recv(connection->fd, connection->in + connection->in_end, SERVER_BUFFER_BYTES - connection->in_end, 0);
+
+            if (received > 0) {
+                connection->in_end += received;
+                progress = 1;
+            } else if (received == 0) {
+                return 0;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else {
+                return 0;
+            }
+        }
+
+        size_t executed = connection->in_start;
+
+        if (!execute_buffered(connection, table, counts)) {
+            return 0;
+        }
+
+        progress |= connection->in_start != executed;
+
+        while (connection->out_start < connection->out_end) {
+            ssize_t sent = send(connection->fd, connection->out + connection->out_start, connection->out_end - connection->out_start, MSG_NOSIGNAL);
+
+            if (sent > 0) {
+                connection->out_start += sent;
+                progress = 1;
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                return 0;
+            }
+        }
+
+        if (connection->out_start == connection->out_end) {
+            connection->out_start = 0;
+            connection->out_end = 0;
+        }
+
+        // Stop once the socket is drained and every complete request is answered
+        if (connection->in_end < SERVER_BUFFER_BYTES && connection->out_start == connection->out_end) {
+            break;
+        }
+    }
+
+    // Only ask for more input while the receive buffer has room for it
+    uint32_t events = 0;
+    if (connection->in_end < SERVER_BUFFER_BYTES) {
+        events |= EPOLLIN;
+    }
+    if (connection->out_start < connection->out_end) {
+        events |= EPOLLOUT;
+    }
+
+    if (events != connection->events) {
+        struct epoll_event event = { .events = events, .data.ptr = connection };
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Copy words into a ring, wrapping at its end
+ *
+ * @param data char* -> bytes of the ring
+ * @param position uint64_t -> where to write (any multiple of 8)
+ * @param words const uint64_t* -> words to copy
+ * @param count size_t -> number of words
+ */
+static void ring_copy_in(char* data, uint64_t position, const uint64_t* words, size_t count) {
+    size_t offset = position & (SHM_RING_BYTES - 1);
+    size_t bytes = count * sizeof(uint64_t);
+    size_t first = SHM_RING_BYTES - offset < bytes ? SHM_RING_BYTES - offset : bytes;
+
+    memcpy(data + offset, words, first);
+    memcpy(data, (const char*)words + first, bytes - first);
+}
+
+/**
+ * @brief Serve what one shared memory channel has waiting
+ *
+ * Stops once the response ring has no room for the next response. A
+ * closed channel gets its rings reset and goes back to free, a request
+ * that is not valid closes the channel from this side.
+ *
+ * @param channel ShmChannel* -> channel owned by the calling thread
+ * @param table ShardedTable* -> the table
+ * @param scratch uint64_t* -> SERVER_MAX_KEYS words for responses that wrap
+ * @param counts ServerCounts* -> counters of the calling thread
+ * @return int -> 1 if the channel is open
+ */
+static int serve_channel(ShmChannel* channel, ShardedTable* table, uint64_t* scratch, ServerCounts* counts) {
+    uint32_t state;
+
+    #pragma omp atomic read seq_cst
+    state = channel->state;
+
+    if (state == SHM_CHANNEL_CLOSED) {
+        channel->requests.written = 0;
+        channel->requests.read = 0;
+        channel->responses.written = 0;
+        channel->responses.read = 0;
+
+        #pragma omp atomic write seq_cst
+        channel->state = SHM_CHANNEL_FREE;
+
+        return 0;
+    }
+    if (state != SHM_CHANNEL_OPEN) {
+        return 0;
+    }
+
+    // This thread is the only one moving requests.read and responses.written
+    uint64_t request_position = channel->requests.read;
+    uint64_t requests_written = ring_written(&channel->requests);
+    uint64_t response_position = channel->responses.written;
+    uint64_t served = request_position;
+
+    if (request_position == 0 && requests_written > 0) {
+        counts->channels++;
+    }
+
+    while (request_position < requests_written) {
+        size_t offset = request_position & (SHM_RING_BYTES - 1);
+        const ServerRequest* request = (const ServerRequest*)(channel->request_data + offset);
+
+        if (request->op == SERVER_OP_PAD) {
+            request_position += SHM_RING_BYTES - offset;
+            continue;
+        }
+
+        if (!request_valid(request) || offset + request_bytes(request) > SHM_RING_BYTES) {
+            #pragma omp atomic write seq_cst
+            channel->state = SHM_CHANNEL_CLOSED;
+
+            return 0;
+        }
+
+        size_t out_bytes = response_bytes(request);
+
+        if (response_position + out_bytes - ring_read(&channel->responses) > SHM_RING_BYTES) {
+            break;
+        }
+
+        // Straight into the ring unless the response wraps around its end
+        size_t response_offset = response_position & (SHM_RING_BYTES - 1);
+        int wraps = response_offset + out_bytes > SHM_RING_BYTES;
+        uint64_t* out = wraps ? scratch : (uint64_t*)(channel->response_data + response_offset);
+
+        if (!execute_request(table, request, (const uint64_t*)(request + 1), out, counts)) {
+            #pragma omp atomic write seq_cst
+            channel->state = SHM_CHANNEL_CLOSED;
+
+            return 0;
+        }
+
+        if (wraps) {
+            ring_copy_in(channel->response_data, response_position, scratch, out_bytes / sizeof(uint64_t));
+        }
+
+        request_position += request_bytes(request);
+        response_position += out_bytes;
+        ring_publish(&channel->responses, response_position);
+    }
+
+    if (request_position != served) {
+        ring_release(&channel->requests, request_position);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Run one thread's event loop until server_stop is set
+ *
+ * @param server Server* -> shared state
+ * @param thread int -> thread number
+ * @param num_threads int -> threads running event loops
+ */
+static void serve(Server* server, int thread, int num_threads) {
+    ServerCounts* counts = &server->counts[thread];
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    Connection* connections = NULL;
+    uint64_t* scratch = malloc(SERVER_MAX_KEYS * sizeof(uint64_t));
+    int owns_channels = server->region != NULL && (uint32_t)thread < server->region->num_channels;
+
+    int epoll_fd = epoll_create1(0);
+    int listener = open_listener(server->port);
+
+    if (listener < 0) {
+        printf("thread %d could not listen on port %d, serving shared memory only\n", thread, server->port);
+    } else {
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = NULL };
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listener, &event);
+    }
+
+    while (!server_stop) {
+        int open = 0;
+
+        if (owns_channels) {
+            uint64_t served = counts->requests[SERVER_OP_LOOKUP] + counts->requests[SERVER_OP_INSERT] + counts->requests[SERVER_OP_REMOVE];
+
+            for (uint32_t i = thread; i < server->region->num_channels; i += num_threads) {
+                open |= serve_channel(&server->region->channels[i], server->table, scratch, counts);
+            }
+
+            // Open but idle, give a client that shares the core its turn
+            if (open && served == counts->requests[SERVER_OP_LOOKUP] + counts->requests[SERVER_OP_INSERT] + counts->requests[SERVER_OP_REMOVE]) {
+                sched_yield();
+            }
+        }
+
+        // An open channel is polled, not waited for
+        int timeout = open ? 0 : owns_channels ? SERVER_SHM_POLL_MS : SERVER_POLL_MS;
+        int ready = epoll_wait(epoll_fd, events, SERVER_MAX_EVENTS, timeout);
+
+        for (int i = 0; i < ready; i++) {
+            Connection* connection = events[i].data.ptr;
+
+            if (connection == NULL) {
+                accept_connections(listener, epoll_fd, &connections, counts);
+            } else if ((events[i].events & (EPOLLERR | EPOLLHUP)) && !(events[i].events & EPOLLIN)) {
+                close_connection(connection, &connections);
+            } else if (!serve_connection(connection, epoll_fd, server->table, counts)) {
+                close_connection(connection, &connections);
+            }
+        }
+    }
+
+    while (connections) {
+        close_connection(connections, &connections);
+    }
+    if (listener >= 0) {
+        close(listener);
+    }
+    close(epoll_fd);
+    free(scratch);
+}
+
+/**
+ * @brief Create the shared memory channels
+ *
+ * @param name const char* -> POSIX shared memory name, e.g. /hashtable
+ * @param num_channels int -> channels, one per concurrent client
+ * @return ShmRegion* -> mapped region, NULL on failure
+ */
+static ShmRegion* create_region(const char* name, int num_channels) {
+    size_t bytes = shm_region_bytes(num_channels);
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (ftruncate(fd, bytes) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    ShmRegion* region = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (region == MAP_FAILED) {
+        shm_unlink(name);
+        return NULL;
+    }
+
+    // ftruncate zero fills, so every channel starts out free; magic last, clients check it
+    region->version = SHM_VERSION;
+    region->num_channels = num_channels;
+
+    #pragma omp flush
+    memcpy(region->magic, SHM_MAGIC, sizeof(region->magic));
+
+    return region;
+}
+
+/**
+ * @brief Print what the event loops served
+ *
+ * @param server Server* -> shared state
+ * @param num_threads int -> threads that ran event loops
+ * @param seconds double -> time the server ran
+ */
+static void print_counts(Server* server, int num_threads, double seconds) {
+    static const char* op_names[SERVER_OP_REMOVE + 1] = { "pad", "lookup", "insert", "remove" };
+    ServerCounts total = {0};
+
+    for (int t = 0; t < num_threads; t++) {
+        for (int op = SERVER_OP_LOOKUP; op <= SERVER_OP_REMOVE; op++) {
+            total.requests[op] += server->counts[t].requests[op];
+            total.keys[op] += server->counts[t].keys[op];
+        }
+        total.hits += server->counts[t].hits;
+        total.connections += server->counts[t].connections;
+        total.channels += server->counts[t].channels;
+    }
+
+    uint64_t requests = 0;
+    uint64_t keys = 0;
+
+    for (int op = SERVER_OP_LOOKUP; op <= SERVER_OP_REMOVE; op++) {
+        printf("%s: %" PRIu64 " requests, %" PRIu64 " keys\n", op_names[op], total.requests[op], total.keys[op]);
+        requests += total.requests[op];
+        keys += total.keys[op];
+    }
+
+    printf("served %" PRIu64 " requests (%" PRIu64 " keys, %" PRIu64 " hits) from %" PRIu64 " connections and %" PRIu64 " channels in %f seconds\n",
+           requests, keys, total.hits, total.connections, total.channels, seconds);
+}
+
+int main(int argc, char *argv[]) {
+
+    int initial_buckets = INIT_NUM_BUCKETS;
+    int num_threads = omp_get_num_procs();
+    int num_shards = SERVER_SHARDS;
+    int port = SERVER_PORT;
+    char* shm_name = NULL;
+    int num_channels = SERVER_CHANNELS;
+    int pin_policy = NUMA_PIN_CLOSE;
+    int verbose = 0;
+    TableConfig config = TABLE_CONFIG_DEFAULT;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:b:H:t:S:M:C:A:R:K:NGriov")) != -1) {
+        switch (opt) {
+            case 'p':
+                port = atoi(optarg);
+                if (port < 1 || port > 65535) {
+                    printf("port must be between 1 and 65535, setting to default\n");
+                    port = SERVER_PORT;
+                }
+                break;
+            case 'b':
+                initial_buckets = atoi(optarg);
+                if (initial_buckets == 0) {
+                    printf("start buckets must be > 0, setting to default\n");
+                    initial_buckets = INIT_NUM_BUCKETS;
+                }
+                break;
+            case 'H':
+                if (strcmp(optarg, "murmur") == 0) {
+                    config.hash_function = HASH_MURMUR;
+                } else if (strcmp(optarg, "wy") == 0) {
+                    config.hash_function = HASH_WY;
+                } else if (strcmp(optarg, "legacy") == 0) {
+                    config.hash_function = HASH_LEGACY;
+                } else {
+                    printf("hash must be murmur, wy or legacy, keeping default\n");
+                }
+                break;
+            case 't':
+                num_threads = atoi(optarg);
+                if (num_threads < 1) {
+                    printf("number of threads must be > 1, setting to default\n");
+                    num_threads = omp_get_num_procs();
+                }
+                if (num_threads > MAX_THREADS) {
+                    printf("number of threads must be <= %d, setting to max\n", MAX_THREADS);
+                    num_threads = MAX_THREADS;
+                }
+                break;
+            case 'S':
+                num_shards = atoi(optarg);
+                if (num_shards < 1) {
+                    printf("number of shards must be >= 1, setting to default\n");
+                    num_shards = SERVER_SHARDS;
+                }
+                break;
+            case 'M':
+                shm_name = optarg;
+                break;
+            case 'C':
+                num_channels = atoi(optarg);
+                if (num_channels < 1) {
+                    printf("number of channels must be >= 1, setting to default\n");
+                    num_channels = SERVER_CHANNELS;
+                }
+                break;
+            case 'A':
+                if (strcmp(optarg, "close") == 0) {
+                    pin_policy = NUMA_PIN_CLOSE;
+                } else if (strcmp(optarg, "spread") == 0) {
+                    pin_policy = NUMA_PIN_SPREAD;
+                } else if (strcmp(optarg, "none") == 0) {
+                    pin_policy = NUMA_PIN_NONE;
+                } else {
+                    printf("affinity must be close, spread or none, pinning close\n");
+                    pin_policy = NUMA_PIN_CLOSE;
+                }
+                break;
+            case 'R':
+                if (!policy_parse(optarg, &config)) {
+                    printf("resize policy must be name=value[,name=value...] with max_load, min_load, long, grow >= 2, expect, report, see README\n");
+                    exit(1);
+                }
+                break;
+            case 'K':
+                if (!hot_parse(optarg, &config.hot_keys)) {
+                    printf("hot keys must be all or name[,name...] with cache, front, combine, see README\n");
+                    exit(1);
+                }
+                break;
+            case 'N':
+                config.numa = 1;
+                break;
+            case 'G':
+                config.huge_pages = 1;
+                break;
+            case 'r':
+                config.resize_enabled = 0;
+                break;
+            case 'i':
+                config.incremental_resize = 1;
+                break;
+            case 'o':
+                config.optimistic_reads = 1;
+                break;
+            case 'v':
+                verbose = 1;
+                break;
+            default:
+                printf("format to use: %s [-p port] [-b initial_buckets] [-H murmur|wy|legacy] [-t num_threads] [-S num_shards] [-M shm_name] [-C shm_channels] [-A close|spread|none] [-R resize_policy] [-K hot_keys] [-N numa_placement] [-G huge_pages] [-r disable_resize] [-i incremental_resize] [-o optimistic_reads] [-v table_stats]\n", argv[0]);
+                exit(1);
+        }
+    }
+
+    config.hot_keys = hot_restrict(config.hot_keys, hot_keys_supported());
+
+    omp_set_num_threads(num_threads);
+    numa_pin_threads(pin_policy, num_threads);
+
+    int num_locks = initial_buckets / INIT_NUM_LOCKS_RATIO;
+    if (num_locks < 1) {
+        num_locks = 1;
+    }
+
+    Server server = {
+        .table = create_sharded(num_shards, initial_buckets, num_locks, &config),
+        .port = port,
+        .counts = aligned_alloc(64, num_threads * sizeof(ServerCounts)),
+    };
+    memset(server.counts, 0, num_threads * sizeof(ServerCounts));
+
+    if (shm_name != NULL) {
+        server.region = create_region(shm_name, num_channels);
+        if (server.region == NULL) {
+            printf("could not create shared memory %s, serving TCP only\n", shm_name);
+        }
+    }
+
+    struct sigaction action = { .sa_handler = handle_stop };
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("serving on port %d with %d threads", port, num_threads);
+    if (server.region != NULL) {
+        printf(", %d channels in %s", num_channels, shm_name);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    double start = omp_get_wtime();
+
+    #pragma omp parallel
+    {
+        serve(&server, omp_get_thread_num(), omp_get_num_threads());
+    }
+
+    print_counts(&server, num_threads, omp_get_wtime() - start);
+
+    if (config.huge_pages) {
+        huge_report();
+    }
+
+    if (verbose) {
+        print_sharded_stats(server.table);
+    }
+
+    if (server.region != NULL) {
+        munmap(server.region, shm_region_bytes(num_channels));
+        shm_unlink(shm_name);
+    }
+
+    destroy_sharded(server.table);
+    free(server.counts);
+
+    return 0;
+}
@@ -0,0 +1,423 @@
+/**
+ * @file sharded.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Independent table shards behind one interface
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * The gate is two counters per shard. An operation increments active and
+ * then checks closed, a resizer sets closed and then waits for active to
+ * reach zero. Both sides use seq_cst so at least one of them sees the
+ * other: either the operation backs out, or the resizer waits for it.
+ */
+
+#include "sharded.h"
+#include "hash.h"
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sched.h>
+
+// Local constants
+#define SHARD_GROUP 32   // keys split by shard at once in the batch calls
+
+/**
+ * @struct Shard
+ * @brief one table and its gate, one cache line apart from other shards
+ *
+ * @param table ChainedHashTable* -> the shard, replaced by resize_exclusive
+ * @param active volatile int -> operations currently inside the gate
+ * @param closed volatile int -> set while a thread resizes the shard
+ * @param resizes int -> number of times the shard grew (metric purposes)
+ */
+typedef struct {
+    ChainedHashTable* table; /** @brief the shard, replaced by resize_exclusive */
+    volatile int active; /** @brief operations currently inside the gate */
+    volatile int closed; /** @brief set while a thread resizes the shard */
+    int resizes; /** @brief number of times the shard grew (metric purposes) */
+} __attribute__((aligned(64))) Shard;
+
+/**
+ * @struct ShardedTable
+ * @brief table split into independently resized shards
+ *
+ * @param shards Shard* -> gate and table per shard
+ * @param num_shards size_t -> number of shards (power of two)
+ * @param shard_shift int -> hash bits dropped to get a shard index
+ * @param config TableConfig -> settings every shard was created with
+ */
+struct ShardedTable {
+    Shard* shards; /** @brief gate and table per shard */
+    size_t num_shards; /** @brief number of shards (power of two) */
+    int shard_shift; /** @brief hash bits dropped to get a shard index */
+    TableConfig config; /** @brief settings every shard was created with */
+};
+
+/**
+ * @brief pick the shard of a key from the top bits of its hash
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param key uint64_t -> hash table key
+ * @return size_t -> shard index
+ */
+static inline size_t shard_index(ShardedTable* sharded, uint64_t key) {
+    if (sharded->num_shards == 1) {
+        return 0; // a shift by 64 is undefined
+    }
+    return hash_key(key, sharded->config.hash_function) >> sharded->shard_shift;
+}
+
+/**
+ * @brief Create sharded table
+ *
+ * @param num_shards size_t -> number of shards, rounded up to a power of two
+ * @param num_buckets size_t -> initial number of buckets over all shards
+ * @param num_locks size_t -> initial number of locks over all shards
+ * @param config const TableConfig* -> settings for every shard (NULL for TABLE_CONFIG_DEFAULT)
+ * @return ShardedTable*
+ */
+ShardedTable* create_sharded(size_t num_shards, size_t num_buckets, size_t num_locks, const TableConfig* config) {
+    ShardedTable* sharded = malloc(sizeof(ShardedTable));
+    TableConfig default_config = TABLE_CONFIG_DEFAULT;
+
+    sharded->config = config ? *config : default_config;
+    sharded->num_shards = round_up_pow2(num_shards);
+
+    sharded->shard_shift = 64;
+    for (size_t n = sharded->num_shards; n > 1; n >>= 1) {
+        sharded->shard_shift--;
+    }
+
+    size_t shard_buckets = num_buckets / sharded->num_shards;
+    size_t shard_locks = num_locks / sharded->num_shards;
+
+    sharded->shards = aligned_alloc(64, sharded->num_shards * sizeof(Shard));
+
+    for (size_t i = 0; i < sharded->num_shards; i++) {
+        Shard* shard = &sharded->shards[i];
+        shard->table = create_table(shard_buckets ? shard_buckets : 1, shard_locks ? shard_locks : 1, &sharded->config);
+        shard->active = 0;
+        shard->closed = 0;
+        shard->resizes = 0;
+    }
+
+    return sharded;
+}
+
+/**
+ * @brief Destroy sharded table and every shard
+ *
+ * @param sharded ShardedTable* -> table to destroy
+ */
+void destroy_sharded(ShardedTable* sharded) {
+    for (size_t i = 0; i < sharded->num_shards; i++) {
+        destroy_table(sharded->shards[i].table);
+    }
+
+    free(sharded->shards);
+    free(sharded);
+}
+
+/**
+ * @brief Pass the gate of a shard
+ *
+ * Waits while the shard is being resized.
+ *
+ * @param shard Shard* -> shard to enter
+ * @return ChainedHashTable* -> table that stays valid until shard_exit
+ */
+static ChainedHashTable* shard_enter(Shard* shard) {
+    while (1) {
+        int closed;
+
+        #pragma omp atomic update seq_cst
+        shard->active++;
+
+        #pragma omp atomic read seq_cst
+        closed = shard->closed;
+
+        if (!closed) {
+            ChainedHashTable* table;
+
+            #pragma omp atomic read
+            table = shard->table;
+
+            return table;
+        }
+
+        // Back out so the resizer can drain, then wait for it to reopen
+        #pragma omp atomic update seq_cst
+        shard->active--;
+
+        while (closed) {
+            sched_yield();
+
+            #pragma omp atomic read seq_cst
+            closed = shard->closed;
+        }
+    }
+}
+
+/**
+ * @brief Leave the gate of a shard
+ *
+ * @param shard Shard* -> shard to leave
+ */
+static void shard_exit(Shard* shard) {
+    #pragma omp atomic update seq_cst
+    shard->active--;
+}
+
+/**
+ * @brief Grow one shard while the others keep working
+ *
+ * Called outside the gate by a thread whose insert left the shard asking
+ * for resize(). If another thread is already resizing it, that resize
+ * covers this request too.
+ *
+ * @param shard Shard* -> shard to grow
+ */
+static void resize_shard(Shard* shard) {
+    int was_closed;
+
+    #pragma omp atomic compare capture seq_cst
+    {
+        was_closed = shard->closed;
+        if (shard->closed == 0) {
+            shard->closed = 1;
+        }
+    }
+
+    if (was_closed) {
+        return;
+    }
+
+    int active;
+
+    #pragma omp atomic read seq_cst
+    active = shard->active;
+
+    while (active > 0) {
+        sched_yield();
+
+        #pragma omp atomic read seq_cst
+        active = shard->active;
+    }
+
+    // Someone may have grown it between our insert and closing the gate
+    if (needs_resize(shard->table)) {
+        resize_exclusive(&shard->table);
+        shard->resizes++;
+    }
+
+    #pragma omp atomic write seq_cst
+    shard->closed = 0;
+}
+
+/**
+ * @brief lookup key in sharded table
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> value at key (INVALID_VALUE if key not found)
+ */
+uint64_t sharded_lookup(ShardedTable* sharded, uint64_t key) {
+    Shard* shard = &sharded->shards[shard_index(sharded, key)];
+
+    ChainedHashTable* table = shard_enter(shard);
+    uint64_t value = lookup(table, key);
+    shard_exit(shard);
+
+    return value;
+}
+
+/**
+ * @brief Insert item into sharded table, growing its shard if needed
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @param value uint64_t -> value value (must not be INVALID_VALUE)
+ */
+void sharded_insert(ShardedTable* sharded, uint64_t key, uint64_t value) {
+    Shard* shard = &sharded->shards[shard_index(sharded, key)];
+
+    ChainedHashTable* table = shard_enter(shard);
+    insert(table, key, value);
+    int grow = needs_resize(table);
+    shard_exit(shard);
+
+    if (grow) {
+        resize_shard(shard);
+    }
+}
+
+/**
+ * @brief run one group of a batch call, shard by shard
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param keys const uint64_t* -> keys of the group
+ * @param values const uint64_t* -> values to insert (NULL for lookups)
+ * @param out uint64_t* -> lookup results (NULL for inserts)
+ * @param n size_t -> number of keys (at most SHARD_GROUP)
+ */
+static void run_group(ShardedTable* sharded, const uint64_t* keys, const uint64_t* values, uint64_t* out, size_t n) {
+    size_t shard_idx[SHARD_GROUP];
+    uint64_t shard_keys[SHARD_GROUP];
+    uint64_t shard_values[SHARD_GROUP];
+    size_t positions[SHARD_GROUP];
+    uint64_t done = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        shard_idx[i] = shard_index(sharded, keys[i]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (done & (1ULL << i)) {
+            continue;
+        }
+
+        // Gather every remaining key of this shard, keeping their order
+        size_t count = 0;
+        for (size_t j = i; j < n; j++) {
+            if (shard_idx[j] == shard_idx[i]) {
+                positions[count] = j;
+                shard_keys[count] = keys[j];
+                if (values != NULL) {
+                    shard_values[count] = values[j];
+                }
+                count++;
+                done |= 1ULL << j;
+            }
+        }
+
+        Shard* shard = &sharded->shards[shard_idx[i]];
+        ChainedHashTable* table = shard_enter(shard);
+        int grow = 0;
+
+        if (values != NULL) {
+            insert_batch(table, shard_keys, shard_values, count);
+            grow = needs_resize(table);
+        } else {
+            lookup_batch(table, shard_keys, shard_values, count);
+        }
+
+        shard_exit(shard);
+
+        if (grow) {
+            resize_shard(shard);
+        }
+
+        if (out != NULL) {
+            for (size_t k = 0; k < count; k++) {
+                out[positions[k]] = shard_values[k];
+            }
+        }
+    }
+}
+
+/**
+ * @brief lookup many keys in sharded table
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param keys const uint64_t* -> keys to look up
+ * @param out uint64_t* -> value per key (INVALID_VALUE if key not found)
+ * @param n size_t -> number of keys
+ */
+void sharded_lookup_batch(ShardedTable* sharded, const uint64_t* keys, uint64_t* out, size_t n) {
+    for (size_t start = 0; start < n; start += SHARD_GROUP) {
+        size_t count = (n - start < SHARD_GROUP) ? n - start : SHARD_GROUP;
+        run_group(sharded, keys + start, NULL, out + start, count);
+    }
+}
+
+/**
+ * @brief Insert many items into sharded table
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void sharded_insert_batch(ShardedTable* sharded, const uint64_t* keys, const uint64_t* values, size_t n) {
+    for (size_t start = 0; start < n; start += SHARD_GROUP) {
+        size_t count = (n - start < SHARD_GROUP) ? n - start : SHARD_GROUP;
+        run_group(sharded, keys + start, values + start, NULL, count);
+    }
+}
+
+/**
+ * @brief Fill a sharded table with a known key set at once
+ *
+ * The split by shard is one serial counting pass and one scatter, the
+ * shards then build one after the other with the whole team each.
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void sharded_bulk_load(ShardedTable* sharded, const uint64_t* keys, const uint64_t* values, size_t n) {
+    size_t* starts = calloc(sharded->num_shards + 1, sizeof(size_t));
+    uint64_t* shard_keys = malloc((n ? n : 1) * sizeof(uint64_t));
+    uint64_t* shard_values = malloc((n ? n : 1) * sizeof(uint64_t));
+
+    for (size_t i = 0; i < n; i++) {
+        starts[shard_index(sharded, keys[i]) + 1]++;
+    }
+    for (size_t s = 0; s < sharded->num_shards; s++) {
+        starts[s + 1] += starts[s];
+    }
+
+    // Order within a shard is kept, a repeated key still ends on its last value
+    size_t* next = malloc(sharded->num_shards * sizeof(size_t));
+    memcpy(next, starts, sharded->num_shards * sizeof(size_t));
+
+    for (size_t i = 0; i < n; i++) {
+        size_t slot = next[shard_index(sharded, keys[i])]++;
+        shard_keys[slot] = keys[i];
+        shard_values[slot] = values[i];
+    }
+
+    for (size_t s = 0; s < sharded->num_shards; s++) {
+        bulk_load(&sharded->shards[s].table, shard_keys + starts[s], shard_values + starts[s], starts[s + 1] - starts[s]);
+    }
+
+    free(next);
+    free(shard_values);
+    free(shard_keys);
+    free(starts);
+}
+
+/**
+ * @brief Remove item from sharded table
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> removed value (INVALID_VALUE if key not found)
+ */
+uint64_t sharded_remove_key(ShardedTable* sharded, uint64_t key) {
+    Shard* shard = &sharded->shards[shard_index(sharded, key)];
+
+    ChainedHashTable* table = shard_enter(shard);
+    uint64_t value = remove_key(table, key);
+    shard_exit(shard);
+
+    return value;
+}
+
+/**
+ * @brief Print print_table_stats() of every shard
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ */
+void print_sharded_stats(ShardedTable* sharded) {
+    printf("num_shards: %zu\n", sharded->num_shards);
+
+    for (size_t i = 0; i < sharded->num_shards; i++) {
+        printf("shard %zu: resizes=%d\n", i, sharded->shards[i].resizes);
+        print_table_stats(sharded->shards[i].table);
+    }
+}
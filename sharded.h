@@ -0,0 +1,133 @@
+/**
+ * @file sharded.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Independent table shards behind one interface
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * One long chain used to double the whole table, and the driver had to
+ * drain every task and meet at a barrier to do it. A sharded table is
+ * num_shards ordinary tables from whatever back end it is linked with.
+ * The top bits of the key hash pick the shard and the back end indexes
+ * its buckets with the low bits, so both stay uniform.
+ *
+ * Every shard keeps its own resize_needed and num_items. When an insert
+ * leaves its shard asking for resize(), the inserting thread grows that
+ * shard alone with resize_exclusive() while the other threads keep
+ * working on the other shards. A shard is guarded by a small gate:
+ * operations count themselves in, the resizing thread closes the gate
+ * and waits for the count to drain.
+ */
+
+#ifndef SHARDED_H
+#define SHARDED_H
+
+#include "chained.h"
+
+/**
+ * @struct ShardedTable
+ * @brief table split into independently resized shards
+ *
+ * @param shards Shard* -> gate and table per shard
+ * @param num_shards size_t -> number of shards (power of two)
+ * @param shard_shift int -> hash bits dropped to get a shard index
+ * @param config TableConfig -> settings every shard was created with
+ */
+typedef struct ShardedTable ShardedTable;
+
+/**
+ * @brief Create sharded table
+ *
+ * The counts are totals, every shard gets its share (at least one).
+ *
+ * @param num_shards size_t -> number of shards, rounded up to a power of two
+ * @param num_buckets size_t -> initial number of buckets over all shards
+ * @param num_locks size_t -> initial number of locks over all shards
+ * @param config const TableConfig* -> settings for every shard (NULL for TABLE_CONFIG_DEFAULT)
+ * @return ShardedTable*
+ */
+ShardedTable* create_sharded(size_t num_shards, size_t num_buckets, size_t num_locks, const TableConfig* config);
+
+/**
+ * @brief Destroy sharded table and every shard
+ *
+ * @param sharded ShardedTable* -> table to destroy
+ */
+void destroy_sharded(ShardedTable* sharded);
+
+/**
+ * @brief lookup key in sharded table
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> value at key (INVALID_VALUE if key not found)
+ */
+uint64_t sharded_lookup(ShardedTable* sharded, uint64_t key);
+
+/**
+ * @brief Insert item into sharded table, growing its shard if needed
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @param value uint64_t -> value value (must not be INVALID_VALUE)
+ */
+void sharded_insert(ShardedTable* sharded, uint64_t key, uint64_t value);
+
+/**
+ * @brief lookup many keys in sharded table
+ *
+ * Keys of the same shard go to lookup_batch() together, keys of
+ * different shards are independent so their relative order is free.
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param keys const uint64_t* -> keys to look up
+ * @param out uint64_t* -> value per key (INVALID_VALUE if key not found)
+ * @param n size_t -> number of keys
+ */
+void sharded_lookup_batch(ShardedTable* sharded, const uint64_t* keys, uint64_t* out, size_t n);
+
+/**
+ * @brief Insert many items into sharded table
+ *
+ * Same grouping as sharded_lookup_batch, through insert_batch().
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void sharded_insert_batch(ShardedTable* sharded, const uint64_t* keys, const uint64_t* values, size_t n);
+
+/**
+ * @brief Fill a sharded table with a known key set at once
+ *
+ * Splits the pairs by shard and hands every shard its share through
+ * bulk_load(). Opens its own parallel regions, call it from outside one
+ * while no other thread touches the table.
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param keys const uint64_t* -> keys to insert
+ * @param values const uint64_t* -> value per key
+ * @param n size_t -> number of items
+ */
+void sharded_bulk_load(ShardedTable* sharded, const uint64_t* keys, const uint64_t* values, size_t n);
+
+/**
+ * @brief Remove item from sharded table
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ * @param key uint64_t -> key value (must not be INVALID_KEY)
+ * @return uint64_t -> removed value (INVALID_VALUE if key not found)
+ */
+uint64_t sharded_remove_key(ShardedTable* sharded, uint64_t key);
+
+/**
+ * @brief Print print_table_stats() of every shard
+ *
+ * Not thread safe, call it after the parallel region.
+ *
+ * @param sharded ShardedTable* -> specific sharded table
+ */
+void print_sharded_stats(ShardedTable* sharded);
+
+#endif // SHARDED_H
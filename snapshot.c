@@ -0,0 +1,299 @@
+/**
+ * @file snapshot.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Flat on-disk image of a table for save_table() / load_table()
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * The writer keeps the pairs in arrival order. load_table() checks that
+ * every section lies inside the file and that the settings are ones
+ * create_table() accepts before it trusts the image.
+ */
+
+#include "snapshot.h"
+#include "hot.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @struct SnapshotWriter
+ * @brief pairs collected for one image
+ *
+ * @param header SnapshotHeader -> filled in up front, counts and offsets at the end
+ * @param keys uint64_t* -> keys in arrival order
+ * @param values uint64_t* -> value per key
+ * @param count size_t -> pairs collected
+ * @param capacity size_t -> room in keys and values
+ */
+struct SnapshotWriter {
+    SnapshotHeader header; /** @brief filled in up front, counts and offsets at the end */
+    uint64_t* keys; /** @brief keys in arrival order */
+    uint64_t* values; /** @brief value per key */
+    size_t count; /** @brief pairs collected */
+    size_t capacity; /** @brief room in keys and values */
+};
+
+/**
+ * @brief round a file offset up to the next section boundary
+ *
+ * @param offset uint64_t -> file offset
+ * @return uint64_t -> offset aligned to 64 bytes
+ */
+static inline uint64_t section_align(uint64_t offset) {
+    return (offset + 63) & ~(uint64_t)63;
+}
+
+/**
+ * @brief Start collecting the pairs of a table
+ *
+ * @param config const TableConfig* -> settings of the table being saved
+ * @param num_buckets size_t -> buckets of the table being saved (power of two)
+ * @return SnapshotWriter*
+ */
+SnapshotWriter* snapshot_begin(const TableConfig* config, size_t num_buckets) {
+    SnapshotWriter* writer = calloc(1, sizeof(SnapshotWriter));
+
+    memcpy(writer->header.magic, SNAPSHOT_MAGIC, sizeof(writer->header.magic));
+    writer->header.version = SNAPSHOT_VERSION;
+    writer->header.hash_function = config->hash_function;
+    writer->header.resize_enabled = config->resize_enabled;
+    writer->header.incremental_resize = config->incremental_resize;
+    writer->header.optimistic_reads = config->optimistic_reads;
+    writer->header.numa = config->numa;
+    writer->header.growth_factor = config->growth_factor;
+    writer->header.report_resizes = config->report_resizes;
+    writer->header.huge_pages = config->huge_pages;
+    writer->header.hot_keys = config->hot_keys;
+    writer->header.max_load = config->max_load;
+    writer->header.min_load = config->min_load;
+    writer->header.long_chain_ratio = config->long_chain_ratio;
+    writer->header.expected_items = config->expected_items;
+    writer->header.num_buckets = num_buckets;
+
+    return writer;
+}
+
+/**
+ * @brief Add one live pair
+ *
+ * @param writer SnapshotWriter* -> from snapshot_begin()
+ * @param key uint64_t -> hash table key
+ * @param value uint64_t -> value at key
+ */
+void snapshot_add(SnapshotWriter* writer, uint64_t key, uint64_t value) {
+    if (writer->count == writer->capacity) {
+        writer->capacity = writer->capacity ? 2 * writer->capacity : 1024;
+        writer->keys = realloc(writer->keys, writer->capacity * sizeof(uint64_t));
+        writer->values = realloc(writer->values, writer->capacity * sizeof(uint64_t));
+    }
+    writer->keys[writer->count] = key;
+    writer->values[writer->count] = value;
+    writer->count++;
+}
+
+/**
+ * @brief write one section, zero padded up to its offset
+ *
+ * @param file FILE* -> image being written
+ * @param at uint64_t -> file offset of the section
+ * @param data const void* -> section contents
+ * @param bytes size_t -> section size
+ * @return int -> 1 on success
+ */
+static int write_section(FILE* file, uint64_t at, const void* data, size_t bytes) {
+    static const char zeros[64] = {0};
+    long position = ftell(file);
+
+    if (position < 0 || (uint64_t)position > at) {
+        return 0;
+    }
+    if (fwrite(zeros, 1, at - position, file) != at - position) {
+        return 0;
+    }
+    return fwrite(data, 1, bytes, file) == bytes;
+}
+
+/**
+ * @brief Write the image and free the writer
+ *
+ * @param writer SnapshotWriter* -> from snapshot_begin()
+ * @param path const char* -> image file
+ * @return int -> 1 on success, 0 if the file could not be written
+ */
+int snapshot_finish(SnapshotWriter* writer, const char* path) {
+    SnapshotHeader* header = &writer->header;
+    size_t n = writer->count;
+
+    header->num_items = n;
+    header->keys_at = section_align(sizeof(SnapshotHeader));
+    header->values_at = section_align(header->keys_at + n * sizeof(uint64_t));
+
+    size_t tmp_len = strlen(path) + 5;
+    char* tmp_path = malloc(tmp_len);
+    snprintf(tmp_path, tmp_len, "%s.tmp", path);
+
+    FILE* file = fopen(tmp_path, "wb");
+    int written = file != NULL
+        && write_section(file, 0, header, sizeof(SnapshotHeader))
+        && write_section(file, header->keys_at, writer->keys, n * sizeof(uint64_t))
+        && write_section(file, header->values_at, writer->values, n * sizeof(uint64_t));
+
+    if (file != NULL && fclose(file) != 0) {
+        written = 0;
+    }
+    if (written && rename(tmp_path, path) != 0) {
+        written = 0;
+    }
+    if (!written) {
+        remove(tmp_path);
+    }
+
+    free(tmp_path);
+    free(writer->values);
+    free(writer->keys);
+    free(writer);
+
+    return written;
+}
+
+/**
+ * @brief check the settings of an image before they reach create_table()
+ *
+ * The same bounds policy_parse() and hot_parse() hold the command line
+ * to, an image that is damaged or from another build may hold anything.
+ *
+ * @param header const SnapshotHeader* -> header of a mapped image
+ * @return int -> 1 if the settings are usable
+ */
+static int check_settings(const SnapshotHeader* header) {
+    if (header->hash_function != HASH_MURMUR && header->hash_function != HASH_WY && header->hash_function != HASH_LEGACY) {
+        return 0;
+    }
+    if (header->growth_factor < 2 || (header->growth_factor & (header->growth_factor - 1)) != 0) {
+        return 0;
+    }
+
+    if (!isfinite(header->max_load) || header->max_load < 0.0
+        || !isfinite(header->min_load) || header->min_load < 0.0
+        || !isfinite(header->long_chain_ratio) || header->long_chain_ratio < 0.0) {
+        return 0;
+    }
+
+    // A grow must not land below min_load again (and a shrink above max_load)
+    if (header->min_load > 0.0 && header->max_load > 0.0 && header->min_load * header->growth_factor >= header->max_load) {
+        return 0;
+    }
+
+    if (header->resize_enabled > 1 || header->incremental_resize > 1 || header->optimistic_reads > 1
+        || header->numa > 1 || header->huge_pages > 1 || (header->hot_keys & ~(uint32_t)HOT_ALL) != 0) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief check that a mapped image is one and that its sections fit
+ *
+ * @param image const char* -> mapped file
+ * @param size size_t -> file size
+ * @return const SnapshotHeader* -> the header, NULL if the image is not valid
+ */
+static const SnapshotHeader* check_image(const char* image, size_t size) {
+    if (size < sizeof(SnapshotHeader)) {
+        return NULL;
+    }
+
+    const SnapshotHeader* header = (const SnapshotHeader*)image;
+
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION) {
+        return NULL;
+    }
+    if (!check_settings(header)) {
+        return NULL;
+    }
+
+    uint64_t num_buckets = header->num_buckets;
+    uint64_t n = header->num_items;
+
+    // Sizes first, so none of the products below can wrap
+    if (num_buckets == 0 || (num_buckets & (num_buckets - 1)) != 0 || num_buckets > SNAPSHOT_MAX_BUCKETS || n >= size) {
+        return NULL;
+    }
+    if (header->keys_at % 64 != 0 || header->values_at % 64 != 0) {
+        return NULL;
+    }
+    if (header->keys_at > size || n * sizeof(uint64_t) > size - header->keys_at
+        || header->values_at > size || n * sizeof(uint64_t) > size - header->values_at) {
+        return NULL;
+    }
+
+    return header;
+}
+
+/**
+ * @brief Build a table from an image written by save_table()
+ *
+ * @param path const char* -> image file
+ * @return ChainedHashTable* -> NULL if the file is missing or not an image
+ */
+ChainedHashTable* load_table(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    char* image = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (image == MAP_FAILED) {
+        return NULL;
+    }
+
+    // bulk_load reads the pairs front to back
+    madvise(image, size, MADV_SEQUENTIAL);
+
+    const SnapshotHeader* header = check_image(image, size);
+    if (header == NULL) {
+        munmap(image, size);
+        return NULL;
+    }
+
+    TableConfig config = TABLE_CONFIG_DEFAULT;
+    config.hash_function = header->hash_function;
+    config.resize_enabled = header->resize_enabled;
+    config.incremental_resize = header->incremental_resize;
+    config.optimistic_reads = header->optimistic_reads;
+    config.numa = header->numa;
+    config.growth_factor = header->growth_factor;
+    config.report_resizes = header->report_resizes;
+    config.huge_pages = header->huge_pages;
+    config.hot_keys = header->hot_keys;
+    config.max_load = header->max_load;
+    config.min_load = header->min_load;
+    config.long_chain_ratio = header->long_chain_ratio;
+    config.expected_items = header->expected_items;
+
+    size_t num_locks = header->num_buckets / SNAPSHOT_LOCK_RATIO;
+    ChainedHashTable* chained = create_table(header->num_buckets, num_locks ? num_locks : 1, &config);
+
+    bulk_load(&chained, (const uint64_t*)(image + header->keys_at), (const uint64_t*)(image + header->values_at), header->num_items);
+
+    munmap(image, size);
+    return chained;
+}
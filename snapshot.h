@@ -0,0 +1,122 @@
+/**
+ * @file snapshot.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Flat on-disk image of a table for save_table() / load_table()
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Rebuilding a table after a restart used to mean replaying its traces.
+ * An image holds the live pairs of a table in three sections:
+ *
+ *   header    SnapshotHeader: magic, version, the TableConfig, bucket and item counts, section offsets
+ *   keys      uint64_t[num_items]
+ *   values    uint64_t[num_items]
+ *
+ * Every section starts on a 64 byte boundary and holds indexes, never
+ * pointers, so the file works wherever it is mapped. Integers are in
+ * host byte order, an image is for the machine (or one like it) that
+ * wrote it.
+ *
+ * load_table() maps the image and hands the key and value sections to
+ * bulk_load() as they are, nothing is parsed or copied on the way.
+ * bulk_load() partitions the pairs for the table it builds, so the image
+ * keeps no bucket layout and any back end loads any back end's image.
+ *
+ * Every back end walks its own buckets for save_table() and feeds the
+ * pairs to a SnapshotWriter, which does the writing.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "chained.h"
+
+// Global Constants
+#define SNAPSHOT_MAGIC "HTIMAGE"  // first 8 bytes of an image, with the terminating zero
+#define SNAPSHOT_VERSION 3
+#define SNAPSHOT_LOCK_RATIO 8     // buckets per stripe of a loaded table, the driver's default
+#define SNAPSHOT_MAX_BUCKETS (1ULL << 40) // larger bucket counts are taken for damage
+
+/**
+ * @struct SnapshotHeader
+ * @brief first bytes of an image
+ *
+ * @param magic char[8] -> SNAPSHOT_MAGIC
+ * @param version uint32_t -> SNAPSHOT_VERSION
+ * @param hash_function uint32_t -> TableConfig.hash_function
+ * @param resize_enabled uint32_t -> TableConfig.resize_enabled
+ * @param incremental_resize uint32_t -> TableConfig.incremental_resize
+ * @param optimistic_reads uint32_t -> TableConfig.optimistic_reads
+ * @param numa uint32_t -> TableConfig.numa
+ * @param growth_factor uint32_t -> TableConfig.growth_factor
+ * @param report_resizes uint32_t -> TableConfig.report_resizes
+ * @param huge_pages uint32_t -> TableConfig.huge_pages
+ * @param hot_keys uint32_t -> TableConfig.hot_keys
+ * @param max_load double -> TableConfig.max_load
+ * @param min_load double -> TableConfig.min_load
+ * @param long_chain_ratio double -> TableConfig.long_chain_ratio
+ * @param expected_items uint64_t -> TableConfig.expected_items
+ * @param num_buckets uint64_t -> buckets of the saved table
+ * @param num_items uint64_t -> pairs in the image
+ * @param keys_at uint64_t -> file offset of the keys
+ * @param values_at uint64_t -> file offset of the values
+ */
+typedef struct {
+    char magic[8]; /** @brief SNAPSHOT_MAGIC */
+    uint32_t version; /** @brief SNAPSHOT_VERSION */
+    uint32_t hash_function; /** @brief TableConfig.hash_function */
+    uint32_t resize_enabled; /** @brief TableConfig.resize_enabled */
+    uint32_t incremental_resize; /** @brief TableConfig.incremental_resize */
+    uint32_t optimistic_reads; /** @brief TableConfig.optimistic_reads */
+    uint32_t numa; /** @brief TableConfig.numa */
+    uint32_t growth_factor; /** @brief TableConfig.growth_factor */
+    uint32_t report_resizes; /** @brief TableConfig.report_resizes */
+    uint32_t huge_pages; /** @brief TableConfig.huge_pages */
+    uint32_t hot_keys; /** @brief TableConfig.hot_keys */
+    double max_load; /** @brief TableConfig.max_load */
+    double min_load; /** @brief TableConfig.min_load */
+    double long_chain_ratio; /** @brief TableConfig.long_chain_ratio */
+    uint64_t expected_items; /** @brief TableConfig.expected_items */
+    uint64_t num_buckets; /** @brief buckets of the saved table */
+    uint64_t num_items; /** @brief pairs in the image */
+    uint64_t keys_at; /** @brief file offset of the keys */
+    uint64_t values_at; /** @brief file offset of the values */
+} SnapshotHeader;
+
+/**
+ * @struct SnapshotWriter
+ * @brief pairs collected for one image
+ */
+typedef struct SnapshotWriter SnapshotWriter;
+
+/**
+ * @brief Start collecting the pairs of a table
+ *
+ * @param config const TableConfig* -> settings of the table being saved
+ * @param num_buckets size_t -> buckets of the table being saved (power of two)
+ * @return SnapshotWriter*
+ */
+SnapshotWriter* snapshot_begin(const TableConfig* config, size_t num_buckets);
+
+/**
+ * @brief Add one live pair
+ *
+ * @param writer SnapshotWriter* -> from snapshot_begin()
+ * @param key uint64_t -> hash table key
+ * @param value uint64_t -> value at key
+ */
+void snapshot_add(SnapshotWriter* writer, uint64_t key, uint64_t value);
+
+/**
+ * @brief Write the image and free the writer
+ *
+ * Writes path.tmp and renames it over path, so a crash never leaves a
+ * half written image behind under the real name.
+ *
+ * @param writer SnapshotWriter* -> from snapshot_begin()
+ * @param path const char* -> image file
+ * @return int -> 1 on success, 0 if the file could not be written
+ */
+int snapshot_finish(SnapshotWriter* writer, const char* path);
+
+#endif // SNAPSHOT_H
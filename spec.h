@@ -0,0 +1,127 @@
+/**
+ * @file spec.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Build time specialization of the back ends
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * A chain node used to be a 64 bit key, a 64 bit value and a next
+ * pointer, 24 bytes whatever the keys looked like, and every insert
+ * checked resize_enabled and fed the counters whether anyone read them
+ * or not. These switches pick the layout and the policy when the back
+ * end is compiled instead, so a switched off feature is dead code the
+ * compiler drops rather than a branch on every operation:
+ *
+ *   -DTABLE_KEY_BITS=32     keys stored as uint32_t (default 64)
+ *   -DTABLE_VALUE_BITS=32   values stored as uint32_t, 0 for a key only set (default 64)
+ *   -DTABLE_STATS=0         no op_depths or cas_retries counting (num_items is always kept)
+ *   -DTABLE_RESIZE=0 or 1   never or always resize, whatever TableConfig says (default -1, up to the table)
+ *   -DMAX_CHAIN_SIZE=n      chain length that asks for a resize in the chained back ends (default 8)
+ *
+ * The API stays 64 bit. A narrow table drops inserts of keys or values
+ * that do not fit (as insert() drops INVALID_KEY), lookups of such keys
+ * miss. In a set every present key has the value SET_VALUE. A 32 bit
+ * key and value (or key only) node is 16 bytes.
+ *
+ * Narrow keys and values are for chained_locked.c and chained_lock_free.c,
+ * whose nodes hold nothing else. chained_open.c and cuckoo.c lay out their
+ * buckets as one cache line of 64 bit slots with INVALID_KEY for a free
+ * slot and refuse to build with them. The driver's generated load (-g)
+ * makes keys and values that fit, traces are 64 bit.
+ */
+
+#ifndef SPEC_H
+#define SPEC_H
+
+#include "chained.h"
+
+#include <stdint.h>
+
+#ifndef TABLE_KEY_BITS
+#define TABLE_KEY_BITS 64
+#endif
+
+#ifndef TABLE_VALUE_BITS
+#define TABLE_VALUE_BITS 64
+#endif
+
+#ifndef TABLE_STATS
+#define TABLE_STATS 1
+#endif
+
+#ifndef TABLE_RESIZE
+#define TABLE_RESIZE -1
+#endif
+
+// Value of every key in a key only set
+#define SET_VALUE 0
+
+#if TABLE_KEY_BITS == 64
+typedef uint64_t spec_key_t;
+#elif TABLE_KEY_BITS == 32
+typedef uint32_t spec_key_t;
+#else
+#error "TABLE_KEY_BITS must be 32 or 64"
+#endif
+
+#if TABLE_VALUE_BITS == 64
+typedef uint64_t spec_value_t;
+#elif TABLE_VALUE_BITS == 32
+typedef uint32_t spec_value_t;
+#elif TABLE_VALUE_BITS != 0
+#error "TABLE_VALUE_BITS must be 0, 32 or 64"
+#endif
+
+// Read and write the value field of a node, which a set does not have
+#if TABLE_VALUE_BITS
+#define ITEM_VALUE(item) ((uint64_t)(item)->value)
+#define SET_ITEM_VALUE(item, v) ((item)->value = (spec_value_t)(v))
+#else
+#define ITEM_VALUE(item) ((void)(item), (uint64_t)SET_VALUE)
+#define SET_ITEM_VALUE(item, v) ((void)(item), (void)(v))
+#endif
+
+/**
+ * @brief check whether a pair can go into the table
+ *
+ * INVALID_KEY and INVALID_VALUE never can, narrow tables also refuse
+ * what does not fit. Constant folds to the two INVALID checks in a
+ * 64 bit build.
+ *
+ * @param key uint64_t -> hash table key
+ * @param value uint64_t -> value at key
+ * @return int -> 1 if insert() stores the pair
+ */
+static inline int spec_storable(uint64_t key, uint64_t value) {
+    return key != INVALID_KEY && value != INVALID_VALUE
+        && (TABLE_KEY_BITS == 64 || key <= UINT32_MAX)
+        && (TABLE_VALUE_BITS != 32 || value <= UINT32_MAX);
+}
+
+/**
+ * @brief whether a table grows
+ *
+ * @param config const TableConfig* -> settings of the table
+ * @return int -> TABLE_RESIZE if it is fixed at build time, resize_enabled otherwise
+ */
+static inline int spec_resize_enabled(const TableConfig* config) {
+#if TABLE_RESIZE < 0
+    return config->resize_enabled;
+#else
+    (void)config;
+    return TABLE_RESIZE;
+#endif
+}
+
+/**
+ * @brief Apply the build time settings to a table's copy of its config
+ *
+ * So a saved image records what the table really does.
+ *
+ * @param config TableConfig* -> copy made by create_table
+ */
+static inline void spec_config(TableConfig* config) {
+    config->resize_enabled = spec_resize_enabled(config);
+}
+
+#endif // SPEC_H
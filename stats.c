@@ -0,0 +1,169 @@
+/**
+ * @file stats.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Per-thread table counters, merged on read
+ * @version 0.1
+ * @date 2026-10-14
+ */
+
+#include "stats.h"
+#include "hash.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+_Thread_local int stats_slot = 0;
+
+volatile uint64_t stats_resizes_started = 0;
+volatile uint64_t stats_resizes_finished = 0;
+
+// Next slot to hand out
+static volatile int next_slot = 0;
+
+/**
+ * @brief Hand the calling thread its counter slot
+ *
+ * Slots wrap around after MAX_THREADS threads, two threads sharing one
+ * would only lose a few counts.
+ *
+ * @return int -> slot plus one
+ */
+int stats_claim_slot(void) {
+    int slot;
+
+    #pragma omp atomic capture
+    slot = next_slot++;
+
+    return (slot & (MAX_THREADS - 1)) + 1;
+}
+
+/**
+ * @brief Sum the item counts of every thread that has counted so far
+ *
+ * @param stats StatsCounters* -> table counters
+ * @return int64_t -> number of items in the table
+ */
+int64_t stats_total_items(StatsCounters* stats) {
+    int claimed;
+
+    #pragma omp atomic read
+    claimed = next_slot;
+
+    if (claimed > MAX_THREADS) {
+        claimed = MAX_THREADS;
+    }
+
+    int64_t items = 0;
+    for (int t = 0; t < claimed; t++) {
+        items += stats->threads[t].items;
+    }
+    return items;
+}
+
+/**
+ * @brief Create zeroed counters
+ *
+ * @return StatsCounters*
+ */
+StatsCounters* stats_create(void) {
+    StatsCounters* stats = aligned_alloc(64, sizeof(StatsCounters));
+    memset(stats, 0, sizeof(StatsCounters));
+    return stats;
+}
+
+/**
+ * @brief Destroy counters
+ *
+ * @param stats StatsCounters* -> counters to destroy (may be NULL)
+ */
+void stats_destroy(StatsCounters* stats) {
+    free(stats);
+}
+
+/**
+ * @brief Mark the start of a resize
+ *
+ * @return double -> omp_get_wtime() to hand to stats_resize()
+ */
+double stats_resize_begin(void) {
+    #pragma omp atomic update
+    stats_resizes_started++;
+
+    return omp_get_wtime();
+}
+
+/**
+ * @brief Record one finished resize
+ *
+ * @param stats StatsCounters* -> table counters
+ * @param started double -> what stats_resize_begin() returned
+ */
+void stats_resize(StatsCounters* stats, double started) {
+    double seconds = omp_get_wtime() - started;
+
+    stats->resizes++;
+    stats->resize_time += seconds;
+    if (seconds > stats->resize_max) {
+        stats->resize_max = seconds;
+    }
+
+    #pragma omp atomic update
+    stats_resizes_finished++;
+}
+
+/**
+ * @brief Sum the per-thread counters into a snapshot
+ *
+ * @param stats StatsCounters* -> table counters
+ * @param out TableStats* -> snapshot to fill
+ */
+void stats_merge(StatsCounters* stats, TableStats* out) {
+    memset(out, 0, sizeof(TableStats));
+
+    for (int t = 0; t < MAX_THREADS; t++) {
+        ThreadCounters* counters = &stats->threads[t];
+
+        out->items += counters->items;
+        out->cas_retries += counters->cas_retries;
+        out->hot_hits += counters->hot_hits;
+        out->hot_moves += counters->hot_moves;
+        out->hot_combined += counters->hot_combined;
+
+        for (int i = 0; i < STATS_DEPTH_BINS; i++) {
+            out->depths[i] += counters->depths[i];
+            out->ops += counters->depths[i];
+        }
+    }
+
+    out->lock_contended = stats->lock_contended;
+    out->lock_wait = stats->lock_wait;
+    out->resizes = stats->resizes;
+    out->shrinks = stats->shrinks;
+    out->resize_time = stats->resize_time;
+    out->resize_max = stats->resize_max;
+}
+
+/**
+ * @brief Print a snapshot, one metric per line
+ *
+ * @param snapshot const TableStats* -> merged counters
+ */
+void stats_print(const TableStats* snapshot) {
+    size_t depths[STATS_DEPTH_BINS];
+    for (int i = 0; i < STATS_DEPTH_BINS; i++) {
+        depths[i] = snapshot->depths[i];
+    }
+
+    printf("num_items: %" PRId64 "\n", snapshot->items);
+    print_length_histogram("op_depths", depths, STATS_DEPTH_BINS);
+    printf("cas_retries: %" PRIu64 "\n", snapshot->cas_retries);
+    printf("hot_keys: %" PRIu64 " cache hits, %" PRIu64 " moved to front, %" PRIu64 " inserts combined\n",
+           snapshot->hot_hits, snapshot->hot_moves, snapshot->hot_combined);
+    printf("lock_contended: %" PRIu64 "\n", snapshot->lock_contended);
+    printf("lock_wait: %f seconds\n", snapshot->lock_wait);
+    printf("hottest_stripe: %zu (%f seconds)\n", snapshot->hottest_stripe, snapshot->hottest_wait);
+    printf("resizes: %" PRIu64 " (%" PRIu64 " shrinks)\n", snapshot->resizes, snapshot->shrinks);
+    printf("resize_time: %f seconds (max %f)\n", snapshot->resize_time, snapshot->resize_max);
+}
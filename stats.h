@@ -0,0 +1,289 @@
+/**
+ * @file stats.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Per-thread table counters, merged on read
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * num_items used to be one shared counter that every insert and delete
+ * hit with an atomic, which is why speed tests turned it off. Now every
+ * thread counts into its own cache line with plain adds and print_table_stats
+ * sums the lines up. The same lines hold the instrumentation: how deep
+ * each lookup/insert walked, and how often a lock-free CAS had to retry.
+ * Lock wait is kept per stripe by the lock holder, and resize time by
+ * the one thread that finishes a resize. None of it needs an atomic, so
+ * it stays on all the time, unless the back end is built with
+ * -DTABLE_STATS=0 (see spec.h), which keeps only the item count.
+ *
+ * omp_get_thread_num() is a library call, and on the hot path it cost
+ * more than the counting itself. Every thread instead claims a slot the
+ * first time it counts and keeps it in a thread local. OpenMP reuses its
+ * threads, so MAX_THREADS slots are never close to running out. A merged
+ * read is exact once the threads are quiet, while they run it may miss a
+ * few updates.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "chained.h"
+#include "spec.h"
+
+// Local constants
+#define STATS_DEPTH_BINS 17  // depth histogram bins, the last one counts everything deeper
+
+/**
+ * @struct ThreadCounters
+ * @brief counters of one thread, alone on its cache lines
+ *
+ * @param items int64_t -> items this thread added minus items it removed
+ * @param cas_retries uint64_t -> failed compare and sets that made an operation start over
+ * @param depths uint64_t[] -> operations per number of chain items (or probe buckets) walked
+ * @param hot_hits uint64_t -> lookups answered from the hot key cache (see hot.h)
+ * @param hot_moves uint64_t -> items moved to the front of their chain
+ * @param hot_combined uint64_t -> batched inserts dropped for a later insert of the same key
+ */
+typedef struct {
+    int64_t items; /** @brief items this thread added minus items it removed */
+    uint64_t cas_retries; /** @brief failed compare and sets that made an operation start over */
+    uint64_t depths[STATS_DEPTH_BINS]; /** @brief operations per number of chain items (or probe buckets) walked */
+    uint64_t hot_hits; /** @brief lookups answered from the hot key cache (see hot.h) */
+    uint64_t hot_moves; /** @brief items moved to the front of their chain */
+    uint64_t hot_combined; /** @brief batched inserts dropped for a later insert of the same key */
+} __attribute__((aligned(64))) ThreadCounters;
+
+/**
+ * @struct StatsCounters
+ * @brief live counters of a table, handed to the next table on resize
+ *
+ * @param threads ThreadCounters[] -> one block per thread
+ * @param resizes uint64_t -> completed resizes
+ * @param shrinks uint64_t -> resizes that made the table smaller (see policy.h)
+ * @param resize_time double -> seconds spent in resizes
+ * @param resize_max double -> longest single resize in seconds
+ * @param lock_contended uint64_t -> contended acquisitions of stripes that were resized away
+ * @param lock_wait double -> seconds waited on stripes that were resized away
+ */
+typedef struct {
+    ThreadCounters threads[MAX_THREADS]; /** @brief one block per thread */
+    uint64_t resizes; /** @brief completed resizes */
+    uint64_t shrinks; /** @brief resizes that made the table smaller (see policy.h) */
+    double resize_time; /** @brief seconds spent in resizes */
+    double resize_max; /** @brief longest single resize in seconds */
+    uint64_t lock_contended; /** @brief contended acquisitions of stripes that were resized away */
+    double lock_wait; /** @brief seconds waited on stripes that were resized away */
+} StatsCounters;
+
+/**
+ * @struct TableStats
+ * @brief merged snapshot of a table's counters
+ *
+ * @param items int64_t -> number of items in the table
+ * @param ops uint64_t -> lookups and inserts counted in depths (hot key cache hits are not)
+ * @param depths uint64_t[] -> operations per number of chain items (or probe buckets) walked
+ * @param cas_retries uint64_t -> failed compare and sets that made an operation start over
+ * @param hot_hits uint64_t -> lookups answered from the hot key cache
+ * @param hot_moves uint64_t -> items moved to the front of their chain
+ * @param hot_combined uint64_t -> batched inserts dropped for a later insert of the same key
+ * @param lock_contended uint64_t -> stripe acquisitions that had to wait
+ * @param lock_wait double -> seconds spent waiting for stripes
+ * @param hottest_stripe size_t -> stripe of the current table with the most wait
+ * @param hottest_wait double -> seconds waited on hottest_stripe
+ * @param resizes uint64_t -> completed resizes
+ * @param shrinks uint64_t -> resizes that made the table smaller
+ * @param resize_time double -> seconds spent in resizes
+ * @param resize_max double -> longest single resize in seconds
+ */
+struct TableStats {
+    int64_t items; /** @brief number of items in the table */
+    uint64_t ops; /** @brief lookups and inserts counted in depths (hot key cache hits are not) */
+    uint64_t depths[STATS_DEPTH_BINS]; /** @brief operations per number of chain items (or probe buckets) walked */
+    uint64_t cas_retries; /** @brief failed compare and sets that made an operation start over */
+    uint64_t hot_hits; /** @brief lookups answered from the hot key cache */
+    uint64_t hot_moves; /** @brief items moved to the front of their chain */
+    uint64_t hot_combined; /** @brief batched inserts dropped for a later insert of the same key */
+    uint64_t lock_contended; /** @brief stripe acquisitions that had to wait */
+    double lock_wait; /** @brief seconds spent waiting for stripes */
+    size_t hottest_stripe; /** @brief stripe of the current table with the most wait */
+    double hottest_wait; /** @brief seconds waited on hottest_stripe */
+    uint64_t resizes; /** @brief completed resizes */
+    uint64_t shrinks; /** @brief resizes that made the table smaller */
+    double resize_time; /** @brief seconds spent in resizes */
+    double resize_max; /** @brief longest single resize in seconds */
+};
+
+// Resizes of any table in the process that have started and finished, see latency.h
+extern volatile uint64_t stats_resizes_started;
+extern volatile uint64_t stats_resizes_finished;
+
+// Slot of the calling thread plus one, 0 until it first counts (see stats.c)
+extern _Thread_local int stats_slot;
+
+/**
+ * @brief Hand the calling thread its counter slot
+ *
+ * @return int -> slot plus one
+ */
+int stats_claim_slot(void);
+
+/**
+ * @brief counters of the calling thread
+ *
+ * @param stats StatsCounters* -> table counters
+ * @return ThreadCounters*
+ */
+static inline ThreadCounters* stats_thread(StatsCounters* stats) {
+    if (__builtin_expect(stats_slot == 0, 0)) {
+        stats_slot = stats_claim_slot();
+    }
+    return &stats->threads[stats_slot - 1];
+}
+
+/**
+ * @brief count one lookup or insert and how deep it walked
+ *
+ * @param stats StatsCounters* -> table counters
+ * @param depth size_t -> chain items (or probe buckets) walked
+ */
+static inline void stats_depth(StatsCounters* stats, size_t depth) {
+#if TABLE_STATS
+    stats_thread(stats)->depths[depth < STATS_DEPTH_BINS - 1 ? depth : STATS_DEPTH_BINS - 1]++;
+#else
+    (void)stats;
+    (void)depth;
+#endif
+}
+
+/**
+ * @brief count items added (positive) or removed (negative)
+ *
+ * @param stats StatsCounters* -> table counters
+ * @param delta int -> change in the number of items
+ */
+static inline void stats_items(StatsCounters* stats, int delta) {
+    stats_thread(stats)->items += delta;
+}
+
+/**
+ * @brief count compare and sets that made an operation start over
+ *
+ * @param stats StatsCounters* -> table counters
+ * @param retries uint64_t -> number of retries
+ */
+static inline void stats_cas_retries(StatsCounters* stats, uint64_t retries) {
+#if TABLE_STATS
+    if (retries) {
+        stats_thread(stats)->cas_retries += retries;
+    }
+#else
+    (void)stats;
+    (void)retries;
+#endif
+}
+
+/**
+ * @brief count one lookup the hot key cache answered
+ *
+ * @param stats StatsCounters* -> table counters
+ */
+static inline void stats_hot_hit(StatsCounters* stats) {
+#if TABLE_STATS
+    stats_thread(stats)->hot_hits++;
+#else
+    (void)stats;
+#endif
+}
+
+/**
+ * @brief count one item moved to the front of its chain
+ *
+ * @param stats StatsCounters* -> table counters
+ */
+static inline void stats_hot_move(StatsCounters* stats) {
+#if TABLE_STATS
+    stats_thread(stats)->hot_moves++;
+#else
+    (void)stats;
+#endif
+}
+
+/**
+ * @brief count batched inserts dropped for a later insert of the same key
+ *
+ * @param stats StatsCounters* -> table counters
+ * @param combined uint64_t -> inserts dropped
+ */
+static inline void stats_hot_combined(StatsCounters* stats, uint64_t combined) {
+#if TABLE_STATS
+    if (combined) {
+        stats_thread(stats)->hot_combined += combined;
+    }
+#else
+    (void)stats;
+    (void)combined;
+#endif
+}
+
+/**
+ * @brief Sum the item counts of every thread that has counted so far
+ *
+ * Cheaper than stats_merge(), it only reads the slots handed out. Close
+ * enough while other threads are counting, see policy.h.
+ *
+ * @param stats StatsCounters* -> table counters
+ * @return int64_t -> number of items in the table
+ */
+int64_t stats_total_items(StatsCounters* stats);
+
+/**
+ * @brief Create zeroed counters
+ *
+ * @return StatsCounters*
+ */
+StatsCounters* stats_create(void);
+
+/**
+ * @brief Destroy counters
+ *
+ * @param stats StatsCounters* -> counters to destroy (may be NULL)
+ */
+void stats_destroy(StatsCounters* stats);
+
+/**
+ * @brief Mark the start of a resize
+ *
+ * Only called by the thread that starts the resize.
+ *
+ * @return double -> omp_get_wtime() to hand to stats_resize()
+ */
+double stats_resize_begin(void);
+
+/**
+ * @brief Record one finished resize
+ *
+ * Only called by the thread that completes the resize.
+ *
+ * @param stats StatsCounters* -> table counters
+ * @param started double -> what stats_resize_begin() returned
+ */
+void stats_resize(StatsCounters* stats, double started);
+
+/**
+ * @brief Sum the per-thread counters into a snapshot
+ *
+ * Lock fields other than the resized away totals are left for the back
+ * end to add from its stripes.
+ *
+ * @param stats StatsCounters* -> table counters
+ * @param out TableStats* -> snapshot to fill
+ */
+void stats_merge(StatsCounters* stats, TableStats* out);
+
+/**
+ * @brief Print a snapshot, one metric per line
+ *
+ * @param snapshot const TableStats* -> merged counters
+ */
+void stats_print(const TableStats* snapshot);
+
+#endif // STATS_H
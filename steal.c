@@ -0,0 +1,217 @@
+/**
+ * @file steal.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Per-thread work-stealing deques of trace chunks
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Chase-Lev deque on a fixed ring. top only moves forward, by CAS from
+ * thieves or from the owner taking the last chunk. bottom is only written
+ * by the owner. A pop first lowers bottom and then reads top (both
+ * seq_cst), a thief reads top and then bottom, so when one chunk is left
+ * either the thief sees it gone or both race on the CAS of top.
+ *
+ * A thief copies the slot before its CAS. The owner can not overwrite
+ * that slot in the meantime, a push only reuses a slot once top has moved
+ * a whole ring past it.
+ */
+
+#include "steal.h"
+
+#include <omp.h>
+#include <stdlib.h>
+
+// Local constants
+#define STEAL_MASK (STEAL_DEQUE_SIZE - 1)
+
+/**
+ * @struct ChunkDeque
+ * @brief bounded deque owned by one thread
+ *
+ * @param top volatile long -> oldest chunk, advanced by thieves
+ * @param bottom volatile long -> one past the newest chunk, owner only
+ * @param seed unsigned int -> owner's random state for picking victims
+ * @param slots Chunk[] -> ring of queued chunks
+ */
+typedef struct {
+    volatile long top; /** @brief oldest chunk, advanced by thieves */
+    volatile long bottom; /** @brief one past the newest chunk, owner only */
+    unsigned int seed; /** @brief owner's random state for picking victims */
+    Chunk slots[STEAL_DEQUE_SIZE]; /** @brief ring of queued chunks */
+} __attribute__((aligned(64))) ChunkDeque;
+
+/**
+ * @struct StealPool
+ * @brief one deque per thread of the team
+ *
+ * @param deques ChunkDeque* -> deque per thread, cache line aligned
+ * @param num_threads int -> number of deques
+ */
+struct StealPool {
+    ChunkDeque* deques; /** @brief deque per thread, cache line aligned */
+    int num_threads; /** @brief number of deques */
+};
+
+/**
+ * @brief Create pool
+ *
+ * @param num_threads int -> number of deques (size of the team)
+ * @return StealPool*
+ */
+StealPool* steal_create(int num_threads) {
+    StealPool* pool = malloc(sizeof(StealPool));
+
+    pool->num_threads = num_threads;
+    pool->deques = aligned_alloc(64, num_threads * sizeof(ChunkDeque));
+
+    for (int i = 0; i < num_threads; i++) {
+        pool->deques[i].top = 0;
+        pool->deques[i].bottom = 0;
+        pool->deques[i].seed = 2654435761u * (i + 1);
+    }
+
+    return pool;
+}
+
+/**
+ * @brief Destroy pool
+ *
+ * @param pool StealPool* -> pool to destroy
+ */
+void steal_destroy(StealPool* pool) {
+    free(pool->deques);
+    free(pool);
+}
+
+/**
+ * @brief Push chunk onto the bottom of the calling thread's deque
+ *
+ * @param pool StealPool* -> specific pool
+ * @param chunk const Chunk* -> chunk to queue
+ * @return int -> 0 if the deque is full (the chunk is not queued)
+ */
+int steal_push(StealPool* pool, const Chunk* chunk) {
+    ChunkDeque* deque = &pool->deques[omp_get_thread_num()];
+    long bottom = deque->bottom;
+    long top;
+
+    #pragma omp atomic read seq_cst
+    top = deque->top;
+
+    if (bottom - top >= STEAL_DEQUE_SIZE) {
+        return 0;
+    }
+
+    deque->slots[bottom & STEAL_MASK] = *chunk;
+
+    // Publishes the slot to thieves
+    #pragma omp atomic write seq_cst
+    deque->bottom = bottom + 1;
+
+    return 1;
+}
+
+/**
+ * @brief Pop the newest chunk from the calling thread's deque
+ *
+ * @param pool StealPool* -> specific pool
+ * @param chunk Chunk* -> filled in on success
+ * @return int -> 0 if the deque is empty
+ */
+int steal_pop(StealPool* pool, Chunk* chunk) {
+    ChunkDeque* deque = &pool->deques[omp_get_thread_num()];
+    long bottom = deque->bottom - 1;
+    long top;
+
+    #pragma omp atomic write seq_cst
+    deque->bottom = bottom;
+
+    #pragma omp atomic read seq_cst
+    top = deque->top;
+
+    if (top > bottom) {
+        #pragma omp atomic write seq_cst
+        deque->bottom = bottom + 1;
+        return 0;
+    }
+
+    *chunk = deque->slots[bottom & STEAL_MASK];
+
+    if (top < bottom) {
+        return 1;
+    }
+
+    // Last chunk, a thief may be going for it too
+    long old_top;
+
+    #pragma omp atomic compare capture seq_cst
+    {
+        old_top = deque->top;
+        if (deque->top == top) {
+            deque->top = top + 1;
+        }
+    }
+
+    #pragma omp atomic write seq_cst
+    deque->bottom = bottom + 1;
+
+    return old_top == top;
+}
+
+/**
+ * @brief Steal the oldest chunk of some other thread
+ *
+ * @param pool StealPool* -> specific pool
+ * @param chunk Chunk* -> filled in on success
+ * @return int -> 0 if every other deque looked empty
+ */
+int steal_take(StealPool* pool, Chunk* chunk) {
+    int self = omp_get_thread_num();
+    ChunkDeque* own = &pool->deques[self];
+
+    if (pool->num_threads < 2) {
+        return 0;
+    }
+
+    own->seed = own->seed * 1103515245u + 12345u;
+    int start = (own->seed >> 16) % pool->num_threads;
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        int victim_idx = (start + i) % pool->num_threads;
+        if (victim_idx == self) {
+            continue;
+        }
+
+        ChunkDeque* victim = &pool->deques[victim_idx];
+        long top;
+        long bottom;
+
+        #pragma omp atomic read seq_cst
+        top = victim->top;
+
+        #pragma omp atomic read seq_cst
+        bottom = victim->bottom;
+
+        if (top >= bottom) {
+            continue;
+        }
+
+        Chunk stolen = victim->slots[top & STEAL_MASK];
+        long old_top;
+
+        #pragma omp atomic compare capture seq_cst
+        {
+            old_top = victim->top;
+            if (victim->top == top) {
+                victim->top = top + 1;
+            }
+        }
+
+        if (old_top == top) {
+            *chunk = stolen;
+            return 1;
+        }
+    }
+
+    return 0;
+}
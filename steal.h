@@ -0,0 +1,96 @@
+/**
+ * @file steal.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief Per-thread work-stealing deques of trace chunks
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * The task pipeline has one thread reading the whole trace while the
+ * others wait for it, and every round of MAX_TASK_POOL tasks ends at two
+ * barriers. Here every thread owns a bounded Chase-Lev deque. The owner
+ * pushes and pops at the bottom without any atomic read-modify-write in
+ * the common case, idle threads steal the oldest chunk from the top of
+ * someone else's deque with one compare and swap.
+ *
+ * Threads are identified by omp_get_thread_num(), so a pool may only be
+ * used from inside a single OpenMP team.
+ */
+
+#ifndef STEAL_H
+#define STEAL_H
+
+#include <stddef.h>
+
+// Local constants
+#define STEAL_DEQUE_SIZE 64  // chunks one deque can hold (power of two)
+
+/**
+ * @struct Chunk
+ * @brief part of the trace that one thread processes at a time
+ *
+ * @param begin const char* -> first byte, at the start of a line or record
+ * @param end const char* -> one past the last byte
+ * @param buffer char* -> memory to free after processing (NULL for a mapped trace)
+ */
+typedef struct {
+    const char* begin; /** @brief first byte, at the start of a line or record */
+    const char* end; /** @brief one past the last byte */
+    char* buffer; /** @brief memory to free after processing (NULL for a mapped trace) */
+} Chunk;
+
+/**
+ * @struct StealPool
+ * @brief one deque per thread of the team
+ *
+ * @param deques ChunkDeque* -> deque per thread, cache line aligned
+ * @param num_threads int -> number of deques
+ */
+typedef struct StealPool StealPool;
+
+/**
+ * @brief Create pool
+ *
+ * @param num_threads int -> number of deques (size of the team)
+ * @return StealPool*
+ */
+StealPool* steal_create(int num_threads);
+
+/**
+ * @brief Destroy pool
+ *
+ * Chunks still queued are not freed.
+ *
+ * @param pool StealPool* -> pool to destroy
+ */
+void steal_destroy(StealPool* pool);
+
+/**
+ * @brief Push chunk onto the bottom of the calling thread's deque
+ *
+ * @param pool StealPool* -> specific pool
+ * @param chunk const Chunk* -> chunk to queue
+ * @return int -> 0 if the deque is full (the chunk is not queued)
+ */
+int steal_push(StealPool* pool, const Chunk* chunk);
+
+/**
+ * @brief Pop the newest chunk from the calling thread's deque
+ *
+ * @param pool StealPool* -> specific pool
+ * @param chunk Chunk* -> filled in on success
+ * @return int -> 0 if the deque is empty
+ */
+int steal_pop(StealPool* pool, Chunk* chunk);
+
+/**
+ * @brief Steal the oldest chunk of some other thread
+ *
+ * Victims are tried once each, starting at a random one.
+ *
+ * @param pool StealPool* -> specific pool
+ * @param chunk Chunk* -> filled in on success
+ * @return int -> 0 if every other deque looked empty
+ */
+int steal_take(StealPool* pool, Chunk* chunk);
+
+#endif // STEAL_H
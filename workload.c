@@ -0,0 +1,413 @@
+/**
+ * @file workload.c
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief In-memory operation generator for the driver (-g)
+ * @version 0.1
+ * @date 2026-10-14
+ */
+
+#include "workload.h"
+#include "chained.h"
+#include "spec.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Local constants
+#define ZETA_EXACT_TERMS 1000000  // zeta(n) is summed up to here and integrated beyond
+#define ZIPF_TRIES 8              // draws before a Zipfian pick over the live keys gives up
+#if TABLE_KEY_BITS == 32
+#define MISS_SPAN (1ULL << 31)    // numbers past key_space used for missing lookups, all below 2^32
+#define MAX_KEY_SPACE (1ULL << 31) // so key_space + MISS_SPAN key numbers fit a 32 bit key
+#else
+#define MISS_SPAN (1ULL << 40)    // numbers past key_space used for missing lookups
+#endif
+
+/**
+ * @struct WorkloadPreset
+ * @brief one DataConfig of python_data_generator.py
+ */
+typedef struct {
+    const char* name;
+    double insert_ratio;
+    double add_ratio;
+    double transition_to_updates_ratio;
+    double correct_lookup_ratio;
+    double delete_ratio;
+    uint64_t num_ops;
+} WorkloadPreset;
+
+static const WorkloadPreset presets[] = {
+    { "balanced", 0.5, 0.5, 0.0, 1.0, 0.0, 100000 },
+    { "write_heavy", 0.9, 0.5, 0.0, 1.0, 0.0, 100000 },
+    { "read_heavy", 0.1, 0.5, 0.0, 1.0, 0.0, 100000 },
+    { "typical", 0.5, 0.8, 0.8, 1.0, 0.0, 100000 },
+    { "typical_with_misses", 0.5, 0.8, 0.8, 0.9, 0.0, 100000 },
+    { "delete_heavy", 0.4, 0.2, 0.0, 0.9, 0.3, 100000 },
+    { "large", 0.5, 0.8, 0.8, 0.9, 0.0, 1000000 },
+};
+
+/**
+ * @brief splitmix64 finalizer, a bijection on 64 bit numbers
+ *
+ * @param x uint64_t -> input
+ * @return uint64_t -> mixed
+ */
+static inline uint64_t scramble(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief murmur3 32 bit finalizer (fmix32), a bijection on 32 bit numbers
+ *
+ * Key numbers of a build with 32 bit keys (see spec.h).
+ *
+ * @param x uint32_t -> input
+ * @return uint32_t -> mixed
+ */
+static inline uint32_t scramble32(uint32_t x) {
+    x = (x ^ (x >> 16)) * 0x85EBCA6BU;
+    x = (x ^ (x >> 13)) * 0xC2B2AE35U;
+    return x ^ (x >> 16);
+}
+
+/**
+ * @brief next random number (xorshift64*)
+ *
+ * @param state WorkloadThread* -> generator of the calling thread
+ * @return uint64_t -> random bits
+ */
+static inline uint64_t next_random(WorkloadThread* state) {
+    state->rng ^= state->rng >> 12;
+    state->rng ^= state->rng << 25;
+    state->rng ^= state->rng >> 27;
+    return state->rng * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief random number in [0, 1)
+ *
+ * @param state WorkloadThread* -> generator of the calling thread
+ * @return double
+ */
+static inline double next_double(WorkloadThread* state) {
+    return (next_random(state) >> 11) * 0x1.0p-53;
+}
+
+/**
+ * @brief sum of 1 / i^theta for i = 1 to n
+ *
+ * The tail past ZETA_EXACT_TERMS comes from Euler-Maclaurin (integral
+ * plus the trapezoid correction), which is exact to far below what
+ * matters for picking keys.
+ *
+ * @param n uint64_t -> number of terms
+ * @param theta double -> exponent (below 1)
+ * @return double
+ */
+static double zeta(uint64_t n, double theta) {
+    uint64_t exact = n < ZETA_EXACT_TERMS ? n : ZETA_EXACT_TERMS;
+    double sum = 0.0;
+
+    for (uint64_t i = 1; i <= exact; i++) {
+        sum += 1.0 / pow((double)i, theta);
+    }
+
+    if (n > exact) {
+        double m = (double)exact;
+        double last = (double)n;
+        sum += (pow(last, 1.0 - theta) - pow(m, 1.0 - theta)) / (1.0 - theta);
+        sum += 0.5 * (pow(last, -theta) - pow(m, -theta));
+    }
+
+    return sum;
+}
+
+/**
+ * @brief Zipfian rank in [0, key_space), 0 the most likely (Gray et al., as in YCSB)
+ *
+ * @param workload const Workload* -> shared state
+ * @param state WorkloadThread* -> generator of the calling thread
+ * @return uint64_t
+ */
+static uint64_t zipf_rank(const Workload* workload, WorkloadThread* state) {
+    double u = next_double(state);
+    double uz = u * workload->zeta_n;
+
+    if (uz < 1.0) {
+        return 0;
+    }
+    if (uz < 1.0 + workload->half_pow_theta) {
+        return 1;
+    }
+
+    uint64_t rank = (uint64_t)(workload->config.key_space * pow(workload->zipf_eta * u - workload->zipf_eta + 1.0, workload->zipf_alpha));
+    return rank < workload->config.key_space ? rank : workload->config.key_space - 1;
+}
+
+/**
+ * @brief pick one of the live keys
+ *
+ * A Zipfian rank that is not live yet is drawn again, early in a run
+ * most of the key space is not.
+ *
+ * @param workload const Workload* -> shared state
+ * @param state WorkloadThread* -> generator of the calling thread
+ * @param live uint64_t -> number of live keys (at least 1)
+ * @return uint64_t -> key number
+ */
+static uint64_t pick_live(const Workload* workload, WorkloadThread* state, uint64_t live) {
+    if (workload->config.zipf_theta > 0.0) {
+        for (int i = 0; i < ZIPF_TRIES; i++) {
+            uint64_t rank = zipf_rank(workload, state);
+            if (rank < live) {
+                return rank;
+            }
+        }
+    }
+    return next_random(state) % live;
+}
+
+/**
+ * @brief fill in one operation on a key number
+ *
+ * @param item BatchItem* -> operation to fill in
+ * @param hash_op char -> 'I', 'L' or 'D'
+ * @param number uint64_t -> key number
+ */
+static inline void make_op(BatchItem* item, char hash_op, uint64_t number) {
+#if TABLE_KEY_BITS == 32
+    uint64_t key = scramble32((uint32_t)number);
+#else
+    uint64_t key = scramble(number);
+#endif
+    uint64_t value = scramble(key ^ 0x9E3779B97F4A7C15ULL);
+
+    // Values a narrow build can store, every key of a set has SET_VALUE
+#if TABLE_VALUE_BITS == 32
+    value &= UINT32_MAX;
+#elif TABLE_VALUE_BITS == 0
+    value = SET_VALUE;
+#endif
+
+    item->hash_op = hash_op;
+    item->key = key != INVALID_KEY ? key : 0;
+    item->value = value != INVALID_VALUE ? value : 0;
+}
+
+/**
+ * @brief Parse "preset,name=value,..." into a configuration
+ *
+ * @param spec const char* -> specification
+ * @param config WorkloadConfig* -> filled in
+ * @return int -> 0 if spec is not valid
+ */
+int workload_parse(const char* spec, WorkloadConfig* config) {
+    const WorkloadPreset* preset = &presets[6];
+    size_t num_presets = sizeof(presets) / sizeof(presets[0]);
+
+    // A preset name can only be the first field
+    size_t first_len = strcspn(spec, ",");
+    int has_preset = first_len > 0 && memchr(spec, '=', first_len) == NULL;
+
+    if (has_preset) {
+        size_t i;
+        for (i = 0; i < num_presets; i++) {
+            if (strlen(presets[i].name) == first_len && strncmp(spec, presets[i].name, first_len) == 0) {
+                break;
+            }
+        }
+        if (i == num_presets) {
+            return 0;
+        }
+        preset = &presets[i];
+    }
+
+    memset(config, 0, sizeof(WorkloadConfig));
+    config->insert_ratio = preset->insert_ratio;
+    config->add_ratio = preset->add_ratio;
+    config->transition_to_updates_ratio = preset->transition_to_updates_ratio;
+    config->correct_lookup_ratio = preset->correct_lookup_ratio;
+    config->delete_ratio = preset->delete_ratio;
+    config->num_ops = preset->num_ops;
+    config->key_space = 1 << 20;
+    config->interval = 1.0;
+
+    int valid = 1;
+    int has_ops = 0;
+    int has_time = 0;
+
+    char* copy = strdup(spec + (has_preset ? first_len : 0));
+    char* save = NULL;
+
+    for (char* field = strtok_r(copy, ",", &save); field != NULL; field = strtok_r(NULL, ",", &save)) {
+        char* equals = strchr(field, '=');
+        if (equals == NULL) {
+            valid = 0;
+            break;
+        }
+
+        *equals = '\0';
+        const char* name = field;
+        const char* text = equals + 1;
+        double value = atof(text);
+
+        if (strcmp(name, "insert") == 0) {
+            config->insert_ratio = value;
+        } else if (strcmp(name, "add") == 0) {
+            config->add_ratio = value;
+        } else if (strcmp(name, "transition") == 0) {
+            config->transition_to_updates_ratio = value;
+        } else if (strcmp(name, "hit") == 0) {
+            config->correct_lookup_ratio = value;
+        } else if (strcmp(name, "delete") == 0) {
+            config->delete_ratio = value;
+        } else if (strcmp(name, "keys") == 0) {
+            config->key_space = strtoull(text, NULL, 10);
+        } else if (strcmp(name, "zipf") == 0) {
+            config->zipf_theta = value;
+        } else if (strcmp(name, "ops") == 0) {
+            config->num_ops = strtoull(text, NULL, 10);
+            has_ops = 1;
+        } else if (strcmp(name, "time") == 0) {
+            config->duration = value;
+            has_time = 1;
+        } else if (strcmp(name, "interval") == 0) {
+            config->interval = value;
+        } else if (strcmp(name, "preload") == 0) {
+            config->preload = strtoull(text, NULL, 10);
+        } else {
+            valid = 0;
+            break;
+        }
+    }
+
+    free(copy);
+
+    // A duration alone runs for that long instead of the preset's op count
+    if (has_time && !has_ops) {
+        config->num_ops = 0;
+    }
+
+    if (config->key_space < 1 || config->zipf_theta < 0.0 || config->zipf_theta >= 1.0 || config->interval <= 0.0) {
+        valid = 0;
+    }
+    if (config->num_ops == 0 && config->duration <= 0.0) {
+        valid = 0;
+    }
+
+    return valid;
+}
+
+/**
+ * @brief Set up the shared state
+ *
+ * @param workload Workload* -> filled in
+ * @param config const WorkloadConfig* -> configuration to copy
+ * @param num_threads int -> threads generating
+ */
+void workload_init(Workload* workload, const WorkloadConfig* config, int num_threads) {
+    workload->config = *config;
+    workload->num_threads = num_threads;
+
+#ifdef MAX_KEY_SPACE
+    if (workload->config.key_space > MAX_KEY_SPACE) {
+        workload->config.key_space = MAX_KEY_SPACE;
+    }
+#endif
+
+    // Every thread takes the same share, the way its adds would have gone
+    if (workload->config.preload > workload->config.key_space) {
+        workload->config.preload = workload->config.key_space;
+    }
+    workload->config.preload -= workload->config.preload % num_threads;
+
+    double theta = config->zipf_theta;
+
+    if (theta > 0.0) {
+        double n = (double)workload->config.key_space;
+        double zeta_2 = 1.0 + pow(0.5, theta);
+
+        workload->zeta_n = zeta(workload->config.key_space, theta);
+        workload->zipf_alpha = 1.0 / (1.0 - theta);
+        workload->zipf_eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta_2 / workload->zeta_n);
+        workload->half_pow_theta = pow(0.5, theta);
+    }
+}
+
+/**
+ * @brief Set up one thread's generator
+ *
+ * @param workload const Workload* -> shared state
+ * @param state WorkloadThread* -> filled in
+ * @param thread int -> thread number
+ */
+void workload_thread_init(const Workload* workload, WorkloadThread* state, int thread) {
+    state->rng = scramble(0x2545F4914F6CDD1DULL + thread) | 1;
+    state->added = workload->config.preload / workload->num_threads;
+    state->thread = thread;
+}
+
+/**
+ * @brief Make the pairs of the preloaded key numbers
+ *
+ * @param workload const Workload* -> shared state
+ * @param keys uint64_t* -> config.preload keys
+ * @param values uint64_t* -> config.preload values
+ */
+void workload_preload(const Workload* workload, uint64_t* keys, uint64_t* values) {
+    #pragma omp parallel for
+    for (uint64_t i = 0; i < workload->config.preload; i++) {
+        BatchItem item;
+        make_op(&item, 'I', i);
+        keys[i] = item.key;
+        values[i] = item.value;
+    }
+}
+
+/**
+ * @brief Generate operations
+ *
+ * @param workload const Workload* -> shared state
+ * @param state WorkloadThread* -> generator of the calling thread
+ * @param progress double -> how far the run is, from 0 to 1 (for transition_to_updates_ratio)
+ * @param batch BatchItem* -> generated operations
+ * @param count size_t -> number of operations to generate
+ */
+void workload_generate(const Workload* workload, WorkloadThread* state, double progress, BatchItem* batch, size_t count) {
+    const WorkloadConfig* config = &workload->config;
+    uint64_t num_threads = workload->num_threads;
+    double add_ratio = config->add_ratio - progress * progress * config->transition_to_updates_ratio;
+
+    for (size_t i = 0; i < count; i++) {
+        // Keys every thread has added about as many of, capped at the key space
+        uint64_t live = state->added * num_threads;
+        if (live > config->key_space) {
+            live = config->key_space;
+        }
+
+        uint64_t next_add = state->thread + state->added * num_threads;
+        int can_add = next_add < config->key_space;
+        double op = next_double(state);
+
+        if (live > 0 && op < config->delete_ratio) {
+            make_op(&batch[i], 'D', pick_live(workload, state, live));
+        } else if (op < config->delete_ratio + config->insert_ratio) {
+            if (can_add && (live == 0 || next_double(state) < add_ratio)) {
+                make_op(&batch[i], 'I', next_add);
+                state->added++;
+            } else if (live > 0) {
+                make_op(&batch[i], 'I', pick_live(workload, state, live));
+            } else {
+                make_op(&batch[i], 'L', config->key_space + next_random(state) % MISS_SPAN);
+            }
+        } else if (live > 0 && next_double(state) < config->correct_lookup_ratio) {
+            make_op(&batch[i], 'L', pick_live(workload, state, live));
+        } else {
+            make_op(&batch[i], 'L', config->key_space + next_random(state) % MISS_SPAN);
+        }
+    }
+}
@@ -0,0 +1,160 @@
+/**
+ * @file workload.h
+ * @author Ryan Frost (rfrost26@vt.edu)
+ * @brief In-memory operation generator for the driver (-g)
+ * @version 0.1
+ * @date 2026-10-14
+ *
+ * Replaying a trace costs file I/O and parsing, and large.txt stops after
+ * 1M operations. Here every thread makes up its own operations with the
+ * same knobs as DataConfig in python_data_generator.py: insert, delete
+ * and lookup ratios, how many inserts add a key instead of updating one
+ * (shifting towards updates over the run), and how many lookups hit.
+ *
+ * Keys are numbered 0 to key_space - 1 and scrambled with a bijective
+ * mixer. Thread t adds keys t, t + T, t + 2T, ... so adds need no shared
+ * counter, and about T times its own adds are live. Updates, deletes and
+ * hitting lookups pick a live key, uniformly or Zipfian (YCSB style, key 0
+ * is the hottest, shared by all threads). Misses use numbers past
+ * key_space that are never inserted. Once a thread has added its share of
+ * key_space every insert is an update, so a run can go on for as long as
+ * it likes in bounded memory.
+ *
+ * With preload the first key numbers are bulk_load()ed before the clock
+ * starts, as if every thread had already added its share of them, so a
+ * run can start from a full table instead of growing into one.
+ *
+ * A key's value is always a hash of the key, so the driver still checks
+ * every lookup and delete. Threads that lag behind and deleted keys make
+ * a few lookups meant to hit miss.
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "parse.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @struct WorkloadConfig
+ * @brief what to generate and for how long
+ *
+ * @param insert_ratio double -> share of inserts (including updates)
+ * @param add_ratio double -> share of inserts that add a new key at the start
+ * @param transition_to_updates_ratio double -> add_ratio drops by this times progress squared
+ * @param correct_lookup_ratio double -> share of lookups that go to a live key
+ * @param delete_ratio double -> share of deletes
+ * @param key_space uint64_t -> number of distinct keys that can be added
+ * @param zipf_theta double -> key skew, 0 for uniform, below 1 for Zipfian
+ * @param num_ops uint64_t -> stop after this many operations in total (0 for no limit)
+ * @param duration double -> stop after this many seconds (0 for no limit)
+ * @param interval double -> seconds between throughput reports
+ * @param preload uint64_t -> key numbers loaded before the run (rounded down to a multiple of the threads)
+ */
+typedef struct {
+    double insert_ratio; /** @brief share of inserts (including updates) */
+    double add_ratio; /** @brief share of inserts that add a new key at the start */
+    double transition_to_updates_ratio; /** @brief add_ratio drops by this times progress squared */
+    double correct_lookup_ratio; /** @brief share of lookups that go to a live key */
+    double delete_ratio; /** @brief share of deletes */
+    uint64_t key_space; /** @brief number of distinct keys that can be added */
+    double zipf_theta; /** @brief key skew, 0 for uniform, below 1 for Zipfian */
+    uint64_t num_ops; /** @brief stop after this many operations in total (0 for no limit) */
+    double duration; /** @brief stop after this many seconds (0 for no limit) */
+    double interval; /** @brief seconds between throughput reports */
+    uint64_t preload; /** @brief key numbers loaded before the run (rounded down to a multiple of the threads) */
+} WorkloadConfig;
+
+/**
+ * @struct Workload
+ * @brief configuration plus the Zipfian constants, shared by all threads
+ *
+ * @param config WorkloadConfig -> copy of the configuration
+ * @param num_threads int -> threads generating
+ * @param zeta_n double -> sum of 1 / i^theta over the key space
+ * @param zipf_alpha double -> 1 / (1 - theta)
+ * @param zipf_eta double -> YCSB's eta for the key space
+ * @param half_pow_theta double -> 0.5^theta
+ */
+typedef struct {
+    WorkloadConfig config; /** @brief copy of the configuration */
+    int num_threads; /** @brief threads generating */
+    double zeta_n; /** @brief sum of 1 / i^theta over the key space */
+    double zipf_alpha; /** @brief 1 / (1 - theta) */
+    double zipf_eta; /** @brief YCSB's eta for the key space */
+    double half_pow_theta; /** @brief 0.5^theta */
+} Workload;
+
+/**
+ * @struct WorkloadThread
+ * @brief generator state of one thread
+ *
+ * @param rng uint64_t -> random state
+ * @param added uint64_t -> keys this thread has added
+ * @param thread int -> thread number
+ */
+typedef struct {
+    uint64_t rng; /** @brief random state */
+    uint64_t added; /** @brief keys this thread has added */
+    int thread; /** @brief thread number */
+} WorkloadThread;
+
+/**
+ * @brief Parse "preset,name=value,..." into a configuration
+ *
+ * Presets are the datasets of python_data_generator.py (balanced,
+ * write_heavy, read_heavy, typical, typical_with_misses, delete_heavy,
+ * large), names are insert, add, transition, hit, delete, keys, zipf, ops,
+ * time, interval and preload.
+ *
+ * @param spec const char* -> specification
+ * @param config WorkloadConfig* -> filled in
+ * @return int -> 0 if spec is not valid
+ */
+int workload_parse(const char* spec, WorkloadConfig* config);
+
+/**
+ * @brief Set up the shared state
+ *
+ * @param workload Workload* -> filled in
+ * @param config const WorkloadConfig* -> configuration to copy
+ * @param num_threads int -> threads generating
+ */
+void workload_init(Workload* workload, const WorkloadConfig* config, int num_threads);
+
+/**
+ * @brief Set up one thread's generator
+ *
+ * A thread starts with its share of the preloaded keys already added.
+ *
+ * @param workload const Workload* -> shared state
+ * @param state WorkloadThread* -> filled in
+ * @param thread int -> thread number
+ */
+void workload_thread_init(const Workload* workload, WorkloadThread* state, int thread);
+
+/**
+ * @brief Make the pairs of the preloaded key numbers
+ *
+ * Same keys and values the threads' adds would have made.
+ *
+ * @param workload const Workload* -> shared state
+ * @param keys uint64_t* -> config.preload keys
+ * @param values uint64_t* -> config.preload values
+ */
+void workload_preload(const Workload* workload, uint64_t* keys, uint64_t* values);
+
+/**
+ * @brief Generate operations
+ *
+ * @param workload const Workload* -> shared state
+ * @param state WorkloadThread* -> generator of the calling thread
+ * @param progress double -> how far the run is, from 0 to 1 (for transition_to_updates_ratio)
+ * @param batch BatchItem* -> generated operations
+ * @param count size_t -> number of operations to generate
+ */
+void workload_generate(const Workload* workload, WorkloadThread* state, double progress, BatchItem* batch, size_t count);
+
+#endif // WORKLOAD_H